@@ -0,0 +1,147 @@
+#pragma once
+
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/culling.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Dynamic bounding volume tree indexing the objects of a 2D scene by
+ * their bounds, only x and y being used
+ *
+ * Each object is a leaf holding its bounds and a fat box, its bounds grown by
+ * a margin. Objects moving inside their fat box only update their bounds,
+ * the others are removed and inserted again, the tree rebalancing itself with
+ * rotations on the way up. Queries walk the fat boxes and test the bounds
+ * of the leaves they reach, so results are exact.
+ *
+ * Leaves are identified by the proxy insert() returned, which stays valid
+ * until the leaf is removed.
+ */
+class aabb_tree
+{
+public:
+    static constexpr std::uint32_t null =
+        std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @param margin How far the fat boxes reach around the bounds, in world
+     * units. Larger margins mean fewer reinsertions but looser queries
+     *
+     * @throws std::invalid_argument If margin is negative
+     */
+    explicit aabb_tree(float margin = 1.0F);
+
+    /**
+     * @brief Replaces the content of the tree by the given bounds, built top
+     * down in one go. Far faster than inserting the objects one by one, and
+     * gives a better tree
+     *
+     * The object of bounds[i] is i, and so is its proxy
+     *
+     * @throws std::invalid_argument If some bounds are empty
+     */
+    void build(std::span<const aabb> bounds);
+
+    /**
+     * @brief Adds an object and returns its proxy
+     *
+     * @throws std::invalid_argument If bounds is empty
+     */
+    std::uint32_t insert(const aabb& bounds, std::uint32_t object);
+
+    /**
+     * @brief Updates the bounds of an object. Returns true if it left its fat
+     * box and was inserted again
+     */
+    bool move(std::uint32_t proxy, const aabb& bounds);
+
+    void remove(std::uint32_t proxy);
+    void clear() noexcept;
+
+    /**
+     * @brief Appends to objects the ones whose bounds intersect the rect
+     */
+    void query(const view_rect&            rect,
+               std::vector<std::uint32_t>& objects) const;
+
+    /**
+     * @brief Appends to objects the ones whose bounds contain the point
+     */
+    void query(float x, float y, std::vector<std::uint32_t>& objects) const;
+
+    /**
+     * @brief Returns the object whose bounds are the closest to the point,
+     * or null if none is closer than max_distance. Bounds containing the
+     * point are at a distance of 0
+     */
+    std::uint32_t nearest(float x,
+                          float y,
+                          float max_distance =
+                              std::numeric_limits<float>::infinity()) const;
+
+    std::uint32_t object(std::uint32_t proxy) const;
+
+    /**
+     * @brief Returns the bounds of a leaf, as given to insert or move. Only
+     * x and y are kept
+     */
+    aabb bounds(std::uint32_t proxy) const;
+
+    std::size_t size() const noexcept { return size_; }
+    bool        empty() const noexcept { return size_ == 0; }
+
+    /**
+     * @brief Returns the number of levels below the root, 0 for an empty
+     * tree or a single leaf
+     */
+    int height() const noexcept;
+
+private:
+    // min x, min y, max x, max y
+    using box = std::array<float, 4>;
+
+    struct node
+    {
+        box fat {};
+        // Bounds of the object, only meaningful for leaves
+        box tight {};
+        // Next free node while the node is free
+        std::uint32_t parent {null};
+        std::uint32_t left {null};
+        std::uint32_t right {null};
+        std::uint32_t object {null};
+        // Leaves are at 0, free nodes at -1
+        int height {-1};
+
+        bool leaf() const noexcept { return left == null; }
+    };
+
+    std::uint32_t allocate();
+    void          release(std::uint32_t index);
+    void          insert_leaf(std::uint32_t leaf);
+    void          remove_leaf(std::uint32_t leaf);
+    std::uint32_t balance(std::uint32_t index);
+    void          refit(std::uint32_t index);
+    std::uint32_t build_range(std::uint32_t* begin, std::uint32_t* end);
+    box           fatten(const box& tight) const noexcept;
+    void          check_proxy(std::uint32_t proxy, const char* function) const;
+
+    template<class Enter, class Visit>
+    void traverse(const Enter& enter, const Visit& visit) const;
+
+    std::vector<node> nodes_;
+    std::uint32_t     root_ {null};
+    std::uint32_t     free_ {null};
+    std::size_t       size_ {0};
+    float             margin_;
+};
+}    // namespace corgi
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <corgi/opengl/vertex_attribute.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+namespace corgi
+{
+
+/**
+ * @brief 4x4 matrix stored column by column, like OpenGL expects it
+ *
+ * Element (row, column) is at index column * 4 + row, the translation is in
+ * elements 12, 13 and 14
+ */
+using matrix4 = std::array<float, 16>;
+
+constexpr matrix4 identity_matrix4 {1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F,
+                                    0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F,
+                                    0.0F, 0.0F, 0.0F, 1.0F};
+
+/**
+ * @brief Returns the point transformed by the matrix, assuming w is 1
+ */
+constexpr std::array<float, 3> transform_point(const matrix4&              m,
+                                               const std::array<float, 3>& p)
+{
+    return {m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+            m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+            m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]};
+}
+
+/**
+ * @brief Axis aligned bounding box
+ *
+ * A default constructed box is empty : min is bigger than max, so expanding
+ * it by a point gives a box around that point only
+ */
+struct aabb
+{
+    std::array<float, 3> min {std::numeric_limits<float>::max(),
+                              std::numeric_limits<float>::max(),
+                              std::numeric_limits<float>::max()};
+    std::array<float, 3> max {std::numeric_limits<float>::lowest(),
+                              std::numeric_limits<float>::lowest(),
+                              std::numeric_limits<float>::lowest()};
+
+    constexpr bool empty() const noexcept
+    {
+        return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+    }
+
+    constexpr void expand(const std::array<float, 3>& point) noexcept
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            min[i] = std::min(min[i], point[i]);
+            max[i] = std::max(max[i], point[i]);
+        }
+    }
+
+    constexpr void merge(const aabb& other) noexcept
+    {
+        if(other.empty())
+            return;
+
+        expand(other.min);
+        expand(other.max);
+    }
+
+    constexpr std::array<float, 3> center() const noexcept
+    {
+        return {(min[0] + max[0]) * 0.5F, (min[1] + max[1]) * 0.5F,
+                (min[2] + max[2]) * 0.5F};
+    }
+
+    /**
+     * @brief Returns half the size of the box on each axis
+     */
+    constexpr std::array<float, 3> extent() const noexcept
+    {
+        return {(max[0] - min[0]) * 0.5F, (max[1] - min[1]) * 0.5F,
+                (max[2] - min[2]) * 0.5F};
+    }
+
+    bool operator==(const aabb& other) const = default;
+};
+
+/**
+ * @brief Sphere around a set of points, cheaper than a box to test against
+ * a frustum or a ray
+ *
+ * A default constructed sphere is empty : its radius is negative
+ */
+struct bounding_sphere
+{
+    std::array<float, 3> center {0.0F, 0.0F, 0.0F};
+    float                radius {-1.0F};
+
+    constexpr bool empty() const noexcept { return radius < 0.0F; }
+
+    bool operator==(const bounding_sphere& other) const = default;
+};
+
+/**
+ * @brief Returns the box around the transformed box
+ *
+ * Transforms the center and the extent instead of the 8 corners
+ */
+constexpr aabb transform(const aabb& box, const matrix4& m)
+{
+    if(box.empty())
+        return box;
+
+    const auto center = transform_point(m, box.center());
+    const auto extent = box.extent();
+
+    // std::abs is only constexpr since C++23
+    auto abs = [](float value) { return value < 0.0F ? -value : value; };
+
+    aabb result;
+
+    for(int row = 0; row < 3; row++)
+    {
+        const float e = abs(m[row]) * extent[0] +
+                        abs(m[4 + row]) * extent[1] +
+                        abs(m[8 + row]) * extent[2];
+
+        result.min[row] = center[row] - e;
+        result.max[row] = center[row] + e;
+    }
+    return result;
+}
+
+/**
+ * @brief Returns the box around a float attribute of interleaved vertices
+ *
+ * Components the attribute doesn't have are 0 in the box, so 2D positions
+ * give a flat box
+ *
+ * @param components Number of floats of the attribute, 1 to 3 are read
+ */
+aabb compute_aabb(std::span<const std::byte> vertices,
+                  std::size_t                stride,
+                  std::size_t                offset,
+                  int                        components);
+
+/**
+ * @brief Returns the sphere centered on the box that holds every point of
+ * the attribute
+ *
+ * @param box The box computed by compute_aabb for the same attribute
+ */
+bounding_sphere compute_bounding_sphere(std::span<const std::byte> vertices,
+                                        std::size_t                stride,
+                                        std::size_t                offset,
+                                        int                        components,
+                                        const aabb&                box);
+
+/**
+ * @brief Returns the bounds of the float positions at location 0, or an empty
+ * box if the vertices have none
+ */
+aabb compute_aabb(std::span<const std::byte>        vertices,
+                  std::span<const vertex_attribute> attributes);
+
+bounding_sphere compute_bounding_sphere(
+    std::span<const std::byte>        vertices,
+    std::span<const vertex_attribute> attributes,
+    const aabb&                       box);
+
+}    // namespace corgi
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/memory_tracker.h>
 #include <glad/glad.h>
 
 #include <exception>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace corgi
@@ -15,6 +18,20 @@ enum class buffer_type
     uniform
 };
 
+constexpr resource_type to_resource_type(buffer_type type) noexcept
+{
+    switch(type)
+    {
+        case buffer_type::array_buffer:
+            return resource_type::vertex_buffer;
+        case buffer_type::element_array_buffer:
+            return resource_type::index_buffer;
+        case buffer_type::uniform:
+            return resource_type::uniform_buffer;
+    }
+    return resource_type::vertex_buffer;
+}
+
 /**
  * \brief Ties data to its openGL representation.
  *
@@ -55,26 +72,12 @@ public:
     buffer(std::vector<T> data)
         : data_(std::move(data))
     {
-        glGenBuffers(1, &id_);
-
-        if(id_ == 0)
-            throw std::logic_error(
-                "buffer::buffer(std::vector<T> data, buffer_type type) : id is "
-                "equals to 0 after glGenBuffers");
-
         push_data();
     }
 
     buffer(const buffer& other)
         : data_(other.data_)
     {
-        glGenBuffers(1, &id_);
-
-        if(id_ == 0)
-            throw std::logic_error(
-                "buffer::buffer(const buffer& other) : id is "
-                "equals to 0 after glGenBuffers");
-
         push_data();
     }
 
@@ -111,16 +114,39 @@ public:
 
     /**
      * \brief Puts the buffer in empty state
+     *
+     * The buffer's name goes back to the gl_name_pool
      */
     void clear()
     {
-        glDeleteBuffers(1, &id_);
+        memory_tracker::instance().untrack(to_resource_type(type_), id_);
+        gl_name_pool::instance().release_buffer(id_, size_in_bytes());
         id_ = 0;
         data_.clear();
     }
 
     static buffer_type type() noexcept { return type_; }
 
+    /**
+     * @brief Returns the number of bytes allocated on the GPU for the buffer
+     */
+    std::size_t size_in_bytes() const noexcept
+    {
+        return sizeof(T) * data_.size();
+    }
+
+    /**
+     * @brief Tags the buffer's GPU allocation so it can be found in the
+     * memory_tracker report
+     *
+     * Does nothing if the buffer is empty
+     */
+    void set_tag(std::string tag) const
+    {
+        memory_tracker::instance().set_tag(to_resource_type(type_), id_,
+                                           std::move(tag));
+    }
+
     bool empty() const { return id_ == 0; }
 
     void set_data(std::vector<T> data)
@@ -192,31 +218,50 @@ protected:
      */
     void push_data()
     {
-        // If id_ is equals to zero qui try to
-        // regenerate a buffer id.
-        // The only way for id_ to be equals to zero is if we moved the
-        // buffer
+        const auto bytes = size_in_bytes();
+
+        // If id_ is equals to zero we try to get a buffer id from the pool.
+        // The only way for id_ to be equals to zero is if we moved or
+        // cleared the buffer
         if(id_ == 0)
-            glGenBuffers(1, &id_);
+        {
+            id_ = gl_name_pool::instance().acquire_buffer(bytes);
 
-        bind();
-        const auto s = static_cast<GLsizei>(sizeof(T) * data_.size());
+            if(id_ == 0)
+                throw std::logic_error(
+                    "buffer::push_data : id is equals to 0 after "
+                    "glGenBuffers");
+        }
 
+        // The storage is always specified again, so the driver can orphan the
+        // previous one instead of waiting for the draw calls still using it
         switch(type_)
         {
             case buffer_type::array_buffer:
-                glBufferData(GL_ARRAY_BUFFER, s, data_.data(), GL_STATIC_DRAW);
+                bind();
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes),
+                             data_.data(), GL_STATIC_DRAW);
                 break;
 
             case buffer_type::element_array_buffer:
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, s, data_.data(),
-                             GL_STATIC_DRAW);
+                // Filled through GL_ARRAY_BUFFER : binding it to
+                // GL_ELEMENT_ARRAY_BUFFER would attach it to the vertex
+                // array currently bound, which other meshes of the same
+                // layout share
+                glBindBuffer(GL_ARRAY_BUFFER, id_);
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes),
+                             data_.data(), GL_STATIC_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
                 break;
 
             case buffer_type::uniform:
-                glBufferData(GL_UNIFORM_BUFFER, s, data_.data(),
-                             GL_DYNAMIC_DRAW);
+                bind();
+                glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(bytes),
+                             data_.data(), GL_DYNAMIC_DRAW);
         }
+
+        memory_tracker::instance().track(to_resource_type(type_), id_,
+                                         size_in_bytes());
     }
     std::vector<T> data_;
     unsigned       id_ {0};
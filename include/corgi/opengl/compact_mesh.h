@@ -0,0 +1,134 @@
+#pragma once
+
+#include <corgi/opengl/layout_registry.h>
+#include <corgi/opengl/vertex_array.h>
+#include <corgi/opengl/vertex_array_cache.h>
+#include <corgi/opengl/vertex_layout.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace corgi
+{
+
+/**
+ * @brief Mesh stored on the GPU only, small enough to be kept by value in
+ * contiguous arrays
+ *
+ * A mesh keeps a copy of its geometry on the CPU. A compact_mesh only holds
+ * the OpenGL names of its buffers, the counts, the layout id and the
+ * primitive. Like meshes, it reads its vertices through the vertex array
+ * shared by its layout, see vertex_array_cache. The geometry is read from
+ * spans when the mesh is uploaded and isn't kept : callers that need it on
+ * the CPU keep it themselves, once.
+ *
+ * Names come from and go back to the gl_name_pool.
+ */
+class compact_mesh
+{
+public:
+    /**
+     * @brief Creates an empty compact_mesh
+     */
+    compact_mesh() = default;
+
+    /**
+     * @brief Uploads the geometry to the GPU
+     *
+     * @param vertices Vertices laid out as described by the layout
+     * @param indexes Stored with the smallest index_type able to hold them,
+     * uint16 at least
+     *
+     * @throws std::invalid_argument If vertices or indexes is empty, or if the
+     * size of vertices isn't a multiple of the layout's stride
+     */
+    compact_mesh(std::span<const std::byte> vertices,
+                 std::span<const unsigned>  indexes,
+                 layout_id                  layout,
+                 primitive_type primitive = primitive_type::triangles);
+
+    /**
+     * @brief Uploads indexes that are already packed, for instance straight
+     * from a mapped mesh_file
+     *
+     * @param indexes Indexes stored as described by type
+     *
+     * @throws std::invalid_argument If vertices or indexes is empty, or if
+     * their sizes don't match the layout's stride or the index type
+     */
+    compact_mesh(std::span<const std::byte> vertices,
+                 std::span<const std::byte> indexes,
+                 corgi::index_type          type,
+                 layout_id                  layout,
+                 primitive_type primitive = primitive_type::triangles);
+
+    compact_mesh(std::span<const float>    vertices,
+                 std::span<const unsigned> indexes,
+                 layout_id                 layout,
+                 primitive_type primitive = primitive_type::triangles);
+
+    /**
+     * @brief Uploads vertex structs described by a vertex_layout
+     */
+    template<has_vertex_layout Vertex>
+    compact_mesh(std::span<const Vertex>   vertices,
+                 std::span<const unsigned> indexes,
+                 primitive_type primitive = primitive_type::triangles)
+        : compact_mesh(std::as_bytes(vertices),
+                       indexes,
+                       layout_of<Vertex>(),
+                       primitive)
+    {
+    }
+
+    compact_mesh(const compact_mesh& other)            = delete;
+    compact_mesh& operator=(const compact_mesh& other) = delete;
+
+    compact_mesh(compact_mesh&& other) noexcept;
+    compact_mesh& operator=(compact_mesh&& other) noexcept;
+
+    ~compact_mesh();
+
+    /**
+     * @brief Releases the OpenGL objects and puts the mesh in an empty state
+     */
+    void clear();
+
+    bool empty() const noexcept { return vertex_buffer_ == 0; }
+
+    unsigned vertex_buffer() const noexcept { return vertex_buffer_; }
+    unsigned index_buffer() const noexcept { return index_buffer_; }
+
+    std::uint32_t     vertex_count() const noexcept { return vertex_count_; }
+    std::uint32_t     index_count() const noexcept { return index_count_; }
+    layout_id         layout() const noexcept { return layout_; }
+    primitive_type    primitive() const noexcept { return primitive_; }
+    corgi::index_type index_type() const noexcept { return index_type_; }
+
+    /**
+     * @brief Returns the number of bytes the mesh uses on the GPU
+     */
+    std::size_t size_in_bytes() const;
+
+    /**
+     * @brief Binds the layout's vertex array from the cache, reading from
+     * the mesh's buffers
+     */
+    void bind(vertex_array_cache& vertex_arrays) const;
+
+private:
+    void release() noexcept;
+
+    unsigned          vertex_buffer_ {0};
+    unsigned          index_buffer_ {0};
+    std::uint32_t     vertex_count_ {0};
+    std::uint32_t     index_count_ {0};
+    layout_id         layout_ {0};
+    primitive_type    primitive_ {primitive_type::triangles};
+    corgi::index_type index_type_ {index_type::uint16};
+};
+
+static_assert(sizeof(compact_mesh) <= 32,
+              "compact_mesh must stay small enough for contiguous arrays");
+}    // namespace corgi
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/occlusion_buffer.h>
+#include <corgi/opengl/thread_pool.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+class aabb_tree;
+
+/**
+ * @brief The 6 planes bounding what a camera sees
+ *
+ * Each plane is (a, b, c, d) with a point p inside when
+ * a * p.x + b * p.y + c * p.z + d >= 0. Planes are normalized
+ */
+struct frustum
+{
+    // Left, right, bottom, top, near and far
+    std::array<std::array<float, 4>, 6> planes {};
+
+    /**
+     * @brief Extracts the planes of a view projection matrix, stored column
+     * by column, for OpenGL's clip space
+     */
+    static frustum from_matrix(const matrix4& view_projection);
+
+    /**
+     * @brief Returns the frustum of an orthographic projection, with the same
+     * arguments as Matrix::ortho
+     */
+    static frustum orthographic(float left,
+                                float right,
+                                float bottom,
+                                float top,
+                                float z_near,
+                                float z_far);
+
+    /**
+     * @brief Returns true if the box is at least partly inside
+     */
+    bool intersects(const aabb& box) const noexcept;
+};
+
+/**
+ * @brief Area of the 2D world shown on screen, for scenes that don't need
+ * a frustum
+ */
+struct view_rect
+{
+    float left {0.0F};
+    float bottom {0.0F};
+    float right {0.0F};
+    float top {0.0F};
+
+    bool intersects(const aabb& box) const noexcept;
+};
+
+/**
+ * @brief Bounds of the objects to cull, stored as structure of arrays
+ *
+ * Each box is kept as its center and extent, one array per component, so 4
+ * boxes are tested at once against a plane. Objects are identified by the
+ * index add() returned, which the visible lists refer to.
+ */
+class cull_set
+{
+public:
+    /**
+     * @brief Adds the bounds of an object and returns its index
+     *
+     * An empty box is never visible
+     */
+    std::uint32_t add(const aabb& bounds);
+
+    /**
+     * @brief Replaces the bounds of an object that moved
+     */
+    void set(std::uint32_t index, const aabb& bounds);
+
+    /**
+     * @brief Returns the bounds of an object, rebuilt from its center and
+     * extent
+     */
+    aabb bounds(std::uint32_t index) const;
+
+    void reserve(std::size_t count);
+    void clear() noexcept;
+
+    std::size_t size() const noexcept { return size_; }
+    bool        empty() const noexcept { return size_ == 0; }
+
+    // Arrays are padded with empty boxes to a multiple of 4
+    std::span<const float> center_x() const noexcept { return center_x_; }
+    std::span<const float> center_y() const noexcept { return center_y_; }
+    std::span<const float> center_z() const noexcept { return center_z_; }
+    std::span<const float> extent_x() const noexcept { return extent_x_; }
+    std::span<const float> extent_y() const noexcept { return extent_y_; }
+    std::span<const float> extent_z() const noexcept { return extent_z_; }
+
+private:
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> extent_x_;
+    std::vector<float> extent_y_;
+    std::vector<float> extent_z_;
+
+    std::size_t size_ {0};
+};
+
+/**
+ * @brief Finds the objects of a cull_set that can be seen, before anything is
+ * sent to the renderer
+ *
+ * The visible list holds the indexes of the visible objects, sorted. Feed it
+ * to renderer::draw when the set was built from the ranges of a
+ * static_batch, or use it to pick the meshes to draw.
+ *
+ * Large sets are split across the threads of the pool. Scratch lists are
+ * kept between calls, culling allocates nothing once they've grown.
+ */
+class culling_stage
+{
+public:
+    /**
+     * @param pool Threads to split large sets across, nullptr to cull on the
+     * calling thread only
+     * @param min_chunk Fewest objects a thread is given
+     */
+    explicit culling_stage(thread_pool* pool      = nullptr,
+                           std::size_t  min_chunk = 16384);
+
+    std::span<const std::uint32_t> cull(const cull_set& set,
+                                        const frustum&  view);
+
+    std::span<const std::uint32_t> cull(const cull_set& set,
+                                        const view_rect& view);
+
+    /**
+     * @brief Builds the visible list from the objects of the tree, for large
+     * 2D scenes where only a small part is on screen
+     */
+    std::span<const std::uint32_t> cull(const aabb_tree& tree,
+                                        const view_rect& view);
+
+    /**
+     * @brief Removes from the visible list the objects hidden in the
+     * occlusion buffer, which must have been rendered with the same view
+     *
+     * Optional pass for dense 3D scenes, run after cull
+     */
+    std::span<const std::uint32_t> remove_occluded(
+        const cull_set&         set,
+        const occlusion_buffer& occlusion,
+        const matrix4&          view_projection);
+
+    /**
+     * @brief Returns the list built by the last call to cull
+     */
+    std::span<const std::uint32_t> visible() const noexcept
+    {
+        return visible_;
+    }
+
+private:
+    template<class Test>
+    std::span<const std::uint32_t> run(const cull_set& set, const Test& test);
+
+    thread_pool* pool_;
+    std::size_t  min_chunk_;
+
+    std::vector<std::uint32_t>              visible_;
+    std::vector<std::vector<std::uint32_t>> chunks_;
+};
+}    // namespace corgi
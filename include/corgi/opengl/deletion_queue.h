@@ -0,0 +1,117 @@
+#pragma once
+
+#include <corgi/opengl/memory_tracker.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace corgi
+{
+
+enum class gl_object : char
+{
+    buffer,
+    vertex_array,
+    texture,
+    shader,
+    program,
+    renderbuffer,
+    framebuffer,
+    query
+};
+
+/**
+ * @brief Delays the deletion of OpenGL objects until the GPU is done with
+ * them
+ *
+ * Deleting an object the GPU may still be using can force the driver to
+ * synchronize, and glDelete* can only be called from the thread owning the
+ * context. Destructors retire their objects here instead, from any thread.
+ * Objects retired with their resource type stay counted by the
+ * memory_tracker until they're deleted, since their storage is still there.
+ *
+ * Objects retired during a frame are put in a batch when end_frame() is
+ * called, along with a fence. A batch is deleted once it's at least
+ * frames_in_flight() frames old and its fence is signaled. end_frame() never
+ * waits for a fence : batches that aren't done yet are checked again on the
+ * next frame.
+ *
+ * end_frame() and flush() must be called from the thread owning the context.
+ */
+class deletion_queue
+{
+public:
+    static deletion_queue& instance();
+
+    deletion_queue(const deletion_queue& other)            = delete;
+    deletion_queue& operator=(const deletion_queue& other) = delete;
+
+    /**
+     * @brief Queues the object for deletion. Ignores id 0. Thread safe
+     */
+    void retire(gl_object type, unsigned id);
+
+    /**
+     * @brief Queues the object for deletion, its storage staying registered
+     * to the memory_tracker until it's actually deleted. Thread safe
+     *
+     * @param tracked Type the object is tracked as
+     */
+    void retire(gl_object type, unsigned id, resource_type tracked);
+
+    /**
+     * @brief Closes the current frame's batch and deletes the batches the GPU
+     * is done with
+     */
+    void end_frame();
+
+    /**
+     * @brief Deletes every retired object right away
+     *
+     * Used before destroying the context, or when the memory is needed now
+     */
+    void flush();
+
+    /**
+     * @brief Returns the number of times end_frame() was called
+     */
+    std::uint64_t frame() const noexcept;
+
+    void     set_frames_in_flight(unsigned frames) noexcept;
+    unsigned frames_in_flight() const noexcept;
+
+    /**
+     * @brief Returns the number of objects waiting to be deleted
+     */
+    std::size_t pending() const;
+
+private:
+    deletion_queue() = default;
+
+    struct object
+    {
+        gl_object     type;
+        unsigned      id;
+        bool          tracked {false};
+        resource_type tracked_type {resource_type::vertex_buffer};
+    };
+
+    struct batch
+    {
+        std::vector<object> objects;
+        void*               fence {nullptr};
+        std::uint64_t       frame {0};
+    };
+
+    static void destroy(const std::vector<object>& objects);
+
+    mutable std::mutex  mutex_;
+    std::vector<object> current_;
+    std::deque<batch>   batches_;
+    std::uint64_t       frame_ {0};
+    unsigned            frames_in_flight_ {2};
+};
+}    // namespace corgi
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <corgi/opengl/layout_registry.h>
+#include <corgi/opengl/memory_tracker.h>
+#include <corgi/opengl/vertex_array.h>
+#include <corgi/opengl/vertex_array_cache.h>
+#include <corgi/opengl/vertex_layout.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief How a dynamic_mesh sends new data to its buffers
+ */
+enum class update_mode : char
+{
+    // glBufferData with no data, then glBufferSubData. The driver gives the
+    // buffer new storage if the GPU still reads the old one
+    orphan,
+    // glMapBufferRange with the invalidate bit, the data is written straight
+    // to the mapping
+    map_range
+};
+
+/**
+ * @brief Mesh whose geometry changes every frame, like particles, trails or
+ * live charts
+ *
+ * The buffers are created once and keep their names : when the geometry
+ * doesn't fit anymore, their storage grows to at least twice its previous
+ * capacity, so updating a mesh that grows slowly rarely reallocates. Like
+ * every mesh, it reads its vertices through the vertex array shared by its
+ * layout, see vertex_array_cache.
+ *
+ * Only a range of the indexes is drawn, the whole geometry by default.
+ */
+class dynamic_mesh
+{
+public:
+    /**
+     * @brief Creates an empty dynamic_mesh, with no buffers
+     */
+    dynamic_mesh() = default;
+
+    /**
+     * @param vertex_capacity Bytes reserved for the vertices, 0 to allocate
+     * on the first update
+     * @param index_capacity Number of indexes reserved
+     */
+    explicit dynamic_mesh(layout_id      layout,
+                          primitive_type primitive = primitive_type::triangles,
+                          update_mode    mode      = update_mode::orphan,
+                          std::size_t    vertex_capacity = 0,
+                          std::size_t    index_capacity  = 0);
+
+    dynamic_mesh(const dynamic_mesh& other)            = delete;
+    dynamic_mesh& operator=(const dynamic_mesh& other) = delete;
+
+    dynamic_mesh(dynamic_mesh&& other) noexcept;
+    dynamic_mesh& operator=(dynamic_mesh&& other) noexcept;
+
+    ~dynamic_mesh();
+
+    /**
+     * @brief Replaces the whole geometry and draws all of it
+     *
+     * @throws std::invalid_argument If the size of vertices isn't a multiple
+     * of the layout's stride
+     * @throws std::logic_error If the mesh was default constructed
+     */
+    void update(std::span<const std::byte> vertices,
+                std::span<const unsigned>  indexes);
+
+    void update(std::span<const float>    vertices,
+                std::span<const unsigned> indexes);
+
+    /**
+     * @brief Overwrites some vertices in place, without touching the others
+     * nor the indexes
+     *
+     * @throws std::out_of_range If the vertices go past the current vertex
+     * count
+     */
+    void update_vertices(std::size_t first_vertex,
+                         std::span<const std::byte> vertices);
+
+    /**
+     * @brief Makes sure the buffers can hold the given sizes without growing
+     *
+     * Growing a buffer gives it new storage : if it happens, the mesh is
+     * emptied and must be updated again
+     */
+    void reserve(std::size_t vertex_bytes, std::size_t index_count);
+
+    /**
+     * @brief Only draws index_count indexes starting at first_index
+     *
+     * @throws std::out_of_range If the range goes past the index count
+     */
+    void set_draw_range(std::uint32_t first_index, std::uint32_t index_count);
+
+    std::uint32_t first_index() const noexcept { return first_index_; }
+    std::uint32_t draw_count() const noexcept { return draw_count_; }
+
+    /**
+     * @brief Binds the layout's vertex array from the cache, reading from
+     * the mesh's buffers
+     */
+    void bind(vertex_array_cache& vertex_arrays) const;
+
+    bool empty() const noexcept { return index_count_ == 0; }
+
+    unsigned vertex_buffer() const noexcept { return vertex_buffer_; }
+    unsigned index_buffer() const noexcept { return index_buffer_; }
+
+    std::uint32_t     vertex_count() const noexcept { return vertex_count_; }
+    std::uint32_t     index_count() const noexcept { return index_count_; }
+    layout_id         layout() const noexcept { return layout_; }
+    primitive_type    primitive() const noexcept { return primitive_; }
+    corgi::index_type index_type() const noexcept { return index_type_; }
+    update_mode       mode() const noexcept { return mode_; }
+
+    // Capacities of the buffers, in bytes
+    std::size_t vertex_capacity() const noexcept { return vertex_capacity_; }
+    std::size_t index_capacity() const noexcept { return index_capacity_; }
+
+    /**
+     * @brief Number of times a buffer had to grow, for profiling
+     */
+    std::size_t reallocations() const noexcept { return reallocations_; }
+
+private:
+    void release() noexcept;
+
+    /**
+     * @brief Gives the buffer at least the requested capacity, keeping its
+     * name. Returns true if the buffer's storage changed
+     */
+    bool grow(unsigned&     buffer,
+              std::size_t&  capacity,
+              std::size_t   bytes,
+              resource_type type);
+
+    unsigned      vertex_buffer_ {0};
+    unsigned      index_buffer_ {0};
+    std::size_t   vertex_capacity_ {0};
+    std::size_t   index_capacity_ {0};
+    std::uint32_t vertex_count_ {0};
+    std::uint32_t index_count_ {0};
+    std::uint32_t first_index_ {0};
+    std::uint32_t draw_count_ {0};
+    std::size_t   stride_ {0};
+    std::size_t   reallocations_ {0};
+
+    layout_id         layout_ {0};
+    primitive_type    primitive_ {primitive_type::triangles};
+    corgi::index_type index_type_ {index_type::uint16};
+    update_mode       mode_ {update_mode::orphan};
+
+    // Indexes are packed here in orphan mode, kept to avoid an allocation
+    // per update
+    std::vector<std::byte> packed_indexes_;
+};
+
+/**
+ * @brief dynamic_mesh updated with vertex structs
+ *
+ * The layout comes from the Vertex type, so updating the mesh with vertices
+ * of another layout is caught by a static_assert instead of being compared at
+ * runtime
+ */
+template<has_vertex_layout Vertex>
+class dynamic_mesh_of : public dynamic_mesh
+{
+public:
+    /**
+     * @param vertex_capacity Number of vertices reserved
+     * @param index_capacity Number of indexes reserved
+     */
+    explicit dynamic_mesh_of(
+        primitive_type primitive       = primitive_type::triangles,
+        update_mode    mode            = update_mode::orphan,
+        std::size_t    vertex_capacity = 0,
+        std::size_t    index_capacity  = 0)
+        : dynamic_mesh(layout_of<Vertex>(),
+                       primitive,
+                       mode,
+                       vertex_capacity * sizeof(Vertex),
+                       index_capacity)
+    {
+    }
+
+    /**
+     * @brief Replaces the whole geometry and draws all of it. Other is
+     * usually Vertex, but any struct with the same layout is accepted
+     */
+    template<has_vertex_layout Other>
+    void update(std::span<const Other>    vertices,
+                std::span<const unsigned> indexes)
+    {
+        static_assert(layout_matches<Other>(vertex_layout<Vertex>::attributes),
+                      "Vertex doesn't have the mesh's layout");
+
+        dynamic_mesh::update(std::as_bytes(vertices), indexes);
+    }
+
+    /**
+     * @brief Overwrites some vertices in place, without touching the others
+     * nor the indexes
+     *
+     * @throws std::out_of_range If the vertices go past the current vertex
+     * count
+     */
+    void update_vertices(std::size_t             first_vertex,
+                         std::span<const Vertex> vertices)
+    {
+        dynamic_mesh::update_vertices(first_vertex, std::as_bytes(vertices));
+    }
+};
+}    // namespace corgi
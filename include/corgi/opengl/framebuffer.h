@@ -0,0 +1,182 @@
+#pragma once
+
+#include <corgi/opengl/renderbuffer.h>
+#include <corgi/opengl/texture.h>
+
+#include <vector>
+
+namespace corgi
+{
+
+enum class attachment : char
+{
+    color0,
+    color1,
+    color2,
+    color3,
+    depth,
+    stencil,
+    depth_stencil
+};
+
+constexpr int max_color_attachments = 4;
+
+/**
+ * @brief Render target made of textures and renderbuffers
+ *
+ * Binding a framebuffer redirects the draw calls to its attachments instead of
+ * the window. Rendering to a texture attachment is how we render a pass once
+ * and sample the result many times later on.
+ *
+ * The framebuffer doesn't own its attachments, they must outlive it. Its size
+ * is the size of the first attachment.
+ *
+ * Operations that need to bind the framebuffer bind the default target back
+ * when they are done.
+ *
+ * Multisampled attachments can't be sampled, they must be resolved in a
+ * non multisampled framebuffer with resolve() or blit_to().
+ */
+class framebuffer
+{
+public:
+    framebuffer();
+
+    framebuffer(const framebuffer& other) = delete;
+    framebuffer(framebuffer&& other) noexcept;
+
+    framebuffer& operator=(const framebuffer& other) = delete;
+    framebuffer& operator=(framebuffer&& other) noexcept;
+
+    ~framebuffer();
+
+    /**
+     * @brief Attaches one level of a texture to the framebuffer
+     *
+     * @throws std::logic_error If the texture is empty or its size doesn't
+     * match the size of the previous attachments
+     */
+    void attach(attachment point, const texture& texture, int level = 0);
+
+    /**
+     * @throws std::logic_error If the renderbuffer is empty, or if its size or
+     * sample count doesn't match the previous attachments
+     */
+    void attach(attachment point, const renderbuffer& renderbuffer);
+
+    void detach(attachment point);
+
+    /**
+     * @brief Returns true if the framebuffer can be rendered to
+     */
+    bool complete() const;
+
+    /**
+     * @brief Binds the framebuffer for both drawing and reading, and sets the
+     * viewport to its size
+     *
+     * @throws std::logic_error If the framebuffer is empty
+     */
+    void bind() const;
+
+    /**
+     * @brief Binds the default target back, and restores the viewport if the
+     * default target's size is known
+     */
+    static void unbind();
+
+    /**
+     * @brief Sets the framebuffer used as the default target
+     *
+     * The default target is the window's framebuffer (0) unless rendering
+     * happens offscreen, like with the headless_context. Framebuffer
+     * operations bind the default target back when they are done.
+     *
+     * @param width,height Size of the default target, 0 if unknown
+     */
+    static void set_default_target(unsigned id,
+                                   unsigned width  = 0,
+                                   unsigned height = 0) noexcept;
+
+    static unsigned default_target() noexcept;
+
+    /**
+     * @brief Copies the content of the framebuffer into another one
+     *
+     * This is how multisampled attachments are resolved. The target may only
+     * be multisampled if it has the same sample count as the framebuffer.
+     * When either side is multisampled, both must have the same size.
+     * Otherwise, if sizes differ, the image is stretched using the given
+     * filter, which must be nearest when copying depth or stencil.
+     *
+     * @throws std::logic_error If the target is multisampled with a different
+     * sample count, or if either side is multisampled and the sizes differ
+     */
+    void blit_to(const framebuffer& target,
+                 bool               color   = true,
+                 bool               depth   = false,
+                 bool               stencil = false,
+                 mag_filter         filter  = mag_filter::nearest) const;
+
+    /**
+     * @brief Copies the content of the framebuffer into the framebuffer with
+     * the given id, 0 being the window
+     *
+     * @throws std::logic_error If the framebuffer is multisampled and the
+     * sizes differ
+     */
+    void blit_to(unsigned   target_id,
+                 unsigned   target_width,
+                 unsigned   target_height,
+                 bool       color   = true,
+                 bool       depth   = false,
+                 bool       stencil = false,
+                 mag_filter filter  = mag_filter::nearest) const;
+
+    /**
+     * @brief Resolves the multisampled color attachment 0 into the target's
+     * color attachment 0
+     *
+     * @throws std::logic_error Like blit_to, if the target has another size
+     * or is multisampled with a different sample count
+     */
+    void resolve(const framebuffer& target) const;
+
+    /**
+     * @brief Tells the driver the content of the given attachments isn't
+     * needed anymore
+     *
+     * Usually done on depth/stencil attachments at the end of a pass, or on
+     * multisampled attachments once they are resolved. Tiled GPUs can then
+     * skip writing them back to memory.
+     */
+    void invalidate(const std::vector<attachment>& points) const;
+
+    /**
+     * @brief Invalidates every attachment of the framebuffer
+     */
+    void invalidate() const;
+
+    unsigned id() const noexcept;
+    unsigned width() const noexcept;
+    unsigned height() const noexcept;
+    int      samples() const noexcept;
+
+private:
+    void clear();
+    void check_size(unsigned width, unsigned height, int samples);
+    void update_draw_buffers() const;
+
+    static unsigned default_id_;
+    static unsigned default_width_;
+    static unsigned default_height_;
+
+    unsigned id_ {0};
+    unsigned width_ {0};
+    unsigned height_ {0};
+    int      samples_ {0};
+
+    // Attachment points currently in use
+    std::vector<attachment> attachments_;
+};
+}    // namespace corgi
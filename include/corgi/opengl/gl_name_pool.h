@@ -0,0 +1,230 @@
+#pragma once
+
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Counters of a gl_name_pool, per kind of object
+ */
+struct pool_statistics
+{
+    // Names handed out by acquire
+    std::size_t acquired {0};
+    // Names that came from the pool instead of glGen*
+    std::size_t recycled {0};
+    // Names given back to the pool
+    std::size_t released {0};
+    // Names that didn't fit in the pool and went to the deletion_queue
+    std::size_t overflowed {0};
+    // Names currently waiting in the pool
+    std::size_t pooled {0};
+
+    /**
+     * @brief Returns the share of acquired names that were recycled, between
+     * 0 and 1
+     */
+    double hit_rate() const noexcept;
+};
+
+/**
+ * @brief Keeps the names of destroyed buffers, vertex arrays and textures so
+ * new objects can reuse them instead of calling glGen* and glDelete*
+ *
+ * Buffers are bucketed by size, rounded up to the next power of two. Buffers
+ * bigger than max_pooled_buffer_size aren't pooled. A recycled buffer's
+ * storage is always specified again with glBufferData, which lets the driver
+ * orphan the previous storage, so the name can be reused right away even if
+ * the GPU is still reading it. Drivers usually recycle storage of the same
+ * size, hence the buckets.
+ *
+ * Textures are bucketed by internal format and size, and only come back once
+ * the deletion_queue's frames in flight are over, so their storage can be
+ * updated with glTexSubImage2D without waiting for the GPU. A recycled
+ * texture isn't cleared : until its new owner writes every texel, it shows
+ * what the previous owner left in it.
+ *
+ * Pooled names keep their storage. It's registered to the memory_tracker as
+ * pooled_buffer or pooled_texture, and the pool never holds more than
+ * max_pooled_bytes : past it, the oldest names go to the deletion_queue.
+ *
+ * Vertex arrays are plain names. The pool remembers which attribute
+ * locations they left enabled so the next owner can disable the ones it
+ * doesn't use.
+ *
+ * Releasing is thread safe. Acquiring may call glGen* and must be done from
+ * the thread owning the context. When a bucket is full, released names go
+ * to the deletion_queue.
+ */
+class gl_name_pool
+{
+public:
+    static constexpr std::size_t max_pooled_buffer_size = 1u << 20;
+    static constexpr std::size_t default_max_pooled_bytes = 64u << 20;
+
+    struct vertex_array_name
+    {
+        unsigned      id {0};
+        std::uint32_t enabled_attributes {0};
+    };
+
+    struct texture_name
+    {
+        unsigned id {0};
+        // True if the name already has storage of the requested format and
+        // size
+        bool has_storage {false};
+    };
+
+    static gl_name_pool& instance();
+
+    gl_name_pool(const gl_name_pool& other)            = delete;
+    gl_name_pool& operator=(const gl_name_pool& other) = delete;
+
+    /**
+     * @brief Returns the size of the bucket a buffer of the given size goes
+     * to, 0 if the buffer is too big to be pooled
+     */
+    static std::size_t buffer_bucket(std::size_t bytes) noexcept;
+
+    /**
+     * @brief Returns a buffer name from the bucket matching the size the
+     * buffer will be filled with
+     */
+    unsigned acquire_buffer(std::size_t bytes);
+
+    /**
+     * @param bytes Size of the buffer's storage
+     */
+    void release_buffer(unsigned id, std::size_t bytes);
+
+    vertex_array_name acquire_vertex_array();
+
+    /**
+     * @param enabled_attributes Bit i is set if attribute location i is
+     * enabled on the vertex array
+     */
+    void release_vertex_array(unsigned id, std::uint32_t enabled_attributes);
+
+    /**
+     * @param levels Number of mipmap levels the texture counts, textures
+     * only share names with the same level count
+     */
+    texture_name acquire_texture(internal_format format,
+                                 unsigned        width,
+                                 unsigned        height,
+                                 unsigned        levels);
+    void         release_texture(unsigned        id,
+                                 internal_format format,
+                                 unsigned        width,
+                                 unsigned        height,
+                                 unsigned        levels);
+
+    /**
+     * @brief Sets how many names each bucket can keep. Default is 16
+     */
+    void        set_max_per_bucket(std::size_t count);
+    std::size_t max_per_bucket() const;
+
+    /**
+     * @brief Sets the most bytes of storage the pooled buffers and textures
+     * can hold, trimming the pool if it holds more
+     */
+    void        set_max_pooled_bytes(std::size_t bytes);
+    std::size_t max_pooled_bytes() const;
+
+    /**
+     * @brief Sends the oldest pooled buffers and textures to the
+     * deletion_queue until at most max_bytes are pooled
+     */
+    void trim(std::size_t max_bytes);
+
+    /**
+     * @brief Trims the pool down to max_pooled_bytes
+     */
+    void trim();
+
+    /**
+     * @param type Only buffer, vertex_array and texture are pooled
+     */
+    pool_statistics statistics(gl_object type) const;
+    void            reset_statistics();
+
+    /**
+     * @brief Returns the GPU memory held by the pooled buffers and textures
+     */
+    std::size_t pooled_bytes() const;
+
+    /**
+     * @brief Prints the hit rate of every pool and the content of the buckets
+     */
+    void dump(std::ostream& stream) const;
+
+    /**
+     * @brief Sends every pooled name to the deletion_queue
+     */
+    void clear();
+
+private:
+    gl_name_pool() = default;
+
+    struct pooled_name
+    {
+        unsigned      id;
+        std::size_t   bytes;
+        // Order the names were released in, to trim the oldest first
+        std::uint64_t order;
+        std::uint64_t released_frame;
+    };
+
+    struct evicted_name
+    {
+        gl_object type;
+        unsigned  id;
+        // True if the name's storage is tracked as pooled
+        bool pooled;
+    };
+
+    static std::uint64_t texture_key(internal_format format,
+                                     unsigned        width,
+                                     unsigned        height,
+                                     unsigned        levels) noexcept;
+
+    pool_statistics& stats(gl_object type);
+
+    /**
+     * @brief Removes the oldest names from the buckets until at most
+     * max_bytes are pooled. Called with the mutex locked, the names must be
+     * retired once it's unlocked
+     */
+    void evict(std::size_t max_bytes, std::vector<evicted_name>& evicted);
+
+    static void retire(const std::vector<evicted_name>& evicted);
+
+    mutable std::mutex mutex_;
+
+    std::size_t   max_per_bucket_ {16};
+    std::size_t   max_pooled_bytes_ {default_max_pooled_bytes};
+    std::size_t   pooled_bytes_ {0};
+    std::uint64_t next_order_ {0};
+
+    // Keyed by bucket size, oldest names first
+    std::map<std::size_t, std::vector<pooled_name>> buffers_;
+    std::vector<vertex_array_name>                  vertex_arrays_;
+    // Keyed by texture_key, oldest names first
+    std::map<std::uint64_t, std::vector<pooled_name>> textures_;
+
+    pool_statistics buffer_stats_;
+    pool_statistics vertex_array_stats_;
+    pool_statistics texture_stats_;
+};
+}    // namespace corgi
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <corgi/opengl/image.h>
+
+#include <memory>
+
+namespace corgi
+{
+class framebuffer;
+class renderbuffer;
+
+/**
+ * @brief Creates an OpenGL context that doesn't need a window or a display
+ *
+ * The context is created through EGL, using a surfaceless context when the
+ * driver supports it (Mesa's llvmpipe does) and falling back on a small
+ * pbuffer otherwise. Either way, the pixels are rendered inside a framebuffer
+ * object of the requested size that replaces the window's default target, so
+ * the renderer can be used as is. That framebuffer is registered as the
+ * default target with framebuffer::set_default_target().
+ *
+ * The context is made current and the OpenGL functions are loaded in the
+ * constructor, so the headless_context must be constructed before any other
+ * object of the library.
+ */
+class headless_context
+{
+public:
+    /**
+     * @throws std::runtime_error If EGL or the OpenGL context can't be
+     * initialized
+     */
+    headless_context(unsigned width, unsigned height);
+
+    headless_context(const headless_context& other) = delete;
+    headless_context(headless_context&& other)      = delete;
+
+    headless_context& operator=(const headless_context& other) = delete;
+    headless_context& operator=(headless_context&& other)      = delete;
+
+    ~headless_context();
+
+    /**
+     * @brief Makes the context current on the calling thread and binds its
+     * default target
+     */
+    void make_current();
+
+    /**
+     * @brief Binds the framebuffer object used as a default target and
+     * resets the viewport to its size
+     */
+    void bind_default_target() const;
+
+    /**
+     * @brief Returns the id of the framebuffer object used as a default
+     * target
+     */
+    unsigned default_target() const noexcept;
+
+    unsigned width() const noexcept;
+    unsigned height() const noexcept;
+
+    /**
+     * @brief Reads back the content of the default target as RGBA pixels
+     *
+     * This call waits for the GPU to be done with the rendering
+     */
+    image read_pixels() const;
+
+private:
+    void create_default_target();
+
+    /**
+     * @brief Deletes the default target then destroys the context, surface
+     * and display
+     */
+    void release() noexcept;
+
+    // Stored as void* so EGL headers don't leak in the library's interface
+    void* display_ {nullptr};
+    void* context_ {nullptr};
+    void* surface_ {nullptr};
+
+    unsigned width_;
+    unsigned height_;
+
+    std::unique_ptr<renderbuffer> color_;
+    std::unique_ptr<renderbuffer> depth_stencil_;
+    std::unique_ptr<framebuffer>  framebuffer_;
+};
+}    // namespace corgi
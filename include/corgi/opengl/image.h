@@ -8,10 +8,26 @@ namespace corgi
 
 struct image
 {
+    /**
+     * @brief Decodes an image file, converting its pixels to rgba
+     *
+     * @throws std::runtime_error If the file couldn't be read or decoded
+     */
     static image load(const std::string& path);
 
+    /**
+     * @brief Writes the image in a png file
+     *
+     * Rows are stored bottom to top like OpenGL does, so they are written in
+     * reverse order. Safe to call from several threads at once
+     *
+     * @return false if the file couldn't be written
+     */
+    bool save_png(const std::string& path) const;
+
     std::vector<unsigned char> data;
     int                        width;
     int                        height;
+    int                        channels {4};
 };
 }    // namespace corgi
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+enum class index_type : char
+{
+    uint8,
+    uint16,
+    uint32
+};
+
+constexpr std::size_t index_type_size(index_type type) noexcept
+{
+    switch(type)
+    {
+        case index_type::uint8:
+            return 1;
+        case index_type::uint16:
+            return 2;
+        case index_type::uint32:
+            return 4;
+    }
+    return 4;
+}
+
+/**
+ * @brief Returns the smallest index type able to address the given vertex
+ *
+ * uint8 is only picked when allowed : many GPUs don't fetch 8 bits indexes
+ * natively and convert them in the driver, so uint16 is the default minimum
+ */
+constexpr index_type select_index_type(std::uint32_t max_index,
+                                       bool allow_uint8 = false) noexcept
+{
+    if(allow_uint8 && max_index <= 0xFF)
+        return index_type::uint8;
+    if(max_index <= 0xFFFF)
+        return index_type::uint16;
+    return index_type::uint32;
+}
+
+/**
+ * @brief Returns the smallest index type able to hold every index
+ */
+inline index_type select_index_type(std::span<const unsigned> indexes,
+                                    bool allow_uint8 = false) noexcept
+{
+    if(indexes.empty())
+        return select_index_type(0u, allow_uint8);
+    return select_index_type(*std::max_element(indexes.begin(), indexes.end()),
+                             allow_uint8);
+}
+
+/**
+ * @brief Converts the indexes to the given type and writes them to
+ * destination, which must hold indexes.size() * index_type_size(type) bytes.
+ * Lets callers write straight to a mapped buffer
+ */
+inline void pack_indexes(std::span<const unsigned> indexes,
+                         index_type                type,
+                         std::byte*                destination)
+{
+    auto copy = [&]<class T>(T)
+    {
+        for(std::size_t i = 0; i < indexes.size(); i++)
+        {
+            const auto value = static_cast<T>(indexes[i]);
+            std::memcpy(destination + i * sizeof(T), &value, sizeof(T));
+        }
+    };
+
+    switch(type)
+    {
+        case index_type::uint8:
+            copy(std::uint8_t {});
+            break;
+        case index_type::uint16:
+            copy(std::uint16_t {});
+            break;
+        case index_type::uint32:
+            copy(std::uint32_t {});
+            break;
+    }
+}
+
+/**
+ * @brief Converts the indexes to the given type, as stored in an index
+ * buffer. Indexes must fit in the type
+ */
+inline std::vector<std::byte> pack_indexes(std::span<const unsigned> indexes,
+                                           index_type                type)
+{
+    std::vector<std::byte> bytes(indexes.size() * index_type_size(type));
+    pack_indexes(indexes, type, bytes.data());
+    return bytes;
+}
+
+/**
+ * @brief Reads back indexes stored as the given type
+ */
+inline std::vector<unsigned> unpack_indexes(std::span<const std::byte> bytes,
+                                            index_type                 type)
+{
+    std::vector<unsigned> indexes(bytes.size() / index_type_size(type));
+
+    auto copy = [&]<class T>(T)
+    {
+        for(std::size_t i = 0; i < indexes.size(); i++)
+        {
+            T value;
+            std::memcpy(&value, bytes.data() + i * sizeof(T), sizeof(T));
+            indexes[i] = value;
+        }
+    };
+
+    switch(type)
+    {
+        case index_type::uint8:
+            copy(std::uint8_t {});
+            break;
+        case index_type::uint16:
+            copy(std::uint16_t {});
+            break;
+        case index_type::uint32:
+            copy(std::uint32_t {});
+            break;
+    }
+    return indexes;
+}
+
+}    // namespace corgi
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <corgi/opengl/vertex_attribute.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace corgi
+{
+
+using layout_id = std::uint16_t;
+
+/**
+ * @brief Interns vertex layouts so meshes can refer to them through a small
+ * id instead of keeping their own vector of attributes
+ *
+ * Identical attribute vectors share the same id. The stride is computed once,
+ * when the layout is registered.
+ */
+class layout_registry
+{
+public:
+    static layout_registry& instance();
+
+    layout_registry(const layout_registry& other)            = delete;
+    layout_registry& operator=(const layout_registry& other) = delete;
+
+    /**
+     * @brief Returns the id of the layout, registering it if needed
+     *
+     * @throws std::invalid_argument If attributes is empty or uses a
+     * location outside of [0, 32)
+     * @throws std::length_error If every id is already used
+     */
+    layout_id intern(const std::vector<vertex_attribute>& attributes);
+
+    /**
+     * @throws std::out_of_range If the id wasn't returned by intern
+     */
+    const std::vector<vertex_attribute>& attributes(layout_id id) const;
+
+    /**
+     * @brief Returns the size of one vertex, in bytes
+     *
+     * @throws std::out_of_range If the id wasn't returned by intern
+     */
+    std::size_t stride(layout_id id) const;
+
+    std::size_t size() const;
+
+private:
+    layout_registry() = default;
+
+    struct layout
+    {
+        std::vector<vertex_attribute> attributes;
+        std::size_t                   stride;
+    };
+
+    struct hasher
+    {
+        std::size_t
+        operator()(const std::vector<vertex_attribute>& attributes) const noexcept;
+    };
+
+    const layout& get(layout_id id) const;
+
+    mutable std::mutex mutex_;
+
+    // A deque so references returned by attributes stay valid
+    std::deque<layout>                                                layouts_;
+    std::unordered_map<std::vector<vertex_attribute>, layout_id, hasher> ids_;
+};
+}    // namespace corgi
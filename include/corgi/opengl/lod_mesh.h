@@ -0,0 +1,81 @@
+#pragma once
+
+#include <corgi/opengl/mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Range of the index buffer holding one level of detail
+ */
+struct lod_level
+{
+    std::uint32_t first_index {0};
+    std::uint32_t index_count {0};
+    // Error of the level, relative to the mesh's largest extent
+    float error {0.0F};
+};
+
+/**
+ * @brief Mesh with several levels of detail sharing the same vertices
+ *
+ * Coarser levels are made by mesh_optimizer::simplify, which only removes
+ * triangles. Every level is stored in the same index buffer, one after the
+ * other, so picking a level only changes the range given to the draw call.
+ */
+class lod_mesh
+{
+public:
+    /**
+     * @brief Creates an empty lod_mesh
+     */
+    lod_mesh() = default;
+
+    /**
+     * @param data Triangles with a float position at location 0
+     * @param max_levels Number of levels to build, the original included
+     * @param reduction Share of the triangles each level keeps from the
+     * previous one
+     * @param max_error Levels stop once simplifying costs more than this
+     *
+     * @throws std::invalid_argument If data isn't made of triangles or has no
+     * float position
+     */
+    explicit lod_mesh(mesh_data   data,
+                      std::size_t max_levels = 4,
+                      float       reduction  = 0.5F,
+                      float       max_error  = 0.05F);
+
+    const corgi::mesh&            mesh() const noexcept { return mesh_; }
+    const std::vector<lod_level>& levels() const noexcept { return levels_; }
+
+    /**
+     * @brief Returns the coarsest level whose error stays under the given
+     * number of pixels
+     *
+     * @param screen_size Size of the mesh's largest extent on screen, in
+     * pixels. See projected_size
+     */
+    std::size_t select(float screen_size, float max_pixel_error = 1.0F) const;
+
+private:
+    corgi::mesh            mesh_;
+    std::vector<lod_level> levels_;
+};
+
+/**
+ * @brief Returns how many pixels an object of the given size covers on
+ * screen, with a perspective projection
+ *
+ * @param fov_y Vertical field of view, in radians
+ */
+float projected_size(float size,
+                     float distance,
+                     float fov_y,
+                     float viewport_height) noexcept;
+
+}    // namespace corgi
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace corgi
+{
+
+enum class resource_type : char
+{
+    vertex_buffer,
+    index_buffer,
+    uniform_buffer,
+    texture,
+    renderbuffer,
+    pixel_buffer,
+    // Storage kept by the gl_name_pool for names waiting to be recycled
+    pooled_buffer,
+    pooled_texture
+};
+
+constexpr std::size_t resource_type_count = 8;
+
+/**
+ * @brief Describes one live GPU allocation registered to the tracker
+ */
+struct allocation_info
+{
+    resource_type type;
+    unsigned      id;
+    std::size_t   bytes;
+    std::string   tag;
+};
+
+/**
+ * @brief Keeps count of the GPU memory used by the library's resources
+ *
+ * buffers, textures and renderbuffers register their storage size every time
+ * they (re)allocate it and unregister it when they release their OpenGL
+ * object. Sizes are computed from what we asked OpenGL to allocate, so they
+ * are an estimate : drivers may pad or compress the actual storage.
+ *
+ * Allocations are identified by their type and OpenGL id. A tag can be
+ * attached to an allocation so we can know which assets are responsible for
+ * the memory usage.
+ *
+ * The tracker can be used from any thread.
+ */
+class memory_tracker
+{
+public:
+    static memory_tracker& instance();
+
+    /**
+     * @brief Registers the storage of an OpenGL object
+     *
+     * If the object is already tracked, its size is updated and its tag is
+     * kept
+     */
+    void track(resource_type type, unsigned id, std::size_t bytes);
+
+    /**
+     * @brief Unregisters the storage of an OpenGL object. Does nothing if the
+     * object isn't tracked
+     */
+    void untrack(resource_type type, unsigned id);
+
+    /**
+     * @brief Attaches a tag to a tracked allocation
+     *
+     * The tag is kept when the allocation is resized
+     */
+    void set_tag(resource_type type, unsigned id, std::string tag);
+
+    /**
+     * @brief Returns the number of bytes currently allocated
+     */
+    std::size_t current() const;
+    std::size_t current(resource_type type) const;
+
+    /**
+     * @brief Returns the highest number of bytes allocated at the same time
+     * since the start of the program or the last call to reset_peak()
+     */
+    std::size_t peak() const;
+    std::size_t peak(resource_type type) const;
+
+    /**
+     * @brief Returns the number of bytes currently allocated by objects
+     * sharing the given tag
+     */
+    std::size_t tag_total(const std::string& tag) const;
+
+    /**
+     * @brief Returns the current total of every tag in use
+     */
+    std::map<std::string, std::size_t> tag_totals() const;
+
+    /**
+     * @brief Returns the count biggest live allocations, sorted by decreasing
+     * size
+     */
+    std::vector<allocation_info> largest(std::size_t count) const;
+
+    std::size_t allocation_count() const;
+
+    void reset_peak();
+
+    /**
+     * @brief Writes the totals per resource type and per tag, followed by
+     * the count biggest allocations
+     */
+    void dump(std::ostream& stream, std::size_t count = 10) const;
+
+private:
+    memory_tracker() = default;
+
+    static std::uint64_t key(resource_type type, unsigned id) noexcept;
+
+    void add(resource_type type, std::size_t bytes);
+    void remove(resource_type type, std::size_t bytes);
+
+    mutable std::mutex mutex_;
+
+    std::unordered_map<std::uint64_t, allocation_info> allocations_;
+
+    std::size_t current_ {0};
+    std::size_t peak_ {0};
+    std::size_t current_per_type_[resource_type_count] {};
+    std::size_t peak_per_type_[resource_type_count] {};
+};
+
+const char* to_string(resource_type type) noexcept;
+
+}    // namespace corgi
@@ -1,19 +1,80 @@
 #pragma once
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/layout_registry.h>
 #include <corgi/opengl/vertex_array.h>
+#include <corgi/opengl/vertex_layout.h>
 
-#include <memory>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace corgi
 {
+/**
+ * @brief Geometry of a mesh on the CPU, before it is uploaded
+ *
+ * Vertices are laid out as described by the attributes. Passes like the
+ * mesh_optimizer work on it before a mesh is built
+ */
+struct mesh_data
+{
+    std::vector<std::byte>        vertices;
+    std::vector<unsigned>         indexes;
+    std::vector<vertex_attribute> attributes;
+    primitive_type                primitive {primitive_type::triangles};
+
+    /**
+     * @brief Returns the number of vertices, from the attributes' stride
+     */
+    std::size_t vertex_count() const;
+};
+
+/**
+ * @brief Mesh whose geometry is also kept on the CPU, inside its buffers
+ *
+ * Use a compact_mesh when the CPU copy isn't needed
+ */
 class mesh
 {
 public:
+    /**
+     * The indexes are stored with the smallest index_type able to hold them,
+     * uint16 at least
+     */
     mesh(std::vector<float>            vertices,
          std::vector<unsigned>         indexes,
          std::vector<vertex_attribute> vertex_attributes,
          primitive_type primitive_type = primitive_type::triangles);
 
+    /**
+     * @brief Builds a mesh from a raw byte stream, laid out as described by
+     * the attributes. Lets vertices use smaller types than floats
+     */
+    mesh(std::vector<std::byte>        vertices,
+         std::vector<unsigned>         indexes,
+         std::vector<vertex_attribute> vertex_attributes,
+         primitive_type primitive_type = primitive_type::triangles);
+
+    /**
+     * @brief Builds a mesh from vertex structs described by a vertex_layout.
+     * The layout is known at compile time, nothing is described at runtime
+     */
+    template<has_vertex_layout Vertex>
+    mesh(const std::vector<Vertex>& vertices,
+         std::vector<unsigned>      indexes,
+         primitive_type primitive_type = primitive_type::triangles)
+        : mesh(std::vector<std::byte>(
+                   reinterpret_cast<const std::byte*>(vertices.data()),
+                   reinterpret_cast<const std::byte*>(vertices.data() +
+                                                      vertices.size())),
+               std::move(indexes),
+               layout_of<Vertex>(),
+               primitive_type)
+    {
+    }
+
+    explicit mesh(mesh_data data);
+
     mesh();
 
     mesh(const mesh& other);
@@ -23,17 +84,50 @@ public:
     mesh& operator=(mesh&& other) noexcept;
 
     /**
-     * @brief Returns a points to the vertex array object
+     * @brief Returns the id of the mesh's attributes in the layout_registry.
+     * Meshes don't own a vertex array, see vertex_array_cache
      */
-    const corgi::vertex_array* vertex_array() const;
+    layout_id layout() const noexcept;
+
+    const std::vector<vertex_attribute>& attributes() const;
+
+    const buffer<std::byte, buffer_type::array_buffer>* vertex_buffer() const;
 
     /**
-     * @brief Returns the buffer that contains the mesh's indexes
+     * @brief Returns the buffer that contains the mesh's indexes, stored as
+     * index_type()
      */
-    const buffer<unsigned, buffer_type::element_array_buffer>*
+    const buffer<std::byte, buffer_type::element_array_buffer>*
     index_buffer() const;
 
-    const std::vector<unsigned>& indexes() const;
+    /**
+     * @brief Returns a copy of the indexes, widened to unsigned
+     */
+    std::vector<unsigned> indexes() const;
+
+    /**
+     * @brief Returns a copy of the mesh's geometry
+     */
+    mesh_data data() const;
+
+    std::uint32_t     index_count() const noexcept;
+    corgi::index_type index_type() const noexcept;
+    primitive_type    primitive() const noexcept;
+    const std::vector<std::byte>& vertices() const;
+
+    /**
+     * @brief Returns the box around the mesh's positions, in model space
+     *
+     * Computed once when the mesh is built, from the float attribute at
+     * location 0. Empty if the mesh has no such attribute
+     */
+    const aabb& bounds() const noexcept;
+
+    /**
+     * @brief Returns the sphere around the mesh's positions, centered on
+     * bounds()
+     */
+    const corgi::bounding_sphere& bounding_sphere() const noexcept;
 
     /**
      * @brief Returns true if the mesh holds no usable data
@@ -42,17 +136,25 @@ public:
     bool empty() const;
 
 private:
+    mesh(std::vector<std::byte> vertices,
+         std::vector<unsigned>  indexes,
+         layout_id              layout,
+         primitive_type         primitive_type);
+
     void copy_from(const mesh& other);
     void move_from(mesh&& other) noexcept;
     void reset();
 
-    buffer<float, buffer_type::array_buffer>            vertex_buffer_;
-    buffer<unsigned, buffer_type::element_array_buffer> index_buffer_;
+    // The buffers hold the only CPU copy of the geometry
+    buffer<std::byte, buffer_type::array_buffer>         vertex_buffer_;
+    buffer<std::byte, buffer_type::element_array_buffer> index_buffer_;
 
-    std::unique_ptr<corgi::vertex_array> vertex_array_;
+    aabb                   bounds_;
+    corgi::bounding_sphere bounding_sphere_;
 
-    std::vector<float>    vertices_;
-    std::vector<unsigned> indexes_;
-    primitive_type        primitive_;
+    layout_id         layout_ {0};
+    std::uint32_t     index_count_ {0};
+    corgi::index_type index_type_ {index_type::uint16};
+    primitive_type    primitive_ {primitive_type::triangles};
 };
 }    // namespace corgi
\ No newline at end of file
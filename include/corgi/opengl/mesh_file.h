@@ -0,0 +1,168 @@
+#pragma once
+
+#include <corgi/opengl/compact_mesh.h>
+#include <corgi/opengl/mesh.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Read only view of a whole file, mapped in memory
+ *
+ * Uses mmap on POSIX systems and CreateFileMapping on Windows. Pages are
+ * only read from the disk when they are touched.
+ */
+class mapped_file
+{
+public:
+    mapped_file() = default;
+
+    /**
+     * @throws std::runtime_error If the file can't be opened, is empty or
+     * can't be mapped
+     */
+    explicit mapped_file(const std::filesystem::path& path);
+
+    mapped_file(const mapped_file& other)            = delete;
+    mapped_file& operator=(const mapped_file& other) = delete;
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    ~mapped_file();
+
+    std::span<const std::byte> data() const noexcept
+    {
+        return {data_, size_};
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool        empty() const noexcept { return size_ == 0; }
+
+private:
+    void release() noexcept;
+
+    const std::byte* data_ {nullptr};
+    std::size_t      size_ {0};
+
+#ifdef _WIN32
+    void* file_ {nullptr};
+    void* mapping_ {nullptr};
+#endif
+};
+
+/**
+ * @brief Header at the start of a mesh file
+ *
+ * The header is followed by attribute_count mesh_file_attribute, then by the
+ * vertices and the indexes. Both blobs start on a mesh_file_alignment
+ * boundary so they can be given to glBufferData straight from the mapping.
+ * Everything is stored in the machine's byte order.
+ */
+struct mesh_file_header
+{
+    std::array<char, 4> magic {'C', 'M', 'S', 'H'};
+    std::uint32_t       version {1};
+    std::uint32_t       vertex_count {0};
+    std::uint32_t       index_count {0};
+    // Size of one vertex, in bytes
+    std::uint32_t stride {0};
+    std::uint16_t attribute_count {0};
+    // corgi::index_type of the stored indexes
+    std::uint8_t index_type {0};
+    // corgi::primitive_type
+    std::uint8_t primitive {0};
+    // Axis aligned box around the positions, 0 if the mesh has none
+    std::array<float, 3> bounds_min {0.0F, 0.0F, 0.0F};
+    std::array<float, 3> bounds_max {0.0F, 0.0F, 0.0F};
+    // Offsets from the start of the file, in bytes
+    std::uint64_t vertices_offset {0};
+    std::uint64_t vertices_size {0};
+    std::uint64_t indexes_offset {0};
+    std::uint64_t indexes_size {0};
+};
+
+struct mesh_file_attribute
+{
+    std::int32_t location {0};
+    std::int32_t offset {0};
+    std::int32_t size {0};
+    // corgi::attribute_type
+    std::uint8_t type {0};
+    // corgi::attribute_mode
+    std::uint8_t  mode {0};
+    std::uint16_t reserved {0};
+};
+
+static_assert(sizeof(mesh_file_header) == 80);
+static_assert(sizeof(mesh_file_attribute) == 16);
+
+constexpr std::size_t mesh_file_alignment = 16;
+
+/**
+ * @brief Writes the mesh data in the mesh file format
+ *
+ * Indexes are stored with the smallest index_type able to hold them. Bounds
+ * are computed from the float position at location 0, if there is one.
+ *
+ * @throws std::invalid_argument If the mesh data has no vertices, indexes or
+ * attributes
+ * @throws std::runtime_error If the file can't be written
+ */
+void write_mesh_file(const std::filesystem::path& path, const mesh_data& data);
+
+/**
+ * @brief Mesh file mapped in memory
+ *
+ * Opening the file checks the header and scans the indexes to make sure
+ * they stay within the vertices. Vertices are only read by the driver when
+ * the mesh is uploaded, and neither goes through intermediate vectors.
+ */
+class mesh_file
+{
+public:
+    /**
+     * @throws std::runtime_error If the file can't be mapped or isn't a valid
+     * mesh file
+     */
+    explicit mesh_file(const std::filesystem::path& path);
+
+    const mesh_file_header&              header() const noexcept;
+    const std::vector<vertex_attribute>& attributes() const noexcept;
+
+    std::span<const std::byte> vertices() const noexcept;
+
+    /**
+     * @brief Returns the indexes as stored in the file, with the header's
+     * index_type
+     */
+    std::span<const std::byte> indexes() const noexcept;
+
+    corgi::index_type index_type() const noexcept;
+    primitive_type    primitive() const noexcept;
+
+    /**
+     * @brief Uploads the geometry to a new compact_mesh, straight from the
+     * mapping
+     */
+    compact_mesh upload() const;
+
+private:
+    mapped_file                   file_;
+    mesh_file_header              header_;
+    std::vector<vertex_attribute> attributes_;
+};
+
+/**
+ * @brief Maps the file, uploads it and unmaps it
+ */
+compact_mesh load_mesh_file(const std::filesystem::path& path);
+
+}    // namespace corgi
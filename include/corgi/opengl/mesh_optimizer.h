@@ -0,0 +1,150 @@
+#pragma once
+
+#include <corgi/opengl/mesh.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Measures how well an index buffer uses the post transform vertex
+ * cache
+ */
+struct vertex_cache_statistics
+{
+    std::size_t triangles {0};
+    // Number of vertex shader invocations, cache misses included
+    std::size_t vertices_transformed {0};
+    // Number of distinct vertices referenced by the indexes
+    std::size_t vertices {0};
+
+    // Average cache miss ratio : vertices transformed per triangle. 0.5 is
+    // the best possible value for a regular grid, 3 the worst
+    float acmr {0.0F};
+    // Average transform to vertex ratio : vertices transformed per vertex.
+    // 1 is the best possible value
+    float atvr {0.0F};
+};
+
+/**
+ * @brief Passes that reorder a triangle mesh so the GPU processes it faster,
+ * without changing what is drawn
+ *
+ * They are meant to run once, when a mesh is imported, in this order, after
+ * duplicated vertices are merged with weld_vertices :
+ *
+ * * optimize_vertex_cache reorders the triangles so vertices are reused
+ *   while they are still in the post transform cache (Forsyth's algorithm)
+ * * optimize_overdraw splits the result in clusters and sorts them so
+ *   triangles facing outward are drawn first, which lets the depth test
+ *   reject more fragments. Clusters are cut where the cache would be cold
+ *   anyway, so the cache efficiency only drops by the given threshold
+ * * optimize_vertex_fetch reorders the vertices in the order the indexes
+ *   first use them, so vertex fetching reads memory linearly
+ *
+ * Only triangle lists are reordered by the first two passes.
+ */
+namespace mesh_optimizer
+{
+
+/**
+ * @brief Simulates a FIFO post transform cache of the given size
+ */
+vertex_cache_statistics
+analyze_vertex_cache(std::span<const unsigned> indexes,
+                     std::size_t               vertex_count,
+                     unsigned                  cache_size = 16);
+
+/**
+ * @brief Reorders the triangles to improve the post transform cache hit rate
+ */
+void optimize_vertex_cache(std::span<unsigned> indexes,
+                           std::size_t         vertex_count);
+
+/**
+ * @brief Sorts clusters of triangles to reduce overdraw
+ *
+ * @param positions 3 floats per vertex
+ * @param threshold How much the ACMR may grow, 1.05 allows 5%
+ */
+void optimize_overdraw(std::span<unsigned>    indexes,
+                       std::span<const float> positions,
+                       float                  threshold  = 1.05F,
+                       unsigned               cache_size = 16);
+
+/**
+ * @brief Reorders the vertices in the order the indexes use them and
+ * removes the unused ones
+ *
+ * @param stride Size of a vertex in bytes
+ * @return The new number of vertices
+ */
+std::size_t optimize_vertex_fetch(std::vector<std::byte>& vertices,
+                                  std::span<unsigned>     indexes,
+                                  std::size_t             stride);
+
+/**
+ * @brief Merges the vertices whose attributes are equal, up to epsilon
+ *
+ * Float components are snapped to a grid of epsilon wide cells before being
+ * hashed, so two vertices are merged when every float lands in the same cell
+ * and every other component is identical. Vertices closer than epsilon but
+ * on both sides of a cell border aren't merged. An epsilon of 0 only merges
+ * identical vertices.
+ *
+ * Vertices keep the order of their first occurrence. Triangles that become
+ * degenerate are removed.
+ *
+ * @return The new number of vertices
+ */
+std::size_t weld_vertices(mesh_data& data, float epsilon = 1e-6F);
+
+/**
+ * @brief Removes triangles by collapsing edges, keeping the vertices where
+ * they are so the result can share the original vertex buffer
+ *
+ * Each collapse moves a vertex onto one of its neighbours. Collapses are
+ * picked by their cost on a quadric error metric : the sum of the squared
+ * distances to the planes of the triangles around the vertex. Open borders
+ * get extra quadrics so the silhouette of flat meshes is kept, and border
+ * vertices only slide along the border. Collapses that would flip a
+ * triangle are rejected.
+ *
+ * Errors are relative to the size of the mesh : 0.01 is 1% of its largest
+ * extent.
+ *
+ * @param positions 3 floats per vertex
+ * @param target_index_count Simplification stops once there are this many
+ * indexes left, or less
+ * @param target_error Simplification also stops before a collapse would
+ * cost more than this
+ * @param result_error If not null, receives the error of the result
+ * @return The indexes of the simplified triangles
+ */
+std::vector<unsigned> simplify(std::span<const unsigned> indexes,
+                               std::span<const float>    positions,
+                               std::size_t               target_index_count,
+                               float                     target_error = 0.01F,
+                               float* result_error = nullptr);
+
+/**
+ * @brief Returns the position of every vertex as 3 floats, read from the
+ * float attribute at location 0. z is 0 for 2D positions
+ *
+ * @throws std::invalid_argument If there is no float position attribute
+ */
+std::vector<float> vertex_positions(const mesh_data& data);
+
+/**
+ * @brief Runs every pass on the mesh data
+ *
+ * The overdraw pass is skipped when the vertices don't have a float
+ * position at location 0
+ */
+void optimize(mesh_data& data, float overdraw_threshold = 1.05F);
+
+}    // namespace mesh_optimizer
+}    // namespace corgi
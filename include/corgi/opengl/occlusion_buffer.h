@@ -0,0 +1,126 @@
+#pragma once
+
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/thread_pool.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Low poly mesh hiding what's behind it, like a wall or a building
+ */
+struct occluder
+{
+    // 3 floats per vertex
+    std::span<const float>    positions;
+    std::span<const unsigned> indexes;
+    matrix4                   model_view_projection {identity_matrix4};
+};
+
+/**
+ * @brief Small depth buffer rasterized on the CPU, to skip objects hidden
+ * behind occluders before anything is sent to the GPU
+ *
+ * Occluders are rendered at a coarse resolution, 4 pixels at a time with
+ * SSE, then every tile of 8x8 pixels keeps its farthest depth. A box is
+ * tested against the tiles first, and only against the pixels of the tiles
+ * it could be visible in.
+ *
+ * Results are conservative : a box is only reported hidden when every pixel
+ * it covers is nearer than its nearest point. Triangles crossing the near
+ * plane are skipped, so they hide nothing.
+ */
+class occlusion_buffer
+{
+public:
+    static constexpr int tile_size = 8;
+
+    /**
+     * @throws std::invalid_argument If width or height aren't positive
+     * multiples of tile_size
+     */
+    occlusion_buffer(int width, int height);
+
+    /**
+     * @brief Resets every pixel to the far plane
+     */
+    void clear();
+
+    /**
+     * @brief Renders the occluders, splitting the buffer in bands of rows
+     * across the pool's threads
+     *
+     * Only triangles facing the camera are rendered : occluders should be
+     * closed meshes
+     */
+    void render(std::span<const occluder> occluders, thread_pool* pool = nullptr);
+
+    /**
+     * @brief Returns true if some of the box could be seen
+     *
+     * Boxes outside of the screen aren't visible, boxes crossing the near
+     * plane always are
+     */
+    bool visible(const aabb& box, const matrix4& view_projection) const;
+
+    int width() const noexcept { return width_; }
+    int height() const noexcept { return height_; }
+
+    /**
+     * @brief Returns the depth of each pixel, from 0 on the near plane to 1
+     * on the far plane, row by row starting at the bottom
+     */
+    std::span<const float> depth() const noexcept { return depth_; }
+
+    /**
+     * @brief Returns the farthest depth of each tile
+     */
+    std::span<const float> tile_depth() const noexcept { return tiles_; }
+
+    /**
+     * @brief Returns the number of triangles rasterized by the last render,
+     * after skipping the ones facing away or crossing the near plane
+     */
+    std::size_t rendered_triangles() const noexcept
+    {
+        return triangles_.size();
+    }
+
+private:
+    /**
+     * @brief Triangle ready to be rasterized. Edges and depth are planes in
+     * screen space, evaluated at the pixels' centers
+     */
+    struct triangle
+    {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_c[3];
+        float depth_a;
+        float depth_b;
+        float depth_c;
+        int   min_x;
+        int   max_x;
+        int   min_y;
+        int   max_y;
+    };
+
+    void setup(const occluder& o);
+    void rasterize(const triangle& t, int first_row, int end_row);
+    void update_tiles(int first_tile_row, int end_tile_row);
+
+    int width_;
+    int height_;
+    int tiles_x_;
+    int tiles_y_;
+
+    std::vector<float>    depth_;
+    std::vector<float>    tiles_;
+    std::vector<triangle> triangles_;
+    std::vector<float>    screen_;
+};
+}    // namespace corgi
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/mesh.h>
+#include <corgi/opengl/pipeline_state.h>
+#include <corgi/opengl/program.h>
+#include <corgi/opengl/vertex_array_cache.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Asks the GPU which objects are hidden, by drawing their bounding
+ * boxes against the depth buffer
+ *
+ * Each frame, after the occluders are drawn, the boxes of the objects to test
+ * are drawn between begin_proxies and end_proxies, each inside a
+ * GL_ANY_SAMPLES_PASSED_CONSERVATIVE query. No color nor depth is written.
+ *
+ * Results are read at the start of the next frame, only if the GPU is done
+ * with them : the CPU never waits, unless a result is still missing when its
+ * query is needed again two frames later. Each object keeps a history of its
+ * last results, and stays visible for a few frames after it was last seen so
+ * objects don't pop in and out at the edges of occluders.
+ *
+ * To skip draws without waiting for any result, wrap them between
+ * begin_conditional_render and end_conditional_render : the GPU drops them
+ * itself if the object's box of this frame had no sample pass.
+ */
+class occlusion_queries
+{
+public:
+    /**
+     * @param hysteresis Number of frames an object stays visible after its
+     * last visible result, from 1 to 32
+     */
+    explicit occlusion_queries(unsigned hysteresis = 3);
+
+    occlusion_queries(const occlusion_queries& other)            = delete;
+    occlusion_queries& operator=(const occlusion_queries& other) = delete;
+
+    ~occlusion_queries();
+
+    /**
+     * @brief Adds an object to test, visible until a result says otherwise,
+     * and returns its index
+     */
+    std::uint32_t add();
+
+    std::size_t size() const noexcept { return objects_.size(); }
+
+    /**
+     * @brief Collects the results the GPU is done with. Call it once per
+     * frame, before testing objects
+     */
+    void begin_frame();
+
+    /**
+     * @brief Sets the state to draw boxes : depth test on, color and depth
+     * writes off, the proxy program and the box mesh bound
+     *
+     * The proxy state is applied through the pipeline_state_registry, going
+     * from current_state, and end_proxies goes back to it. OpenGL isn't
+     * queried, so current_state must be the state actually set. Between
+     * renderer draws, pass renderer::current_state() and
+     * renderer::current_program() so the renderer's cache stays right
+     *
+     * @param current_state State set before the call, restored by end_proxies
+     * @param current_program Program used again by end_proxies. No program is
+     * used if null
+     */
+    void begin_proxies(vertex_array_cache& vertex_arrays,
+                       const matrix4&      view_projection,
+                       pipeline_state_id   current_state,
+                       program*            current_program);
+
+    /**
+     * @brief Issues the query of an object, drawing its bounds
+     *
+     * Boxes crossing the near plane aren't drawn and count as visible, the
+     * camera could be inside them
+     *
+     * @throws std::logic_error If called outside of begin_proxies and
+     * end_proxies
+     */
+    void test(std::uint32_t object, const aabb& bounds);
+
+    void end_proxies();
+
+    /**
+     * @brief Returns true if the object was seen in one of the last
+     * hysteresis frames with results, or has no results yet
+     */
+    bool visible(std::uint32_t object) const;
+
+    /**
+     * @brief Returns the object's last 32 results, bit 0 being the latest,
+     * set when the object was seen
+     */
+    std::uint32_t history(std::uint32_t object) const;
+
+    /**
+     * @brief Makes the GPU skip the next draws if the object's box of this
+     * frame had no sample pass, without the CPU waiting for the result
+     *
+     * Does nothing if the object wasn't tested this frame : the draws happen
+     */
+    void begin_conditional_render(std::uint32_t object);
+    void end_conditional_render();
+
+    /**
+     * @brief Number of times a result had to be waited for
+     */
+    std::size_t stalls() const noexcept { return stalls_; }
+
+private:
+    struct object_state
+    {
+        std::array<unsigned, 2> queries {0, 0};
+        // Frame each query was issued at, 0 when its result was read
+        std::array<std::uint64_t, 2> issued {0, 0};
+        // Set when the box crossed the near plane instead of being drawn
+        std::array<bool, 2> forced {false, false};
+        std::uint32_t       history {0xFFFFFFFFu};
+    };
+
+    void record(object_state& o, std::size_t slot, bool wait);
+
+    std::vector<object_state> objects_;
+    unsigned                  hysteresis_mask_ {0};
+    std::uint64_t             frame_ {0};
+    std::size_t               stalls_ {0};
+    bool                      drawing_proxies_ {false};
+    bool                      conditional_ {false};
+    matrix4                   view_projection_ {identity_matrix4};
+
+    // Interned once, applied by begin_proxies
+    pipeline_state_id proxy_state_ {0};
+
+    // Given to begin_proxies, restored by end_proxies
+    pipeline_state_id previous_state_ {0};
+    program*          previous_program_ {nullptr};
+
+    std::unique_ptr<shader>  vertex_shader_;
+    std::unique_ptr<shader>  fragment_shader_;
+    std::unique_ptr<program> proxy_program_;
+    corgi::mesh              box_;
+};
+}    // namespace corgi
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <corgi/opengl/pipeline_state.h>
 #include <corgi/opengl/program.h>
 #include <corgi/opengl/uniform_buffer_object.h>
 #include <corgi/opengl/texture.h>
@@ -24,10 +25,21 @@ class pipeline
 public:
     corgi::program* program_ {nullptr};
 
-    bool write_color {true};
-    bool enable_depth_test {true};
-    bool depth_mask {false};
-    
+    /**
+     * @brief Interns the state in the pipeline_state_registry and uses it
+     */
+    void set_state(const pipeline_state& state);
+    void set_state(pipeline_state_id id) noexcept;
+
+    pipeline_state_id     state() const noexcept;
+    const pipeline_state& state_description() const;
+
+    /**
+     * @brief State used by pipelines unless told otherwise : depth test on,
+     * depth writes off
+     */
+    static pipeline_state_id default_state();
+
     color clear_color;
 
     template<class T>
@@ -57,5 +69,6 @@ public:
 
 private:
 
+    pipeline_state_id state_ {default_state()};
 };
 }    // namespace corgi
\ No newline at end of file
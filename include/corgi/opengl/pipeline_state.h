@@ -0,0 +1,261 @@
+#pragma once
+
+#include <corgi/opengl/stencil.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace corgi
+{
+
+enum class cull_mode : char
+{
+    none,
+    front,
+    back
+};
+
+enum class front_face : char
+{
+    counter_clockwise,
+    clockwise
+};
+
+enum class polygon_mode : char
+{
+    fill,
+    line,
+    point
+};
+
+enum class compare_function : char
+{
+    never,
+    less,
+    equal,
+    less_equal,
+    greater,
+    not_equal,
+    greater_equal,
+    always
+};
+
+enum class blend_factor : char
+{
+    zero,
+    one,
+    src_color,
+    one_minus_src_color,
+    dst_color,
+    one_minus_dst_color,
+    src_alpha,
+    one_minus_src_alpha,
+    dst_alpha,
+    one_minus_dst_alpha
+};
+
+enum class blend_equation : char
+{
+    add,
+    subtract,
+    reverse_subtract,
+    min,
+    max
+};
+
+// Bits of the color mask
+constexpr unsigned char color_mask_red   = 0b0001;
+constexpr unsigned char color_mask_green = 0b0010;
+constexpr unsigned char color_mask_blue  = 0b0100;
+constexpr unsigned char color_mask_alpha = 0b1000;
+constexpr unsigned char color_mask_all   = 0b1111;
+
+struct raster_state
+{
+    cull_mode    cull {cull_mode::none};
+    front_face   front {front_face::counter_clockwise};
+    polygon_mode polygon {polygon_mode::fill};
+    bool         scissor_test {false};
+
+    bool operator==(const raster_state& other) const = default;
+};
+
+struct depth_state
+{
+    bool             test {false};
+    bool             write {true};
+    compare_function function {compare_function::less};
+
+    bool operator==(const depth_state& other) const = default;
+};
+
+struct blend_state
+{
+    bool           enabled {false};
+    blend_factor   src_color {blend_factor::one};
+    blend_factor   dst_color {blend_factor::zero};
+    blend_factor   src_alpha {blend_factor::one};
+    blend_factor   dst_alpha {blend_factor::zero};
+    blend_equation color_equation {blend_equation::add};
+    blend_equation alpha_equation {blend_equation::add};
+
+    bool operator==(const blend_state& other) const = default;
+
+    /**
+     * @brief Usual "over" blending for non premultiplied colors
+     */
+    static blend_state alpha_blending() noexcept;
+};
+
+/**
+ * @brief Groups of OpenGL states that differ between two pipeline states
+ */
+enum class state_group : std::uint32_t
+{
+    cull           = 1u << 0,
+    front_face     = 1u << 1,
+    polygon        = 1u << 2,
+    scissor        = 1u << 3,
+    depth_test     = 1u << 4,
+    depth_write    = 1u << 5,
+    depth_function = 1u << 6,
+    stencil        = 1u << 7,
+    blend_enable   = 1u << 8,
+    blend_function = 1u << 9,
+    blend_equation = 1u << 10,
+    color_mask     = 1u << 11
+};
+
+constexpr std::uint32_t state_group_all = (1u << 12) - 1;
+
+/**
+ * @brief Immutable description of the fixed function states used by a draw
+ * call
+ *
+ * A default constructed pipeline_state matches OpenGL's default states. The
+ * hash is computed once, when the state is built.
+ */
+class pipeline_state
+{
+public:
+    pipeline_state();
+
+    pipeline_state(raster_state  raster,
+                   depth_state   depth,
+                   corgi::stencil stencil,
+                   blend_state   blend,
+                   unsigned char color_mask = color_mask_all);
+
+    const raster_state&   raster() const noexcept;
+    const depth_state&    depth() const noexcept;
+    const corgi::stencil& stencil() const noexcept;
+    const blend_state&    blend() const noexcept;
+    unsigned char         color_mask() const noexcept;
+
+    // Returns a copy of the state with one part replaced
+    pipeline_state with_raster(raster_state raster) const;
+    pipeline_state with_depth(depth_state depth) const;
+    pipeline_state with_stencil(corgi::stencil stencil) const;
+    pipeline_state with_blend(blend_state blend) const;
+    pipeline_state with_color_mask(unsigned char mask) const;
+
+    std::size_t hash() const noexcept;
+
+    /**
+     * @brief Returns the state_group bits that differ between both states
+     */
+    std::uint32_t difference(const pipeline_state& other) const noexcept;
+
+    bool operator==(const pipeline_state& other) const noexcept;
+
+    /**
+     * @brief Stencil state matching OpenGL's defaults
+     */
+    static corgi::stencil default_stencil() noexcept;
+
+private:
+    std::size_t compute_hash() const noexcept;
+
+    raster_state   raster_;
+    depth_state    depth_;
+    corgi::stencil stencil_;
+    blend_state    blend_;
+    unsigned char  color_mask_ {color_mask_all};
+    std::size_t    hash_ {0};
+};
+
+using pipeline_state_id = std::uint16_t;
+
+/**
+ * @brief Interns pipeline states so they can be compared through an id
+ *
+ * Identical states share the same id. Id 0 is always OpenGL's default
+ * state. The OpenGL calls needed to go from a state to another are only
+ * worked out once per pair of ids and cached.
+ */
+class pipeline_state_registry
+{
+public:
+    static pipeline_state_registry& instance();
+
+    pipeline_state_registry(const pipeline_state_registry& other) = delete;
+    pipeline_state_registry& operator=(const pipeline_state_registry& other) =
+        delete;
+
+    /**
+     * @brief Returns the id of the state, registering it if needed
+     *
+     * @throws std::length_error If every id is already used
+     */
+    pipeline_state_id intern(const pipeline_state& state);
+
+    /**
+     * @throws std::out_of_range If the id wasn't returned by intern
+     */
+    const pipeline_state& get(pipeline_state_id id) const;
+
+    /**
+     * @brief Returns the state_group bits that differ between two states
+     */
+    std::uint32_t delta(pipeline_state_id from, pipeline_state_id to);
+
+    /**
+     * @brief Issues the OpenGL calls to go from one state to another,
+     * assuming the current OpenGL state is "from"
+     */
+    void apply(pipeline_state_id from, pipeline_state_id to);
+
+    /**
+     * @brief Sets every state tracked by the registry to OpenGL's default
+     * values, whatever the current OpenGL state is
+     */
+    void apply_defaults();
+
+    std::size_t size() const;
+
+private:
+    pipeline_state_registry();
+
+    struct hasher
+    {
+        std::size_t operator()(const pipeline_state& state) const noexcept
+        {
+            return state.hash();
+        }
+    };
+
+    void apply(const pipeline_state& from,
+               const pipeline_state& to,
+               std::uint32_t         groups) const;
+
+    mutable std::mutex mutex_;
+
+    // A deque so references returned by get stay valid
+    std::deque<pipeline_state>                                    states_;
+    std::unordered_map<pipeline_state, pipeline_state_id, hasher> ids_;
+    std::unordered_map<std::uint32_t, std::uint32_t>              deltas_;
+};
+}    // namespace corgi
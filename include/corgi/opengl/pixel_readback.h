@@ -0,0 +1,154 @@
+#pragma once
+
+#include <corgi/opengl/image.h>
+#include <corgi/opengl/texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Area of the framebuffer to read, in pixels, from the bottom left
+ * corner
+ */
+struct pixel_rect
+{
+    int      x {0};
+    int      y {0};
+    unsigned width {0};
+    unsigned height {0};
+};
+
+class pixel_readback;
+
+/**
+ * @brief Handle to pixels being copied back from the GPU
+ *
+ * The ticket stays valid until its pixels are taken. It must not outlive the
+ * pixel_readback that created it. Tickets can only be moved : dropping one
+ * discards its pixels, and the ring buffer it used can be reused.
+ */
+class readback_ticket
+{
+public:
+    readback_ticket() = default;
+
+    readback_ticket(const readback_ticket& other)            = delete;
+    readback_ticket& operator=(const readback_ticket& other) = delete;
+
+    readback_ticket(readback_ticket&& other) noexcept;
+    readback_ticket& operator=(readback_ticket&& other) noexcept;
+
+    ~readback_ticket();
+
+    /**
+     * @brief Returns true if the pixels can be taken without waiting for the
+     * GPU. Never blocks
+     */
+    bool ready() const;
+
+    /**
+     * @brief Returns the pixels, waiting for the GPU if they aren't ready yet
+     *
+     * @throws std::logic_error If the ticket is empty or was already taken
+     */
+    image take();
+
+    /**
+     * @brief Drops the pixels without waiting for the GPU, leaving the
+     * ticket empty. Does nothing if the ticket is already empty
+     */
+    void discard() noexcept;
+
+    /**
+     * @brief Returns true if the ticket has pixels left to take
+     */
+    bool valid() const noexcept;
+
+private:
+    friend class pixel_readback;
+
+    readback_ticket(pixel_readback* owner, std::uint64_t id);
+
+    pixel_readback* owner_ {nullptr};
+    std::uint64_t   id_ {0};
+};
+
+/**
+ * @brief Reads pixels back from the GPU without stalling the pipeline
+ *
+ * glReadPixels blocks until every draw call touching the framebuffer is done.
+ * Here, pixels are read into a ring of pixel pack buffers instead : the copy
+ * is queued on the GPU and a fence is inserted behind it. The pixels are
+ * mapped once the fence is signaled, usually a frame or two later.
+ *
+ * When every buffer of the ring is in use, requesting a new readback waits
+ * for the oldest one and keeps its pixels on the CPU until they are taken.
+ */
+class pixel_readback
+{
+public:
+    /**
+     * @param slots Number of pixel pack buffers in the ring. 2 or 3 are
+     * usually enough to hide the latency
+     */
+    explicit pixel_readback(std::size_t slots = 3);
+
+    pixel_readback(const pixel_readback& other) = delete;
+    pixel_readback& operator=(const pixel_readback& other) = delete;
+
+    ~pixel_readback();
+
+    /**
+     * @brief Queues a copy of the given area of the framebuffer bound for
+     * reading
+     *
+     * @param pixel_format Only red, rg, rgb, rgba, bgr and bgra are supported,
+     * read as unsigned bytes
+     *
+     * @throws std::invalid_argument If the area is empty or the format
+     * isn't supported
+     * @throws std::runtime_error If every buffer is in use and the oldest
+     * one can't be copied out
+     */
+    readback_ticket request(pixel_rect rect,
+                            format     pixel_format = format::rgba);
+
+    /**
+     * @brief Returns the number of readbacks whose pixels weren't taken yet
+     */
+    std::size_t pending() const noexcept;
+
+    std::size_t slot_count() const noexcept;
+
+private:
+    friend class readback_ticket;
+
+    struct slot
+    {
+        unsigned      id {0};
+        std::size_t   capacity {0};
+        void*         fence {nullptr};
+        std::uint64_t ticket {0};
+        int           width {0};
+        int           height {0};
+        int           channels {0};
+    };
+
+    bool  ready(std::uint64_t ticket) const;
+    image take(std::uint64_t ticket);
+    void  discard(std::uint64_t ticket) noexcept;
+
+    slot* find(std::uint64_t ticket);
+    slot& free_slot();
+    image copy_out(slot& s);
+
+    std::vector<slot>                        slots_;
+    std::unordered_map<std::uint64_t, image> completed_;
+    std::uint64_t                            next_ticket_ {1};
+};
+}    // namespace corgi
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <corgi/opengl/image.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace corgi
+{
+
+/**
+ * @brief Encodes images to png files on a worker thread
+ *
+ * Meant to be fed with the images coming out of a pixel_readback, so the
+ * rendering thread never waits for the encoder. When the queue is full,
+ * push() blocks until the worker catches up, which keeps the memory used by
+ * waiting images bounded.
+ */
+class png_sink
+{
+public:
+    /**
+     * @param max_queued Number of images that can wait to be encoded before
+     * push() blocks
+     */
+    explicit png_sink(std::size_t max_queued = 8);
+
+    png_sink(const png_sink& other)            = delete;
+    png_sink& operator=(const png_sink& other) = delete;
+
+    /**
+     * @brief Encodes the images still in the queue then stops the worker
+     */
+    ~png_sink();
+
+    void push(image img, std::string path);
+
+    /**
+     * @brief Waits until every pushed image is written
+     */
+    void flush();
+
+    std::size_t written() const;
+    std::size_t failed() const;
+
+private:
+    struct job
+    {
+        image       img;
+        std::string path;
+    };
+
+    void run();
+
+    mutable std::mutex      mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+
+    std::deque<job> queue_;
+    std::size_t     max_queued_;
+    std::size_t     encoding_ {0};
+    std::size_t     written_ {0};
+    std::size_t     failed_ {0};
+    bool            stopping_ {false};
+
+    std::thread worker_;
+};
+}    // namespace corgi
@@ -2,6 +2,8 @@
 
 #include <corgi/opengl/mesh.h>
 
+#include <algorithm>
+#include <cmath>
 #include <numbers>
 
 namespace corgi
@@ -10,73 +12,110 @@ namespace corgi
 namespace primitive
 {
 
-inline mesh build_circle_pos2_uv(float radius, int discretisation)
+/**
+ * @brief Returns how many segments a circle needs so its rim stays within
+ * max_error of the real circle
+ *
+ * With the radius in pixels, small or far away circles get fewer triangles
+ * while big ones stay round
+ */
+inline int circle_discretisation(float radius, float max_error = 0.25F)
 {
-    std::vector<float>    vertices;
-    std::vector<unsigned> indexes;
+    constexpr int min_segments = 8;
+    constexpr int max_segments = 512;
+
+    if(radius <= max_error)
+        return min_segments;
+
+    // A segment deviates from the circle by radius * (1 - cos(pi / n))
+    const float segments =
+        std::numbers::pi_v<float> / std::acos(1.0F - max_error / radius);
+
+    return std::clamp(static_cast<int>(std::ceil(segments)), min_segments,
+                      max_segments);
+}
 
-    vertices.reserve(discretisation * 12);
+/**
+ * @brief Writes the geometry of build_circle_pos2_uv to the vectors,
+ * replacing their content. Lets callers reuse their storage every frame
+ */
+inline void circle_pos2_uv(float                  radius,
+                           int                    discretisation,
+                           std::vector<float>&    vertices,
+                           std::vector<unsigned>& indexes)
+{
+    vertices.clear();
+    indexes.clear();
+
+    vertices.reserve((discretisation + 1) * 4);
     indexes.reserve(discretisation * 3);
 
     float delta = 2.0F * std::numbers::pi_v<float> / discretisation;
 
+    vertices.insert(vertices.end(), {0.0f, 0.0f, 0.0F, 0.0F});
+
     for(int i = 0; i < discretisation; i++)
     {
-        float angle  = delta * i;
-        float angle2 = delta * (i + 1);
-
-        vertices.insert(
-            vertices.end(), {0.0f, 0.0f, 0.0F, 0.0F});
+        float angle = delta * i;
 
         vertices.insert
         (
             vertices.end(),
             {
                 cosf(angle) * radius,
-                sinf(angle) * radius, 
-                cosf(angle), 
+                sinf(angle) * radius,
+                cosf(angle),
                 sinf(angle)
             }
         );
 
-        vertices.insert(vertices.end(), {cosf(angle2) * radius, sinf(angle2) * radius, cosf(angle), sinf(angle)});
+        indexes.push_back(0);
+        indexes.push_back(i + 1);
+        indexes.push_back((i + 1) % discretisation + 1);
+    }
+}
 
+/**
+ * @brief Builds a disc made of a center vertex and discretisation vertices
+ * on the rim, shared by the triangles
+ */
+inline mesh build_circle_pos2_uv(float radius, int discretisation)
+{
+    std::vector<float>    vertices;
+    std::vector<unsigned> indexes;
 
-        indexes.push_back(i * 3);
-        indexes.push_back(i * 3 + 1);
-        indexes.push_back(i * 3 + 2);
-    }
+    circle_pos2_uv(radius, discretisation, vertices, indexes);
 
     return corgi::mesh(vertices, indexes, common_attributes::pos2_uv);
 }
 
+/**
+ * @brief Builds a disc made of a center vertex and discretisation vertices
+ * on the rim, shared by the triangles
+ */
 inline mesh build_circle_pos2(float radius, int discretisation)
 {
     std::vector<float>    vertices;
     std::vector<unsigned> indexes;
 
-    vertices.reserve(discretisation * 6);
+    vertices.reserve((discretisation + 1) * 2);
     indexes.reserve(discretisation * 3);
 
     float delta = 2.0F * std::numbers::pi_v<float> / discretisation;
 
+    vertices.push_back(0.0f);
+    vertices.push_back(0.0F);
+
     for(int i = 0; i < discretisation; i++)
     {
-        float angle  = delta * i;
-        float angle2 = delta * (i + 1);
-
-        vertices.push_back(0.0f);
-        vertices.push_back(0.0F);
+        float angle = delta * i;
 
         vertices.push_back(cos(angle) * radius);
         vertices.push_back(sin(angle) * radius);
 
-        vertices.push_back(cos(angle2) * radius);
-        vertices.push_back(sin(angle2) * radius);
-
-        indexes.push_back(i * 3);
-        indexes.push_back(i * 3 + 1);
-        indexes.push_back(i * 3 + 2);
+        indexes.push_back(0);
+        indexes.push_back(i + 1);
+        indexes.push_back((i + 1) % discretisation + 1);
     }
 
     return corgi::mesh(vertices, indexes, common_attributes::pos2);
@@ -113,43 +152,65 @@ inline mesh build_rect_pos2(float half_width, float half_height)
     return corgi::mesh(vertices, indexes, common_attributes::pos2);
 }
 
+/**
+ * @brief Writes the geometry of build_rect_pos2_uv to the vectors, replacing
+ * their content. Lets callers reuse their storage every frame
+ */
+inline void rect_pos2_uv(float                  half_width,
+                         float                  half_height,
+                         std::vector<float>&    vertices,
+                         std::vector<unsigned>& indexes)
+{
+    vertices.assign({-half_width, -half_height, 0.0F, 0.0F,
+                     half_width,  -half_height, 1.0F, 0.0F,
+                     half_width,  half_height,  1.0F, 1.0F,
+                     -half_width, half_height,  0.0F, 1.0F});
+
+    indexes.assign({0, 1, 2, 2, 3, 0});
+}
+
 inline mesh build_rect_pos2_uv(float half_width, float half_height)
 {
     std::vector<float>    vertices;
     std::vector<unsigned> indexes;
 
-    vertices.reserve(4 * 4);
-    indexes.reserve(3 * 2);
-
-    vertices.push_back(-half_width);
-    vertices.push_back(-half_height);
-    vertices.push_back(0.0f);
-    vertices.push_back(0.0F);
-
-    vertices.push_back(half_width);
-    vertices.push_back(-half_height);
-    vertices.push_back(1.0f);
-    vertices.push_back(0.0F);
+    rect_pos2_uv(half_width, half_height, vertices, indexes);
 
-    vertices.push_back(half_width);
-    vertices.push_back(half_height);
-    vertices.push_back(1.0f);
-    vertices.push_back(1.0F);
+    return corgi::mesh(vertices, indexes, common_attributes::pos2_uv);
+}
 
-    vertices.push_back(-half_width);
-    vertices.push_back(half_height);
-    vertices.push_back(0.0f);
-    vertices.push_back(1.0F);
+/**
+ * @brief Writes the 8 corners and 12 triangles of a box to the vectors,
+ * replacing their content. Positions have 3 floats, triangles are counter
+ * clockwise seen from outside
+ */
+inline void box_pos3(const aabb&            box,
+                     std::vector<float>&    vertices,
+                     std::vector<unsigned>& indexes)
+{
+    vertices.clear();
+
+    // Corner i takes max on x if bit 0 is set, on y for bit 1, on z for bit 2
+    for(int i = 0; i < 8; i++)
+        for(int axis = 0; axis < 3; axis++)
+            vertices.push_back((i >> axis) & 1 ? box.max[axis] : box.min[axis]);
+
+    indexes.assign({0, 4, 6, 6, 2, 0,    // -x
+                    1, 3, 7, 7, 5, 1,    // +x
+                    0, 1, 5, 5, 4, 0,    // -y
+                    2, 6, 7, 7, 3, 2,    // +y
+                    0, 2, 3, 3, 1, 0,    // -z
+                    4, 5, 7, 7, 6, 4});  // +z
+}
 
-    indexes.push_back(0);
-    indexes.push_back(1);
-    indexes.push_back(2);
+inline mesh build_box_pos3(const aabb& box)
+{
+    std::vector<float>    vertices;
+    std::vector<unsigned> indexes;
 
-    indexes.push_back(2);
-    indexes.push_back(3);
-    indexes.push_back(0);
+    box_pos3(box, vertices, indexes);
 
-    return corgi::mesh(vertices, indexes, common_attributes::pos2_uv);
+    return corgi::mesh(vertices, indexes, common_attributes::pos3);
 }
 
 }    // namespace primitive
@@ -7,6 +7,11 @@ namespace corgi
 class program
 {
 public:
+    /**
+     * @brief Links the shaders, which must share the same vertex
+     * attributes. Vertex structs can be checked against constexpr shaders
+     * at compile time, see layout_matches
+     */
     program(shader& vertex_shader, shader& fragment_shader);
 
     program(const program& other)     = delete;
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <corgi/opengl/framebuffer.h>
+#include <corgi/opengl/texture.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace corgi
+{
+class renderer;
+
+/**
+ * @brief Describes a render target created by the render_graph
+ */
+struct render_target_desc
+{
+    unsigned        width {0};
+    unsigned        height {0};
+    internal_format format {internal_format::rgba8};
+
+    bool operator==(const render_target_desc& other) const = default;
+};
+
+/**
+ * @brief Schedules rendering passes and the render targets they use
+ *
+ * Passes declare the resources they read and write. When the graph is
+ * compiled :
+ *
+ * * Passes that don't contribute to an output are culled. Outputs are the
+ *   default target, imported textures and resources marked with
+ *   mark_output()
+ * * Passes are ordered following the resources they read. A pass reading a
+ *   resource runs after the last pass declared before it that writes the
+ *   resource, and before the passes declared after it that write it again.
+ *   If no pass declared before it writes the resource, it runs after all the
+ *   passes writing it. Passes writing the same resource keep their
+ *   declaration order, and so do passes with no dependency
+ * * Transient render targets are assigned to textures from a pool. Two
+ *   targets with the same description share the same texture if their
+ *   lifetimes don't overlap. Outputs keep their texture for the whole frame,
+ *   it can be read with texture() once the graph is executed
+ *
+ * Compiling doesn't call OpenGL, textures and framebuffers are created the
+ * first time the graph is executed and kept for the next frames. Framebuffers
+ * are cached by the textures they attach, so passes writing the same targets
+ * get the same framebuffer after a reset().
+ */
+class render_graph
+{
+public:
+    using resource = unsigned;
+
+    class pass_builder
+    {
+    public:
+        /**
+         * @brief Declares that the pass samples the resource
+         */
+        void read(resource r);
+
+        /**
+         * @brief Declares that the pass renders into the resource
+         *
+         * Color resources are attached in the order they are declared,
+         * depth resources are attached to the depth or depth_stencil point
+         *
+         * @throws std::logic_error If the pass writes the default target
+         * and other resources
+         */
+        void write(resource r);
+
+    private:
+        friend class render_graph;
+
+        pass_builder(render_graph& graph, std::size_t pass);
+
+        render_graph& graph_;
+        std::size_t   pass_;
+    };
+
+    class pass_context
+    {
+    public:
+        /**
+         * @brief Returns the texture behind a resource read or written by the
+         * pass
+         *
+         * @throws std::logic_error If the resource is the default target
+         */
+        const corgi::texture& texture(resource r) const;
+
+        corgi::renderer& renderer() const;
+
+    private:
+        friend class render_graph;
+
+        pass_context(const render_graph& graph, corgi::renderer& renderer);
+
+        const render_graph& graph_;
+        corgi::renderer&    renderer_;
+    };
+
+    using setup_function   = std::function<void(pass_builder&)>;
+    using execute_function = std::function<void(pass_context&)>;
+
+    render_graph();
+    ~render_graph();
+
+    render_graph(const render_graph& other)            = delete;
+    render_graph& operator=(const render_graph& other) = delete;
+
+    /**
+     * @brief Declares a render target that only lives for the frame
+     */
+    resource create(std::string name, render_target_desc desc);
+
+    /**
+     * @brief Declares a texture that lives outside of the graph
+     *
+     * Passes writing into an imported texture are never culled. Its
+     * internal format decides where it is attached, depth textures going to
+     * the depth or depth_stencil point. Call trim() after deleting a texture
+     * that was imported, so the framebuffers attaching it are released
+     */
+    resource import(std::string name, corgi::texture& texture);
+
+    /**
+     * @brief Returns the resource standing for the default target
+     */
+    resource default_target() const noexcept;
+
+    /**
+     * @brief Keeps the passes writing the resource even if no pass reads it
+     */
+    void mark_output(resource r);
+
+    void add_pass(std::string      name,
+                  setup_function   setup,
+                  execute_function execute);
+
+    /**
+     * @brief Culls and orders the passes, then assigns the transient
+     * resources to pooled textures
+     *
+     * @throws std::logic_error If passes depend on each other cyclically
+     */
+    void compile();
+
+    /**
+     * @brief Runs the passes in order. Compiles the graph first if needed
+     */
+    void execute(corgi::renderer& renderer);
+
+    /**
+     * @brief Removes every pass and resource. Pooled textures and cached
+     * framebuffers are kept so the next frame's graph can reuse them
+     */
+    void reset();
+
+    /**
+     * @brief Releases the pooled textures and the framebuffers the last
+     * executed graph doesn't use
+     */
+    void trim();
+
+    /**
+     * @brief Returns the name of the passes that will run, in order
+     */
+    std::vector<std::string> execution_order() const;
+
+    /**
+     * @brief Returns the name of the passes that were culled
+     */
+    std::vector<std::string> culled_passes() const;
+
+    /**
+     * @brief Returns the memory needed by the transient resources once they
+     * share pooled textures
+     */
+    std::size_t transient_bytes() const;
+
+    /**
+     * @brief Returns the memory the transient resources would need if each
+     * one had its own texture for the whole frame
+     */
+    std::size_t transient_bytes_without_aliasing() const;
+
+    /**
+     * @brief Returns the number of pooled textures used by the last compiled
+     * graph
+     */
+    std::size_t physical_target_count() const;
+
+    /**
+     * @brief Returns the texture behind a resource of the compiled graph,
+     * for instance a transient marked with mark_output() once the graph is
+     * executed
+     *
+     * @throws std::logic_error If the resource is the default target or
+     * has no texture yet
+     */
+    const corgi::texture& texture(resource r) const;
+
+private:
+    struct resource_node
+    {
+        std::string        name;
+        render_target_desc desc;
+        corgi::texture*    imported {nullptr};
+        bool               output {false};
+        bool               default_target {false};
+
+        // Filled by compile
+        std::size_t first_use {0};
+        std::size_t last_use {0};
+        bool        used {false};
+        int         slot {-1};
+    };
+
+    struct pass_node
+    {
+        std::string           name;
+        execute_function      execute;
+        std::vector<resource> reads;
+        std::vector<resource> writes;
+        bool                  culled {false};
+
+        // Owned by the framebuffer cache, found again after each compile
+        corgi::framebuffer* framebuffer {nullptr};
+        // Attachment point of each written resource
+        std::vector<attachment> attachments;
+    };
+
+    struct cached_framebuffer
+    {
+        // Texture attached to each point
+        std::vector<std::pair<attachment, unsigned>> attachments;
+        std::unique_ptr<corgi::framebuffer>          framebuffer;
+        bool                                         used {false};
+    };
+
+    struct pooled_target
+    {
+        render_target_desc              desc;
+        std::unique_ptr<corgi::texture> texture;
+        bool                            used {false};
+        std::size_t                     busy_until {0};
+    };
+
+    bool is_transient(const resource_node& node) const noexcept;
+    void check(resource r) const;
+    void cull();
+    void sort();
+    void assign_slots();
+    void prepare_pass(pass_node& pass);
+
+    std::vector<resource_node> resources_;
+    std::vector<pass_node>     passes_;
+    std::vector<std::size_t>   order_;
+    std::vector<pooled_target> pool_;
+
+    std::vector<cached_framebuffer> framebuffers_;
+
+    resource default_target_;
+    bool     compiled_ {false};
+};
+}    // namespace corgi
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <corgi/opengl/texture.h>
+
+#include <cstddef>
+#include <string>
+
+namespace corgi
+{
+
+/**
+ * @brief Image storage that can only be used as a framebuffer attachment
+ *
+ * Unlike a texture, a renderbuffer can't be sampled from a shader. It's the
+ * storage to use for depth/stencil buffers and for multisampled color buffers
+ * that are resolved into a texture later on.
+ */
+class renderbuffer
+{
+public:
+    /**
+     * @brief Allocates a new renderbuffer
+     *
+     * @param samples Number of samples per pixel. 0 means the renderbuffer
+     * isn't multisampled
+     */
+    renderbuffer(internal_format format,
+                 unsigned        width,
+                 unsigned        height,
+                 int             samples = 0);
+
+    renderbuffer(const renderbuffer& other) = delete;
+    renderbuffer(renderbuffer&& other) noexcept;
+
+    renderbuffer& operator=(const renderbuffer& other) = delete;
+    renderbuffer& operator=(renderbuffer&& other) noexcept;
+
+    ~renderbuffer();
+
+    unsigned id() const noexcept;
+
+    internal_format format() const noexcept;
+
+    unsigned width() const noexcept;
+    unsigned height() const noexcept;
+
+    int samples() const noexcept;
+
+    /**
+     * @brief Returns the number of bytes used by the renderbuffer, all samples
+     * included
+     */
+    std::size_t size_in_bytes() const noexcept;
+
+    void set_tag(std::string tag) const;
+
+    void bind() const;
+    void unbind() const;
+
+private:
+    void clear();
+
+    unsigned        id_ {0};
+    internal_format format_;
+    unsigned        width_ {0};
+    unsigned        height_ {0};
+    int             samples_ {0};
+};
+}    // namespace corgi
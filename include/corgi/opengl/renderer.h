@@ -1,8 +1,15 @@
 #pragma once
 
+#include <corgi/opengl/compact_mesh.h>
+#include <corgi/opengl/culling.h>
+#include <corgi/opengl/dynamic_mesh.h>
+#include <corgi/opengl/lod_mesh.h>
 #include <corgi/opengl/mesh.h>
 #include <corgi/opengl/pipeline.h>
 #include <corgi/opengl/color.h>
+#include <corgi/opengl/pixel_readback.h>
+#include <corgi/opengl/static_batch.h>
+#include <corgi/opengl/vertex_array_cache.h>
 
 namespace corgi
 {
@@ -25,6 +32,40 @@ public:
 
     // Normally, you should set the pipeline then call draw
     void draw(const mesh& m);
+    void draw(const compact_mesh& m);
+
+    /**
+     * @brief Draws the mesh's draw range
+     */
+    void draw(const dynamic_mesh& m);
+
+    /**
+     * @brief Draws every mesh of the batch with a single call
+     */
+    void draw(const static_batch& batch);
+
+    /**
+     * @brief Draws some of the batch's meshes with a single call
+     *
+     * @param ranges Indexes in batch.ranges() of the meshes to draw, for
+     * instance the ones that passed culling. Sorted ranges that follow each
+     * other are merged
+     */
+    void draw(const static_batch& batch, std::span<const std::uint32_t> ranges);
+
+    /**
+     * @brief Draws a range of the mesh's index buffer
+     */
+    void draw(const mesh& m, std::uint32_t first_index, std::uint32_t index_count);
+
+    /**
+     * @brief Draws the level of detail matching the mesh's size on screen.
+     * Does nothing if the mesh has no level
+     *
+     * @param screen_size Size of the mesh's largest extent on screen, in
+     * pixels. See projected_size
+     */
+    void draw(const lod_mesh& m, float screen_size);
     void set_pipeline(pipeline& pipeline);
 
 
@@ -34,6 +75,56 @@ public:
     void draw_default_circle_on_screen(float x, float y, float radius);
     void draw_default_rect_on_screen(float x, float y, float width, float height);
 
+    /**
+     * @brief Tells the renderer the frame is done
+     *
+     * Deletes the OpenGL objects retired in the deletion_queue that the GPU
+     * isn't using anymore. Call it once per frame, after swapping buffers
+     */
+    void end_frame();
+
+    /**
+     * @brief Returns the volume seen through the orthographic projection the
+     * renderer draws its default shapes with, to cull objects against it
+     */
+    frustum screen_frustum() const;
+
+    /**
+     * @brief Returns the area of the world covered by the screen, centered on
+     * the origin, for 2D scenes
+     */
+    view_rect screen_rect() const noexcept;
+
+    /**
+     * @brief Returns the vertex arrays used to draw meshes, one per layout
+     */
+    vertex_array_cache& vertex_arrays() noexcept;
+
+    /**
+     * @brief Returns the pipeline state last applied by the renderer
+     *
+     * The renderer skips the state and program changes it thinks are
+     * already done. Code changing them behind its back, like
+     * occlusion_queries::begin_proxies, must set these back when done
+     */
+    pipeline_state_id current_state() const noexcept;
+
+    /**
+     * @brief Returns the program last used by the renderer, null if it
+     * hasn't drawn anything yet
+     */
+    program* current_program() const noexcept;
+
+    /**
+     * @brief Queues a copy of an area of the framebuffer bound for reading,
+     * without waiting for the GPU
+     *
+     * Pixels are taken from the returned ticket, usually a frame later.
+     * See pixel_readback
+     */
+    readback_ticket read_pixels_async(pixel_rect rect,
+                                      format     pixel_format = format::rgba);
+
 private:
 
     unsigned short   screen_width_;
@@ -43,6 +134,10 @@ private:
 
     corgi::pipeline* pipeline_ {nullptr};
 
+    // State currently set on the OpenGL side. The constructor resets OpenGL
+    // to its defaults, which is state 0
+    pipeline_state_id state_ {0};
+
     /**
      * Default pipeline for specific draw operations 
      */
@@ -53,5 +148,21 @@ private:
     std::unique_ptr<program> default_program_;
 
     color clear_color_;
+
+    // Created on the first asynchronous readback
+    std::unique_ptr<pixel_readback> readback_;
+
+    // One vertex array per layout, shared by every mesh drawn
+    vertex_array_cache vertex_arrays_;
+
+    // Geometry of the default circles and rects, updated for each of them
+    // instead of building a mesh every time
+    dynamic_mesh          default_shape_;
+    std::vector<float>    default_shape_vertices_;
+    std::vector<unsigned> default_shape_indexes_;
+
+    // Arguments of glMultiDrawElements, kept between draws
+    std::vector<int>         multi_draw_counts_;
+    std::vector<const void*> multi_draw_offsets_;
 };
 }    // namespace corgi
@@ -2,7 +2,10 @@
 
 #include <corgi/opengl/vertex_attribute.h>
 
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace corgi
@@ -30,17 +33,41 @@ struct material
 
 // Meshes using this shader only stores x,y position
 
+/**
+ * @brief Source and layout of a shader, known at compile time
+ *
+ * Shaders declared constexpr can be checked against a vertex struct with a
+ * static_assert, see layout_matches
+ *
+ * shader_content doesn't own anything : the attributes and the source must
+ * outlive it. Building it from a temporary vector or string doesn't compile,
+ * shaders built at runtime should use the shader(std::string,
+ * std::vector<vertex_attribute>, shader_type) constructor instead
+ */
 struct shader_content
 {
+    template<class Attributes, class Content>
+        requires std::ranges::borrowed_range<Attributes> &&
+                 std::ranges::borrowed_range<Content>
+    constexpr shader_content(Attributes&&       attributes,
+                             Content&&          content,
+                             corgi::shader_type shader_type)
+        : attributes(attributes)
+        , content(content)
+        , shader_type(shader_type)
+    {
+    }
+
     /**
-     * @brief Vertex attributes the shader is compatible with
+     * @brief Vertex attributes the shader is compatible with. Usually one of
+     * the common_layouts
      */
-    std::vector<vertex_attribute> attributes;
+    std::span<const vertex_attribute> attributes;
 
     /**
      *  @brief The actual content of the shader
      */
-    std::string content;
+    std::string_view content;
 
     /**
      * @brief Type of the shader
@@ -51,8 +78,9 @@ struct shader_content
 namespace common_shaders
 {
 
-const inline shader_content simple_2d_vertex_shader {common_attributes::pos2,
-                                                     R"(
+inline constexpr shader_content simple_2d_vertex_shader {
+    common_layouts::pos2,
+    R"(
             #version 430 core
             layout(location = 0) in vec2 position;
 
@@ -67,10 +95,11 @@ const inline shader_content simple_2d_vertex_shader {common_attributes::pos2,
             { 
                 gl_Position =  mvp *  vec4(position, 0.0, 1.0); 
             })",
-                                                     shader_type::vertex};
+    shader_type::vertex};
 
-const inline shader_content simple_2d_fragment_shader {common_attributes::pos2,
-                                                       R"(
+inline constexpr shader_content simple_2d_fragment_shader {
+    common_layouts::pos2,
+    R"(
             #version 430 core
             out vec4 color;
 
@@ -84,10 +113,10 @@ const inline shader_content simple_2d_fragment_shader {common_attributes::pos2,
                 color	= main_color;
             }
         )",
-                                                       shader_type::fragment};
+    shader_type::fragment};
 
-const inline shader_content simple_2d_texture_vertex_shader {
-    common_attributes::pos2_uv,
+inline constexpr shader_content simple_2d_texture_vertex_shader {
+    common_layouts::pos2_uv,
     R"(
 #version 430 core
 
@@ -109,8 +138,8 @@ void main() {
 })",
     shader_type::vertex};
 
-const inline shader_content simple_2d_texture_fragment_shader {
-    common_attributes::pos2_uv, R"(
+inline constexpr shader_content simple_2d_texture_fragment_shader {
+    common_layouts::pos2_uv, R"(
 
 #version 430 core
 
@@ -144,6 +173,43 @@ void main()
 }
 
 ;
+
+// Draws the boxes tested by occlusion_queries : a unit box around the origin,
+// moved and scaled to the tested bounds. Writes no color
+inline constexpr shader_content occlusion_proxy_vertex_shader {
+    common_layouts::pos3,
+    R"(
+#version 430 core
+
+layout(location = 0) in vec3 position;
+
+layout(location = 0) uniform mat4 view_projection;
+layout(location = 1) uniform vec3 center;
+layout(location = 2) uniform vec3 extent;
+
+void main()
+{
+    gl_Position = view_projection * vec4(center + position * extent, 1.0);
+})",
+    shader_type::vertex};
+
+inline constexpr shader_content occlusion_proxy_fragment_shader {
+    common_layouts::pos3,
+    R"(
+#version 430 core
+
+void main()
+{
+})",
+    shader_type::fragment};
+
+// Programs link these shaders by pair, so both must read the same vertices
+static_assert(attributes_equal(simple_2d_vertex_shader.attributes,
+                               simple_2d_fragment_shader.attributes));
+static_assert(attributes_equal(simple_2d_texture_vertex_shader.attributes,
+                               simple_2d_texture_fragment_shader.attributes));
+static_assert(attributes_equal(occlusion_proxy_vertex_shader.attributes,
+                               occlusion_proxy_fragment_shader.attributes));
 }    // namespace common_shaders
 
 }    // namespace corgi
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <corgi/opengl/bounds.h>
+#include <corgi/opengl/compact_mesh.h>
+#include <corgi/opengl/mesh.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief One mesh to merge in a static batch, placed by its transform
+ */
+struct batch_item
+{
+    const corgi::mesh* mesh {nullptr};
+    matrix4            transform {identity_matrix4};
+};
+
+/**
+ * @brief Range of the batch's index buffer holding one of the merged meshes
+ */
+struct batch_range
+{
+    std::uint32_t first_index {0};
+    std::uint32_t index_count {0};
+    // Bounds of the transformed mesh, to cull ranges one by one
+    aabb bounds;
+};
+
+/**
+ * @brief Geometry of a static batch on the CPU, before it is uploaded
+ */
+struct batch_data
+{
+    mesh_data                data;
+    std::vector<batch_range> ranges;
+    aabb                     bounds;
+};
+
+/**
+ * @brief Merges meshes into a single vertex and index buffer, their vertices
+ * moved by their transforms
+ *
+ * Positions are read from the float attribute at location 0. 2D positions
+ * only keep the x and y of the transformed point. Other attributes are
+ * copied as is, except the normal when its location is given : it is turned
+ * by the transform, which must not scale unevenly, and normalized again.
+ *
+ * Ranges are in the same order as the items.
+ *
+ * @throws std::invalid_argument If there are no items, a mesh is null or
+ * empty, or the meshes don't share their layout and primitive
+ */
+batch_data build_static_batch(std::span<const batch_item> items,
+                              int                         normal_location = -1);
+
+/**
+ * @brief Meshes that never move, merged so they are drawn with a single call
+ *
+ * Batch meshes sharing a pipeline, like the many small meshes of a level,
+ * once when they are loaded. The range of each merged mesh is kept with its
+ * bounds, so the renderer can still skip the ones that aren't visible.
+ */
+class static_batch
+{
+public:
+    static_batch() = default;
+
+    explicit static_batch(const batch_data& data);
+
+    explicit static_batch(std::span<const batch_item> items,
+                          int                         normal_location = -1);
+
+    const compact_mesh&             mesh() const noexcept { return mesh_; }
+    const std::vector<batch_range>& ranges() const noexcept { return ranges_; }
+    const aabb&                     bounds() const noexcept { return bounds_; }
+
+    /**
+     * @brief Returns the number of meshes merged in the batch
+     */
+    std::size_t size() const noexcept { return ranges_.size(); }
+
+private:
+    compact_mesh             mesh_;
+    std::vector<batch_range> ranges_;
+    aabb                     bounds_;
+};
+}    // namespace corgi
@@ -37,7 +37,9 @@ enum class stencil_operation : char
             // If 1 we write in the stencil buffer
             int stencil_mask_ = 0xFF;
 
-			void apply(stencil previous_stencil);
+			void apply(stencil previous_stencil) const;
+
+            bool operator==(const stencil& other) const = default;
 
 		private:
 	};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace corgi
@@ -57,7 +58,10 @@ enum class internal_format : char
     rg32_f,
     rg32_i,
     rg32_ui,
-    depth24_stencil8
+    depth24_stencil8,
+    rgba8,
+    rgba16_f,
+    depth_component24
 };
 
 enum class data_type : char
@@ -82,6 +86,34 @@ enum class wrap : char
     repeat               = 4
 };
 
+/*!
+ * @brief Returns the OpenGL enum matching the given internal format
+ */
+unsigned to_gl(internal_format format) noexcept;
+
+/*!
+ * @brief Returns the number of bytes used by one texel of the given format
+ *
+ * Unsized formats use the size drivers usually pick for them, rgb being
+ * padded to 4 bytes
+ */
+std::size_t bytes_per_texel(internal_format format) noexcept;
+
+/*!
+ * @brief Returns the number of levels in a complete mipmap chain for a
+ * texture of the given size
+ */
+unsigned mipmap_level_count(unsigned width, unsigned height) noexcept;
+
+/*!
+ * @brief Returns the number of bytes needed to store a texture of the given
+ * size and format, summing up the requested number of mipmap levels
+ */
+std::size_t texture_size_in_bytes(internal_format format,
+                                  unsigned        width,
+                                  unsigned        height,
+                                  unsigned        levels = 1) noexcept;
+
 struct create_info
 {
     min_filter      min_filter {min_filter::nearest};
@@ -120,17 +152,17 @@ public:
      * @brief	Generates a new texture
      *			Copies the name
      */
-    texture(const std::string& name,
-            unsigned           width,
-            unsigned           height,
-            min_filter         min_filter,
-            mag_filter         mag_filter,
-            wrap               wrap_s,
-            wrap               wrap_t,
-            format             format,
-            internal_format    internal_format,
-            data_type          dt,
-            unsigned char*     data = nullptr);
+    texture(const std::string&     name,
+            unsigned               width,
+            unsigned               height,
+            min_filter             min_filter,
+            mag_filter             mag_filter,
+            wrap                   wrap_s,
+            wrap                   wrap_t,
+            format                 format,
+            corgi::internal_format internal_format,
+            data_type              dt,
+            unsigned char*         data = nullptr);
 
     texture(texture&& texture) noexcept;
     texture(const texture& texture) = delete;
@@ -192,6 +224,16 @@ public:
     unsigned width() const noexcept;
     unsigned height() const noexcept;
 
+    corgi::internal_format internal_format() const noexcept;
+
+    /*!
+     * @brief Returns the number of bytes used by the texture on the GPU
+     *
+     * If the minification filter uses mipmaps, the whole mipmap chain is
+     * counted
+     */
+    std::size_t size_in_bytes() const noexcept;
+
     void width(unsigned width) noexcept;
     void height(unsigned height) noexcept;
 
@@ -277,7 +319,19 @@ public:
        height, Image::format, void * pixels);*/
 
 private:
-    void generate_opengl_texture();
+    /*!
+     * @param has_storage True if the texture name was recycled with storage
+     * of the right format and size already
+     */
+    void generate_opengl_texture(bool has_storage);
+
+    void track_memory() const;
+
+    /*!
+     * @brief Returns the number of mipmap levels the minification filter
+     * needs, 1 if it doesn't use mipmaps
+     */
+    unsigned level_count() const noexcept;
 
     void update_gl_min_filter();
     void update_gl_mag_filter();
@@ -300,10 +354,10 @@ private:
     unsigned width_ {0u};
     unsigned height_ {0u};
 
-    format          format_;
-    internal_format internal_format_;
-    data_type       data_type_;
-    void*           data_;
+    format                 format_ {format::rgba};
+    corgi::internal_format internal_format_ {internal_format::rgba};
+    data_type              data_type_ {data_type::unsigned_byte};
+    void*                  data_ {nullptr};
 
     // Total size : 20 bytes
 };
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <corgi/opengl/image.h>
+#include <corgi/opengl/texture.h>
+#include <corgi/opengl/thread_pool.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief How a streamed texture is sampled. Its size comes from the image,
+ * and pixels are always stored as rgba8
+ */
+struct stream_settings
+{
+    corgi::min_filter min {min_filter::linear};
+    corgi::mag_filter mag {mag_filter::linear};
+    wrap              wrap_s {wrap::repeat};
+    wrap              wrap_t {wrap::repeat};
+};
+
+enum class stream_state : char
+{
+    // Waiting for a worker to decode the file
+    decoding,
+    // Decoded, its rows are being sent to the GPU
+    uploading,
+    // Every row was sent, the texture can be used
+    resident,
+    // The file couldn't be decoded, or the image is too large for the ring
+    // or for GL_MAX_TEXTURE_SIZE
+    failed
+};
+
+/**
+ * @brief Loads textures in the background, so loading a level doesn't
+ * freeze the application
+ *
+ * Files are decoded on the workers of a thread pool. Once decoded, update()
+ * copies their pixels into a ring of persistently mapped pixel unpack
+ * buffers, and glTexSubImage2D reads them from there without the driver
+ * copying them again. A fence is inserted behind each frame's uploads, and
+ * its part of the ring is reused once the fence is signaled.
+ *
+ * update() never sends more than the frame budget : large images are sent a
+ * few rows at a time over several frames. A texture can be used once it is
+ * resident. The budget only counts the bytes sent : when the texture's
+ * min_filter uses mipmaps, glGenerateMipmap runs in the frame its last rows
+ * are sent and its cost isn't part of the budget.
+ *
+ * Every function must be called on the thread owning the OpenGL context.
+ */
+class texture_streamer
+{
+public:
+    using handle = std::uint32_t;
+
+    /**
+     * @param pool Workers decoding the files. Must outlive the jobs
+     * submitted to it, not the streamer
+     * @param ring_size Size of the pixel unpack buffer ring, in bytes. A row
+     * of an image must fit in it
+     * @param frame_budget Most bytes update() sends to the GPU
+     *
+     * @throws std::invalid_argument If ring_size or frame_budget is 0
+     * @throws std::runtime_error If the ring couldn't be mapped
+     */
+    texture_streamer(thread_pool& pool,
+                     std::size_t  ring_size    = 16 * 1024 * 1024,
+                     std::size_t  frame_budget = 4 * 1024 * 1024);
+
+    texture_streamer(const texture_streamer& other)            = delete;
+    texture_streamer& operator=(const texture_streamer& other) = delete;
+
+    ~texture_streamer();
+
+    /**
+     * @brief Queues a file to be decoded on the pool then uploaded
+     */
+    handle load(const std::string& path, stream_settings settings = {});
+
+    /**
+     * @brief Queues pixels already on the CPU to be uploaded. The image must
+     * have 4 channels
+     *
+     * @throws std::invalid_argument If the image is empty or doesn't have 4
+     * channels
+     */
+    handle load(image pixels, stream_settings settings = {});
+
+    /**
+     * @brief Collects the decoded images and sends pixels to the GPU, up to
+     * the frame budget. Call it once per frame
+     *
+     * Mipmaps of the textures completed by the call are generated on top of
+     * the budget
+     */
+    void update();
+
+    stream_state state(handle texture) const;
+
+    bool resident(handle texture) const;
+
+    /**
+     * @throws std::logic_error If the texture isn't resident yet
+     */
+    const texture& get(handle texture) const;
+
+    /**
+     * @brief Forgets a texture, deleting it if it was created. A texture
+     * still decoding is dropped once decoded
+     */
+    void release(handle texture);
+
+    /**
+     * @brief Returns the number of textures decoding or uploading
+     */
+    std::size_t pending() const noexcept;
+
+    std::size_t frame_budget() const noexcept { return frame_budget_; }
+
+    /**
+     * @throws std::invalid_argument If budget is 0
+     */
+    void frame_budget(std::size_t budget);
+
+    /**
+     * @brief Returns the number of bytes the last update sent
+     */
+    std::size_t uploaded_bytes() const noexcept { return uploaded_bytes_; }
+
+    std::size_t ring_size() const noexcept { return ring_size_; }
+
+private:
+    struct entry
+    {
+        stream_state             state {stream_state::decoding};
+        stream_settings          settings;
+        image                    pixels;
+        std::unique_ptr<texture> gpu;
+        // First row not sent yet
+        int next_row {0};
+    };
+
+    /**
+     * @brief Images handed over by the workers, kept alive by the jobs so
+     * the streamer doesn't have to wait for them when destroyed
+     */
+    struct decoded_queue
+    {
+        std::mutex                            mutex;
+        std::vector<std::pair<handle, image>> images;
+        std::vector<handle>                   failures;
+    };
+
+    struct in_flight
+    {
+        void*       fence {nullptr};
+        std::size_t begin {0};
+    };
+
+    const entry& find(handle texture, const char* function) const;
+
+    void        retire();
+    void        collect();
+    std::size_t free_block(std::size_t& offset) const;
+    bool        upload(entry& e, std::size_t& budget);
+
+    thread_pool&                   pool_;
+    std::shared_ptr<decoded_queue> decoded_;
+
+    std::unordered_map<handle, entry> entries_;
+    std::deque<handle>                uploads_;
+    handle                            next_handle_ {0};
+
+    unsigned       ring_ {0};
+    unsigned char* mapped_ {nullptr};
+    std::size_t    ring_size_;
+    std::size_t    head_ {0};
+
+    std::deque<in_flight> in_flight_;
+    // Part of the ring written by the current update, not fenced yet
+    std::size_t batch_begin_ {0};
+    bool        batch_used_ {false};
+
+    std::size_t frame_budget_;
+    std::size_t uploaded_bytes_ {0};
+    int         max_texture_size_ {0};
+};
+}    // namespace corgi
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Worker threads running jobs for the CPU side of rendering, like
+ * culling or decoding textures
+ *
+ * Jobs must not throw : an exception escaping a job terminates the program,
+ * like it would from any std::thread.
+ */
+class thread_pool
+{
+public:
+    using chunk_function = std::function<void(
+        std::size_t begin, std::size_t end, std::size_t chunk)>;
+
+    /**
+     * @param threads Number of worker threads, the hardware concurrency minus
+     * the calling thread by default
+     */
+    explicit thread_pool(std::size_t threads = default_thread_count());
+
+    thread_pool(const thread_pool& other)            = delete;
+    thread_pool& operator=(const thread_pool& other) = delete;
+
+    /**
+     * @brief Runs the jobs still in the queue then stops the workers
+     */
+    ~thread_pool();
+
+    /**
+     * @brief Queues a job to run on a worker
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Waits until every submitted job is done
+     */
+    void wait();
+
+    /**
+     * @brief Splits [0, count) in chunks of at least min_chunk elements and
+     * runs them on the workers and the calling thread, then returns once
+     * they are all done
+     *
+     * body is called with the first and past the last element of a chunk,
+     * and the index of the chunk. Chunks are numbered in order, up to
+     * max_chunks(), so results can be stored per chunk and gathered in order
+     */
+    void parallel_for(std::size_t           count,
+                      std::size_t           min_chunk,
+                      const chunk_function& body);
+
+    /**
+     * @brief Returns the number of worker threads
+     */
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    /**
+     * @brief Returns the most chunks parallel_for can split a loop into
+     */
+    std::size_t max_chunks() const noexcept { return workers_.size() + 1; }
+
+    static std::size_t default_thread_count();
+
+private:
+    void run();
+
+    std::mutex              mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+
+    std::deque<std::function<void()>> queue_;
+    std::size_t                       running_ {0};
+    bool                              stopping_ {false};
+
+    std::vector<std::thread> workers_;
+};
+}    // namespace corgi
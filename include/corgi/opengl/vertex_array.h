@@ -1,7 +1,10 @@
 #pragma once
 #include <corgi/opengl/buffer.h>
+#include <corgi/opengl/index_type.h>
 #include <corgi/opengl/vertex_attribute.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace corgi
@@ -14,6 +17,38 @@ enum class primitive_type : char
     lines
 };
 
+/**
+ * @brief Enables and describes the attributes on the vertex array currently
+ * bound, reading from the array buffer currently bound
+ *
+ * @param enabled_attributes Locations already enabled on the vertex array.
+ * The ones the attributes don't use are disabled
+ */
+void set_vertex_attributes(const std::vector<vertex_attribute>& attributes,
+                           std::uint32_t enabled_attributes = 0);
+
+/**
+ * @brief Enables and describes the attributes on the vertex array currently
+ * bound, reading from a vertex buffer binding point instead of the array
+ * buffer
+ *
+ * Only the format is stored : the buffer is attached later with
+ * glBindVertexBuffer, so vertex arrays can be shared by every mesh using the
+ * same layout
+ *
+ * @param enabled_attributes Locations already enabled on the vertex array.
+ * The ones the attributes don't use are disabled
+ */
+void set_vertex_formats(const std::vector<vertex_attribute>& attributes,
+                        unsigned                             binding = 0,
+                        std::uint32_t enabled_attributes = 0);
+
+/**
+ * @brief Describes how vertices are read from a vertex buffer
+ *
+ * The vertex array only keeps the names of the buffers it reads from : the
+ * buffers must outlive it.
+ */
 class vertex_array
 {
 public:
@@ -22,10 +57,19 @@ public:
      */
     vertex_array() = default;
 
-    vertex_array(
-        std::vector<vertex_attribute>                        vertex_attributes,
-        buffer<float, buffer_type::array_buffer>&            vertex_buffer,
-        buffer<unsigned, buffer_type::element_array_buffer>& index_buffer);
+    /**
+     * @brief Reads vertices from the vertex buffer, laid out as described by
+     * the attributes. Buffers can hold any type, the attributes tell how
+     * their bytes are read
+     */
+    template<class V, class I>
+    vertex_array(std::vector<vertex_attribute>                  vertex_attributes,
+                 buffer<V, buffer_type::array_buffer>&         vertex_buffer,
+                 buffer<I, buffer_type::element_array_buffer>& index_buffer)
+    {
+        set(vertex_buffer.id(), index_buffer.id(),
+            std::move(vertex_attributes));
+    }
 
     vertex_array(const vertex_array& other);
     vertex_array(vertex_array&& other) noexcept;
@@ -35,9 +79,13 @@ public:
 
     ~vertex_array();
 
-    void set(buffer<float, buffer_type::array_buffer>&           vertex_buffer,
-             buffer<unsigned, buffer_type::element_array_buffer> index_buffer,
-             std::vector<vertex_attribute>                       attributes);
+    template<class V, class I>
+    void set(buffer<V, buffer_type::array_buffer>&         vertex_buffer,
+             buffer<I, buffer_type::element_array_buffer>& index_buffer,
+             std::vector<vertex_attribute>                  attributes)
+    {
+        set(vertex_buffer.id(), index_buffer.id(), std::move(attributes));
+    }
 
     const std::vector<vertex_attribute>& vertex_attributes() const;
 
@@ -52,12 +100,15 @@ public:
     unsigned id() const;
 
 private:
+    void set(unsigned                      vertex_buffer,
+             unsigned                      index_buffer,
+             std::vector<vertex_attribute> attributes);
+
     void push_data();
 
-    unsigned                                  id_ {0};
-    buffer<float, buffer_type::array_buffer>* vertex_buffer_ {nullptr};
-    buffer<unsigned, buffer_type::element_array_buffer>* index_buffer_ {
-        nullptr};
+    unsigned                      id_ {0};
+    unsigned                      vertex_buffer_ {0};
+    unsigned                      index_buffer_ {0};
     std::vector<vertex_attribute> vertex_attributes_;
 };
-}    // namespace corgi
\ No newline at end of file
+}    // namespace corgi
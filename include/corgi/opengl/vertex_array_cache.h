@@ -0,0 +1,72 @@
+#pragma once
+
+#include <corgi/opengl/layout_registry.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace corgi
+{
+
+/**
+ * @brief Keeps one vertex array per vertex layout, shared by every mesh
+ * using that layout
+ *
+ * The vertex arrays only store the format of the attributes, with
+ * glVertexAttribFormat, and read from binding point 0. Binding a mesh
+ * attaches its vertex buffer with glBindVertexBuffer and its index buffer to
+ * the layout's vertex array, so going from a mesh to another never
+ * describes the attributes again.
+ *
+ * Vertex arrays are per context : the cache must only be used with the
+ * context it was created on. The renderer owns one.
+ */
+class vertex_array_cache
+{
+public:
+    vertex_array_cache() = default;
+
+    vertex_array_cache(const vertex_array_cache& other)            = delete;
+    vertex_array_cache& operator=(const vertex_array_cache& other) = delete;
+
+    ~vertex_array_cache();
+
+    /**
+     * @brief Returns the vertex array of the layout, creating it if needed
+     *
+     * @throws std::out_of_range If the id wasn't returned by the
+     * layout_registry
+     */
+    unsigned vertex_array(layout_id layout);
+
+    /**
+     * @brief Binds the layout's vertex array, reading from the given buffers
+     *
+     * The vertex array stays bound afterwards
+     */
+    void bind(layout_id layout, unsigned vertex_buffer, unsigned index_buffer);
+
+    /**
+     * @brief Returns the number of vertex arrays in the cache
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * @brief Gives every vertex array back to the gl_name_pool
+     */
+    void clear();
+
+private:
+    struct entry
+    {
+        unsigned id {0};
+        int      stride {0};
+    };
+
+    const entry& get(layout_id layout);
+
+    // Indexed by layout id, ids are small and dense
+    std::vector<entry> vertex_arrays_;
+    std::size_t        size_ {0};
+};
+}    // namespace corgi
@@ -1,54 +1,246 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <numeric>
+#include <span>
 #include <vector>
 
 namespace corgi
 {
+
+/**
+ * @brief Type of each component of an attribute, as stored in the vertex
+ * buffer
+ */
+enum class attribute_type : char
+{
+    float32,
+    float16,
+    int8,
+    uint8,
+    int16,
+    uint16,
+    int32,
+    uint32,
+    // 3 signed 10 bits components and a 2 bits one, packed in 32 bits
+    int_2_10_10_10_rev,
+    // 3 unsigned 10 bits components and a 2 bits one, packed in 32 bits
+    uint_2_10_10_10_rev
+};
+
+/**
+ * @brief How the shader sees the components of an attribute
+ */
+enum class attribute_mode : char
+{
+    // Converted to float as is
+    floating,
+    // Integers mapped to [0, 1], or [-1, 1] for signed types
+    normalized,
+    // Read as ints or uints by the shader. Only for integer types
+    integer
+};
+
+/**
+ * @brief Returns the size of one component of the given type, in bytes.
+ * Packed types return the size of the 4 components
+ */
+constexpr int attribute_type_size(attribute_type type) noexcept
+{
+    switch(type)
+    {
+        case attribute_type::int8:
+        case attribute_type::uint8:
+            return 1;
+        case attribute_type::float16:
+        case attribute_type::int16:
+        case attribute_type::uint16:
+            return 2;
+        case attribute_type::float32:
+        case attribute_type::int32:
+        case attribute_type::uint32:
+        case attribute_type::int_2_10_10_10_rev:
+        case attribute_type::uint_2_10_10_10_rev:
+            return 4;
+    }
+    return 4;
+}
+
+constexpr bool is_packed(attribute_type type) noexcept
+{
+    return type == attribute_type::int_2_10_10_10_rev ||
+           type == attribute_type::uint_2_10_10_10_rev;
+}
+
 /**
  * @brief Tells the GPU where to look for 1 attribute in the vertex
+ *
+ * Offsets are in bytes, from the start of the vertex
  */
 struct vertex_attribute
 {
-    int location {0};
-    int offset {0};
-    int size {0};
+    int            location {0};
+    int            offset {0};
+    int            size {0};
+    attribute_type type {attribute_type::float32};
+    attribute_mode mode {attribute_mode::floating};
 
-    vertex_attribute(int location, int offset, int size)
+    /**
+     * @brief Float attribute, in a vertex made of floats only
+     *
+     * @param offset Offset of the attribute, counted in floats
+     */
+    constexpr vertex_attribute(int location, int offset, int size)
         : location(location)
-        , offset(offset)
+        , offset(offset * static_cast<int>(sizeof(float)))
         , size(size)
     {
         // size must be in between 1 and 4
         assert(size >= 1 && size < 5);
     }
 
-    bool operator==(const vertex_attribute& other) const
+    /**
+     * @param byte_offset Offset of the attribute, in bytes
+     */
+    constexpr vertex_attribute(int            location,
+                               int            byte_offset,
+                               int            size,
+                               attribute_type type,
+                               attribute_mode mode)
+        : location(location)
+        , offset(byte_offset)
+        , size(size)
+        , type(type)
+        , mode(mode)
+    {
+        // size must be in between 1 and 4
+        assert(size >= 1 && size < 5);
+
+        // Packed types always hold 4 components
+        assert(!is_packed(type) || size == 4);
+
+        // Floats can't be read as integers
+        assert(mode != attribute_mode::integer ||
+               (type != attribute_type::float32 &&
+                type != attribute_type::float16 && !is_packed(type)));
+    }
+
+    /**
+     * @brief Returns the number of bytes the attribute takes in the vertex
+     */
+    constexpr int size_in_bytes() const noexcept
+    {
+        if(is_packed(type))
+            return attribute_type_size(type);
+        return size * attribute_type_size(type);
+    }
+
+    constexpr bool operator==(const vertex_attribute& other) const
     {
         return location == other.location && offset == other.offset &&
-               size == other.size;
+               size == other.size && type == other.type &&
+               mode == other.mode;
     }
 
-    bool operator!=(const vertex_attribute&& other) const
+    constexpr bool operator!=(const vertex_attribute& other) const
     {
         return !(*this == other);
     }
 };
 
-inline int
-attributes_total_size(const std::vector<vertex_attribute>& attributes)
+/**
+ * @brief Returns the number of floats in a vertex made of float attributes
+ * only
+ */
+constexpr int
+attributes_total_size(std::span<const vertex_attribute> attributes)
 {
     return std::accumulate(attributes.begin(), attributes.end(), 0,
                            [](int sum, const vertex_attribute& v)
                            { return sum + v.size; });
 }
 
+/**
+ * @brief Returns the size of a vertex, in bytes
+ *
+ * The vertex ends with its last attribute, rounded up to 4 bytes so every
+ * vertex stays aligned
+ */
+constexpr int attributes_stride(std::span<const vertex_attribute> attributes)
+{
+    int end = 0;
+    for(const auto& attribute : attributes)
+        end = std::max(end, attribute.offset + attribute.size_in_bytes());
+    return (end + 3) & ~3;
+}
+
+/**
+ * @brief Returns the vertex position, the attribute made of at least 2
+ * floats at location 0, or nullptr if there isn't one
+ */
+constexpr const vertex_attribute*
+find_position_attribute(std::span<const vertex_attribute> attributes)
+{
+    for(const auto& attribute : attributes)
+        if(attribute.location == 0 &&
+           attribute.type == attribute_type::float32 &&
+           attribute.mode == attribute_mode::floating && attribute.size >= 2)
+            return &attribute;
+    return nullptr;
+}
+
+/**
+ * @brief Returns a mask where bit i is set if an attribute uses location i.
+ * Locations must be in [0, 32), which layout_registry::intern makes sure of
+ */
+constexpr std::uint32_t
+attributes_locations(std::span<const vertex_attribute> attributes)
+{
+    std::uint32_t locations = 0;
+    for(const auto& attribute : attributes)
+        locations |= 1u << attribute.location;
+    return locations;
+}
+
+/**
+ * @brief Returns true if both attribute lists are the same, usable in
+ * static_assert
+ */
+constexpr bool attributes_equal(std::span<const vertex_attribute> a,
+                                std::span<const vertex_attribute> b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+// Layouts of the common shaders, known at compile time. See vertex_layout
+namespace common_layouts
+{
+// Inline so every translation unit, and the spans pointing to them, see the
+// same arrays
+inline constexpr std::array<vertex_attribute, 1> pos2 {{{0, 0, 2}}};
+inline constexpr std::array<vertex_attribute, 2> pos2_col3 {
+    {{0, 0, 2}, {1, 2, 3}}};
+inline constexpr std::array<vertex_attribute, 2> pos2_col4 {
+    {{0, 0, 2}, {1, 2, 4}}};
+inline constexpr std::array<vertex_attribute, 2> pos2_uv {
+    {{0, 0, 2}, {1, 2, 2}}};
+inline constexpr std::array<vertex_attribute, 1> pos3 {{{0, 0, 3}}};
+}    // namespace common_layouts
+
 namespace common_attributes
 {
-const inline std::vector<vertex_attribute> pos2 = {{0, 0, 2}};
-const inline std::vector<vertex_attribute> pos2_col3 {{0, 0, 2}, {1, 2, 3}};
-const inline std::vector<vertex_attribute> pos2_col4 {{0, 0, 2}, {1, 2, 4}};
-const inline std::vector<vertex_attribute> pos2_uv {{0, 0, 2}, {1, 2, 2}};
+const inline std::vector<vertex_attribute> pos2 {common_layouts::pos2.begin(),
+                                                 common_layouts::pos2.end()};
+const inline std::vector<vertex_attribute> pos2_col3 {
+    common_layouts::pos2_col3.begin(), common_layouts::pos2_col3.end()};
+const inline std::vector<vertex_attribute> pos2_col4 {
+    common_layouts::pos2_col4.begin(), common_layouts::pos2_col4.end()};
+const inline std::vector<vertex_attribute> pos2_uv {
+    common_layouts::pos2_uv.begin(), common_layouts::pos2_uv.end()};
+const inline std::vector<vertex_attribute> pos3 {common_layouts::pos3.begin(),
+                                                 common_layouts::pos3.end()};
 
 }    // namespace common_attributes
 }    // namespace corgi
\ No newline at end of file
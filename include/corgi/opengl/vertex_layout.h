@@ -0,0 +1,342 @@
+#pragma once
+
+#include <corgi/opengl/layout_registry.h>
+#include <corgi/opengl/shaders.h>
+#include <corgi/opengl/vertex_attribute.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corgi
+{
+
+// Field types with no C++ equivalent. Fill them with the functions of
+// vertex_packing.h
+
+// 4 bytes read as floats in [0, 1], for colors
+struct unorm8x4
+{
+    std::array<std::uint8_t, 4> value {};
+};
+
+// 2 half floats, see pack_half
+struct half2
+{
+    std::array<std::uint16_t, 2> value {};
+};
+
+// 4 half floats, see pack_half
+struct half4
+{
+    std::array<std::uint16_t, 4> value {};
+};
+
+// 3 signed 10 bits and a 2 bits component read as floats in [-1, 1], for
+// normals and tangents. See pack_snorm_2_10_10_10
+struct packed_2_10_10_10
+{
+    std::uint32_t value {0};
+};
+
+/**
+ * @brief Tells how a field of a vertex struct is read by the GPU
+ *
+ * Only specialized for the types vertices can hold : using any other type
+ * in a vertex_layout doesn't compile
+ */
+template<class Field>
+struct attribute_traits;
+
+template<int            Size,
+         attribute_type Type,
+         attribute_mode Mode = attribute_mode::floating>
+struct attribute_traits_base
+{
+    static constexpr int            size = Size;
+    static constexpr attribute_type type = Type;
+    static constexpr attribute_mode mode = Mode;
+};
+
+template<>
+struct attribute_traits<float>
+    : attribute_traits_base<1, attribute_type::float32>
+{
+};
+
+template<std::size_t N>
+struct attribute_traits<std::array<float, N>>
+    : attribute_traits_base<N, attribute_type::float32>
+{
+    static_assert(N >= 1 && N <= 4, "Attributes hold 1 to 4 components");
+};
+
+template<>
+struct attribute_traits<std::int32_t>
+    : attribute_traits_base<1,
+                            attribute_type::int32,
+                            attribute_mode::integer>
+{
+};
+
+template<>
+struct attribute_traits<std::uint32_t>
+    : attribute_traits_base<1,
+                            attribute_type::uint32,
+                            attribute_mode::integer>
+{
+};
+
+template<std::size_t N>
+struct attribute_traits<std::array<std::int32_t, N>>
+    : attribute_traits_base<N,
+                            attribute_type::int32,
+                            attribute_mode::integer>
+{
+    static_assert(N >= 1 && N <= 4, "Attributes hold 1 to 4 components");
+};
+
+template<std::size_t N>
+struct attribute_traits<std::array<std::uint32_t, N>>
+    : attribute_traits_base<N,
+                            attribute_type::uint32,
+                            attribute_mode::integer>
+{
+    static_assert(N >= 1 && N <= 4, "Attributes hold 1 to 4 components");
+};
+
+template<>
+struct attribute_traits<unorm8x4>
+    : attribute_traits_base<4,
+                            attribute_type::uint8,
+                            attribute_mode::normalized>
+{
+};
+
+template<>
+struct attribute_traits<half2>
+    : attribute_traits_base<2, attribute_type::float16>
+{
+};
+
+template<>
+struct attribute_traits<half4>
+    : attribute_traits_base<4, attribute_type::float16>
+{
+};
+
+template<>
+struct attribute_traits<packed_2_10_10_10>
+    : attribute_traits_base<4,
+                            attribute_type::int_2_10_10_10_rev,
+                            attribute_mode::normalized>
+{
+};
+
+/**
+ * @brief Builds the attribute reading a field of type Field at the given
+ * byte offset. Use CORGI_VERTEX_ATTRIBUTE rather than calling it directly
+ */
+template<class Field>
+constexpr vertex_attribute make_vertex_attribute(int         location,
+                                                 std::size_t offset)
+{
+    using traits = attribute_traits<Field>;
+
+    constexpr vertex_attribute attribute(0, 0, traits::size, traits::type,
+                                         traits::mode);
+
+    static_assert(attribute.size_in_bytes() == sizeof(Field),
+                  "Field doesn't have the size of the attribute reading it");
+
+    return {location, static_cast<int>(offset), traits::size, traits::type,
+            traits::mode};
+}
+
+/**
+ * @brief Attribute reading the member of a vertex struct, at the given
+ * location. The struct must be standard layout
+ */
+#define CORGI_VERTEX_ATTRIBUTE(Vertex, member, location)                     \
+    ::corgi::make_vertex_attribute<decltype(Vertex::member)>(                \
+        location, offsetof(Vertex, member))
+
+/**
+ * @brief Describes the fields of a vertex struct, once, at compile time
+ *
+ * Specialize it with a constexpr std::array named attributes :
+ *
+ * template<>
+ * struct corgi::vertex_layout<my_vertex>
+ * {
+ *     static constexpr std::array attributes {
+ *         CORGI_VERTEX_ATTRIBUTE(my_vertex, position, 0),
+ *         CORGI_VERTEX_ATTRIBUTE(my_vertex, color, 1)};
+ * };
+ *
+ * Stride, offsets and types are then known at compile time, and checking a
+ * vertex against a shader's layout is a static_assert, see layout_matches
+ */
+template<class Vertex>
+struct vertex_layout;
+
+template<class Vertex>
+concept has_vertex_layout = requires {
+    {
+        std::span<const vertex_attribute>(vertex_layout<Vertex>::attributes)
+    };
+};
+
+/**
+ * @brief Returns true if no location is used twice and no attribute
+ * overlaps another one
+ */
+constexpr bool layout_is_valid(std::span<const vertex_attribute> attributes)
+{
+    for(std::size_t i = 0; i < attributes.size(); i++)
+    {
+        const auto& a = attributes[i];
+
+        if(a.location < 0 || a.location >= 32 || a.offset < 0)
+            return false;
+
+        for(std::size_t j = i + 1; j < attributes.size(); j++)
+        {
+            const auto& b = attributes[j];
+
+            if(a.location == b.location)
+                return false;
+
+            if(a.offset < b.offset + b.size_in_bytes() &&
+               b.offset < a.offset + a.size_in_bytes())
+                return false;
+        }
+    }
+    return !attributes.empty();
+}
+
+template<has_vertex_layout Vertex>
+inline constexpr int vertex_stride_v =
+    attributes_stride(vertex_layout<Vertex>::attributes);
+
+/**
+ * @brief Returns true if the vertex struct is read with the given attributes,
+ * for instance one of the common_layouts or the attributes of a constexpr
+ * shader_content :
+ *
+ * static_assert(layout_matches<my_vertex>(my_shader.attributes));
+ */
+template<has_vertex_layout Vertex>
+constexpr bool layout_matches(std::span<const vertex_attribute> attributes)
+{
+    return attributes_equal(vertex_layout<Vertex>::attributes, attributes);
+}
+
+/**
+ * @brief Returns the attributes of the vertex struct, built once
+ */
+template<has_vertex_layout Vertex>
+const std::vector<vertex_attribute>& attributes_of()
+{
+    static const std::vector<vertex_attribute> attributes(
+        vertex_layout<Vertex>::attributes.begin(),
+        vertex_layout<Vertex>::attributes.end());
+    return attributes;
+}
+
+/**
+ * @brief Returns the layout_registry id of the vertex struct, registered the
+ * first time only
+ */
+template<has_vertex_layout Vertex>
+layout_id layout_of()
+{
+    static_assert(layout_is_valid(vertex_layout<Vertex>::attributes),
+                  "Vertex layout uses a location twice or has overlapping "
+                  "attributes");
+
+    static_assert(vertex_stride_v<Vertex> == sizeof(Vertex),
+                  "Vertex struct has padding the layout doesn't account for");
+
+    static const layout_id id =
+        layout_registry::instance().intern(attributes_of<Vertex>());
+    return id;
+}
+
+// Vertex structs matching the common_layouts
+namespace common_vertices
+{
+struct pos2
+{
+    std::array<float, 2> position;
+};
+
+struct pos2_col3
+{
+    std::array<float, 2> position;
+    std::array<float, 3> color;
+};
+
+struct pos2_col4
+{
+    std::array<float, 2> position;
+    std::array<float, 4> color;
+};
+
+struct pos2_uv
+{
+    std::array<float, 2> position;
+    std::array<float, 2> uv;
+};
+
+struct pos3
+{
+    std::array<float, 3> position;
+};
+}    // namespace common_vertices
+
+template<>
+struct vertex_layout<common_vertices::pos2>
+{
+    static constexpr auto attributes = common_layouts::pos2;
+};
+
+template<>
+struct vertex_layout<common_vertices::pos2_col3>
+{
+    static constexpr auto attributes = common_layouts::pos2_col3;
+};
+
+template<>
+struct vertex_layout<common_vertices::pos2_col4>
+{
+    static constexpr auto attributes = common_layouts::pos2_col4;
+};
+
+template<>
+struct vertex_layout<common_vertices::pos2_uv>
+{
+    static constexpr auto attributes = common_layouts::pos2_uv;
+};
+
+template<>
+struct vertex_layout<common_vertices::pos3>
+{
+    static constexpr auto attributes = common_layouts::pos3;
+};
+
+static_assert(layout_matches<common_vertices::pos2_uv>(std::array {
+    CORGI_VERTEX_ATTRIBUTE(common_vertices::pos2_uv, position, 0),
+    CORGI_VERTEX_ATTRIBUTE(common_vertices::pos2_uv, uv, 1)}));
+
+// The common vertices can be drawn by the common shaders
+static_assert(layout_matches<common_vertices::pos2>(
+    common_shaders::simple_2d_vertex_shader.attributes));
+static_assert(layout_matches<common_vertices::pos2_uv>(
+    common_shaders::simple_2d_texture_vertex_shader.attributes));
+static_assert(layout_matches<common_vertices::pos3>(
+    common_shaders::occlusion_proxy_vertex_shader.attributes));
+
+}    // namespace corgi
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace corgi
+{
+
+/**
+ * @brief Converts a float to a IEEE half float, rounding to nearest even
+ *
+ * Values too big for a half become infinity, NaN stays NaN
+ */
+inline std::uint16_t pack_half(float value) noexcept
+{
+    const auto bits = std::bit_cast<std::uint32_t>(value);
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+
+    const int      exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+    std::uint32_t  mantissa = bits & 0x7FFFFF;
+
+    // NaN and infinity
+    if(((bits >> 23) & 0xFF) == 0xFF)
+        return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+
+    if(exponent >= 31)
+        return sign | 0x7C00;
+
+    // Too small even for a denormal half
+    if(exponent <= -10)
+        return sign;
+
+    if(exponent <= 0)
+    {
+        // Denormal half : the implicit leading 1 becomes explicit
+        mantissa |= 0x800000;
+        const int     shift   = 14 - exponent;
+        std::uint32_t half    = mantissa >> shift;
+        const auto    rest    = mantissa & ((1u << shift) - 1);
+        const auto    halfway = 1u << (shift - 1);
+
+        if(rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return static_cast<std::uint16_t>(sign | half);
+    }
+
+    std::uint32_t half = (std::uint32_t(exponent) << 10) | (mantissa >> 13);
+    const auto    rest = mantissa & 0x1FFF;
+
+    // A carry can go into the exponent, which is still correct
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+/**
+ * @brief Packs 4 floats in [-1, 1] into the int_2_10_10_10_rev format,
+ * x in the lowest bits. Meant for normals and tangents
+ */
+inline std::uint32_t
+pack_snorm_2_10_10_10(float x, float y, float z, float w = 0.0F) noexcept
+{
+    auto pack = [](float value, float scale, unsigned bits) -> std::uint32_t
+    {
+        const auto v = static_cast<std::int32_t>(
+            std::lround(std::clamp(value, -1.0F, 1.0F) * scale));
+        return static_cast<std::uint32_t>(v) & ((1u << bits) - 1);
+    };
+
+    return pack(x, 511.0F, 10) | (pack(y, 511.0F, 10) << 10) |
+           (pack(z, 511.0F, 10) << 20) | (pack(w, 1.0F, 2) << 30);
+}
+
+/**
+ * @brief Packs a float in [0, 1] into an unsigned byte, used for colors
+ */
+inline std::uint8_t pack_unorm8(float value) noexcept
+{
+    return static_cast<std::uint8_t>(
+        std::lround(std::clamp(value, 0.0F, 1.0F) * 255.0F));
+}
+
+}    // namespace corgi
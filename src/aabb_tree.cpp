@@ -0,0 +1,586 @@
+#include <corgi/opengl/aabb_tree.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace corgi
+{
+
+namespace
+{
+
+using box = std::array<float, 4>;
+
+box to_box(const aabb& bounds)
+{
+    return {bounds.min[0], bounds.min[1], bounds.max[0], bounds.max[1]};
+}
+
+box merged(const box& a, const box& b)
+{
+    return {std::min(a[0], b[0]), std::min(a[1], b[1]), std::max(a[2], b[2]),
+            std::max(a[3], b[3])};
+}
+
+/**
+ * @brief Cost of a box when looking for where to insert a leaf. The
+ * perimeter is the 2D counterpart of the surface area heuristic
+ */
+float perimeter(const box& b)
+{
+    return 2.0F * ((b[2] - b[0]) + (b[3] - b[1]));
+}
+
+bool contains(const box& outer, const box& inner)
+{
+    return outer[0] <= inner[0] && outer[1] <= inner[1] &&
+           outer[2] >= inner[2] && outer[3] >= inner[3];
+}
+
+bool overlaps(const box& a, const box& b)
+{
+    return a[0] <= b[2] && a[2] >= b[0] && a[1] <= b[3] && a[3] >= b[1];
+}
+
+float squared_distance(const box& b, float x, float y)
+{
+    const float dx = std::max({b[0] - x, 0.0F, x - b[2]});
+    const float dy = std::max({b[1] - y, 0.0F, y - b[3]});
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Nodes left to visit. A balanced tree never needs more than the
+ * local array, deeper ones spill to the heap
+ */
+class node_stack
+{
+public:
+    void push(std::uint32_t index)
+    {
+        if(size_ < local_.size())
+            local_[size_] = index;
+        else
+            heap_.push_back(index);
+        size_++;
+    }
+
+    std::uint32_t pop()
+    {
+        size_--;
+        if(size_ < local_.size())
+            return local_[size_];
+
+        const auto index = heap_.back();
+        heap_.pop_back();
+        return index;
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+
+private:
+    std::array<std::uint32_t, 64> local_;
+    std::vector<std::uint32_t>    heap_;
+    std::size_t                   size_ {0};
+};
+
+}    // namespace
+
+aabb_tree::aabb_tree(float margin)
+    : margin_(margin)
+{
+    if(margin < 0.0F)
+        throw std::invalid_argument(
+            "aabb_tree::aabb_tree : margin can't be negative");
+}
+
+aabb_tree::box aabb_tree::fatten(const box& tight) const noexcept
+{
+    return {tight[0] - margin_, tight[1] - margin_, tight[2] + margin_,
+            tight[3] + margin_};
+}
+
+void aabb_tree::check_proxy(std::uint32_t proxy, const char* function) const
+{
+    if(proxy >= nodes_.size() || nodes_[proxy].height != 0)
+        throw std::out_of_range(std::string("aabb_tree::") + function +
+                                " : Unknown proxy");
+}
+
+std::uint32_t aabb_tree::allocate()
+{
+    if(free_ == null)
+    {
+        nodes_.emplace_back();
+        return static_cast<std::uint32_t>(nodes_.size() - 1);
+    }
+
+    const auto index = free_;
+    free_            = nodes_[index].parent;
+    nodes_[index]    = node {};
+    return index;
+}
+
+void aabb_tree::release(std::uint32_t index)
+{
+    nodes_[index]        = node {};
+    nodes_[index].parent = free_;
+    free_                = index;
+}
+
+void aabb_tree::clear() noexcept
+{
+    nodes_.clear();
+    root_ = null;
+    free_ = null;
+    size_ = 0;
+}
+
+void aabb_tree::build(std::span<const aabb> bounds)
+{
+    for(const auto& b : bounds)
+        if(b.empty())
+            throw std::invalid_argument(
+                "aabb_tree::build : Bounds can't be empty");
+
+    clear();
+
+    if(bounds.empty())
+        return;
+
+    // Leaves come first, so each proxy is the index of its bounds
+    nodes_.reserve(2 * bounds.size() - 1);
+    nodes_.resize(bounds.size());
+
+    std::vector<std::uint32_t> leaves(bounds.size());
+
+    for(std::size_t i = 0; i < bounds.size(); i++)
+    {
+        auto& leaf  = nodes_[i];
+        leaf.tight  = to_box(bounds[i]);
+        leaf.fat    = fatten(leaf.tight);
+        leaf.object = static_cast<std::uint32_t>(i);
+        leaf.height = 0;
+        leaves[i]   = static_cast<std::uint32_t>(i);
+    }
+
+    root_ = build_range(leaves.data(), leaves.data() + leaves.size());
+    size_ = bounds.size();
+}
+
+std::uint32_t aabb_tree::build_range(std::uint32_t* begin, std::uint32_t* end)
+{
+    if(end - begin == 1)
+        return *begin;
+
+    // Splits at the median of the centers, along the axis they spread the
+    // most on
+    box centers {std::numeric_limits<float>::max(),
+                 std::numeric_limits<float>::max(),
+                 std::numeric_limits<float>::lowest(),
+                 std::numeric_limits<float>::lowest()};
+
+    for(auto it = begin; it != end; it++)
+    {
+        const auto& b = nodes_[*it].fat;
+        const float x = b[0] + b[2];
+        const float y = b[1] + b[3];
+        centers       = merged(centers, {x, y, x, y});
+    }
+
+    const int axis =
+        centers[2] - centers[0] >= centers[3] - centers[1] ? 0 : 1;
+    const auto middle = begin + (end - begin) / 2;
+
+    std::nth_element(begin, middle, end,
+                     [&](std::uint32_t a, std::uint32_t b)
+                     {
+                         const auto& box_a = nodes_[a].fat;
+                         const auto& box_b = nodes_[b].fat;
+                         return box_a[axis] + box_a[axis + 2] <
+                                box_b[axis] + box_b[axis + 2];
+                     });
+
+    const auto left  = build_range(begin, middle);
+    const auto right = build_range(middle, end);
+    const auto index = allocate();
+
+    auto& n = nodes_[index];
+    n.left  = left;
+    n.right = right;
+    n.fat   = merged(nodes_[left].fat, nodes_[right].fat);
+    n.height = 1 + std::max(nodes_[left].height, nodes_[right].height);
+
+    nodes_[left].parent  = index;
+    nodes_[right].parent = index;
+
+    return index;
+}
+
+std::uint32_t aabb_tree::insert(const aabb& bounds, std::uint32_t object)
+{
+    if(bounds.empty())
+        throw std::invalid_argument(
+            "aabb_tree::insert : Bounds can't be empty");
+
+    const auto leaf = allocate();
+
+    auto& n  = nodes_[leaf];
+    n.tight  = to_box(bounds);
+    n.fat    = fatten(n.tight);
+    n.object = object;
+    n.height = 0;
+
+    insert_leaf(leaf);
+    size_++;
+
+    return leaf;
+}
+
+bool aabb_tree::move(std::uint32_t proxy, const aabb& bounds)
+{
+    check_proxy(proxy, "move");
+
+    if(bounds.empty())
+        throw std::invalid_argument(
+            "aabb_tree::move : Bounds can't be empty");
+
+    auto& n = nodes_[proxy];
+    n.tight = to_box(bounds);
+
+    // A fat box far larger than needed, after the object shrank, would only
+    // slow queries down
+    const float loose = 4.0F * margin_;
+    const bool  fits  = contains(n.fat, n.tight) &&
+                      n.fat[0] >= n.tight[0] - loose &&
+                      n.fat[1] >= n.tight[1] - loose &&
+                      n.fat[2] <= n.tight[2] + loose &&
+                      n.fat[3] <= n.tight[3] + loose;
+
+    if(fits)
+        return false;
+
+    remove_leaf(proxy);
+    nodes_[proxy].fat = fatten(nodes_[proxy].tight);
+    insert_leaf(proxy);
+
+    return true;
+}
+
+void aabb_tree::remove(std::uint32_t proxy)
+{
+    check_proxy(proxy, "remove");
+
+    remove_leaf(proxy);
+    release(proxy);
+    size_--;
+}
+
+void aabb_tree::insert_leaf(std::uint32_t leaf)
+{
+    if(root_ == null)
+    {
+        root_               = leaf;
+        nodes_[leaf].parent = null;
+        return;
+    }
+
+    const auto leaf_box = nodes_[leaf].fat;
+
+    // Walks down to the sibling that grows the tree the least
+    auto index = root_;
+
+    while(!nodes_[index].leaf())
+    {
+        const auto& n = nodes_[index];
+
+        const float area     = perimeter(n.fat);
+        const float combined = perimeter(merged(n.fat, leaf_box));
+
+        // Pairing the leaf with this node makes a new parent here
+        const float cost = 2.0F * combined;
+
+        // Going down grows this node anyway
+        const float inheritance = 2.0F * (combined - area);
+
+        auto descent_cost = [&](std::uint32_t child)
+        {
+            const auto& c     = nodes_[child];
+            const float grown = perimeter(merged(c.fat, leaf_box));
+
+            if(c.leaf())
+                return grown + inheritance;
+            return grown - perimeter(c.fat) + inheritance;
+        };
+
+        const float cost_left  = descent_cost(n.left);
+        const float cost_right = descent_cost(n.right);
+
+        if(cost < cost_left && cost < cost_right)
+            break;
+
+        index = cost_left < cost_right ? n.left : n.right;
+    }
+
+    const auto sibling    = index;
+    const auto old_parent = nodes_[sibling].parent;
+    const auto new_parent = allocate();
+
+    auto& p  = nodes_[new_parent];
+    p.parent = old_parent;
+    p.fat    = merged(leaf_box, nodes_[sibling].fat);
+    p.height = nodes_[sibling].height + 1;
+    p.left   = sibling;
+    p.right  = leaf;
+
+    if(old_parent == null)
+        root_ = new_parent;
+    else if(nodes_[old_parent].left == sibling)
+        nodes_[old_parent].left = new_parent;
+    else
+        nodes_[old_parent].right = new_parent;
+
+    nodes_[sibling].parent = new_parent;
+    nodes_[leaf].parent    = new_parent;
+
+    for(index = new_parent; index != null; index = nodes_[index].parent)
+    {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+void aabb_tree::remove_leaf(std::uint32_t leaf)
+{
+    if(leaf == root_)
+    {
+        root_ = null;
+        return;
+    }
+
+    const auto parent      = nodes_[leaf].parent;
+    const auto grandparent = nodes_[parent].parent;
+    const auto sibling     = nodes_[parent].left == leaf
+                                 ? nodes_[parent].right
+                                 : nodes_[parent].left;
+
+    release(parent);
+    nodes_[leaf].parent    = null;
+    nodes_[sibling].parent = grandparent;
+
+    if(grandparent == null)
+    {
+        root_ = sibling;
+        return;
+    }
+
+    if(nodes_[grandparent].left == parent)
+        nodes_[grandparent].left = sibling;
+    else
+        nodes_[grandparent].right = sibling;
+
+    for(auto index = grandparent; index != null; index = nodes_[index].parent)
+    {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+void aabb_tree::refit(std::uint32_t index)
+{
+    auto&       n     = nodes_[index];
+    const auto& left  = nodes_[n.left];
+    const auto& right = nodes_[n.right];
+
+    n.fat    = merged(left.fat, right.fat);
+    n.height = 1 + std::max(left.height, right.height);
+}
+
+std::uint32_t aabb_tree::balance(std::uint32_t index)
+{
+    auto& a = nodes_[index];
+
+    if(a.leaf() || a.height < 2)
+        return index;
+
+    // Lifts the taller child in place of a, a taking one of its children
+    const auto lift = [&](std::uint32_t up, bool up_is_right)
+    {
+        auto&      u       = nodes_[up];
+        const auto other   = up_is_right ? a.left : a.right;
+        const auto inner_1 = u.left;
+        const auto inner_2 = u.right;
+
+        u.left   = index;
+        u.parent = a.parent;
+        a.parent = up;
+
+        if(u.parent == null)
+            root_ = up;
+        else if(nodes_[u.parent].left == index)
+            nodes_[u.parent].left = up;
+        else
+            nodes_[u.parent].right = up;
+
+        // The taller grandchild stays with up, the other goes to a
+        auto kept  = inner_1;
+        auto given = inner_2;
+        if(nodes_[inner_2].height > nodes_[inner_1].height)
+            std::swap(kept, given);
+
+        u.right              = kept;
+        nodes_[given].parent = index;
+
+        if(up_is_right)
+            a.right = given;
+        else
+            a.left = given;
+
+        a.fat    = merged(nodes_[other].fat, nodes_[given].fat);
+        a.height = 1 + std::max(nodes_[other].height, nodes_[given].height);
+        u.fat    = merged(a.fat, nodes_[kept].fat);
+        u.height = 1 + std::max(a.height, nodes_[kept].height);
+
+        return up;
+    };
+
+    const int difference = nodes_[a.right].height - nodes_[a.left].height;
+
+    if(difference > 1)
+        return lift(a.right, true);
+    if(difference < -1)
+        return lift(a.left, false);
+
+    return index;
+}
+
+template<class Enter, class Visit>
+void aabb_tree::traverse(const Enter& enter, const Visit& visit) const
+{
+    if(root_ == null)
+        return;
+
+    node_stack stack;
+    stack.push(root_);
+
+    while(!stack.empty())
+    {
+        const auto& n = nodes_[stack.pop()];
+
+        if(!enter(n.fat))
+            continue;
+
+        if(n.leaf())
+        {
+            visit(n);
+            continue;
+        }
+
+        stack.push(n.left);
+        stack.push(n.right);
+    }
+}
+
+void aabb_tree::query(const view_rect&            rect,
+                      std::vector<std::uint32_t>& objects) const
+{
+    const box area {rect.left, rect.bottom, rect.right, rect.top};
+
+    traverse([&](const box& b) { return overlaps(b, area); },
+             [&](const node& leaf)
+             {
+                 if(overlaps(leaf.tight, area))
+                     objects.push_back(leaf.object);
+             });
+}
+
+void aabb_tree::query(float                       x,
+                      float                       y,
+                      std::vector<std::uint32_t>& objects) const
+{
+    const box point {x, y, x, y};
+
+    traverse([&](const box& b) { return overlaps(b, point); },
+             [&](const node& leaf)
+             {
+                 if(overlaps(leaf.tight, point))
+                     objects.push_back(leaf.object);
+             });
+}
+
+std::uint32_t aabb_tree::nearest(float x, float y, float max_distance) const
+{
+    std::uint32_t best          = null;
+    float         best_distance = max_distance * max_distance;
+
+    if(root_ == null ||
+       squared_distance(nodes_[root_].fat, x, y) > best_distance)
+        return null;
+
+    node_stack stack;
+    stack.push(root_);
+
+    while(!stack.empty())
+    {
+        const auto& n = nodes_[stack.pop()];
+
+        // Something closer may have been found since the node was pushed
+        if(squared_distance(n.fat, x, y) > best_distance)
+            continue;
+
+        if(n.leaf())
+        {
+            const float distance = squared_distance(n.tight, x, y);
+
+            if(distance < best_distance ||
+               (best == null && distance <= best_distance))
+            {
+                best          = n.object;
+                best_distance = distance;
+            }
+            continue;
+        }
+
+        // The closer child is pushed last, to be visited first
+        auto near_child = n.left;
+        auto far_child  = n.right;
+
+        float near_distance = squared_distance(nodes_[near_child].fat, x, y);
+        float far_distance  = squared_distance(nodes_[far_child].fat, x, y);
+
+        if(far_distance < near_distance)
+        {
+            std::swap(near_child, far_child);
+            std::swap(near_distance, far_distance);
+        }
+
+        if(far_distance <= best_distance)
+            stack.push(far_child);
+        if(near_distance <= best_distance)
+            stack.push(near_child);
+    }
+
+    return best;
+}
+
+std::uint32_t aabb_tree::object(std::uint32_t proxy) const
+{
+    check_proxy(proxy, "object");
+    return nodes_[proxy].object;
+}
+
+aabb aabb_tree::bounds(std::uint32_t proxy) const
+{
+    check_proxy(proxy, "bounds");
+
+    const auto& b = nodes_[proxy].tight;
+    return {{b[0], b[1], 0.0F}, {b[2], b[3], 0.0F}};
+}
+
+int aabb_tree::height() const noexcept
+{
+    return root_ == null ? 0 : nodes_[root_].height;
+}
+
+}    // namespace corgi
@@ -0,0 +1,195 @@
+#include <corgi/opengl/bounds.h>
+
+#include <cmath>
+#include <cstring>
+
+#include "simd.h"
+
+namespace corgi
+{
+
+/**
+ * @brief Returns the number of vertices whose attribute can be read as 4
+ * floats without going past the end of the stream
+ */
+[[maybe_unused]] static std::size_t wide_count(std::size_t count,
+                                               std::size_t size,
+                                               std::size_t stride,
+                                               std::size_t offset)
+{
+    if(size < offset + 4 * sizeof(float))
+        return 0;
+    return std::min(count, (size - offset - 4 * sizeof(float)) / stride + 1);
+}
+
+static std::array<float, 3> read_point(const std::byte* attribute,
+                                       int              components)
+{
+    std::array<float, 3> p {0.0F, 0.0F, 0.0F};
+    std::memcpy(p.data(), attribute,
+                static_cast<std::size_t>(components) * sizeof(float));
+    return p;
+}
+
+aabb compute_aabb(std::span<const std::byte> vertices,
+                  std::size_t                stride,
+                  std::size_t                offset,
+                  int                        components)
+{
+    components = std::clamp(components, 1, 3);
+
+    const auto count = vertices.size() / stride;
+
+    aabb        bounds;
+    std::size_t v = 0;
+
+#ifdef CORGI_OPENGL_SSE
+    const auto wide = wide_count(count, vertices.size(), stride, offset);
+
+    if(wide != 0)
+    {
+        // Lanes past the attribute's components read the next attribute,
+        // they are dropped at the end. Two accumulators to hide the latency
+        // of min and max
+        __m128 min0 = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 max0 = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        __m128 min1 = min0;
+        __m128 max1 = max0;
+
+        const std::byte* attribute = vertices.data() + offset;
+
+        for(; v + 1 < wide; v += 2, attribute += 2 * stride)
+        {
+            const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(attribute));
+            const __m128 b = _mm_loadu_ps(
+                reinterpret_cast<const float*>(attribute + stride));
+
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+            min1 = _mm_min_ps(min1, b);
+            max1 = _mm_max_ps(max1, b);
+        }
+
+        for(; v < wide; v++, attribute += stride)
+        {
+            const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(attribute));
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+        }
+
+        float lowest[4];
+        float highest[4];
+        _mm_storeu_ps(lowest, _mm_min_ps(min0, min1));
+        _mm_storeu_ps(highest, _mm_max_ps(max0, max1));
+
+        for(int i = 0; i < 3; i++)
+        {
+            bounds.min[i] = i < components ? lowest[i] : 0.0F;
+            bounds.max[i] = i < components ? highest[i] : 0.0F;
+        }
+    }
+#endif
+
+    // The last vertices, or all of them without SSE
+    for(; v < count; v++)
+        bounds.expand(read_point(vertices.data() + v * stride + offset, components));
+
+    return bounds;
+}
+
+bounding_sphere compute_bounding_sphere(std::span<const std::byte> vertices,
+                                        std::size_t                stride,
+                                        std::size_t                offset,
+                                        int                        components,
+                                        const aabb&                box)
+{
+    if(box.empty())
+        return {};
+
+    components = std::clamp(components, 1, 3);
+
+    const auto count  = vertices.size() / stride;
+    const auto center = box.center();
+
+    float       radius2 = 0.0F;
+    std::size_t v       = 0;
+
+#ifdef CORGI_OPENGL_SSE
+    const auto wide = wide_count(count, vertices.size(), stride, offset);
+
+    if(wide != 0)
+    {
+        const __m128 c = _mm_setr_ps(center[0], center[1], center[2], 0.0F);
+
+        // Keeps the lanes of the attribute's components only
+        alignas(16) std::uint32_t lanes[4] {};
+        for(int i = 0; i < components; i++)
+            lanes[i] = 0xFFFFFFFFu;
+        const __m128 mask = _mm_load_ps(reinterpret_cast<const float*>(lanes));
+
+        __m128 farthest = _mm_setzero_ps();
+
+        const std::byte* attribute = vertices.data() + offset;
+
+        for(; v < wide; v++, attribute += stride)
+        {
+            __m128 d = _mm_sub_ps(
+                _mm_loadu_ps(reinterpret_cast<const float*>(attribute)), c);
+            d        = _mm_and_ps(d, mask);
+            d        = _mm_mul_ps(d, d);
+
+            // Horizontal sum, every lane ends up with x² + y² + z²
+            d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+            d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+
+            farthest = _mm_max_ps(farthest, d);
+        }
+        radius2 = _mm_cvtss_f32(farthest);
+    }
+#endif
+
+    for(; v < count; v++)
+    {
+        const auto p =
+            read_point(vertices.data() + v * stride + offset, components);
+
+        float d2 = 0.0F;
+        for(int i = 0; i < 3; i++)
+            d2 += (p[i] - center[i]) * (p[i] - center[i]);
+
+        radius2 = std::max(radius2, d2);
+    }
+
+    return {center, std::sqrt(radius2)};
+}
+
+aabb compute_aabb(std::span<const std::byte>        vertices,
+                  std::span<const vertex_attribute> attributes)
+{
+    const auto* position = find_position_attribute(attributes);
+
+    if(position == nullptr || vertices.empty())
+        return {};
+
+    return compute_aabb(vertices,
+                        static_cast<std::size_t>(attributes_stride(attributes)),
+                        static_cast<std::size_t>(position->offset),
+                        position->size);
+}
+
+bounding_sphere compute_bounding_sphere(
+    std::span<const std::byte>        vertices,
+    std::span<const vertex_attribute> attributes,
+    const aabb&                       box)
+{
+    const auto* position = find_position_attribute(attributes);
+
+    if(position == nullptr || vertices.empty())
+        return {};
+
+    return compute_bounding_sphere(
+        vertices, static_cast<std::size_t>(attributes_stride(attributes)),
+        static_cast<std::size_t>(position->offset), position->size, box);
+}
+
+}    // namespace corgi
@@ -0,0 +1,186 @@
+#include <corgi/opengl/compact_mesh.h>
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/memory_tracker.h>
+#include <glad/glad.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+compact_mesh::compact_mesh(std::span<const float>    vertices,
+                           std::span<const unsigned> indexes,
+                           layout_id                 layout,
+                           primitive_type            primitive)
+    : compact_mesh(std::as_bytes(vertices), indexes, layout, primitive)
+{
+}
+
+compact_mesh::compact_mesh(std::span<const std::byte> vertices,
+                           std::span<const unsigned>  indexes,
+                           layout_id                  layout,
+                           primitive_type             primitive)
+    : compact_mesh(vertices,
+                   pack_indexes(indexes, select_index_type(indexes)),
+                   select_index_type(indexes),
+                   layout,
+                   primitive)
+{
+}
+
+compact_mesh::compact_mesh(std::span<const std::byte> vertices,
+                           std::span<const std::byte> indexes,
+                           corgi::index_type          type,
+                           layout_id                  layout,
+                           primitive_type             primitive)
+    : layout_(layout)
+    , primitive_(primitive)
+    , index_type_(type)
+{
+    if(vertices.empty())
+        throw std::invalid_argument(
+            "compact_mesh::compact_mesh : vertices span is empty");
+
+    if(indexes.empty())
+        throw std::invalid_argument(
+            "compact_mesh::compact_mesh : indexes span is empty");
+
+    const auto stride = layout_registry::instance().stride(layout);
+
+    if(vertices.size_bytes() % stride != 0)
+        throw std::invalid_argument(
+            "compact_mesh::compact_mesh : vertices don't match the layout");
+
+    if(indexes.size_bytes() % index_type_size(type) != 0)
+        throw std::invalid_argument(
+            "compact_mesh::compact_mesh : indexes don't match the index type");
+
+    vertex_count_ = static_cast<std::uint32_t>(vertices.size_bytes() / stride);
+    index_count_  = static_cast<std::uint32_t>(indexes.size_bytes() /
+                                              index_type_size(type));
+
+    auto& pool = gl_name_pool::instance();
+
+    vertex_buffer_ = pool.acquire_buffer(vertices.size_bytes());
+    index_buffer_  = pool.acquire_buffer(indexes.size_bytes());
+
+    if(vertex_buffer_ == 0 || index_buffer_ == 0)
+    {
+        release();
+        throw std::logic_error(
+            "compact_mesh::compact_mesh : Couldn't generate OpenGL names");
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(vertices.size_bytes()),
+                 vertices.data(), GL_STATIC_DRAW);
+
+    // Filled through the array buffer target, binding it to
+    // GL_ELEMENT_ARRAY_BUFFER would change the vertex array currently bound
+    glBindBuffer(GL_ARRAY_BUFFER, index_buffer_);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indexes.size_bytes()), indexes.data(),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    auto& tracker = memory_tracker::instance();
+    tracker.track(resource_type::vertex_buffer, vertex_buffer_,
+                  vertices.size_bytes());
+    tracker.track(resource_type::index_buffer, index_buffer_,
+                  indexes.size_bytes());
+}
+
+compact_mesh::compact_mesh(compact_mesh&& other) noexcept
+    : vertex_buffer_(other.vertex_buffer_)
+    , index_buffer_(other.index_buffer_)
+    , vertex_count_(other.vertex_count_)
+    , index_count_(other.index_count_)
+    , layout_(other.layout_)
+    , primitive_(other.primitive_)
+    , index_type_(other.index_type_)
+{
+    other.vertex_buffer_ = 0;
+    other.index_buffer_  = 0;
+    other.vertex_count_  = 0;
+    other.index_count_   = 0;
+}
+
+compact_mesh& compact_mesh::operator=(compact_mesh&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    release();
+
+    vertex_buffer_ = other.vertex_buffer_;
+    index_buffer_  = other.index_buffer_;
+    vertex_count_  = other.vertex_count_;
+    index_count_   = other.index_count_;
+    layout_        = other.layout_;
+    primitive_     = other.primitive_;
+    index_type_    = other.index_type_;
+
+    other.vertex_buffer_ = 0;
+    other.index_buffer_  = 0;
+    other.vertex_count_  = 0;
+    other.index_count_   = 0;
+    return *this;
+}
+
+compact_mesh::~compact_mesh()
+{
+    release();
+}
+
+void compact_mesh::clear()
+{
+    release();
+}
+
+std::size_t compact_mesh::size_in_bytes() const
+{
+    if(empty())
+        return 0;
+
+    return vertex_count_ * layout_registry::instance().stride(layout_) +
+           index_count_ * index_type_size(index_type_);
+}
+
+void compact_mesh::bind(vertex_array_cache& vertex_arrays) const
+{
+    if(empty())
+        throw std::logic_error(
+            "compact_mesh::bind : Can't bind an empty compact_mesh");
+
+    vertex_arrays.bind(layout_, vertex_buffer_, index_buffer_);
+}
+
+void compact_mesh::release() noexcept
+{
+    auto& pool    = gl_name_pool::instance();
+    auto& tracker = memory_tracker::instance();
+
+    if(vertex_buffer_ != 0)
+    {
+        tracker.untrack(resource_type::vertex_buffer, vertex_buffer_);
+        pool.release_buffer(vertex_buffer_,
+                            vertex_count_ *
+                                layout_registry::instance().stride(layout_));
+    }
+
+    if(index_buffer_ != 0)
+    {
+        tracker.untrack(resource_type::index_buffer, index_buffer_);
+        pool.release_buffer(index_buffer_,
+                            index_count_ * index_type_size(index_type_));
+    }
+
+    vertex_buffer_ = 0;
+    index_buffer_  = 0;
+    vertex_count_  = 0;
+    index_count_   = 0;
+}
+
+}    // namespace corgi
@@ -0,0 +1,451 @@
+#include <corgi/opengl/aabb_tree.h>
+#include <corgi/opengl/culling.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "simd.h"
+
+namespace corgi
+{
+
+frustum frustum::from_matrix(const matrix4& m)
+{
+    // Gribb and Hartmann : each plane is the last row of the matrix plus or
+    // minus one of the others
+    auto row = [&](int i) {
+        return std::array<float, 4> {m[i], m[4 + i], m[8 + i], m[12 + i]};
+    };
+
+    const auto w = row(3);
+
+    frustum result;
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const auto r = row(axis);
+
+        for(int i = 0; i < 4; i++)
+        {
+            result.planes[axis * 2][i]     = w[i] + r[i];
+            result.planes[axis * 2 + 1][i] = w[i] - r[i];
+        }
+    }
+
+    for(auto& plane : result.planes)
+    {
+        const float length = std::sqrt(plane[0] * plane[0] +
+                                       plane[1] * plane[1] + plane[2] * plane[2]);
+        if(length > 0.0F)
+            for(auto& value : plane)
+                value /= length;
+    }
+    return result;
+}
+
+frustum frustum::orthographic(float left,
+                              float right,
+                              float bottom,
+                              float top,
+                              float z_near,
+                              float z_far)
+{
+    if(left == right || bottom == top || z_near == z_far)
+        throw std::invalid_argument(
+            "frustum::orthographic : The volume has no size");
+
+    matrix4 m {};
+    m[0]  = 2.0F / (right - left);
+    m[5]  = 2.0F / (top - bottom);
+    m[10] = -2.0F / (z_far - z_near);
+    m[12] = -(right + left) / (right - left);
+    m[13] = -(top + bottom) / (top - bottom);
+    m[14] = -(z_far + z_near) / (z_far - z_near);
+    m[15] = 1.0F;
+
+    return from_matrix(m);
+}
+
+bool frustum::intersects(const aabb& box) const noexcept
+{
+    if(box.empty())
+        return false;
+
+    const auto c = box.center();
+    const auto e = box.extent();
+
+    // The box is out when even its corner the furthest along the plane's
+    // normal is behind it
+    for(const auto& p : planes)
+    {
+        const float d = p[0] * c[0] + p[1] * c[1] + p[2] * c[2] + p[3];
+        const float r = std::abs(p[0]) * e[0] + std::abs(p[1]) * e[1] +
+                        std::abs(p[2]) * e[2];
+        if(d + r < 0.0F)
+            return false;
+    }
+    return true;
+}
+
+bool view_rect::intersects(const aabb& box) const noexcept
+{
+    if(box.empty())
+        return false;
+
+    return box.min[0] <= right && box.max[0] >= left && box.min[1] <= top &&
+           box.max[1] >= bottom;
+}
+
+// cull_set
+
+std::uint32_t cull_set::add(const aabb& bounds)
+{
+    if(size_ >= std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("cull_set::add : Too many objects");
+
+    // Grows 4 boxes at a time, so every block can be loaded whole
+    if(size_ % 4 == 0)
+    {
+        const auto padded = size_ + 4;
+        const auto none   = std::numeric_limits<float>::lowest();
+
+        center_x_.resize(padded, 0.0F);
+        center_y_.resize(padded, 0.0F);
+        center_z_.resize(padded, 0.0F);
+        extent_x_.resize(padded, none);
+        extent_y_.resize(padded, none);
+        extent_z_.resize(padded, none);
+    }
+
+    const auto index = static_cast<std::uint32_t>(size_++);
+    set(index, bounds);
+    return index;
+}
+
+void cull_set::set(std::uint32_t index, const aabb& bounds)
+{
+    if(index >= size_)
+        throw std::out_of_range("cull_set::set : Index out of range");
+
+    if(bounds.empty())
+    {
+        // A negative extent fails every test
+        const auto none  = std::numeric_limits<float>::lowest();
+        center_x_[index] = center_y_[index] = center_z_[index] = 0.0F;
+        extent_x_[index] = extent_y_[index] = extent_z_[index] = none;
+        return;
+    }
+
+    const auto c = bounds.center();
+    const auto e = bounds.extent();
+
+    center_x_[index] = c[0];
+    center_y_[index] = c[1];
+    center_z_[index] = c[2];
+    extent_x_[index] = e[0];
+    extent_y_[index] = e[1];
+    extent_z_[index] = e[2];
+}
+
+aabb cull_set::bounds(std::uint32_t index) const
+{
+    if(index >= size_)
+        throw std::out_of_range("cull_set::bounds : Index out of range");
+
+    if(extent_x_[index] < 0.0F)
+        return {};
+
+    return {{center_x_[index] - extent_x_[index],
+             center_y_[index] - extent_y_[index],
+             center_z_[index] - extent_z_[index]},
+            {center_x_[index] + extent_x_[index],
+             center_y_[index] + extent_y_[index],
+             center_z_[index] + extent_z_[index]}};
+}
+
+void cull_set::reserve(std::size_t count)
+{
+    count = (count + 3) / 4 * 4;
+
+    center_x_.reserve(count);
+    center_y_.reserve(count);
+    center_z_.reserve(count);
+    extent_x_.reserve(count);
+    extent_y_.reserve(count);
+    extent_z_.reserve(count);
+}
+
+void cull_set::clear() noexcept
+{
+    center_x_.clear();
+    center_y_.clear();
+    center_z_.clear();
+    extent_x_.clear();
+    extent_y_.clear();
+    extent_z_.clear();
+    size_ = 0;
+}
+
+// Tests of the boxes from begin to end, which are multiples of 4. Visible
+// indexes are appended to out
+
+namespace
+{
+
+#ifdef CORGI_OPENGL_SSE
+/**
+ * @brief Appends the lanes set in the mask, skipping the padding
+ */
+void push_lanes(int                         mask,
+                std::size_t                 first,
+                std::size_t                 size,
+                std::vector<std::uint32_t>& out)
+{
+    while(mask != 0)
+    {
+        const auto index =
+            first + static_cast<std::size_t>(std::countr_zero(
+                        static_cast<unsigned>(mask)));
+        if(index < size)
+            out.push_back(static_cast<std::uint32_t>(index));
+        mask &= mask - 1;
+    }
+}
+
+__m128 abs_ps(__m128 value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0F), value);
+}
+#endif
+
+struct frustum_test
+{
+    const frustum& view;
+
+    void operator()(const cull_set&             set,
+                    std::size_t                 begin,
+                    std::size_t                 end,
+                    std::vector<std::uint32_t>& out) const
+    {
+#ifdef CORGI_OPENGL_SSE
+        __m128 plane[6][4];
+        __m128 abs_normal[6][3];
+
+        for(int p = 0; p < 6; p++)
+            for(int i = 0; i < 4; i++)
+            {
+                plane[p][i] = _mm_set1_ps(view.planes[p][i]);
+                if(i < 3)
+                    abs_normal[p][i] = abs_ps(plane[p][i]);
+            }
+
+        const __m128 zero = _mm_setzero_ps();
+
+        for(auto i = begin; i < end; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(set.center_x().data() + i);
+            const __m128 cy = _mm_loadu_ps(set.center_y().data() + i);
+            const __m128 cz = _mm_loadu_ps(set.center_z().data() + i);
+            const __m128 ex = _mm_loadu_ps(set.extent_x().data() + i);
+            const __m128 ey = _mm_loadu_ps(set.extent_y().data() + i);
+            const __m128 ez = _mm_loadu_ps(set.extent_z().data() + i);
+
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+            for(int p = 0; p < 6; p++)
+            {
+                __m128 d = _mm_add_ps(_mm_mul_ps(plane[p][0], cx), plane[p][3]);
+                d        = _mm_add_ps(d, _mm_mul_ps(plane[p][1], cy));
+                d        = _mm_add_ps(d, _mm_mul_ps(plane[p][2], cz));
+
+                __m128 r = _mm_mul_ps(abs_normal[p][0], ex);
+                r        = _mm_add_ps(r, _mm_mul_ps(abs_normal[p][1], ey));
+                r        = _mm_add_ps(r, _mm_mul_ps(abs_normal[p][2], ez));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+            }
+
+            push_lanes(_mm_movemask_ps(inside), i, set.size(), out);
+        }
+#else
+        end = std::min(end, set.size());
+
+        for(auto i = begin; i < end; i++)
+        {
+            const float c[3] {set.center_x()[i], set.center_y()[i],
+                              set.center_z()[i]};
+            const float e[3] {set.extent_x()[i], set.extent_y()[i],
+                              set.extent_z()[i]};
+
+            bool inside = true;
+
+            for(const auto& p : view.planes)
+            {
+                const float d = p[0] * c[0] + p[1] * c[1] + p[2] * c[2] + p[3];
+                const float r = std::abs(p[0]) * e[0] + std::abs(p[1]) * e[1] +
+                                std::abs(p[2]) * e[2];
+                inside = inside && d + r >= 0.0F;
+            }
+
+            if(inside)
+                out.push_back(static_cast<std::uint32_t>(i));
+        }
+#endif
+    }
+};
+
+struct rect_test
+{
+    const view_rect& view;
+
+    void operator()(const cull_set&             set,
+                    std::size_t                 begin,
+                    std::size_t                 end,
+                    std::vector<std::uint32_t>& out) const
+    {
+        const float center_x = (view.left + view.right) * 0.5F;
+        const float center_y = (view.bottom + view.top) * 0.5F;
+        const float half_w   = std::abs(view.right - view.left) * 0.5F;
+        const float half_h   = std::abs(view.top - view.bottom) * 0.5F;
+
+#ifdef CORGI_OPENGL_SSE
+        const __m128 rx = _mm_set1_ps(center_x);
+        const __m128 ry = _mm_set1_ps(center_y);
+        const __m128 hw = _mm_set1_ps(half_w);
+        const __m128 hh = _mm_set1_ps(half_h);
+
+        for(auto i = begin; i < end; i += 4)
+        {
+            const __m128 dx =
+                abs_ps(_mm_sub_ps(_mm_loadu_ps(set.center_x().data() + i), rx));
+            const __m128 dy =
+                abs_ps(_mm_sub_ps(_mm_loadu_ps(set.center_y().data() + i), ry));
+
+            const __m128 in_x = _mm_cmple_ps(
+                dx, _mm_add_ps(_mm_loadu_ps(set.extent_x().data() + i), hw));
+            const __m128 in_y = _mm_cmple_ps(
+                dy, _mm_add_ps(_mm_loadu_ps(set.extent_y().data() + i), hh));
+
+            push_lanes(_mm_movemask_ps(_mm_and_ps(in_x, in_y)), i, set.size(),
+                       out);
+        }
+#else
+        end = std::min(end, set.size());
+
+        for(auto i = begin; i < end; i++)
+            if(std::abs(set.center_x()[i] - center_x) <=
+                   set.extent_x()[i] + half_w &&
+               std::abs(set.center_y()[i] - center_y) <=
+                   set.extent_y()[i] + half_h)
+                out.push_back(static_cast<std::uint32_t>(i));
+#endif
+    }
+};
+}    // namespace
+
+// culling_stage
+
+culling_stage::culling_stage(thread_pool* pool, std::size_t min_chunk)
+    : pool_(pool)
+    , min_chunk_(std::max<std::size_t>(min_chunk, 4))
+{
+}
+
+template<class Test>
+std::span<const std::uint32_t> culling_stage::run(const cull_set& set,
+                                                  const Test&     test)
+{
+    visible_.clear();
+
+    const auto blocks = (set.size() + 3) / 4;
+
+    if(pool_ == nullptr || set.size() < 2 * min_chunk_)
+    {
+        test(set, 0, blocks * 4, visible_);
+        return visible_;
+    }
+
+    chunks_.resize(pool_->max_chunks());
+    for(auto& chunk : chunks_)
+        chunk.clear();
+
+    // Chunks are split on blocks of 4 boxes
+    pool_->parallel_for(blocks, min_chunk_ / 4,
+                        [&](std::size_t begin, std::size_t end,
+                            std::size_t chunk)
+                        { test(set, begin * 4, end * 4, chunks_[chunk]); });
+
+    for(const auto& chunk : chunks_)
+        visible_.insert(visible_.end(), chunk.begin(), chunk.end());
+
+    return visible_;
+}
+
+std::span<const std::uint32_t> culling_stage::cull(const cull_set& set,
+                                                   const frustum&  view)
+{
+    return run(set, frustum_test {view});
+}
+
+std::span<const std::uint32_t> culling_stage::cull(const cull_set&  set,
+                                                   const view_rect& view)
+{
+    return run(set, rect_test {view});
+}
+
+std::span<const std::uint32_t> culling_stage::cull(const aabb_tree& tree,
+                                                   const view_rect& view)
+{
+    visible_.clear();
+    tree.query(view, visible_);
+    std::sort(visible_.begin(), visible_.end());
+    return visible_;
+}
+
+std::span<const std::uint32_t>
+culling_stage::remove_occluded(const cull_set&         set,
+                               const occlusion_buffer& occlusion,
+                               const matrix4&          view_projection)
+{
+    auto test = [&](std::size_t begin, std::size_t end,
+                    std::vector<std::uint32_t>& out)
+    {
+        for(auto i = begin; i < end; i++)
+            if(occlusion.visible(set.bounds(visible_[i]), view_projection))
+                out.push_back(visible_[i]);
+    };
+
+    // Boxes cost far more to test here than against a frustum
+    const auto min_chunk = std::max<std::size_t>(min_chunk_ / 16, 1);
+
+    if(pool_ == nullptr || visible_.size() < 2 * min_chunk)
+    {
+        std::size_t kept = 0;
+        for(auto index : visible_)
+            if(occlusion.visible(set.bounds(index), view_projection))
+                visible_[kept++] = index;
+
+        visible_.resize(kept);
+        return visible_;
+    }
+
+    chunks_.resize(pool_->max_chunks());
+    for(auto& chunk : chunks_)
+        chunk.clear();
+
+    pool_->parallel_for(visible_.size(), min_chunk,
+                        [&](std::size_t begin, std::size_t end,
+                            std::size_t chunk)
+                        { test(begin, end, chunks_[chunk]); });
+
+    visible_.clear();
+    for(const auto& chunk : chunks_)
+        visible_.insert(visible_.end(), chunk.begin(), chunk.end());
+
+    return visible_;
+}
+
+}    // namespace corgi
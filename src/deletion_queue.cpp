@@ -0,0 +1,166 @@
+#include <corgi/opengl/deletion_queue.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace corgi
+{
+
+deletion_queue& deletion_queue::instance()
+{
+    // Never destroyed, objects with static storage can still retire their
+    // OpenGL objects when the program exits
+    static auto* queue = new deletion_queue();
+    return *queue;
+}
+
+void deletion_queue::retire(gl_object type, unsigned id)
+{
+    if(id == 0)
+        return;
+
+    std::lock_guard lock(mutex_);
+    current_.push_back({type, id});
+}
+
+void deletion_queue::retire(gl_object type, unsigned id, resource_type tracked)
+{
+    if(id == 0)
+        return;
+
+    std::lock_guard lock(mutex_);
+    current_.push_back({type, id, true, tracked});
+}
+
+void deletion_queue::end_frame()
+{
+    std::vector<object> ready;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        if(!current_.empty())
+        {
+            batch b;
+            b.objects = std::move(current_);
+            b.fence   = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            b.frame   = frame_;
+            batches_.push_back(std::move(b));
+            current_.clear();
+        }
+
+        frame_++;
+
+        // Batches are in submission order, so we can stop at the first one
+        // that isn't done yet
+        while(!batches_.empty())
+        {
+            auto& b = batches_.front();
+
+            if(frame_ - b.frame < frames_in_flight_)
+                break;
+
+            GLint status = GL_UNSIGNALED;
+            glGetSynciv(static_cast<GLsync>(b.fence), GL_SYNC_STATUS,
+                        sizeof(status), nullptr, &status);
+
+            if(status != GL_SIGNALED)
+                break;
+
+            glDeleteSync(static_cast<GLsync>(b.fence));
+            ready.insert(ready.end(), b.objects.begin(), b.objects.end());
+            batches_.pop_front();
+        }
+    }
+
+    destroy(ready);
+}
+
+void deletion_queue::flush()
+{
+    std::vector<object> objects;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        for(auto& b : batches_)
+        {
+            glDeleteSync(static_cast<GLsync>(b.fence));
+            objects.insert(objects.end(), b.objects.begin(), b.objects.end());
+        }
+
+        objects.insert(objects.end(), current_.begin(), current_.end());
+
+        batches_.clear();
+        current_.clear();
+    }
+
+    destroy(objects);
+}
+
+std::uint64_t deletion_queue::frame() const noexcept
+{
+    std::lock_guard lock(mutex_);
+    return frame_;
+}
+
+void deletion_queue::set_frames_in_flight(unsigned frames) noexcept
+{
+    std::lock_guard lock(mutex_);
+    frames_in_flight_ = std::max(frames, 1u);
+}
+
+unsigned deletion_queue::frames_in_flight() const noexcept
+{
+    std::lock_guard lock(mutex_);
+    return frames_in_flight_;
+}
+
+std::size_t deletion_queue::pending() const
+{
+    std::lock_guard lock(mutex_);
+
+    std::size_t count = current_.size();
+    for(const auto& b : batches_)
+        count += b.objects.size();
+    return count;
+}
+
+void deletion_queue::destroy(const std::vector<object>& objects)
+{
+    for(const auto& o : objects)
+    {
+        switch(o.type)
+        {
+            case gl_object::buffer:
+                glDeleteBuffers(1, &o.id);
+                break;
+            case gl_object::vertex_array:
+                glDeleteVertexArrays(1, &o.id);
+                break;
+            case gl_object::texture:
+                glDeleteTextures(1, &o.id);
+                break;
+            case gl_object::shader:
+                glDeleteShader(o.id);
+                break;
+            case gl_object::program:
+                glDeleteProgram(o.id);
+                break;
+            case gl_object::renderbuffer:
+                glDeleteRenderbuffers(1, &o.id);
+                break;
+            case gl_object::framebuffer:
+                glDeleteFramebuffers(1, &o.id);
+                break;
+            case gl_object::query:
+                glDeleteQueries(1, &o.id);
+                break;
+        }
+
+        if(o.tracked)
+            memory_tracker::instance().untrack(o.tracked_type, o.id);
+    }
+}
+
+}    // namespace corgi
@@ -0,0 +1,335 @@
+#include <corgi/opengl/dynamic_mesh.h>
+#include <corgi/opengl/gl_name_pool.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace corgi
+{
+
+// Smallest storage given to a buffer, so tiny meshes don't grow on every
+// update
+static constexpr std::size_t min_capacity = 256;
+
+/**
+ * @brief Writes bytes at offset in the buffer
+ *
+ * fill writes the data to the pointer it gets : the mapping in map_range
+ * mode, or a scratch vector otherwise. When source isn't null, it already
+ * holds the data and is uploaded as is instead of being copied to scratch
+ *
+ * @param whole True if the whole content of the buffer is replaced, which
+ * lets the driver give it new storage
+ */
+template<class Fill>
+static void upload(unsigned                buffer,
+                   std::size_t             capacity,
+                   std::size_t             offset,
+                   std::size_t             bytes,
+                   bool                    whole,
+                   update_mode             mode,
+                   const std::byte*        source,
+                   std::vector<std::byte>& scratch,
+                   Fill                    fill)
+{
+    if(bytes == 0)
+        return;
+
+    // The array buffer target doesn't belong to the vertex array currently
+    // bound, unlike the element array buffer
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    if(mode == update_mode::map_range)
+    {
+        const GLbitfield access =
+            GL_MAP_WRITE_BIT | (whole ? GL_MAP_INVALIDATE_BUFFER_BIT
+                                      : GL_MAP_INVALIDATE_RANGE_BIT);
+
+        auto* mapping = glMapBufferRange(
+            GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+            static_cast<GLsizeiptr>(bytes), access);
+
+        if(mapping != nullptr)
+        {
+            fill(static_cast<std::byte*>(mapping));
+
+            if(glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                return;
+            }
+        }
+
+        // Mapping failed, or the storage was lost while mapped : the data is
+        // sent again with a copy
+    }
+    else if(whole)
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity),
+                     nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if(source == nullptr)
+    {
+        scratch.resize(bytes);
+        fill(scratch.data());
+        source = scratch.data();
+    }
+
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(bytes), source);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+dynamic_mesh::dynamic_mesh(layout_id      layout,
+                           primitive_type primitive,
+                           update_mode    mode,
+                           std::size_t    vertex_capacity,
+                           std::size_t    index_capacity)
+    : stride_(layout_registry::instance().stride(layout))
+    , layout_(layout)
+    , primitive_(primitive)
+    , mode_(mode)
+{
+    reserve(vertex_capacity, index_capacity);
+}
+
+dynamic_mesh::dynamic_mesh(dynamic_mesh&& other) noexcept
+    : vertex_buffer_(other.vertex_buffer_)
+    , index_buffer_(other.index_buffer_)
+    , vertex_capacity_(other.vertex_capacity_)
+    , index_capacity_(other.index_capacity_)
+    , vertex_count_(other.vertex_count_)
+    , index_count_(other.index_count_)
+    , first_index_(other.first_index_)
+    , draw_count_(other.draw_count_)
+    , stride_(other.stride_)
+    , reallocations_(other.reallocations_)
+    , layout_(other.layout_)
+    , primitive_(other.primitive_)
+    , index_type_(other.index_type_)
+    , mode_(other.mode_)
+    , packed_indexes_(std::move(other.packed_indexes_))
+{
+    other.vertex_buffer_   = 0;
+    other.index_buffer_    = 0;
+    other.vertex_capacity_ = 0;
+    other.index_capacity_  = 0;
+    other.release();
+}
+
+dynamic_mesh& dynamic_mesh::operator=(dynamic_mesh&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    release();
+
+    vertex_buffer_   = other.vertex_buffer_;
+    index_buffer_    = other.index_buffer_;
+    vertex_capacity_ = other.vertex_capacity_;
+    index_capacity_  = other.index_capacity_;
+    vertex_count_    = other.vertex_count_;
+    index_count_     = other.index_count_;
+    first_index_     = other.first_index_;
+    draw_count_      = other.draw_count_;
+    stride_          = other.stride_;
+    reallocations_   = other.reallocations_;
+    layout_          = other.layout_;
+    primitive_       = other.primitive_;
+    index_type_      = other.index_type_;
+    mode_            = other.mode_;
+    packed_indexes_  = std::move(other.packed_indexes_);
+
+    other.vertex_buffer_   = 0;
+    other.index_buffer_    = 0;
+    other.vertex_capacity_ = 0;
+    other.index_capacity_  = 0;
+    other.release();
+    return *this;
+}
+
+dynamic_mesh::~dynamic_mesh()
+{
+    release();
+}
+
+bool dynamic_mesh::grow(unsigned&     buffer,
+                        std::size_t&  capacity,
+                        std::size_t   bytes,
+                        resource_type type)
+{
+    if(bytes <= capacity)
+        return false;
+
+    const auto new_capacity = std::max({bytes, capacity * 2, min_capacity});
+
+    auto& pool    = gl_name_pool::instance();
+    auto& tracker = memory_tracker::instance();
+
+    if(buffer == 0)
+    {
+        buffer = pool.acquire_buffer(new_capacity);
+
+        if(buffer == 0)
+            throw std::logic_error(
+                "dynamic_mesh::reserve : Couldn't generate a buffer");
+    }
+    else
+    {
+        tracker.untrack(type, buffer);
+        reallocations_++;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(new_capacity),
+                 nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    tracker.track(type, buffer, new_capacity);
+
+    capacity = new_capacity;
+    return true;
+}
+
+void dynamic_mesh::reserve(std::size_t vertex_bytes, std::size_t index_count)
+{
+    if(stride_ == 0)
+        throw std::logic_error("dynamic_mesh::reserve : Mesh has no layout");
+
+    // Reserved for the biggest index type, the one used by big meshes
+    const bool vertices_grew = grow(vertex_buffer_, vertex_capacity_,
+                                    vertex_bytes, resource_type::vertex_buffer);
+    const bool indexes_grew =
+        grow(index_buffer_, index_capacity_,
+             index_count * index_type_size(index_type::uint32),
+             resource_type::index_buffer);
+
+    if(vertices_grew || indexes_grew)
+    {
+        vertex_count_ = 0;
+        index_count_  = 0;
+        first_index_  = 0;
+        draw_count_   = 0;
+    }
+}
+
+void dynamic_mesh::update(std::span<const float>    vertices,
+                          std::span<const unsigned> indexes)
+{
+    update(std::as_bytes(vertices), indexes);
+}
+
+void dynamic_mesh::update(std::span<const std::byte> vertices,
+                          std::span<const unsigned>  indexes)
+{
+    if(stride_ == 0)
+        throw std::logic_error("dynamic_mesh::update : Mesh has no layout");
+
+    if(vertices.size_bytes() % stride_ != 0)
+        throw std::invalid_argument(
+            "dynamic_mesh::update : vertices don't match the layout");
+
+    const auto type        = select_index_type(indexes);
+    const auto index_bytes = indexes.size() * index_type_size(type);
+
+    // Storage is replaced as a whole below, nothing to keep
+    grow(vertex_buffer_, vertex_capacity_, vertices.size_bytes(),
+         resource_type::vertex_buffer);
+    grow(index_buffer_, index_capacity_, index_bytes,
+         resource_type::index_buffer);
+
+    upload(vertex_buffer_, vertex_capacity_, 0, vertices.size_bytes(), true,
+           mode_, vertices.data(), packed_indexes_,
+           [&](std::byte* destination) {
+               std::memcpy(destination, vertices.data(),
+                           vertices.size_bytes());
+           });
+
+    upload(index_buffer_, index_capacity_, 0, index_bytes, true, mode_,
+           nullptr, packed_indexes_, [&](std::byte* destination)
+           { pack_indexes(indexes, type, destination); });
+
+    vertex_count_ = static_cast<std::uint32_t>(vertices.size_bytes() / stride_);
+    index_count_  = static_cast<std::uint32_t>(indexes.size());
+    index_type_   = type;
+    first_index_  = 0;
+    draw_count_   = index_count_;
+}
+
+void dynamic_mesh::update_vertices(std::size_t                first_vertex,
+                                   std::span<const std::byte> vertices)
+{
+    if(stride_ == 0)
+        throw std::logic_error(
+            "dynamic_mesh::update_vertices : Mesh has no layout");
+
+    if(vertices.size_bytes() % stride_ != 0)
+        throw std::invalid_argument(
+            "dynamic_mesh::update_vertices : vertices don't match the "
+            "layout");
+
+    if(first_vertex + vertices.size_bytes() / stride_ > vertex_count_)
+        throw std::out_of_range(
+            "dynamic_mesh::update_vertices : Vertices go past the vertex "
+            "count");
+
+    upload(vertex_buffer_, vertex_capacity_, first_vertex * stride_,
+           vertices.size_bytes(), false, mode_, vertices.data(),
+           packed_indexes_,
+           [&](std::byte* destination) {
+               std::memcpy(destination, vertices.data(),
+                           vertices.size_bytes());
+           });
+}
+
+void dynamic_mesh::set_draw_range(std::uint32_t first_index,
+                                  std::uint32_t index_count)
+{
+    if(std::uint64_t(first_index) + index_count > index_count_)
+        throw std::out_of_range(
+            "dynamic_mesh::set_draw_range : Range goes past the index count");
+
+    first_index_ = first_index;
+    draw_count_  = index_count;
+}
+
+void dynamic_mesh::bind(vertex_array_cache& vertex_arrays) const
+{
+    if(vertex_buffer_ == 0 || index_buffer_ == 0)
+        throw std::logic_error(
+            "dynamic_mesh::bind : Can't bind a dynamic_mesh with no buffers");
+
+    vertex_arrays.bind(layout_, vertex_buffer_, index_buffer_);
+}
+
+void dynamic_mesh::release() noexcept
+{
+    auto& pool    = gl_name_pool::instance();
+    auto& tracker = memory_tracker::instance();
+
+    if(vertex_buffer_ != 0)
+    {
+        tracker.untrack(resource_type::vertex_buffer, vertex_buffer_);
+        pool.release_buffer(vertex_buffer_, vertex_capacity_);
+    }
+
+    if(index_buffer_ != 0)
+    {
+        tracker.untrack(resource_type::index_buffer, index_buffer_);
+        pool.release_buffer(index_buffer_, index_capacity_);
+    }
+
+    vertex_buffer_   = 0;
+    index_buffer_    = 0;
+    vertex_capacity_ = 0;
+    index_capacity_  = 0;
+    vertex_count_    = 0;
+    index_count_     = 0;
+    first_index_     = 0;
+    draw_count_      = 0;
+}
+
+}    // namespace corgi
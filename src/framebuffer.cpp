@@ -0,0 +1,350 @@
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/framebuffer.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace corgi
+{
+
+static GLenum to_gl(attachment point)
+{
+    switch(point)
+    {
+        case attachment::color0:
+            return GL_COLOR_ATTACHMENT0;
+        case attachment::color1:
+            return GL_COLOR_ATTACHMENT1;
+        case attachment::color2:
+            return GL_COLOR_ATTACHMENT2;
+        case attachment::color3:
+            return GL_COLOR_ATTACHMENT3;
+        case attachment::depth:
+            return GL_DEPTH_ATTACHMENT;
+        case attachment::stencil:
+            return GL_STENCIL_ATTACHMENT;
+        case attachment::depth_stencil:
+            return GL_DEPTH_STENCIL_ATTACHMENT;
+    }
+    return GL_COLOR_ATTACHMENT0;
+}
+
+unsigned framebuffer::default_id_     = 0;
+unsigned framebuffer::default_width_  = 0;
+unsigned framebuffer::default_height_ = 0;
+
+framebuffer::framebuffer()
+{
+    glGenFramebuffers(1, &id_);
+
+    if(id_ == 0)
+        throw std::logic_error(
+            "framebuffer::framebuffer : id is equals to 0 after "
+            "glGenFramebuffers");
+}
+
+framebuffer::framebuffer(framebuffer&& other) noexcept
+    : id_(other.id_)
+    , width_(other.width_)
+    , height_(other.height_)
+    , samples_(other.samples_)
+    , attachments_(std::move(other.attachments_))
+{
+    other.id_ = 0;
+    other.attachments_.clear();
+}
+
+framebuffer& framebuffer::operator=(framebuffer&& other) noexcept
+{
+    clear();
+
+    id_          = other.id_;
+    width_       = other.width_;
+    height_      = other.height_;
+    samples_     = other.samples_;
+    attachments_ = std::move(other.attachments_);
+
+    other.id_ = 0;
+    other.attachments_.clear();
+    return *this;
+}
+
+framebuffer::~framebuffer()
+{
+    clear();
+}
+
+void framebuffer::clear()
+{
+    deletion_queue::instance().retire(gl_object::framebuffer, id_);
+    id_ = 0;
+    attachments_.clear();
+}
+
+void framebuffer::check_size(unsigned width, unsigned height, int samples)
+{
+    if(attachments_.empty())
+    {
+        width_   = width;
+        height_  = height;
+        samples_ = samples;
+        return;
+    }
+
+    if(width != width_ || height != height_)
+        throw std::logic_error(
+            "framebuffer::attach : Attachment size doesn't match the "
+            "framebuffer size");
+
+    if(samples != samples_)
+        throw std::logic_error(
+            "framebuffer::attach : Attachment sample count doesn't match the "
+            "framebuffer sample count");
+}
+
+void framebuffer::attach(attachment point, const texture& texture, int level)
+{
+    if(texture.id() == 0)
+        throw std::logic_error(
+            "framebuffer::attach : Can't attach an empty texture");
+
+    detach(point);
+
+    check_size(std::max(texture.width() >> level, 1u),
+               std::max(texture.height() >> level, 1u), 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, to_gl(point), GL_TEXTURE_2D,
+                           texture.id(), level);
+
+    attachments_.push_back(point);
+    update_draw_buffers();
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+}
+
+void framebuffer::attach(attachment point, const renderbuffer& renderbuffer)
+{
+    if(renderbuffer.id() == 0)
+        throw std::logic_error(
+            "framebuffer::attach : Can't attach an empty renderbuffer");
+
+    detach(point);
+
+    check_size(renderbuffer.width(), renderbuffer.height(),
+               renderbuffer.samples());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, to_gl(point), GL_RENDERBUFFER,
+                              renderbuffer.id());
+
+    attachments_.push_back(point);
+    update_draw_buffers();
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+}
+
+void framebuffer::detach(attachment point)
+{
+    auto it = std::find(attachments_.begin(), attachments_.end(), point);
+
+    if(it == attachments_.end())
+        return;
+
+    attachments_.erase(it);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, to_gl(point), GL_RENDERBUFFER,
+                              0);
+    update_draw_buffers();
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+}
+
+void framebuffer::update_draw_buffers() const
+{
+    // Draw buffers are part of the framebuffer state, so they only need to be
+    // set when the attachments change
+    GLenum buffers[max_color_attachments];
+    int    count = 0;
+
+    for(int i = 0; i < max_color_attachments; i++)
+    {
+        const auto point = static_cast<attachment>(i);
+
+        if(std::find(attachments_.begin(), attachments_.end(), point) !=
+           attachments_.end())
+            count = i + 1;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        const auto point = static_cast<attachment>(i);
+        buffers[i] = std::find(attachments_.begin(), attachments_.end(),
+                               point) != attachments_.end()
+                         ? to_gl(point)
+                         : GL_NONE;
+    }
+
+    if(count == 0)
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    else
+    {
+        glDrawBuffers(count, buffers);
+        glReadBuffer(buffers[0] == GL_NONE ? GL_NONE : GL_COLOR_ATTACHMENT0);
+    }
+}
+
+bool framebuffer::complete() const
+{
+    if(id_ == 0)
+        return false;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+
+    return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void framebuffer::bind() const
+{
+    if(id_ == 0)
+        throw std::logic_error(
+            "framebuffer::bind : Can't bind an empty framebuffer");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    glViewport(0, 0, width_, height_);
+}
+
+void framebuffer::unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+
+    if(default_width_ != 0 && default_height_ != 0)
+        glViewport(0, 0, default_width_, default_height_);
+}
+
+void framebuffer::set_default_target(unsigned id,
+                                     unsigned width,
+                                     unsigned height) noexcept
+{
+    default_id_     = id;
+    default_width_  = width;
+    default_height_ = height;
+}
+
+unsigned framebuffer::default_target() noexcept
+{
+    return default_id_;
+}
+
+void framebuffer::blit_to(const framebuffer& target,
+                          bool               color,
+                          bool               depth,
+                          bool               stencil,
+                          mag_filter         filter) const
+{
+    if(target.samples_ > 0 && target.samples_ != samples_)
+        throw std::logic_error(
+            "framebuffer::blit_to : Can't blit into a multisampled "
+            "framebuffer with a different sample count");
+
+    // Multisampled blits can't scale, whichever side is multisampled
+    if((samples_ > 0 || target.samples_ > 0) &&
+       (width_ != target.width_ || height_ != target.height_))
+        throw std::logic_error(
+            "framebuffer::blit_to : Multisampled framebuffers can only be "
+            "blitted to the same size");
+
+    blit_to(target.id_, target.width_, target.height_, color, depth, stencil,
+            filter);
+}
+
+void framebuffer::blit_to(unsigned   target_id,
+                          unsigned   target_width,
+                          unsigned   target_height,
+                          bool       color,
+                          bool       depth,
+                          bool       stencil,
+                          mag_filter filter) const
+{
+    GLbitfield mask = 0;
+
+    if(color)
+        mask |= GL_COLOR_BUFFER_BIT;
+    if(depth)
+        mask |= GL_DEPTH_BUFFER_BIT;
+    if(stencil)
+        mask |= GL_STENCIL_BUFFER_BIT;
+
+    if((depth || stencil) && filter != mag_filter::nearest)
+        throw std::logic_error(
+            "framebuffer::blit_to : Depth and stencil can only be blitted "
+            "with the nearest filter");
+
+    if(samples_ > 0 && (width_ != target_width || height_ != target_height))
+        throw std::logic_error(
+            "framebuffer::blit_to : Multisampled framebuffers can only be "
+            "blitted to the same size");
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, id_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_id);
+
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, target_width,
+                      target_height, mask,
+                      filter == mag_filter::linear ? GL_LINEAR : GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+}
+
+void framebuffer::resolve(const framebuffer& target) const
+{
+    blit_to(target, true, false, false, mag_filter::nearest);
+}
+
+void framebuffer::invalidate(const std::vector<attachment>& points) const
+{
+    if(points.empty())
+        return;
+
+    std::vector<GLenum> gl_points;
+    gl_points.reserve(points.size());
+
+    for(auto point : points)
+        gl_points.push_back(to_gl(point));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, id_);
+    glInvalidateFramebuffer(GL_FRAMEBUFFER,
+                            static_cast<GLsizei>(gl_points.size()),
+                            gl_points.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, default_id_);
+}
+
+void framebuffer::invalidate() const
+{
+    invalidate(attachments_);
+}
+
+unsigned framebuffer::id() const noexcept
+{
+    return id_;
+}
+
+unsigned framebuffer::width() const noexcept
+{
+    return width_;
+}
+
+unsigned framebuffer::height() const noexcept
+{
+    return height_;
+}
+
+int framebuffer::samples() const noexcept
+{
+    return samples_;
+}
+
+}    // namespace corgi
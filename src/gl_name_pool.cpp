@@ -0,0 +1,460 @@
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/memory_tracker.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <bit>
+#include <ostream>
+#include <stdexcept>
+
+namespace corgi
+{
+
+double pool_statistics::hit_rate() const noexcept
+{
+    if(acquired == 0)
+        return 0.0;
+    return static_cast<double>(recycled) / static_cast<double>(acquired);
+}
+
+gl_name_pool& gl_name_pool::instance()
+{
+    // Never destroyed, like the deletion_queue, so objects with static
+    // storage can still release their names
+    static auto* pool = new gl_name_pool();
+    return *pool;
+}
+
+std::size_t gl_name_pool::buffer_bucket(std::size_t bytes) noexcept
+{
+    if(bytes == 0 || bytes > max_pooled_buffer_size)
+        return 0;
+
+    // Below 64 bytes, buckets would be too small to be shared
+    return std::bit_ceil(std::max<std::size_t>(bytes, 64));
+}
+
+std::uint64_t gl_name_pool::texture_key(internal_format format,
+                                        unsigned        width,
+                                        unsigned        height,
+                                        unsigned        levels) noexcept
+{
+    return (std::uint64_t(levels & 0xFF) << 56) |
+           (std::uint64_t(static_cast<unsigned char>(format)) << 48) |
+           (std::uint64_t(width & 0xFFFFFF) << 24) | (height & 0xFFFFFF);
+}
+
+pool_statistics& gl_name_pool::stats(gl_object type)
+{
+    switch(type)
+    {
+        case gl_object::vertex_array:
+            return vertex_array_stats_;
+        case gl_object::texture:
+            return texture_stats_;
+        default:
+            return buffer_stats_;
+    }
+}
+
+unsigned gl_name_pool::acquire_buffer(std::size_t bytes)
+{
+    const auto bucket = buffer_bucket(bytes);
+
+    {
+        std::lock_guard lock(mutex_);
+
+        buffer_stats_.acquired++;
+
+        auto it = buffers_.find(bucket);
+
+        if(bucket != 0 && it != buffers_.end() && !it->second.empty())
+        {
+            const auto name = it->second.back();
+            it->second.pop_back();
+
+            buffer_stats_.recycled++;
+            buffer_stats_.pooled--;
+            pooled_bytes_ -= name.bytes;
+
+            // The new owner tracks the storage it specifies
+            memory_tracker::instance().untrack(resource_type::pooled_buffer,
+                                               name.id);
+            return name.id;
+        }
+    }
+
+    unsigned id = 0;
+    glGenBuffers(1, &id);
+    return id;
+}
+
+void gl_name_pool::release_buffer(unsigned id, std::size_t bytes)
+{
+    if(id == 0)
+        return;
+
+    const auto bucket = buffer_bucket(bytes);
+
+    std::vector<evicted_name> evicted;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        buffer_stats_.released++;
+
+        auto* names = bucket != 0 ? &buffers_[bucket] : nullptr;
+
+        if(names == nullptr || names->size() >= max_per_bucket_ ||
+           bytes > max_pooled_bytes_)
+        {
+            buffer_stats_.overflowed++;
+            evicted.push_back({gl_object::buffer, id, false});
+        }
+        else
+        {
+            memory_tracker::instance().track(resource_type::pooled_buffer, id,
+                                             bytes);
+            names->push_back({id, bytes, next_order_++, 0});
+            buffer_stats_.pooled++;
+            pooled_bytes_ += bytes;
+
+            evict(max_pooled_bytes_, evicted);
+        }
+    }
+
+    retire(evicted);
+}
+
+gl_name_pool::vertex_array_name gl_name_pool::acquire_vertex_array()
+{
+    {
+        std::lock_guard lock(mutex_);
+
+        vertex_array_stats_.acquired++;
+
+        if(!vertex_arrays_.empty())
+        {
+            const auto name = vertex_arrays_.back();
+            vertex_arrays_.pop_back();
+
+            vertex_array_stats_.recycled++;
+            vertex_array_stats_.pooled--;
+            return name;
+        }
+    }
+
+    vertex_array_name name;
+    glGenVertexArrays(1, &name.id);
+    return name;
+}
+
+void gl_name_pool::release_vertex_array(unsigned      id,
+                                        std::uint32_t enabled_attributes)
+{
+    if(id == 0)
+        return;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        vertex_array_stats_.released++;
+
+        if(vertex_arrays_.size() < max_per_bucket_)
+        {
+            vertex_arrays_.push_back({id, enabled_attributes});
+            vertex_array_stats_.pooled++;
+            return;
+        }
+
+        vertex_array_stats_.overflowed++;
+    }
+
+    deletion_queue::instance().retire(gl_object::vertex_array, id);
+}
+
+gl_name_pool::texture_name gl_name_pool::acquire_texture(
+    internal_format format, unsigned width, unsigned height, unsigned levels)
+{
+    const auto& queue       = deletion_queue::instance();
+    const auto  frame       = queue.frame();
+    const auto  frames_wait = queue.frames_in_flight();
+
+    {
+        std::lock_guard lock(mutex_);
+
+        texture_stats_.acquired++;
+
+        auto it = textures_.find(texture_key(format, width, height, levels));
+
+        if(it != textures_.end())
+        {
+            auto& bucket = it->second;
+
+            // Oldest textures are at the front, they are the most likely to
+            // be done on the GPU side
+            if(!bucket.empty() &&
+               frame - bucket.front().released_frame >= frames_wait)
+            {
+                const auto name = bucket.front();
+                bucket.erase(bucket.begin());
+
+                texture_stats_.recycled++;
+                texture_stats_.pooled--;
+                pooled_bytes_ -= name.bytes;
+
+                // The new owner tracks the storage it keeps
+                memory_tracker::instance().untrack(
+                    resource_type::pooled_texture, name.id);
+                return {name.id, true};
+            }
+        }
+    }
+
+    texture_name name;
+    glGenTextures(1, &name.id);
+    return name;
+}
+
+void gl_name_pool::release_texture(unsigned        id,
+                                   internal_format format,
+                                   unsigned        width,
+                                   unsigned        height,
+                                   unsigned        levels)
+{
+    if(id == 0)
+        return;
+
+    const auto frame = deletion_queue::instance().frame();
+    const auto bytes = texture_size_in_bytes(format, width, height, levels);
+
+    std::vector<evicted_name> evicted;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        texture_stats_.released++;
+
+        auto& bucket = textures_[texture_key(format, width, height, levels)];
+
+        if(bucket.size() >= max_per_bucket_ || bytes > max_pooled_bytes_)
+        {
+            texture_stats_.overflowed++;
+            evicted.push_back({gl_object::texture, id, false});
+        }
+        else
+        {
+            memory_tracker::instance().track(resource_type::pooled_texture, id,
+                                             bytes);
+            bucket.push_back({id, bytes, next_order_++, frame});
+            texture_stats_.pooled++;
+            pooled_bytes_ += bytes;
+
+            evict(max_pooled_bytes_, evicted);
+        }
+    }
+
+    retire(evicted);
+}
+
+void gl_name_pool::evict(std::size_t                max_bytes,
+                         std::vector<evicted_name>& evicted)
+{
+    while(pooled_bytes_ > max_bytes)
+    {
+        // The oldest name is at the front of one of the buckets
+        std::vector<pooled_name>* oldest      = nullptr;
+        gl_object                 oldest_type = gl_object::buffer;
+
+        auto visit = [&](auto& buckets, gl_object type)
+        {
+            for(auto& [key, bucket] : buckets)
+                if(!bucket.empty() &&
+                   (oldest == nullptr ||
+                    bucket.front().order < oldest->front().order))
+                {
+                    oldest      = &bucket;
+                    oldest_type = type;
+                }
+        };
+
+        visit(buffers_, gl_object::buffer);
+        visit(textures_, gl_object::texture);
+
+        if(oldest == nullptr)
+            break;
+
+        const auto name = oldest->front();
+        oldest->erase(oldest->begin());
+
+        pooled_bytes_ -= name.bytes;
+        stats(oldest_type).pooled--;
+        evicted.push_back({oldest_type, name.id, true});
+    }
+}
+
+void gl_name_pool::retire(const std::vector<evicted_name>& evicted)
+{
+    auto& queue = deletion_queue::instance();
+
+    // Pooled storage stays tracked until the name is deleted
+    for(const auto& name : evicted)
+    {
+        if(!name.pooled)
+            queue.retire(name.type, name.id);
+        else if(name.type == gl_object::buffer)
+            queue.retire(name.type, name.id, resource_type::pooled_buffer);
+        else
+            queue.retire(name.type, name.id, resource_type::pooled_texture);
+    }
+}
+
+void gl_name_pool::set_max_pooled_bytes(std::size_t bytes)
+{
+    std::vector<evicted_name> evicted;
+
+    {
+        std::lock_guard lock(mutex_);
+        max_pooled_bytes_ = bytes;
+        evict(max_pooled_bytes_, evicted);
+    }
+
+    retire(evicted);
+}
+
+std::size_t gl_name_pool::max_pooled_bytes() const
+{
+    std::lock_guard lock(mutex_);
+    return max_pooled_bytes_;
+}
+
+void gl_name_pool::trim(std::size_t max_bytes)
+{
+    std::vector<evicted_name> evicted;
+
+    {
+        std::lock_guard lock(mutex_);
+        evict(max_bytes, evicted);
+    }
+
+    retire(evicted);
+}
+
+void gl_name_pool::trim()
+{
+    trim(max_pooled_bytes());
+}
+
+void gl_name_pool::set_max_per_bucket(std::size_t count)
+{
+    std::lock_guard lock(mutex_);
+    max_per_bucket_ = count;
+}
+
+std::size_t gl_name_pool::max_per_bucket() const
+{
+    std::lock_guard lock(mutex_);
+    return max_per_bucket_;
+}
+
+pool_statistics gl_name_pool::statistics(gl_object type) const
+{
+    std::lock_guard lock(mutex_);
+
+    switch(type)
+    {
+        case gl_object::buffer:
+            return buffer_stats_;
+        case gl_object::vertex_array:
+            return vertex_array_stats_;
+        case gl_object::texture:
+            return texture_stats_;
+        default:
+            throw std::invalid_argument(
+                "gl_name_pool::statistics : Only buffers, vertex arrays and "
+                "textures are pooled");
+    }
+}
+
+void gl_name_pool::reset_statistics()
+{
+    std::lock_guard lock(mutex_);
+
+    for(auto type : {gl_object::buffer, gl_object::vertex_array,
+                     gl_object::texture})
+    {
+        auto& s = stats(type);
+        s       = {0, 0, 0, 0, s.pooled};
+    }
+}
+
+std::size_t gl_name_pool::pooled_bytes() const
+{
+    std::lock_guard lock(mutex_);
+    return pooled_bytes_;
+}
+
+void gl_name_pool::dump(std::ostream& stream) const
+{
+    std::lock_guard lock(mutex_);
+
+    auto line = [&stream](const char* name, const pool_statistics& s)
+    {
+        stream << name << " : " << s.recycled << "/" << s.acquired
+               << " recycled (" << static_cast<int>(s.hit_rate() * 100.0)
+               << "%), " << s.released << " released, " << s.overflowed
+               << " overflowed, " << s.pooled << " pooled\n";
+    };
+
+    stream << "gl_name_pool\n";
+    line("  buffers      ", buffer_stats_);
+    line("  vertex arrays", vertex_array_stats_);
+    line("  textures     ", texture_stats_);
+
+    for(const auto& [capacity, bucket] : buffers_)
+        if(!bucket.empty())
+            stream << "    buffer bucket " << capacity << " bytes : "
+                   << bucket.size() << "\n";
+
+    for(const auto& [key, bucket] : textures_)
+        if(!bucket.empty())
+            stream << "    texture bucket "
+                   << to_gl(static_cast<internal_format>(key >> 48)) << " "
+                   << ((key >> 24) & 0xFFFFFF) << "x" << (key & 0xFFFFFF)
+                   << " : " << bucket.size() << "\n";
+}
+
+void gl_name_pool::clear()
+{
+    std::vector<evicted_name> evicted;
+
+    {
+        std::lock_guard lock(mutex_);
+
+        evict(0, evicted);
+
+        // Names without storage are left by evict
+        for(const auto& [key, bucket] : buffers_)
+            for(const auto& name : bucket)
+                evicted.push_back({gl_object::buffer, name.id, true});
+
+        for(const auto& [key, bucket] : textures_)
+            for(const auto& name : bucket)
+                evicted.push_back({gl_object::texture, name.id, true});
+
+        for(const auto& name : vertex_arrays_)
+            evicted.push_back({gl_object::vertex_array, name.id, false});
+
+        buffers_.clear();
+        vertex_arrays_.clear();
+        textures_.clear();
+
+        buffer_stats_.pooled       = 0;
+        vertex_array_stats_.pooled = 0;
+        texture_stats_.pooled      = 0;
+    }
+
+    retire(evicted);
+}
+
+}    // namespace corgi
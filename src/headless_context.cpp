@@ -0,0 +1,271 @@
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/framebuffer.h>
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/headless_context.h>
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace corgi
+{
+
+static bool has_extension(const char* extensions, const char* name)
+{
+    if(extensions == nullptr)
+        return false;
+
+    const auto length = std::strlen(name);
+
+    for(const char* p = std::strstr(extensions, name); p != nullptr;
+        p             = std::strstr(p + length, name))
+    {
+        const bool starts = p == extensions || p[-1] == ' ';
+        const bool ends   = p[length] == ' ' || p[length] == '\0';
+
+        if(starts && ends)
+            return true;
+    }
+    return false;
+}
+
+static EGLDisplay open_display()
+{
+    const char* client_extensions =
+        eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    // Surfaceless platform doesn't need any display server, it's what we
+    // want for server side rendering
+    if(has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if(get_platform_display != nullptr)
+        {
+            EGLDisplay display = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+            if(display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+headless_context::headless_context(unsigned width, unsigned height)
+    : width_(width)
+    , height_(height)
+{
+    if(width_ == 0 || height_ == 0)
+        throw std::invalid_argument(
+            "headless_context::headless_context : width and height must be "
+            "greater than 0");
+
+    EGLDisplay display = open_display();
+
+    if(display == EGL_NO_DISPLAY)
+        throw std::runtime_error(
+            "headless_context::headless_context : Could not get an EGL "
+            "display");
+
+    EGLint major, minor;
+    if(eglInitialize(display, &major, &minor) == EGL_FALSE)
+        throw std::runtime_error(
+            "headless_context::headless_context : Could not initialize EGL");
+
+    display_ = display;
+
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE,
+                                        EGL_PBUFFER_BIT,
+                                        EGL_RENDERABLE_TYPE,
+                                        EGL_OPENGL_BIT,
+                                        EGL_RED_SIZE,
+                                        8,
+                                        EGL_GREEN_SIZE,
+                                        8,
+                                        EGL_BLUE_SIZE,
+                                        8,
+                                        EGL_ALPHA_SIZE,
+                                        8,
+                                        EGL_NONE};
+
+    EGLConfig config;
+    EGLint    config_count = 0;
+
+    if(eglChooseConfig(display, config_attributes, &config, 1,
+                       &config_count) == EGL_FALSE ||
+       config_count == 0)
+    {
+        eglTerminate(display);
+        throw std::runtime_error(
+            "headless_context::headless_context : No EGL config supports "
+            "desktop OpenGL");
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    // Same profile as the one requested by SDL in the tests
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,
+        4,
+        EGL_CONTEXT_MINOR_VERSION,
+        3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE};
+
+    context_ =
+        eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if(context_ == EGL_NO_CONTEXT)
+    {
+        eglTerminate(display);
+        throw std::runtime_error(
+            "headless_context::headless_context : Could not create an "
+            "OpenGL 4.3 context");
+    }
+
+    // We only need a surface if the driver can't make a context current
+    // without one. Rendering still goes to the framebuffer object
+    if(!has_extension(eglQueryString(display, EGL_EXTENSIONS),
+                      "EGL_KHR_surfaceless_context"))
+    {
+        const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                             EGL_NONE};
+
+        surface_ =
+            eglCreatePbufferSurface(display, config, pbuffer_attributes);
+
+        if(surface_ == EGL_NO_SURFACE)
+        {
+            eglDestroyContext(display, context_);
+            eglTerminate(display);
+            throw std::runtime_error(
+                "headless_context::headless_context : Could not create a "
+                "pbuffer surface");
+        }
+    }
+
+    if(eglMakeCurrent(display, surface_, surface_, context_) == EGL_FALSE)
+    {
+        if(surface_ != nullptr)
+            eglDestroySurface(display, surface_);
+        eglDestroyContext(display, context_);
+        eglTerminate(display);
+        throw std::runtime_error(
+            "headless_context::headless_context : Could not make the "
+            "context current");
+    }
+
+    gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress));
+
+    // The destructor won't run if the constructor throws, the context and
+    // the objects already created must be released here
+    try
+    {
+        create_default_target();
+    }
+    catch(...)
+    {
+        release();
+        throw;
+    }
+}
+
+headless_context::~headless_context()
+{
+    release();
+}
+
+void headless_context::release() noexcept
+{
+    // OpenGL objects must be destroyed while the context is still current
+    framebuffer_.reset();
+    color_.reset();
+    depth_stencil_.reset();
+    gl_name_pool::instance().clear();
+    deletion_queue::instance().flush();
+
+    framebuffer::set_default_target(0);
+
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if(surface_ != nullptr)
+        eglDestroySurface(display_, surface_);
+
+    eglDestroyContext(display_, context_);
+    eglTerminate(display_);
+}
+
+void headless_context::create_default_target()
+{
+    color_ = std::make_unique<renderbuffer>(internal_format::rgba8, width_,
+                                            height_);
+    depth_stencil_ = std::make_unique<renderbuffer>(
+        internal_format::depth24_stencil8, width_, height_);
+
+    color_->set_tag("headless_context");
+    depth_stencil_->set_tag("headless_context");
+
+    framebuffer_ = std::make_unique<framebuffer>();
+    framebuffer_->attach(attachment::color0, *color_);
+    framebuffer_->attach(attachment::depth_stencil, *depth_stencil_);
+
+    if(!framebuffer_->complete())
+        throw std::runtime_error(
+            "headless_context::create_default_target : Default target "
+            "framebuffer is incomplete");
+
+    bind_default_target();
+}
+
+void headless_context::make_current()
+{
+    eglMakeCurrent(display_, surface_, surface_, context_);
+    bind_default_target();
+}
+
+void headless_context::bind_default_target() const
+{
+    framebuffer::set_default_target(framebuffer_->id(), width_, height_);
+    framebuffer::unbind();
+}
+
+unsigned headless_context::default_target() const noexcept
+{
+    return framebuffer_->id();
+}
+
+unsigned headless_context::width() const noexcept
+{
+    return width_;
+}
+
+unsigned headless_context::height() const noexcept
+{
+    return height_;
+}
+
+image headless_context::read_pixels() const
+{
+    image img;
+    img.width  = static_cast<int>(width_);
+    img.height = static_cast<int>(height_);
+    img.data.resize(std::size_t(width_) * height_ * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_->id());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                 img.data.data());
+
+    return img;
+}
+
+}    // namespace corgi
@@ -9,21 +9,50 @@
 #endif
 
 #include <corgi/opengl/stb_image.h>
-// #include "stb_image_write.h"
+#include <corgi/opengl/stb_image_write.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
 
 namespace corgi
 {
 image image::load(const std::string& path)
 {
     int x, y, channels;
-    // Images are horizontal on OpenGL otherwise
-    stbi_set_flip_vertically_on_load(true);
+    // Images are horizontal on OpenGL otherwise. Set for the calling thread
+    // only, images can be decoded on several threads at once
+    stbi_set_flip_vertically_on_load_thread(true);
 
     stbi_uc* imageData =
         stbi_load(path.c_str(), &x, &y, &channels, STBI_rgb_alpha);
 
-    std::vector data_(imageData, imageData + x * y * channels);
+    if(imageData == nullptr)
+        throw std::runtime_error("image::load : Could not load " + path);
+
+    // Pixels are always converted to rgba
+    std::vector data_(imageData, imageData + x * y * 4);
+    stbi_image_free(imageData);
+
+    return {data_, x, y, 4};
+}
+
+bool image::save_png(const std::string& path) const
+{
+    // Flipped here rather than with stbi_flip_vertically_on_write, which
+    // sets a global flag while images may be saved on several threads
+    const auto row_size = static_cast<std::size_t>(width) * channels;
+
+    std::vector<unsigned char> flipped(data.size());
+
+    for(int row = 0; row < height; row++)
+        std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(
+                                       (height - 1 - row) * row_size),
+                    row_size,
+                    flipped.begin() +
+                        static_cast<std::ptrdiff_t>(row * row_size));
 
-    return {data_, x, y};
+    return stbi_write_png(path.c_str(), width, height, channels,
+                          flipped.data(), static_cast<int>(row_size)) != 0;
 }
 }    // namespace corgi
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <corgi/opengl/layout_registry.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+layout_registry& layout_registry::instance()
+{
+    static layout_registry registry;
+    return registry;
+}
+
+std::size_t layout_registry::hasher::operator()(
+    const std::vector<vertex_attribute>& attributes) const noexcept
+{
+    std::size_t seed = attributes.size();
+
+    for(const auto& attribute : attributes)
+    {
+        for(auto value :
+            {attribute.location, attribute.offset, attribute.size,
+             static_cast<int>(attribute.type), static_cast<int>(attribute.mode)})
+            seed ^= std::size_t(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+layout_id layout_registry::intern(const std::vector<vertex_attribute>& attributes)
+{
+    if(attributes.empty())
+        throw std::invalid_argument(
+            "layout_registry::intern : attributes vector is empty");
+
+    // Locations index 32 bits masks, see attributes_locations
+    for(const auto& attribute : attributes)
+        if(attribute.location < 0 || attribute.location >= 32)
+            throw std::invalid_argument(
+                "layout_registry::intern : Attribute location must be in "
+                "[0, 32)");
+
+    std::lock_guard lock(mutex_);
+
+    if(auto it = ids_.find(attributes); it != ids_.end())
+        return it->second;
+
+    if(layouts_.size() > 0xFFFF)
+        throw std::length_error("layout_registry::intern : Too many layouts");
+
+    const auto id = static_cast<layout_id>(layouts_.size());
+    layouts_.push_back(
+        {attributes, static_cast<std::size_t>(attributes_stride(attributes))});
+    ids_.emplace(attributes, id);
+    return id;
+}
+
+const layout_registry::layout& layout_registry::get(layout_id id) const
+{
+    if(id >= layouts_.size())
+        throw std::out_of_range("layout_registry::get : Unknown layout id");
+
+    return layouts_[id];
+}
+
+const std::vector<vertex_attribute>&
+layout_registry::attributes(layout_id id) const
+{
+    std::lock_guard lock(mutex_);
+    return get(id).attributes;
+}
+
+std::size_t layout_registry::stride(layout_id id) const
+{
+    std::lock_guard lock(mutex_);
+    return get(id).stride;
+}
+
+std::size_t layout_registry::size() const
+{
+    std::lock_guard lock(mutex_);
+    return layouts_.size();
+}
+
+}    // namespace corgi
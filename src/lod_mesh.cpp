@@ -0,0 +1,93 @@
+#include <corgi/opengl/lod_mesh.h>
+#include <corgi/opengl/mesh_optimizer.h>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace corgi
+{
+
+lod_mesh::lod_mesh(mesh_data   data,
+                   std::size_t max_levels,
+                   float       reduction,
+                   float       max_error)
+{
+    if(data.primitive != primitive_type::triangles)
+        throw std::invalid_argument(
+            "lod_mesh::lod_mesh : Only triangles can be simplified");
+
+    const auto positions    = mesh_optimizer::vertex_positions(data);
+    const auto vertex_count = data.vertex_count();
+
+    std::vector<std::vector<unsigned>> chain;
+    std::vector<float>                 errors;
+
+    chain.push_back(data.indexes);
+    errors.push_back(0.0F);
+
+    while(chain.size() < max_levels)
+    {
+        const auto previous = chain.back().size();
+        const auto target =
+            static_cast<std::size_t>(float(previous / 3) * reduction) * 3;
+
+        // Coarser levels are simplified from the original, so errors don't
+        // add up
+        float error  = 0.0F;
+        auto  level  = mesh_optimizer::simplify(data.indexes, positions,
+                                                target, max_error, &error);
+
+        // Not worth a level if it barely removes anything
+        if(level.empty() || level.size() > previous * 9 / 10)
+            break;
+
+        mesh_optimizer::optimize_vertex_cache(level, vertex_count);
+
+        chain.push_back(std::move(level));
+        errors.push_back(error);
+    }
+
+    data.indexes.clear();
+
+    for(std::size_t i = 0; i < chain.size(); i++)
+    {
+        levels_.push_back({static_cast<std::uint32_t>(data.indexes.size()),
+                           static_cast<std::uint32_t>(chain[i].size()),
+                           errors[i]});
+        data.indexes.insert(data.indexes.end(), chain[i].begin(),
+                            chain[i].end());
+    }
+
+    // Vertices end up in the order the finest level uses them
+    mesh_optimizer::optimize_vertex_fetch(
+        data.vertices, data.indexes,
+        static_cast<std::size_t>(attributes_stride(data.attributes)));
+
+    mesh_ = corgi::mesh(std::move(data));
+}
+
+std::size_t lod_mesh::select(float screen_size, float max_pixel_error) const
+{
+    std::size_t selected = 0;
+
+    for(std::size_t i = 0; i < levels_.size(); i++)
+        if(levels_[i].error * screen_size <= max_pixel_error)
+            selected = i;
+
+    return selected;
+}
+
+float projected_size(float size,
+                     float distance,
+                     float fov_y,
+                     float viewport_height) noexcept
+{
+    if(distance <= 0.0F)
+        return std::numeric_limits<float>::max();
+
+    return size / (2.0F * distance * std::tan(fov_y * 0.5F)) *
+           viewport_height;
+}
+
+}    // namespace corgi
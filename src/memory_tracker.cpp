@@ -0,0 +1,219 @@
+#include <corgi/opengl/memory_tracker.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace corgi
+{
+
+const char* to_string(resource_type type) noexcept
+{
+    switch(type)
+    {
+        case resource_type::vertex_buffer:
+            return "vertex_buffer";
+        case resource_type::index_buffer:
+            return "index_buffer";
+        case resource_type::uniform_buffer:
+            return "uniform_buffer";
+        case resource_type::texture:
+            return "texture";
+        case resource_type::renderbuffer:
+            return "renderbuffer";
+        case resource_type::pixel_buffer:
+            return "pixel_buffer";
+        case resource_type::pooled_buffer:
+            return "pooled_buffer";
+        case resource_type::pooled_texture:
+            return "pooled_texture";
+    }
+    return "unknown";
+}
+
+memory_tracker& memory_tracker::instance()
+{
+    static memory_tracker tracker;
+    return tracker;
+}
+
+std::uint64_t memory_tracker::key(resource_type type, unsigned id) noexcept
+{
+    return (static_cast<std::uint64_t>(type) << 32) | id;
+}
+
+void memory_tracker::add(resource_type type, std::size_t bytes)
+{
+    const auto index = static_cast<std::size_t>(type);
+
+    current_ += bytes;
+    current_per_type_[index] += bytes;
+
+    peak_                 = std::max(peak_, current_);
+    peak_per_type_[index] = std::max(peak_per_type_[index],
+                                     current_per_type_[index]);
+}
+
+void memory_tracker::remove(resource_type type, std::size_t bytes)
+{
+    current_ -= bytes;
+    current_per_type_[static_cast<std::size_t>(type)] -= bytes;
+}
+
+void memory_tracker::track(resource_type type, unsigned id, std::size_t bytes)
+{
+    if(id == 0)
+        return;
+
+    std::lock_guard lock(mutex_);
+
+    auto it = allocations_.find(key(type, id));
+
+    if(it != allocations_.end())
+    {
+        remove(type, it->second.bytes);
+        it->second.bytes = bytes;
+    }
+    else
+    {
+        allocations_.emplace(key(type, id),
+                             allocation_info {type, id, bytes, {}});
+    }
+
+    add(type, bytes);
+}
+
+void memory_tracker::untrack(resource_type type, unsigned id)
+{
+    if(id == 0)
+        return;
+
+    std::lock_guard lock(mutex_);
+
+    auto it = allocations_.find(key(type, id));
+
+    if(it == allocations_.end())
+        return;
+
+    remove(type, it->second.bytes);
+    allocations_.erase(it);
+}
+
+void memory_tracker::set_tag(resource_type type, unsigned id, std::string tag)
+{
+    std::lock_guard lock(mutex_);
+
+    auto it = allocations_.find(key(type, id));
+
+    if(it != allocations_.end())
+        it->second.tag = std::move(tag);
+}
+
+std::size_t memory_tracker::current() const
+{
+    std::lock_guard lock(mutex_);
+    return current_;
+}
+
+std::size_t memory_tracker::current(resource_type type) const
+{
+    std::lock_guard lock(mutex_);
+    return current_per_type_[static_cast<std::size_t>(type)];
+}
+
+std::size_t memory_tracker::peak() const
+{
+    std::lock_guard lock(mutex_);
+    return peak_;
+}
+
+std::size_t memory_tracker::peak(resource_type type) const
+{
+    std::lock_guard lock(mutex_);
+    return peak_per_type_[static_cast<std::size_t>(type)];
+}
+
+std::size_t memory_tracker::tag_total(const std::string& tag) const
+{
+    std::lock_guard lock(mutex_);
+
+    std::size_t total = 0;
+    for(const auto& [k, allocation] : allocations_)
+        if(allocation.tag == tag)
+            total += allocation.bytes;
+    return total;
+}
+
+std::map<std::string, std::size_t> memory_tracker::tag_totals() const
+{
+    std::lock_guard lock(mutex_);
+
+    std::map<std::string, std::size_t> totals;
+    for(const auto& [k, allocation] : allocations_)
+        totals[allocation.tag] += allocation.bytes;
+    return totals;
+}
+
+std::vector<allocation_info> memory_tracker::largest(std::size_t count) const
+{
+    std::vector<allocation_info> result;
+    {
+        std::lock_guard lock(mutex_);
+        result.reserve(allocations_.size());
+        for(const auto& [k, allocation] : allocations_)
+            result.push_back(allocation);
+    }
+
+    count = std::min(count, result.size());
+
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      [](const allocation_info& a, const allocation_info& b)
+                      { return a.bytes > b.bytes; });
+
+    result.resize(count);
+    return result;
+}
+
+std::size_t memory_tracker::allocation_count() const
+{
+    std::lock_guard lock(mutex_);
+    return allocations_.size();
+}
+
+void memory_tracker::reset_peak()
+{
+    std::lock_guard lock(mutex_);
+
+    peak_ = current_;
+    for(std::size_t i = 0; i < resource_type_count; i++)
+        peak_per_type_[i] = current_per_type_[i];
+}
+
+void memory_tracker::dump(std::ostream& stream, std::size_t count) const
+{
+    stream << "GPU memory : " << current() << " bytes (peak " << peak()
+           << " bytes)\n";
+
+    for(std::size_t i = 0; i < resource_type_count; i++)
+    {
+        const auto type = static_cast<resource_type>(i);
+        stream << "  " << std::left << std::setw(16) << to_string(type)
+               << current(type) << " bytes (peak " << peak(type)
+               << " bytes)\n";
+    }
+
+    stream << "Per tag :\n";
+    for(const auto& [tag, bytes] : tag_totals())
+        stream << "  " << std::left << std::setw(24)
+               << (tag.empty() ? "<untagged>" : tag) << bytes << " bytes\n";
+
+    stream << "Largest allocations :\n";
+    for(const auto& allocation : largest(count))
+        stream << "  " << std::left << std::setw(16)
+               << to_string(allocation.type) << "id " << std::setw(8)
+               << allocation.id << std::setw(12) << allocation.bytes
+               << (allocation.tag.empty() ? "<untagged>" : allocation.tag)
+               << "\n";
+}
+
+}    // namespace corgi
@@ -1,93 +1,150 @@
 #include <assert.h>
 #include <corgi/opengl/mesh.h>
 
+#include <cstring>
 #include <iostream>
 
 namespace corgi
 {
+static std::vector<std::byte> to_bytes(const std::vector<float>& vertices)
+{
+    std::vector<std::byte> bytes(vertices.size() * sizeof(float));
+    if(!vertices.empty())
+        std::memcpy(bytes.data(), vertices.data(), bytes.size());
+    return bytes;
+}
+
+std::size_t mesh_data::vertex_count() const
+{
+    if(attributes.empty())
+        return 0;
+    return vertices.size() / attributes_stride(attributes);
+}
+
+mesh::mesh(mesh_data data)
+    : mesh(std::move(data.vertices),
+           std::move(data.indexes),
+           std::move(data.attributes),
+           data.primitive)
+{
+}
+
 mesh::mesh(std::vector<float>            vertices,
            std::vector<unsigned>         indexes,
            std::vector<vertex_attribute> vertex_attributes,
            primitive_type                primitive_type)
-    : vertices_(std::move(vertices))
-    , indexes_(std::move(indexes))
+    : mesh(to_bytes(vertices),
+           std::move(indexes),
+           std::move(vertex_attributes),
+           primitive_type)
+{
+}
+
+mesh::mesh(std::vector<std::byte>        vertices,
+           std::vector<unsigned>         indexes,
+           std::vector<vertex_attribute> vertex_attributes,
+           primitive_type                primitive_type)
+    : mesh(std::move(vertices),
+           std::move(indexes),
+           layout_registry::instance().intern(vertex_attributes),
+           primitive_type)
+{
+}
+
+mesh::mesh(std::vector<std::byte> vertices,
+           std::vector<unsigned>  indexes,
+           layout_id              layout,
+           primitive_type         primitive_type)
+    : layout_(layout)
+    , index_count_(static_cast<std::uint32_t>(indexes.size()))
+    , index_type_(select_index_type(indexes))
     , primitive_(primitive_type)
 {
-    assert(!vertex_attributes.empty());
-    assert(!vertices_.empty());
-    assert(!indexes_.empty());
+    assert(!vertices.empty());
+    assert(!indexes.empty());
 
-    assert(vertices_.size() % attributes_total_size(vertex_attributes) == 0);
+    assert(vertices.size() % layout_registry::instance().stride(layout) == 0);
 
     switch(primitive_)
     {
         case primitive_type::lines:
-            assert(indexes_.size() % 2 == 0);
+            assert(indexes.size() % 2 == 0);
             break;
 
         case primitive_type::quads:
-            assert(indexes_.size() % 4 == 0);
+            assert(indexes.size() % 4 == 0);
             break;
 
         case primitive_type::triangles:
-            assert(indexes_.size() % 3 == 0);
+            assert(indexes.size() % 3 == 0);
             break;
     }
 
-    vertex_buffer_.set_data(vertices_);
-    index_buffer_.set_data(indexes_);
+    const auto& attributes = layout_registry::instance().attributes(layout);
+    bounds_          = compute_aabb(vertices, attributes);
+    bounding_sphere_ = compute_bounding_sphere(vertices, attributes, bounds_);
 
-    vertex_array_ = std::make_unique<corgi::vertex_array>(
-        vertex_attributes, vertex_buffer_, index_buffer_);
+    vertex_buffer_.set_data(std::move(vertices));
+    index_buffer_.set_data(pack_indexes(indexes, index_type_));
 }
 
 bool mesh::empty() const
 {
-    return vertex_array_.get() == nullptr;
+    return index_count_ == 0;
 }
 
 mesh::mesh() {}
 
 void mesh::copy_from(const mesh& other)
 {
-    vertices_  = other.vertices_;
-    indexes_   = other.indexes_;
-    primitive_ = other.primitive_;
+    bounds_          = other.bounds_;
+    bounding_sphere_ = other.bounding_sphere_;
+    layout_      = other.layout_;
+    index_count_ = other.index_count_;
+    index_type_  = other.index_type_;
+    primitive_   = other.primitive_;
 
     vertex_buffer_ = other.vertex_buffer_;
     index_buffer_  = other.index_buffer_;
-
-    vertex_array_ = std::make_unique<corgi::vertex_array>(
-        other.vertex_array_->vertex_attributes(), vertex_buffer_,
-        index_buffer_);
 }
 
 void mesh::move_from(mesh&& other) noexcept
 {
-    vertices_  = std::move(other.vertices_);
-    indexes_   = std::move(other.indexes_);
-    primitive_ = other.primitive_;
+    bounds_          = other.bounds_;
+    bounding_sphere_ = other.bounding_sphere_;
+    layout_      = other.layout_;
+    index_count_ = other.index_count_;
+    index_type_  = other.index_type_;
+    primitive_   = other.primitive_;
 
     vertex_buffer_ = std::move(other.vertex_buffer_);
     index_buffer_  = std::move(other.index_buffer_);
 
-    vertex_array_ = std::make_unique<corgi::vertex_array>(
-        other.vertex_array_->vertex_attributes(), vertex_buffer_,
-        index_buffer_);
+    other.index_count_ = 0;
+}
+
+layout_id mesh::layout() const noexcept
+{
+    return layout_;
+}
 
-    other.vertex_array_.reset();
+const std::vector<vertex_attribute>& mesh::attributes() const
+{
+    return layout_registry::instance().attributes(layout_);
 }
 
-const vertex_array* mesh::vertex_array() const
+const buffer<std::byte, buffer_type::array_buffer>* mesh::vertex_buffer() const
 {
-    return vertex_array_.get();
+    return &vertex_buffer_;
 }
 
 void mesh::reset()
 {
     vertex_buffer_.clear();
     index_buffer_.clear();
-    vertex_array_.reset();
+    index_count_     = 0;
+    bounds_          = {};
+    bounding_sphere_ = {};
 }
 
 mesh& mesh::operator=(const mesh& other)
@@ -116,23 +173,63 @@ mesh& mesh::operator=(mesh&& other) noexcept
 
 mesh::mesh(mesh&& other) noexcept
 {
-    move_from(std::move(other));
+    if(!other.empty())
+        move_from(std::move(other));
 }
 
 mesh::mesh(const mesh& other)
 {
-    copy_from(other);
+    if(!other.empty())
+        copy_from(other);
 }
 
-const buffer<unsigned, buffer_type::element_array_buffer>*
+const buffer<std::byte, buffer_type::element_array_buffer>*
 mesh::index_buffer() const
 {
     return &index_buffer_;
 }
 
-const std::vector<unsigned>& mesh::indexes() const
+std::vector<unsigned> mesh::indexes() const
+{
+    return unpack_indexes(index_buffer_.data(), index_type_);
+}
+
+mesh_data mesh::data() const
+{
+    if(empty())
+        return {};
+
+    return {vertices(), indexes(), attributes(), primitive_};
+}
+
+std::uint32_t mesh::index_count() const noexcept
+{
+    return index_count_;
+}
+
+index_type mesh::index_type() const noexcept
+{
+    return index_type_;
+}
+
+primitive_type mesh::primitive() const noexcept
+{
+    return primitive_;
+}
+
+const std::vector<std::byte>& mesh::vertices() const
+{
+    return vertex_buffer_.data();
+}
+
+const aabb& mesh::bounds() const noexcept
+{
+    return bounds_;
+}
+
+const bounding_sphere& mesh::bounding_sphere() const noexcept
 {
-    return index_buffer_.data();
+    return bounding_sphere_;
 }
 
 }    // namespace corgi
\ No newline at end of file
@@ -0,0 +1,420 @@
+#include <corgi/opengl/mesh_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#    define NOMINMAX
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace corgi
+{
+
+mapped_file::mapped_file(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        throw std::runtime_error("mapped_file::mapped_file : Couldn't open " +
+                                 path.string());
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+    {
+        release();
+        throw std::runtime_error(
+            "mapped_file::mapped_file : Empty or unreadable file " +
+            path.string());
+    }
+
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    const void* view =
+        mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+    if(view == nullptr)
+    {
+        release();
+        throw std::runtime_error("mapped_file::mapped_file : Couldn't map " +
+                                 path.string());
+    }
+
+    data_ = static_cast<const std::byte*>(view);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+
+    if(fd == -1)
+        throw std::runtime_error("mapped_file::mapped_file : Couldn't open " +
+                                 path.string());
+
+    struct stat status;
+    if(::fstat(fd, &status) == -1 || status.st_size == 0)
+    {
+        ::close(fd);
+        throw std::runtime_error(
+            "mapped_file::mapped_file : Empty or unreadable file " +
+            path.string());
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    void*      view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+
+    if(view == MAP_FAILED)
+        throw std::runtime_error("mapped_file::mapped_file : Couldn't map " +
+                                 path.string());
+
+    // The whole file is read by the upload, start reading it right away
+    ::madvise(view, size, MADV_WILLNEED);
+
+    data_ = static_cast<const std::byte*>(view);
+    size_ = size;
+#endif
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : data_(other.data_)
+    , size_(other.size_)
+#ifdef _WIN32
+    , file_(other.file_)
+    , mapping_(other.mapping_)
+#endif
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+#ifdef _WIN32
+    other.file_    = nullptr;
+    other.mapping_ = nullptr;
+#endif
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    release();
+
+    data_ = other.data_;
+    size_ = other.size_;
+#ifdef _WIN32
+    file_    = other.file_;
+    mapping_ = other.mapping_;
+#endif
+
+    other.data_ = nullptr;
+    other.size_ = 0;
+#ifdef _WIN32
+    other.file_    = nullptr;
+    other.mapping_ = nullptr;
+#endif
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    release();
+}
+
+void mapped_file::release() noexcept
+{
+#ifdef _WIN32
+    if(data_ != nullptr)
+        UnmapViewOfFile(data_);
+    if(mapping_ != nullptr)
+        CloseHandle(mapping_);
+    if(file_ != nullptr)
+        CloseHandle(file_);
+
+    file_    = nullptr;
+    mapping_ = nullptr;
+#else
+    if(data_ != nullptr)
+        ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+static std::uint64_t align_offset(std::uint64_t offset)
+{
+    return (offset + mesh_file_alignment - 1) & ~(mesh_file_alignment - 1);
+}
+
+template<class T>
+static std::uint32_t largest_index(std::span<const std::byte> indexes)
+{
+    std::uint32_t largest = 0;
+
+    // Indexes are aligned in the file, but memcpy doesn't rely on it
+    for(std::size_t i = 0; i < indexes.size(); i += sizeof(T))
+    {
+        T index;
+        std::memcpy(&index, indexes.data() + i, sizeof(T));
+        largest = std::max(largest, static_cast<std::uint32_t>(index));
+    }
+    return largest;
+}
+
+static std::uint32_t largest_index(std::span<const std::byte> indexes,
+                                   index_type                 type)
+{
+    switch(type)
+    {
+        case index_type::uint8:
+            return largest_index<std::uint8_t>(indexes);
+        case index_type::uint16:
+            return largest_index<std::uint16_t>(indexes);
+        default:
+            return largest_index<std::uint32_t>(indexes);
+    }
+}
+
+void write_mesh_file(const std::filesystem::path& path, const mesh_data& data)
+{
+    if(data.vertices.empty() || data.indexes.empty() || data.attributes.empty())
+        throw std::invalid_argument(
+            "write_mesh_file : Mesh data has no vertices, indexes or "
+            "attributes");
+
+    const auto type   = select_index_type(data.indexes);
+    const auto packed = pack_indexes(data.indexes, type);
+    const auto stride = static_cast<std::size_t>(attributes_stride(data.attributes));
+    const auto vcount = data.vertex_count();
+
+    mesh_file_header header;
+    header.vertex_count    = static_cast<std::uint32_t>(vcount);
+    header.index_count     = static_cast<std::uint32_t>(data.indexes.size());
+    header.stride          = static_cast<std::uint32_t>(stride);
+    header.attribute_count = static_cast<std::uint16_t>(data.attributes.size());
+    header.index_type      = static_cast<std::uint8_t>(type);
+    header.primitive       = static_cast<std::uint8_t>(data.primitive);
+
+    const auto* position = find_position_attribute(data.attributes);
+
+    if(position != nullptr)
+    {
+        const auto components = std::min(position->size, 3);
+
+        header.bounds_min.fill(std::numeric_limits<float>::max());
+        header.bounds_max.fill(std::numeric_limits<float>::lowest());
+
+        for(std::size_t v = 0; v < vcount; v++)
+        {
+            float p[3] = {0.0F, 0.0F, 0.0F};
+            std::memcpy(p, data.vertices.data() + v * stride + position->offset,
+                        components * sizeof(float));
+
+            for(int i = 0; i < 3; i++)
+            {
+                header.bounds_min[i] = std::min(header.bounds_min[i], p[i]);
+                header.bounds_max[i] = std::max(header.bounds_max[i], p[i]);
+            }
+        }
+    }
+
+    header.vertices_offset =
+        align_offset(sizeof(mesh_file_header) +
+                     data.attributes.size() * sizeof(mesh_file_attribute));
+    header.vertices_size  = vcount * stride;
+    header.indexes_offset = align_offset(header.vertices_offset +
+                                         header.vertices_size);
+    header.indexes_size   = packed.size();
+
+    std::vector<mesh_file_attribute> attributes;
+    attributes.reserve(data.attributes.size());
+
+    for(const auto& attribute : data.attributes)
+        attributes.push_back({attribute.location, attribute.offset,
+                              attribute.size,
+                              static_cast<std::uint8_t>(attribute.type),
+                              static_cast<std::uint8_t>(attribute.mode), 0});
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    if(!file)
+        throw std::runtime_error("write_mesh_file : Couldn't open " +
+                                 path.string());
+
+    const char padding[mesh_file_alignment] {};
+
+    auto pad_to = [&](std::uint64_t offset)
+    {
+        const auto current = static_cast<std::uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(offset - current));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(attributes.data()),
+               static_cast<std::streamsize>(attributes.size() *
+                                            sizeof(mesh_file_attribute)));
+
+    pad_to(header.vertices_offset);
+    file.write(reinterpret_cast<const char*>(data.vertices.data()),
+               static_cast<std::streamsize>(header.vertices_size));
+
+    pad_to(header.indexes_offset);
+    file.write(reinterpret_cast<const char*>(packed.data()),
+               static_cast<std::streamsize>(packed.size()));
+
+    if(!file)
+        throw std::runtime_error("write_mesh_file : Couldn't write " +
+                                 path.string());
+}
+
+mesh_file::mesh_file(const std::filesystem::path& path)
+    : file_(path)
+{
+    const auto bytes = file_.data();
+
+    auto invalid = [&path](const char* reason)
+    {
+        return std::runtime_error("mesh_file::mesh_file : " + path.string() +
+                                  " " + reason);
+    };
+
+    if(bytes.size() < sizeof(mesh_file_header))
+        throw invalid("is too small to be a mesh file");
+
+    std::memcpy(&header_, bytes.data(), sizeof(mesh_file_header));
+
+    if(header_.magic != mesh_file_header {}.magic)
+        throw invalid("isn't a mesh file");
+
+    if(header_.version != mesh_file_header {}.version)
+        throw invalid("has an unsupported version");
+
+    if(header_.index_type > static_cast<std::uint8_t>(index_type::uint32) ||
+       header_.primitive > static_cast<std::uint8_t>(primitive_type::lines))
+        throw invalid("has an unknown index type or primitive");
+
+    const auto attributes_end =
+        sizeof(mesh_file_header) +
+        std::size_t(header_.attribute_count) * sizeof(mesh_file_attribute);
+
+    if(header_.attribute_count == 0 || attributes_end > bytes.size())
+        throw invalid("has no attributes or is truncated");
+
+    attributes_.reserve(header_.attribute_count);
+
+    for(std::size_t i = 0; i < header_.attribute_count; i++)
+    {
+        mesh_file_attribute attribute;
+        std::memcpy(&attribute,
+                    bytes.data() + sizeof(mesh_file_header) +
+                        i * sizeof(mesh_file_attribute),
+                    sizeof(mesh_file_attribute));
+
+        if(attribute.location < 0 || attribute.location >= 32 ||
+           attribute.size < 1 || attribute.size > 4 || attribute.offset < 0 ||
+           attribute.type >
+               static_cast<std::uint8_t>(attribute_type::uint_2_10_10_10_rev) ||
+           attribute.mode > static_cast<std::uint8_t>(attribute_mode::integer))
+            throw invalid("has an invalid attribute");
+
+        const auto type = static_cast<attribute_type>(attribute.type);
+        const auto mode = static_cast<attribute_mode>(attribute.mode);
+
+        // Same rules as the ones the vertex_attribute constructor asserts
+        if((is_packed(type) && attribute.size != 4) ||
+           (mode == attribute_mode::integer &&
+            (type == attribute_type::float32 ||
+             type == attribute_type::float16 || is_packed(type))))
+            throw invalid("has an invalid attribute");
+
+        const vertex_attribute parsed(attribute.location, attribute.offset,
+                                      attribute.size, type, mode);
+
+        // Checked in 64 bits so attributes_stride can't overflow later
+        if(std::int64_t(parsed.offset) + parsed.size_in_bytes() >
+           std::int64_t(header_.stride))
+            throw invalid("has an attribute outside of its vertex");
+
+        attributes_.push_back(parsed);
+    }
+
+    auto in_file = [&](std::uint64_t offset, std::uint64_t size)
+    {
+        return offset % mesh_file_alignment == 0 && offset >= attributes_end &&
+               offset <= bytes.size() && size <= bytes.size() - offset;
+    };
+
+    if(header_.stride != std::uint32_t(attributes_stride(attributes_)) ||
+       header_.vertices_size !=
+           std::uint64_t(header_.vertex_count) * header_.stride ||
+       header_.indexes_size !=
+           std::uint64_t(header_.index_count) * index_type_size(index_type()))
+        throw invalid("has sizes that don't match its layout");
+
+    if(header_.vertex_count == 0 || header_.index_count == 0 ||
+       !in_file(header_.vertices_offset, header_.vertices_size) ||
+       !in_file(header_.indexes_offset, header_.indexes_size))
+        throw invalid("is empty or truncated");
+
+    // Out of range indexes would make the GPU read past the vertex buffer
+    if(largest_index(indexes(), index_type()) >= header_.vertex_count)
+        throw invalid("has indexes past its last vertex");
+}
+
+const mesh_file_header& mesh_file::header() const noexcept
+{
+    return header_;
+}
+
+const std::vector<vertex_attribute>& mesh_file::attributes() const noexcept
+{
+    return attributes_;
+}
+
+std::span<const std::byte> mesh_file::vertices() const noexcept
+{
+    return file_.data().subspan(header_.vertices_offset, header_.vertices_size);
+}
+
+std::span<const std::byte> mesh_file::indexes() const noexcept
+{
+    return file_.data().subspan(header_.indexes_offset, header_.indexes_size);
+}
+
+corgi::index_type mesh_file::index_type() const noexcept
+{
+    return static_cast<corgi::index_type>(header_.index_type);
+}
+
+primitive_type mesh_file::primitive() const noexcept
+{
+    return static_cast<primitive_type>(header_.primitive);
+}
+
+compact_mesh mesh_file::upload() const
+{
+    return compact_mesh(vertices(), indexes(), index_type(),
+                        layout_registry::instance().intern(attributes_),
+                        primitive());
+}
+
+compact_mesh load_mesh_file(const std::filesystem::path& path)
+{
+    return mesh_file(path).upload();
+}
+
+}    // namespace corgi
@@ -0,0 +1,989 @@
+#include <corgi/opengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+namespace corgi::mesh_optimizer
+{
+
+static constexpr unsigned no_index = std::numeric_limits<unsigned>::max();
+
+/**
+ * @brief FIFO cache, like the post transform cache of most GPUs
+ */
+class fifo_cache
+{
+public:
+    fifo_cache(std::size_t vertex_count, unsigned size)
+        : timestamps_(vertex_count, 0)
+        , size_(size)
+    {
+    }
+
+    /**
+     * @brief Returns true if the vertex had to be transformed
+     */
+    bool miss(unsigned vertex)
+    {
+        // A vertex is in the cache if it was added less than size_ misses ago
+        if(timestamps_[vertex] != 0 && time_ - timestamps_[vertex] < size_)
+            return false;
+
+        timestamps_[vertex] = ++time_;
+        return true;
+    }
+
+    void reset() { time_ += size_ + 1; }
+
+private:
+    std::vector<std::size_t> timestamps_;
+    std::size_t              time_ {0};
+    unsigned                 size_;
+};
+
+vertex_cache_statistics analyze_vertex_cache(std::span<const unsigned> indexes,
+                                             std::size_t vertex_count,
+                                             unsigned    cache_size)
+{
+    vertex_cache_statistics statistics;
+    statistics.triangles = indexes.size() / 3;
+
+    fifo_cache         cache(vertex_count, cache_size);
+    std::vector<bool>  used(vertex_count, false);
+
+    for(auto index : indexes)
+    {
+        if(cache.miss(index))
+            statistics.vertices_transformed++;
+
+        if(!used[index])
+        {
+            used[index] = true;
+            statistics.vertices++;
+        }
+    }
+
+    if(statistics.triangles != 0)
+        statistics.acmr = float(statistics.vertices_transformed) /
+                          float(statistics.triangles);
+    if(statistics.vertices != 0)
+        statistics.atvr = float(statistics.vertices_transformed) /
+                          float(statistics.vertices);
+
+    return statistics;
+}
+
+// Forsyth's scoring, for a LRU cache of 32 vertices
+static constexpr int   forsyth_cache_size    = 32;
+static constexpr float forsyth_last_triangle = 0.75F;
+static constexpr float forsyth_decay_power   = 1.5F;
+static constexpr float forsyth_valence_scale = 2.0F;
+static constexpr float forsyth_valence_power = 0.5F;
+
+static float vertex_score(int cache_position, unsigned remaining)
+{
+    // The vertex isn't used anymore
+    if(remaining == 0)
+        return -1.0F;
+
+    float score = 0.0F;
+
+    if(cache_position >= 0)
+    {
+        // The vertices of the last triangle get a fixed score, so the next
+        // triangle doesn't favor any of them
+        if(cache_position < 3)
+            score = forsyth_last_triangle;
+        else
+            score = std::pow(1.0F - float(cache_position - 3) /
+                                        float(forsyth_cache_size - 3),
+                             forsyth_decay_power);
+    }
+
+    // Vertices with few triangles left are favored, so they can leave the
+    // cache for good
+    return score + forsyth_valence_scale *
+                       std::pow(float(remaining), -forsyth_valence_power);
+}
+
+void optimize_vertex_cache(std::span<unsigned> indexes, std::size_t vertex_count)
+{
+    const auto triangle_count = indexes.size() / 3;
+
+    if(triangle_count == 0)
+        return;
+
+    // Triangles using each vertex, the unemitted ones first
+    std::vector<unsigned> remaining(vertex_count, 0);
+    for(auto index : indexes)
+        remaining[index]++;
+
+    std::vector<unsigned> offsets(vertex_count + 1, 0);
+    for(std::size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned> adjacency(indexes.size());
+    {
+        std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+        for(std::size_t i = 0; i < indexes.size(); i++)
+            adjacency[fill[indexes[i]]++] = static_cast<unsigned>(i / 3);
+    }
+
+    std::vector<int>   cache_position(vertex_count, -1);
+    std::vector<float> scores(vertex_count);
+    for(std::size_t v = 0; v < vertex_count; v++)
+        scores[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool>  emitted(triangle_count, false);
+
+    unsigned best  = 0;
+    float    top   = -1.0F;
+
+    for(std::size_t t = 0; t < triangle_count; t++)
+    {
+        triangle_scores[t] = scores[indexes[t * 3]] +
+                             scores[indexes[t * 3 + 1]] +
+                             scores[indexes[t * 3 + 2]];
+
+        if(triangle_scores[t] > top)
+        {
+            top  = triangle_scores[t];
+            best = static_cast<unsigned>(t);
+        }
+    }
+
+    std::vector<unsigned> result;
+    result.reserve(indexes.size());
+
+    std::vector<unsigned> cache;
+    std::vector<unsigned> next_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    next_cache.reserve(forsyth_cache_size + 3);
+
+    std::size_t cursor = 0;
+
+    for(std::size_t emitted_count = 0; emitted_count < triangle_count;
+        emitted_count++)
+    {
+        // Nothing in the cache can continue the strip, we take the next
+        // triangle in the original order
+        if(best == no_index)
+        {
+            while(emitted[cursor])
+                cursor++;
+            best = static_cast<unsigned>(cursor);
+        }
+
+        const std::array<unsigned, 3> triangle {
+            indexes[best * 3], indexes[best * 3 + 1], indexes[best * 3 + 2]};
+
+        result.insert(result.end(), triangle.begin(), triangle.end());
+        emitted[best] = true;
+
+        for(auto v : triangle)
+        {
+            // Moves the triangle out of the vertex's unemitted triangles
+            auto begin = adjacency.begin() + offsets[v];
+            auto end   = begin + remaining[v];
+            auto it    = std::find(begin, end, best);
+            std::iter_swap(it, end - 1);
+            remaining[v]--;
+        }
+
+        // The triangle's vertices go to the front of the cache
+        next_cache.assign(triangle.begin(), triangle.end());
+        for(auto v : cache)
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+                next_cache.push_back(v);
+
+        // Vertices pushed out of the cache lose their cache score
+        for(std::size_t i = forsyth_cache_size; i < next_cache.size(); i++)
+        {
+            const auto v      = next_cache[i];
+            cache_position[v] = -1;
+            scores[v]         = vertex_score(-1, remaining[v]);
+        }
+
+        if(next_cache.size() > forsyth_cache_size)
+            next_cache.resize(forsyth_cache_size);
+
+        std::swap(cache, next_cache);
+
+        for(std::size_t i = 0; i < cache.size(); i++)
+        {
+            const auto v      = cache[i];
+            cache_position[v] = static_cast<int>(i);
+            scores[v]         = vertex_score(static_cast<int>(i), remaining[v]);
+        }
+
+        // Only triangles using a cached vertex can be the next best one
+        best = no_index;
+        top  = -1.0F;
+
+        for(auto v : cache)
+        {
+            for(unsigned i = 0; i < remaining[v]; i++)
+            {
+                const auto t = adjacency[offsets[v] + i];
+
+                triangle_scores[t] = scores[indexes[t * 3]] +
+                                     scores[indexes[t * 3 + 1]] +
+                                     scores[indexes[t * 3 + 2]];
+
+                if(triangle_scores[t] > top)
+                {
+                    top  = triangle_scores[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    std::copy(result.begin(), result.end(), indexes.begin());
+}
+
+struct cluster
+{
+    std::size_t first_triangle;
+    std::size_t triangle_count;
+    float       sort_key;
+};
+
+/**
+ * @brief Cuts the triangles where the cache is cold anyway, so the clusters
+ * can be reordered without losing much cache efficiency
+ */
+static std::vector<std::size_t>
+cluster_boundaries(std::span<const unsigned> indexes,
+                   std::size_t               vertex_count,
+                   float                     threshold,
+                   unsigned                  cache_size)
+{
+    const auto triangle_count = indexes.size() / 3;
+
+    // Hard boundaries : triangles whose 3 vertices miss the cache
+    std::vector<std::size_t> hard {0};
+    {
+        fifo_cache cache(vertex_count, cache_size);
+
+        for(std::size_t t = 0; t < triangle_count; t++)
+        {
+            unsigned misses = 0;
+            for(unsigned k = 0; k < 3; k++)
+                misses += cache.miss(indexes[t * 3 + k]);
+
+            if(misses == 3 && t != 0)
+                hard.push_back(t);
+        }
+    }
+    hard.push_back(triangle_count);
+
+    // Soft boundaries : inside a hard cluster, we cut as soon as the cluster
+    // started from a cold cache stays under the threshold
+    std::vector<std::size_t> boundaries;
+    fifo_cache               cache(vertex_count, cache_size);
+
+    for(std::size_t h = 0; h + 1 < hard.size(); h++)
+    {
+        const auto start = hard[h];
+        const auto end   = hard[h + 1];
+
+        cache.reset();
+        std::size_t cluster_misses = 0;
+        for(std::size_t t = start; t < end; t++)
+            for(unsigned k = 0; k < 3; k++)
+                cluster_misses += cache.miss(indexes[t * 3 + k]);
+
+        const float limit =
+            threshold * float(cluster_misses) / float(end - start);
+
+        boundaries.push_back(start);
+        cache.reset();
+
+        std::size_t misses      = 0;
+        std::size_t soft_start  = start;
+
+        for(std::size_t t = start; t < end; t++)
+        {
+            for(unsigned k = 0; k < 3; k++)
+                misses += cache.miss(indexes[t * 3 + k]);
+
+            const float acmr = float(misses) / float(t - soft_start + 1);
+
+            if(t + 1 < end && acmr <= limit)
+            {
+                boundaries.push_back(t + 1);
+                soft_start = t + 1;
+                misses     = 0;
+                cache.reset();
+            }
+        }
+    }
+
+    boundaries.push_back(triangle_count);
+    return boundaries;
+}
+
+void optimize_overdraw(std::span<unsigned>    indexes,
+                       std::span<const float> positions,
+                       float                  threshold,
+                       unsigned               cache_size)
+{
+    const auto vertex_count   = positions.size() / 3;
+    const auto triangle_count = indexes.size() / 3;
+
+    if(triangle_count == 0)
+        return;
+
+    const auto boundaries =
+        cluster_boundaries(indexes, vertex_count, threshold, cache_size);
+
+    // Center of the mesh
+    std::array<double, 3> center {0.0, 0.0, 0.0};
+    for(std::size_t v = 0; v < vertex_count; v++)
+        for(unsigned k = 0; k < 3; k++)
+            center[k] += positions[v * 3 + k];
+    for(auto& c : center)
+        c /= double(std::max<std::size_t>(vertex_count, 1));
+
+    std::vector<cluster> clusters;
+    clusters.reserve(boundaries.size());
+
+    for(std::size_t c = 0; c + 1 < boundaries.size(); c++)
+    {
+        const auto first = boundaries[c];
+        const auto count = boundaries[c + 1] - first;
+
+        // Area weighted centroid and normal of the cluster
+        std::array<float, 3> centroid {0.0F, 0.0F, 0.0F};
+        std::array<float, 3> normal {0.0F, 0.0F, 0.0F};
+        float                area = 0.0F;
+
+        for(std::size_t t = first; t < first + count; t++)
+        {
+            const float* a = &positions[indexes[t * 3] * 3];
+            const float* b = &positions[indexes[t * 3 + 1] * 3];
+            const float* d = &positions[indexes[t * 3 + 2] * 3];
+
+            const std::array<float, 3> ab {b[0] - a[0], b[1] - a[1],
+                                           b[2] - a[2]};
+            const std::array<float, 3> ad {d[0] - a[0], d[1] - a[1],
+                                           d[2] - a[2]};
+
+            const std::array<float, 3> cross {ab[1] * ad[2] - ab[2] * ad[1],
+                                              ab[2] * ad[0] - ab[0] * ad[2],
+                                              ab[0] * ad[1] - ab[1] * ad[0]};
+
+            const float triangle_area = std::sqrt(
+                cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+            for(unsigned k = 0; k < 3; k++)
+            {
+                centroid[k] += (a[k] + b[k] + d[k]) / 3.0F * triangle_area;
+                normal[k] += cross[k];
+            }
+            area += triangle_area;
+        }
+
+        float key = 0.0F;
+
+        if(area > 0.0F)
+        {
+            const float length = std::sqrt(normal[0] * normal[0] +
+                                           normal[1] * normal[1] +
+                                           normal[2] * normal[2]);
+
+            for(unsigned k = 0; k < 3; k++)
+                key += (centroid[k] / area - float(center[k])) *
+                       (length > 0.0F ? normal[k] / length : 0.0F);
+        }
+
+        clusters.push_back({first, count, key});
+    }
+
+    // Clusters facing away from the center are the most likely to occlude
+    // the others, they are drawn first
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const cluster& a, const cluster& b)
+                     { return a.sort_key > b.sort_key; });
+
+    std::vector<unsigned> result;
+    result.reserve(indexes.size());
+
+    for(const auto& c : clusters)
+        result.insert(result.end(), indexes.begin() + c.first_triangle * 3,
+                      indexes.begin() +
+                          (c.first_triangle + c.triangle_count) * 3);
+
+    std::copy(result.begin(), result.end(), indexes.begin());
+}
+
+std::size_t optimize_vertex_fetch(std::vector<std::byte>& vertices,
+                                  std::span<unsigned>     indexes,
+                                  std::size_t             stride)
+{
+    if(stride == 0)
+        throw std::invalid_argument(
+            "mesh_optimizer::optimize_vertex_fetch : stride is 0");
+
+    const auto vertex_count = vertices.size() / stride;
+
+    std::vector<unsigned> remap(vertex_count, no_index);
+    unsigned              next = 0;
+
+    for(auto& index : indexes)
+    {
+        if(remap[index] == no_index)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    std::vector<std::byte> result(std::size_t(next) * stride);
+
+    for(std::size_t v = 0; v < vertex_count; v++)
+        if(remap[v] != no_index)
+            std::memcpy(result.data() + remap[v] * stride,
+                        vertices.data() + v * stride, stride);
+
+    vertices = std::move(result);
+    return next;
+}
+
+/**
+ * @brief Returns the components of every vertex as integers, floats being
+ * snapped to the epsilon grid
+ */
+static std::vector<std::int64_t> weld_keys(const mesh_data& data,
+                                           float            epsilon,
+                                           std::size_t&     key_size)
+{
+    const auto stride       = static_cast<std::size_t>(attributes_stride(data.attributes));
+    const auto vertex_count = data.vertex_count();
+
+    key_size = 0;
+    for(const auto& attribute : data.attributes)
+        key_size += attribute.type == attribute_type::float32
+                        ? attribute.size
+                        : (attribute.size_in_bytes() + 7) / 8;
+
+    std::vector<std::int64_t> keys(vertex_count * key_size, 0);
+
+    for(std::size_t v = 0; v < vertex_count; v++)
+    {
+        const auto* vertex = data.vertices.data() + v * stride;
+        auto*       key    = keys.data() + v * key_size;
+
+        for(const auto& attribute : data.attributes)
+        {
+            const auto* bytes = vertex + attribute.offset;
+
+            if(attribute.type != attribute_type::float32)
+            {
+                // Compared as is, 8 bytes at a time
+                const auto size = std::size_t(attribute.size_in_bytes());
+                for(std::size_t i = 0; i < size; i += 8)
+                    std::memcpy(key++, bytes + i, std::min<std::size_t>(8, size - i));
+                continue;
+            }
+
+            for(int c = 0; c < attribute.size; c++)
+            {
+                float value;
+                std::memcpy(&value, bytes + c * sizeof(float), sizeof(float));
+
+                const float cell = epsilon > 0.0F ? value / epsilon : 0.0F;
+
+                if(epsilon > 0.0F && std::isfinite(cell) &&
+                   std::abs(cell) < 9e18F)
+                    *key++ = std::llround(cell);
+                else
+                    *key++ = std::bit_cast<std::int32_t>(value);
+            }
+        }
+    }
+
+    return keys;
+}
+
+std::size_t weld_vertices(mesh_data& data, float epsilon)
+{
+    const auto stride       = static_cast<std::size_t>(attributes_stride(data.attributes));
+    const auto vertex_count = data.vertex_count();
+
+    if(vertex_count == 0)
+        return 0;
+
+    std::size_t key_size = 0;
+    const auto  keys     = weld_keys(data, epsilon, key_size);
+
+    auto hash = [&](std::size_t v)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for(std::size_t i = 0; i < key_size; i++)
+        {
+            h ^= static_cast<std::uint64_t>(keys[v * key_size + i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    };
+
+    auto equal = [&](std::size_t a, std::size_t b)
+    {
+        return std::equal(keys.begin() + a * key_size,
+                          keys.begin() + (a + 1) * key_size,
+                          keys.begin() + b * key_size);
+    };
+
+    // Open addressing table of the first vertex of every distinct key
+    const auto            table_size = std::bit_ceil(vertex_count * 2);
+    std::vector<unsigned> table(table_size, no_index);
+
+    std::vector<unsigned> remap(vertex_count);
+    unsigned              next = 0;
+
+    std::vector<std::byte> vertices;
+    vertices.reserve(data.vertices.size());
+
+    for(std::size_t v = 0; v < vertex_count; v++)
+    {
+        auto slot = hash(v) & (table_size - 1);
+
+        while(table[slot] != no_index && !equal(table[slot], v))
+            slot = (slot + 1) & (table_size - 1);
+
+        if(table[slot] == no_index)
+        {
+            table[slot] = static_cast<unsigned>(v);
+            remap[v]    = next++;
+            vertices.insert(vertices.end(),
+                            data.vertices.begin() + v * stride,
+                            data.vertices.begin() + (v + 1) * stride);
+        }
+        else
+        {
+            remap[v] = remap[table[slot]];
+        }
+    }
+
+    for(auto& index : data.indexes)
+        index = remap[index];
+
+    if(data.primitive == primitive_type::triangles)
+    {
+        std::size_t kept = 0;
+
+        for(std::size_t i = 0; i + 2 < data.indexes.size(); i += 3)
+        {
+            const auto a = data.indexes[i];
+            const auto b = data.indexes[i + 1];
+            const auto c = data.indexes[i + 2];
+
+            if(a == b || b == c || a == c)
+                continue;
+
+            data.indexes[kept++] = a;
+            data.indexes[kept++] = b;
+            data.indexes[kept++] = c;
+        }
+        data.indexes.resize(kept);
+    }
+
+    data.vertices = std::move(vertices);
+    return next;
+}
+
+/**
+ * @brief Symmetric 4x4 matrix summing the squared distances to planes, with
+ * the total weight of the planes
+ */
+struct quadric
+{
+    std::array<double, 10> a {};
+    double                 weight {0.0};
+
+    void add_plane(const std::array<double, 3>& n, double d, double w)
+    {
+        const std::array<double, 4> p {n[0], n[1], n[2], d};
+
+        std::size_t k = 0;
+        for(unsigned i = 0; i < 4; i++)
+            for(unsigned j = i; j < 4; j++)
+                a[k++] += w * p[i] * p[j];
+
+        weight += w;
+    }
+
+    quadric& operator+=(const quadric& other)
+    {
+        for(std::size_t k = 0; k < a.size(); k++)
+            a[k] += other.a[k];
+        weight += other.weight;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the weighted mean of the squared distances between the
+     * point and the planes
+     */
+    double error(const std::array<double, 3>& point) const
+    {
+        if(weight <= 0.0)
+            return 0.0;
+
+        const std::array<double, 4> p {point[0], point[1], point[2], 1.0};
+
+        double      sum = 0.0;
+        std::size_t k   = 0;
+        for(unsigned i = 0; i < 4; i++)
+            for(unsigned j = i; j < 4; j++)
+                sum += (i == j ? 1.0 : 2.0) * a[k++] * p[i] * p[j];
+
+        return std::max(sum, 0.0) / weight;
+    }
+};
+
+using vec3 = std::array<double, 3>;
+
+static vec3 sub(const vec3& a, const vec3& b)
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+static vec3 cross(const vec3& a, const vec3& b)
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+}
+
+static double dot(const vec3& a, const vec3& b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static double length(const vec3& a)
+{
+    return std::sqrt(dot(a, a));
+}
+
+static std::uint64_t edge_key(unsigned a, unsigned b)
+{
+    return (std::uint64_t(a) << 32) | b;
+}
+
+// Border planes weigh more than the triangles, so silhouettes are kept
+static constexpr double border_weight = 10.0;
+
+std::vector<unsigned> simplify(std::span<const unsigned> indexes,
+                               std::span<const float>    positions,
+                               std::size_t               target_index_count,
+                               float                     target_error,
+                               float*                    result_error)
+{
+    const auto vertex_count = positions.size() / 3;
+
+    std::vector<unsigned> current(indexes.begin(),
+                                  indexes.begin() + indexes.size() / 3 * 3);
+
+    // Positions are scaled so the largest extent is 1, errors are then
+    // relative to the mesh's size
+    vec3 low {std::numeric_limits<double>::max(),
+              std::numeric_limits<double>::max(),
+              std::numeric_limits<double>::max()};
+    vec3 high {std::numeric_limits<double>::lowest(),
+               std::numeric_limits<double>::lowest(),
+               std::numeric_limits<double>::lowest()};
+
+    for(auto index : current)
+        for(unsigned k = 0; k < 3; k++)
+        {
+            low[k]  = std::min(low[k], double(positions[index * 3 + k]));
+            high[k] = std::max(high[k], double(positions[index * 3 + k]));
+        }
+
+    double extent = 0.0;
+    for(unsigned k = 0; k < 3; k++)
+        extent = std::max(extent, high[k] - low[k]);
+
+    const double scale = extent > 0.0 ? 1.0 / extent : 1.0;
+
+    std::vector<vec3> points(vertex_count);
+    for(std::size_t v = 0; v < vertex_count; v++)
+        for(unsigned k = 0; k < 3; k++)
+            points[v][k] =
+                (double(positions[v * 3 + k]) - (extent > 0.0 ? low[k] : 0.0)) *
+                scale;
+
+    // An edge is on the border if no triangle uses it in the other direction
+    std::unordered_set<std::uint64_t> edges;
+    for(std::size_t i = 0; i < current.size(); i += 3)
+        for(unsigned k = 0; k < 3; k++)
+            edges.insert(edge_key(current[i + k], current[i + (k + 1) % 3]));
+
+    auto is_border_edge = [&](unsigned a, unsigned b)
+    {
+        return edges.count(edge_key(a, b)) == 0 ||
+               edges.count(edge_key(b, a)) == 0;
+    };
+
+    std::vector<bool>    border(vertex_count, false);
+    std::vector<quadric> quadrics(vertex_count);
+
+    for(std::size_t i = 0; i < current.size(); i += 3)
+    {
+        const std::array<unsigned, 3> t {current[i], current[i + 1],
+                                         current[i + 2]};
+
+        auto       normal = cross(sub(points[t[1]], points[t[0]]),
+                                  sub(points[t[2]], points[t[0]]));
+        const auto area2  = length(normal);
+
+        if(area2 <= 0.0)
+            continue;
+
+        for(auto& n : normal)
+            n /= area2;
+
+        for(auto v : t)
+            quadrics[v].add_plane(normal, -dot(normal, points[t[0]]),
+                                  area2 * 0.5);
+
+        for(unsigned k = 0; k < 3; k++)
+        {
+            const auto a = t[k];
+            const auto b = t[(k + 1) % 3];
+
+            if(edges.count(edge_key(b, a)) != 0)
+                continue;
+
+            border[a] = true;
+            border[b] = true;
+
+            // Plane going through the edge, perpendicular to the triangle
+            const auto edge        = sub(points[b], points[a]);
+            auto       edge_normal = cross(edge, normal);
+            const auto edge_length = length(edge_normal);
+
+            if(edge_length <= 0.0)
+                continue;
+
+            for(auto& n : edge_normal)
+                n /= edge_length;
+
+            const double d = -dot(edge_normal, points[a]);
+            const double w = length(edge) * border_weight;
+
+            quadrics[a].add_plane(edge_normal, d, w);
+            quadrics[b].add_plane(edge_normal, d, w);
+        }
+    }
+
+    struct collapse
+    {
+        unsigned from;
+        unsigned to;
+        double   cost;
+    };
+
+    const double target_error_sq = double(target_error) * target_error;
+    double       max_error_sq    = 0.0;
+
+    std::vector<collapse>              collapses;
+    std::vector<unsigned>              target(vertex_count);
+    std::vector<bool>                  locked(vertex_count);
+    std::vector<unsigned>              triangle_offsets(vertex_count + 1);
+    std::vector<unsigned>              triangles;
+
+    while(current.size() > target_index_count)
+    {
+        // Collapses create new edges, so borders are looked up again
+        edges.clear();
+        for(std::size_t i = 0; i < current.size(); i += 3)
+            for(unsigned k = 0; k < 3; k++)
+                edges.insert(edge_key(current[i + k], current[i + (k + 1) % 3]));
+
+        // Triangles around each vertex, to check for flips
+        std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+        for(auto index : current)
+            triangle_offsets[index + 1]++;
+        for(std::size_t v = 0; v < vertex_count; v++)
+            triangle_offsets[v + 1] += triangle_offsets[v];
+
+        triangles.resize(current.size());
+        {
+            std::vector<unsigned> fill(triangle_offsets.begin(),
+                                       triangle_offsets.end() - 1);
+            for(std::size_t i = 0; i < current.size(); i++)
+                triangles[fill[current[i]]++] = static_cast<unsigned>(i / 3);
+        }
+
+        collapses.clear();
+
+        for(std::size_t i = 0; i < current.size(); i += 3)
+        {
+            for(unsigned k = 0; k < 3; k++)
+            {
+                const auto a = current[i + k];
+                const auto b = current[i + (k + 1) % 3];
+
+                for(auto [from, to] : {std::pair {a, b}, std::pair {b, a}})
+                {
+                    // Border vertices can only slide along the border
+                    if(border[from] && !is_border_edge(from, to))
+                        continue;
+
+                    quadric q = quadrics[from];
+                    q += quadrics[to];
+                    collapses.push_back({from, to, q.error(points[to])});
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const collapse& a, const collapse& b)
+                  { return a.cost < b.cost; });
+
+        std::iota(target.begin(), target.end(), 0u);
+        std::fill(locked.begin(), locked.end(), false);
+
+        auto triangle_count = current.size() / 3;
+        bool collapsed      = false;
+
+        for(const auto& c : collapses)
+        {
+            if(c.cost > target_error_sq ||
+               triangle_count * 3 <= target_index_count)
+                break;
+
+            if(locked[c.from] || locked[c.to])
+                continue;
+
+            // Moving the vertex must not flip the triangles around it
+            bool        flips   = false;
+            std::size_t removed = 0;
+
+            for(auto t = triangle_offsets[c.from];
+                t < triangle_offsets[c.from + 1]; t++)
+            {
+                const auto* tri = &current[triangles[t] * 3];
+
+                if(tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                std::array<vec3, 3> before;
+                std::array<vec3, 3> after;
+                for(unsigned k = 0; k < 3; k++)
+                {
+                    before[k] = points[tri[k]];
+                    after[k]  = tri[k] == c.from ? points[c.to] : before[k];
+                }
+
+                const auto n0 = cross(sub(before[1], before[0]),
+                                      sub(before[2], before[0]));
+                const auto n1 =
+                    cross(sub(after[1], after[0]), sub(after[2], after[0]));
+
+                if(dot(n0, n1) <= 0.0)
+                {
+                    flips = true;
+                    break;
+                }
+            }
+
+            if(flips)
+                continue;
+
+            target[c.from] = c.to;
+            quadrics[c.to] += quadrics[c.from];
+            max_error_sq = std::max(max_error_sq, c.cost);
+            triangle_count -= removed;
+            collapsed = true;
+
+            // The triangles around both vertices changed, their other
+            // collapses must wait for the next pass
+            for(auto v : {c.from, c.to})
+                for(auto t = triangle_offsets[v]; t < triangle_offsets[v + 1];
+                    t++)
+                    for(unsigned k = 0; k < 3; k++)
+                        locked[current[triangles[t] * 3 + k]] = true;
+        }
+
+        if(!collapsed)
+            break;
+
+        std::size_t kept = 0;
+
+        for(std::size_t i = 0; i < current.size(); i += 3)
+        {
+            const auto a = target[current[i]];
+            const auto b = target[current[i + 1]];
+            const auto c = target[current[i + 2]];
+
+            if(a == b || b == c || a == c)
+                continue;
+
+            current[kept++] = a;
+            current[kept++] = b;
+            current[kept++] = c;
+        }
+        current.resize(kept);
+    }
+
+    if(result_error != nullptr)
+        *result_error = static_cast<float>(std::sqrt(max_error_sq));
+
+    return current;
+}
+
+std::vector<float> vertex_positions(const mesh_data& data)
+{
+    const auto* position = find_position_attribute(data.attributes);
+
+    if(position == nullptr)
+        throw std::invalid_argument(
+            "mesh_optimizer::vertex_positions : No float position at location "
+            "0");
+
+    const auto stride       = attributes_stride(data.attributes);
+    const auto vertex_count = data.vertex_count();
+    const auto components   = std::min(position->size, 3);
+
+    std::vector<float> positions(vertex_count * 3, 0.0F);
+
+    for(std::size_t v = 0; v < vertex_count; v++)
+        std::memcpy(&positions[v * 3],
+                    data.vertices.data() + v * stride + position->offset,
+                    components * sizeof(float));
+
+    return positions;
+}
+
+void optimize(mesh_data& data, float overdraw_threshold)
+{
+    const auto stride = static_cast<std::size_t>(attributes_stride(data.attributes));
+
+    if(data.primitive == primitive_type::triangles)
+    {
+        optimize_vertex_cache(data.indexes, data.vertex_count());
+
+        if(find_position_attribute(data.attributes) != nullptr)
+            optimize_overdraw(data.indexes, vertex_positions(data),
+                              overdraw_threshold);
+    }
+
+    optimize_vertex_fetch(data.vertices, data.indexes, stride);
+}
+
+}    // namespace corgi::mesh_optimizer
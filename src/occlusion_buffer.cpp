@@ -0,0 +1,340 @@
+#include <corgi/opengl/occlusion_buffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "simd.h"
+
+namespace corgi
+{
+
+// Vertices closer to the camera plane than this can't be projected
+static constexpr float min_w = 1e-5F;
+
+occlusion_buffer::occlusion_buffer(int width, int height)
+    : width_(width)
+    , height_(height)
+    , tiles_x_(width / tile_size)
+    , tiles_y_(height / tile_size)
+{
+    if(width <= 0 || height <= 0 || width % tile_size != 0 ||
+       height % tile_size != 0)
+        throw std::invalid_argument(
+            "occlusion_buffer::occlusion_buffer : Size must be a positive "
+            "multiple of 8");
+
+    depth_.resize(static_cast<std::size_t>(width_) * height_);
+    tiles_.resize(static_cast<std::size_t>(tiles_x_) * tiles_y_);
+    clear();
+}
+
+void occlusion_buffer::clear()
+{
+    std::ranges::fill(depth_, 1.0F);
+    std::ranges::fill(tiles_, 1.0F);
+}
+
+void occlusion_buffer::setup(const occluder& o)
+{
+    const auto vertex_count = o.positions.size() / 3;
+    const auto& m           = o.model_view_projection;
+
+    // x, y, depth and w of each vertex, in pixels
+    screen_.resize(vertex_count * 4);
+
+    for(std::size_t v = 0; v < vertex_count; v++)
+    {
+        const float* p = o.positions.data() + v * 3;
+        float*       s = screen_.data() + v * 4;
+
+#ifdef CORGI_OPENGL_SSE
+        // One column of the matrix per coordinate, the 4 rows at once
+        __m128 clip = _mm_mul_ps(_mm_loadu_ps(&m[0]), _mm_set1_ps(p[0]));
+        clip = _mm_add_ps(clip, _mm_mul_ps(_mm_loadu_ps(&m[4]), _mm_set1_ps(p[1])));
+        clip = _mm_add_ps(clip, _mm_mul_ps(_mm_loadu_ps(&m[8]), _mm_set1_ps(p[2])));
+        clip = _mm_add_ps(clip, _mm_loadu_ps(&m[12]));
+        _mm_storeu_ps(s, clip);
+#else
+        for(int row = 0; row < 4; row++)
+            s[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] +
+                     m[12 + row];
+#endif
+
+        const float w = s[3];
+        if(w < min_w)
+            continue;
+
+        s[0] = (s[0] / w * 0.5F + 0.5F) * static_cast<float>(width_);
+        s[1] = (s[1] / w * 0.5F + 0.5F) * static_cast<float>(height_);
+        s[2] = s[2] / w * 0.5F + 0.5F;
+    }
+
+    for(std::size_t i = 0; i + 2 < o.indexes.size(); i += 3)
+    {
+        if(o.indexes[i] >= vertex_count || o.indexes[i + 1] >= vertex_count ||
+           o.indexes[i + 2] >= vertex_count)
+            throw std::out_of_range(
+                "occlusion_buffer::render : Index out of range");
+
+        const float* v0 = screen_.data() + o.indexes[i] * 4;
+        const float* v1 = screen_.data() + o.indexes[i + 1] * 4;
+        const float* v2 = screen_.data() + o.indexes[i + 2] * 4;
+
+        // Skipping a triangle only makes the buffer hide less
+        if(v0[3] < min_w || v1[3] < min_w || v2[3] < min_w)
+            continue;
+
+        if(std::min({v0[2], v1[2], v2[2]}) < 0.0F)
+            continue;
+
+        const float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) -
+                           (v2[0] - v0[0]) * (v1[1] - v0[1]);
+
+        // Facing away, or seen from the side
+        if(!(area > 0.0F))
+            continue;
+
+        triangle t;
+
+        auto lowest = [&](int axis) {
+            return static_cast<int>(
+                std::floor(std::min({v0[axis], v1[axis], v2[axis]})));
+        };
+        auto highest = [&](int axis) {
+            return static_cast<int>(
+                std::ceil(std::max({v0[axis], v1[axis], v2[axis]})));
+        };
+
+        t.min_x = std::max(0, lowest(0));
+        t.max_x = std::min(width_, highest(0));
+        t.min_y = std::max(0, lowest(1));
+        t.max_y = std::min(height_, highest(1));
+
+        if(t.min_x >= t.max_x || t.min_y >= t.max_y)
+            continue;
+
+        // Rows are processed 4 pixels at a time, from an aligned column
+        t.min_x &= ~3;
+
+        // Edge i is positive on the inner side of the edge from vertex i to
+        // vertex i + 1
+        const float* corners[3] {v0, v1, v2};
+
+        for(int e = 0; e < 3; e++)
+        {
+            const float* a = corners[e];
+            const float* b = corners[(e + 1) % 3];
+
+            t.edge_a[e] = a[1] - b[1];
+            t.edge_b[e] = b[0] - a[0];
+            t.edge_c[e] = -(t.edge_a[e] * a[0] + t.edge_b[e] * a[1]);
+        }
+
+        t.depth_a = ((v1[2] - v0[2]) * (v2[1] - v0[1]) -
+                     (v2[2] - v0[2]) * (v1[1] - v0[1])) /
+                    area;
+        t.depth_b = ((v1[0] - v0[0]) * (v2[2] - v0[2]) -
+                     (v2[0] - v0[0]) * (v1[2] - v0[2])) /
+                    area;
+        t.depth_c = v0[2] - t.depth_a * v0[0] - t.depth_b * v0[1];
+
+        triangles_.push_back(t);
+    }
+}
+
+void occlusion_buffer::rasterize(const triangle& t, int first_row, int end_row)
+{
+    first_row = std::max(first_row, t.min_y);
+    end_row   = std::min(end_row, t.max_y);
+
+#ifdef CORGI_OPENGL_SSE
+    const __m128 lanes = _mm_setr_ps(0.5F, 1.5F, 2.5F, 3.5F);
+    const __m128 zero  = _mm_setzero_ps();
+
+    const __m128 a0 = _mm_set1_ps(t.edge_a[0]);
+    const __m128 a1 = _mm_set1_ps(t.edge_a[1]);
+    const __m128 a2 = _mm_set1_ps(t.edge_a[2]);
+    const __m128 da = _mm_set1_ps(t.depth_a);
+
+    for(int y = first_row; y < end_row; y++)
+    {
+        const float center_y = static_cast<float>(y) + 0.5F;
+
+        // Parts of the planes that only change with the row
+        const __m128 r0 = _mm_set1_ps(t.edge_b[0] * center_y + t.edge_c[0]);
+        const __m128 r1 = _mm_set1_ps(t.edge_b[1] * center_y + t.edge_c[1]);
+        const __m128 r2 = _mm_set1_ps(t.edge_b[2] * center_y + t.edge_c[2]);
+        const __m128 rd = _mm_set1_ps(t.depth_b * center_y + t.depth_c);
+
+        float* row = depth_.data() + static_cast<std::size_t>(y) * width_;
+
+        for(int x = t.min_x; x < t.max_x; x += 4)
+        {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+
+            __m128 inside =
+                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), r0), zero);
+            inside = _mm_and_ps(
+                inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), r1), zero));
+            inside = _mm_and_ps(
+                inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+
+            if(_mm_movemask_ps(inside) == 0)
+                continue;
+
+            const __m128 old   = _mm_loadu_ps(row + x);
+            const __m128 depth = _mm_min_ps(
+                old, _mm_add_ps(_mm_mul_ps(da, px), rd));
+
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, depth),
+                                             _mm_andnot_ps(inside, old)));
+        }
+    }
+#else
+    for(int y = first_row; y < end_row; y++)
+    {
+        const float center_y = static_cast<float>(y) + 0.5F;
+        float*      row = depth_.data() + static_cast<std::size_t>(y) * width_;
+
+        for(int x = t.min_x; x < t.max_x; x++)
+        {
+            const float center_x = static_cast<float>(x) + 0.5F;
+
+            bool inside = true;
+            for(int e = 0; e < 3; e++)
+                inside = inside && t.edge_a[e] * center_x +
+                                           t.edge_b[e] * center_y +
+                                           t.edge_c[e] >=
+                                       0.0F;
+
+            if(inside)
+                row[x] = std::min(row[x], t.depth_a * center_x +
+                                              t.depth_b * center_y + t.depth_c);
+        }
+    }
+#endif
+}
+
+void occlusion_buffer::update_tiles(int first_tile_row, int end_tile_row)
+{
+    for(int ty = first_tile_row; ty < end_tile_row; ty++)
+        for(int tx = 0; tx < tiles_x_; tx++)
+        {
+            float farthest = 0.0F;
+
+            for(int y = ty * tile_size; y < (ty + 1) * tile_size; y++)
+            {
+                const float* row = depth_.data() +
+                                   static_cast<std::size_t>(y) * width_ +
+                                   tx * tile_size;
+                farthest =
+                    std::max(farthest, *std::max_element(row, row + tile_size));
+            }
+
+            tiles_[static_cast<std::size_t>(ty) * tiles_x_ + tx] = farthest;
+        }
+}
+
+void occlusion_buffer::render(std::span<const occluder> occluders,
+                              thread_pool*              pool)
+{
+    triangles_.clear();
+
+    for(const auto& o : occluders)
+        setup(o);
+
+    // Each band owns whole rows of tiles, so threads never write to the same
+    // pixels
+    auto band = [this](std::size_t first_tile_row, std::size_t end_tile_row,
+                       std::size_t)
+    {
+        const auto first = static_cast<int>(first_tile_row);
+        const auto end   = static_cast<int>(end_tile_row);
+
+        for(const auto& t : triangles_)
+            rasterize(t, first * tile_size, end * tile_size);
+
+        update_tiles(first, end);
+    };
+
+    if(pool == nullptr)
+        band(0, static_cast<std::size_t>(tiles_y_), 0);
+    else
+        pool->parallel_for(static_cast<std::size_t>(tiles_y_), 2, band);
+}
+
+bool occlusion_buffer::visible(const aabb& box, const matrix4& m) const
+{
+    if(box.empty())
+        return false;
+
+    float min_x     = static_cast<float>(width_);
+    float max_x     = 0.0F;
+    float min_y     = static_cast<float>(height_);
+    float max_y     = 0.0F;
+    float min_depth = 1.0F;
+
+    for(int i = 0; i < 8; i++)
+    {
+        const std::array<float, 3> corner {i & 1 ? box.max[0] : box.min[0],
+                                           i & 2 ? box.max[1] : box.min[1],
+                                           i & 4 ? box.max[2] : box.min[2]};
+
+        const auto  p = transform_point(m, corner);
+        const float w = m[3] * corner[0] + m[7] * corner[1] + m[11] * corner[2] +
+                        m[15];
+
+        // Can't be projected, assume it's seen
+        if(w < min_w)
+            return true;
+
+        const float x = (p[0] / w * 0.5F + 0.5F) * static_cast<float>(width_);
+        const float y = (p[1] / w * 0.5F + 0.5F) * static_cast<float>(height_);
+
+        min_x     = std::min(min_x, x);
+        max_x     = std::max(max_x, x);
+        min_y     = std::min(min_y, y);
+        max_y     = std::max(max_y, y);
+        min_depth = std::min(min_depth, p[2] / w * 0.5F + 0.5F);
+    }
+
+    if(min_depth <= 0.0F)
+        return true;
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    const int x1 = std::min(width_, static_cast<int>(std::ceil(max_x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    const int y1 = std::min(height_, static_cast<int>(std::ceil(max_y)));
+
+    // Nothing on screen
+    if(x0 >= x1 || y0 >= y1)
+        return false;
+
+    for(int ty = y0 / tile_size; ty <= (y1 - 1) / tile_size; ty++)
+        for(int tx = x0 / tile_size; tx <= (x1 - 1) / tile_size; tx++)
+        {
+            // Every pixel of the tile is nearer than the box
+            if(tiles_[static_cast<std::size_t>(ty) * tiles_x_ + tx] < min_depth)
+                continue;
+
+            const int px0 = std::max(x0, tx * tile_size);
+            const int px1 = std::min(x1, (tx + 1) * tile_size);
+            const int py0 = std::max(y0, ty * tile_size);
+            const int py1 = std::min(y1, (ty + 1) * tile_size);
+
+            for(int y = py0; y < py1; y++)
+            {
+                const float* row =
+                    depth_.data() + static_cast<std::size_t>(y) * width_;
+
+                if(std::any_of(row + px0, row + px1,
+                               [&](float d) { return d >= min_depth; }))
+                    return true;
+            }
+        }
+
+    return false;
+}
+
+}    // namespace corgi
@@ -0,0 +1,263 @@
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/occlusion_queries.h>
+#include <corgi/opengl/primitives.h>
+#include <corgi/opengl/shaders.h>
+#include <glad/glad.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+static GLenum to_gl(index_type type)
+{
+    switch(type)
+    {
+        case index_type::uint8:
+            return GL_UNSIGNED_BYTE;
+        case index_type::uint16:
+            return GL_UNSIGNED_SHORT;
+        case index_type::uint32:
+            return GL_UNSIGNED_INT;
+    }
+    return GL_UNSIGNED_INT;
+}
+
+/**
+ * @brief Returns true if part of the box is behind the near plane, where
+ * its proxy would be clipped
+ */
+static bool crosses_near_plane(const aabb& box, const matrix4& m)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        const float x = i & 1 ? box.max[0] : box.min[0];
+        const float y = i & 2 ? box.max[1] : box.min[1];
+        const float z = i & 4 ? box.max[2] : box.min[2];
+
+        const float clip_z = m[2] * x + m[6] * y + m[10] * z + m[14];
+        const float clip_w = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+        if(clip_w <= 0.0F || clip_z < -clip_w)
+            return true;
+    }
+    return false;
+}
+
+occlusion_queries::occlusion_queries(unsigned hysteresis)
+    : box_(primitive::build_box_pos3(
+          {{-1.0F, -1.0F, -1.0F}, {1.0F, 1.0F, 1.0F}}))
+{
+    if(hysteresis == 0 || hysteresis > 32)
+        throw std::invalid_argument(
+            "occlusion_queries::occlusion_queries : hysteresis must be "
+            "between 1 and 32");
+
+    hysteresis_mask_ =
+        hysteresis == 32 ? 0xFFFFFFFFu : (1u << hysteresis) - 1u;
+
+    vertex_shader_ =
+        std::make_unique<shader>(common_shaders::occlusion_proxy_vertex_shader);
+    fragment_shader_ = std::make_unique<shader>(
+        common_shaders::occlusion_proxy_fragment_shader);
+    proxy_program_ = std::make_unique<program>(*vertex_shader_, *fragment_shader_);
+
+    // Back faces are drawn too, the box is visible if any of it is
+    proxy_state_ = pipeline_state_registry::instance().intern(
+        pipeline_state()
+            .with_depth({true, false, compare_function::less_equal})
+            .with_color_mask(0));
+}
+
+occlusion_queries::~occlusion_queries()
+{
+    auto& queue = deletion_queue::instance();
+
+    for(const auto& o : objects_)
+        for(auto query : o.queries)
+            queue.retire(gl_object::query, query);
+}
+
+std::uint32_t occlusion_queries::add()
+{
+    object_state o;
+    glGenQueries(2, o.queries.data());
+
+    objects_.push_back(o);
+    return static_cast<std::uint32_t>(objects_.size() - 1);
+}
+
+void occlusion_queries::record(object_state& o, std::size_t slot, bool wait)
+{
+    if(o.issued[slot] == 0)
+        return;
+
+    bool seen = true;
+
+    if(!o.forced[slot])
+    {
+        GLuint available = 0;
+        glGetQueryObjectuiv(o.queries[slot], GL_QUERY_RESULT_AVAILABLE,
+                            &available);
+
+        if(available == 0)
+        {
+            if(!wait)
+                return;
+            stalls_++;
+        }
+
+        GLuint result = 0;
+        glGetQueryObjectuiv(o.queries[slot], GL_QUERY_RESULT, &result);
+        seen = result != 0;
+    }
+
+    o.history      = (o.history << 1) | (seen ? 1u : 0u);
+    o.issued[slot] = 0;
+    o.forced[slot] = false;
+}
+
+void occlusion_queries::begin_frame()
+{
+    if(drawing_proxies_)
+        throw std::logic_error(
+            "occlusion_queries::begin_frame : Call end_proxies first");
+
+    frame_++;
+
+    const std::size_t current  = frame_ % 2;
+    const std::size_t previous = 1 - current;
+
+    for(auto& o : objects_)
+    {
+        // Issued 2 frames ago, its query is about to be used again : the
+        // result can't be left for later anymore
+        record(o, current, true);
+
+        // Issued last frame, taken only if the GPU is done with it
+        record(o, previous, false);
+    }
+}
+
+void occlusion_queries::begin_proxies(vertex_array_cache& vertex_arrays,
+                                      const matrix4&      view_projection,
+                                      pipeline_state_id   current_state,
+                                      program*            current_program)
+{
+    if(frame_ == 0)
+        throw std::logic_error(
+            "occlusion_queries::begin_proxies : Call begin_frame first");
+
+    if(drawing_proxies_)
+        throw std::logic_error(
+            "occlusion_queries::begin_proxies : Already drawing proxies");
+
+    pipeline_state_registry::instance().apply(current_state, proxy_state_);
+
+    drawing_proxies_  = true;
+    view_projection_  = view_projection;
+    previous_state_   = current_state;
+    previous_program_ = current_program;
+
+    proxy_program_->use();
+    glUniformMatrix4fv(0, 1, GL_FALSE, view_projection.data());
+
+    vertex_arrays.bind(box_.layout(), box_.vertex_buffer()->id(),
+                       box_.index_buffer()->id());
+}
+
+void occlusion_queries::test(std::uint32_t object, const aabb& bounds)
+{
+    if(!drawing_proxies_)
+        throw std::logic_error(
+            "occlusion_queries::test : Call begin_proxies first");
+
+    if(object >= objects_.size())
+        throw std::out_of_range("occlusion_queries::test : Unknown object");
+
+    // An empty box has nothing to be seen
+    if(bounds.empty())
+        return;
+
+    auto&             o    = objects_[object];
+    const std::size_t slot = frame_ % 2;
+
+    o.issued[slot] = frame_;
+    o.forced[slot] = crosses_near_plane(bounds, view_projection_);
+
+    if(o.forced[slot])
+        return;
+
+    const auto center = bounds.center();
+    const auto extent = bounds.extent();
+
+    glUniform3f(1, center[0], center[1], center[2]);
+    glUniform3f(2, extent[0], extent[1], extent[2]);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, o.queries[slot]);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(box_.index_count()),
+                   to_gl(box_.index_type()), nullptr);
+    glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+}
+
+void occlusion_queries::end_proxies()
+{
+    if(!drawing_proxies_)
+        return;
+
+    drawing_proxies_ = false;
+
+    pipeline_state_registry::instance().apply(proxy_state_, previous_state_);
+
+    if(previous_program_ != nullptr)
+        previous_program_->use();
+    else
+        glUseProgram(0);
+}
+
+bool occlusion_queries::visible(std::uint32_t object) const
+{
+    return (history(object) & hysteresis_mask_) != 0;
+}
+
+std::uint32_t occlusion_queries::history(std::uint32_t object) const
+{
+    if(object >= objects_.size())
+        throw std::out_of_range("occlusion_queries::history : Unknown object");
+
+    return objects_[object].history;
+}
+
+void occlusion_queries::begin_conditional_render(std::uint32_t object)
+{
+    if(object >= objects_.size())
+        throw std::out_of_range(
+            "occlusion_queries::begin_conditional_render : Unknown object");
+
+    if(conditional_)
+        throw std::logic_error(
+            "occlusion_queries::begin_conditional_render : Already rendering "
+            "conditionally");
+
+    const auto&       o    = objects_[object];
+    const std::size_t slot = frame_ % 2;
+
+    if(o.issued[slot] != frame_ || o.forced[slot])
+        return;
+
+    // Without waiting : if the result isn't there when the GPU reaches the
+    // draws, they happen
+    glBeginConditionalRender(o.queries[slot], GL_QUERY_NO_WAIT);
+    conditional_ = true;
+}
+
+void occlusion_queries::end_conditional_render()
+{
+    if(!conditional_)
+        return;
+
+    glEndConditionalRender();
+    conditional_ = false;
+}
+
+}    // namespace corgi
@@ -3,4 +3,32 @@
 namespace corgi
 {
 
+void pipeline::set_state(const pipeline_state& state)
+{
+    state_ = pipeline_state_registry::instance().intern(state);
+}
+
+void pipeline::set_state(pipeline_state_id id) noexcept
+{
+    state_ = id;
+}
+
+pipeline_state_id pipeline::state() const noexcept
+{
+    return state_;
+}
+
+const pipeline_state& pipeline::state_description() const
+{
+    return pipeline_state_registry::instance().get(state_);
+}
+
+pipeline_state_id pipeline::default_state()
+{
+    static const pipeline_state_id id =
+        pipeline_state_registry::instance().intern(
+            pipeline_state().with_depth({true, false, compare_function::less}));
+    return id;
+}
+
 }    // namespace corgi
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include <corgi/opengl/pipeline_state.h>
+#include <glad/glad.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+static GLenum to_gl(compare_function function)
+{
+    switch(function)
+    {
+        case compare_function::never:
+            return GL_NEVER;
+        case compare_function::less:
+            return GL_LESS;
+        case compare_function::equal:
+            return GL_EQUAL;
+        case compare_function::less_equal:
+            return GL_LEQUAL;
+        case compare_function::greater:
+            return GL_GREATER;
+        case compare_function::not_equal:
+            return GL_NOTEQUAL;
+        case compare_function::greater_equal:
+            return GL_GEQUAL;
+        case compare_function::always:
+            return GL_ALWAYS;
+    }
+    return GL_LESS;
+}
+
+static GLenum to_gl(blend_factor factor)
+{
+    switch(factor)
+    {
+        case blend_factor::zero:
+            return GL_ZERO;
+        case blend_factor::one:
+            return GL_ONE;
+        case blend_factor::src_color:
+            return GL_SRC_COLOR;
+        case blend_factor::one_minus_src_color:
+            return GL_ONE_MINUS_SRC_COLOR;
+        case blend_factor::dst_color:
+            return GL_DST_COLOR;
+        case blend_factor::one_minus_dst_color:
+            return GL_ONE_MINUS_DST_COLOR;
+        case blend_factor::src_alpha:
+            return GL_SRC_ALPHA;
+        case blend_factor::one_minus_src_alpha:
+            return GL_ONE_MINUS_SRC_ALPHA;
+        case blend_factor::dst_alpha:
+            return GL_DST_ALPHA;
+        case blend_factor::one_minus_dst_alpha:
+            return GL_ONE_MINUS_DST_ALPHA;
+    }
+    return GL_ONE;
+}
+
+static GLenum to_gl(blend_equation equation)
+{
+    switch(equation)
+    {
+        case blend_equation::add:
+            return GL_FUNC_ADD;
+        case blend_equation::subtract:
+            return GL_FUNC_SUBTRACT;
+        case blend_equation::reverse_subtract:
+            return GL_FUNC_REVERSE_SUBTRACT;
+        case blend_equation::min:
+            return GL_MIN;
+        case blend_equation::max:
+            return GL_MAX;
+    }
+    return GL_FUNC_ADD;
+}
+
+static GLenum to_gl(polygon_mode mode)
+{
+    switch(mode)
+    {
+        case polygon_mode::fill:
+            return GL_FILL;
+        case polygon_mode::line:
+            return GL_LINE;
+        case polygon_mode::point:
+            return GL_POINT;
+    }
+    return GL_FILL;
+}
+
+static void enable(GLenum capability, bool enabled)
+{
+    if(enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+static std::uint32_t bit(state_group group)
+{
+    return static_cast<std::uint32_t>(group);
+}
+
+// blend_state
+
+blend_state blend_state::alpha_blending() noexcept
+{
+    blend_state state;
+    state.enabled   = true;
+    state.src_color = blend_factor::src_alpha;
+    state.dst_color = blend_factor::one_minus_src_alpha;
+    state.src_alpha = blend_factor::one;
+    state.dst_alpha = blend_factor::one_minus_src_alpha;
+    return state;
+}
+
+// pipeline_state
+
+stencil pipeline_state::default_stencil() noexcept
+{
+    corgi::stencil s;
+    s.success_depth_success = stencil_operation::keep;
+    s.success_depth_fail    = stencil_operation::keep;
+    s.fail                  = stencil_operation::keep;
+    return s;
+}
+
+pipeline_state::pipeline_state()
+    : stencil_(default_stencil())
+{
+    hash_ = compute_hash();
+}
+
+pipeline_state::pipeline_state(raster_state   raster,
+                               depth_state    depth,
+                               corgi::stencil stencil,
+                               blend_state    blend,
+                               unsigned char  color_mask)
+    : raster_(raster)
+    , depth_(depth)
+    , stencil_(stencil)
+    , blend_(blend)
+    , color_mask_(color_mask & color_mask_all)
+{
+    hash_ = compute_hash();
+}
+
+const raster_state& pipeline_state::raster() const noexcept
+{
+    return raster_;
+}
+
+const depth_state& pipeline_state::depth() const noexcept
+{
+    return depth_;
+}
+
+const stencil& pipeline_state::stencil() const noexcept
+{
+    return stencil_;
+}
+
+const blend_state& pipeline_state::blend() const noexcept
+{
+    return blend_;
+}
+
+unsigned char pipeline_state::color_mask() const noexcept
+{
+    return color_mask_;
+}
+
+pipeline_state pipeline_state::with_raster(raster_state raster) const
+{
+    return {raster, depth_, stencil_, blend_, color_mask_};
+}
+
+pipeline_state pipeline_state::with_depth(depth_state depth) const
+{
+    return {raster_, depth, stencil_, blend_, color_mask_};
+}
+
+pipeline_state pipeline_state::with_stencil(corgi::stencil stencil) const
+{
+    return {raster_, depth_, stencil, blend_, color_mask_};
+}
+
+pipeline_state pipeline_state::with_blend(blend_state blend) const
+{
+    return {raster_, depth_, stencil_, blend, color_mask_};
+}
+
+pipeline_state pipeline_state::with_color_mask(unsigned char mask) const
+{
+    return {raster_, depth_, stencil_, blend_, mask};
+}
+
+std::size_t pipeline_state::hash() const noexcept
+{
+    return hash_;
+}
+
+std::size_t pipeline_state::compute_hash() const noexcept
+{
+    // FNV-1a over every field, fields are small so they are hashed one by
+    // one instead of hashing the padding of the structures
+    std::uint64_t h = 14695981039346656037ull;
+
+    auto add = [&h](std::uint64_t value)
+    {
+        h ^= value;
+        h *= 1099511628211ull;
+    };
+
+    add(static_cast<std::uint64_t>(raster_.cull));
+    add(static_cast<std::uint64_t>(raster_.front));
+    add(static_cast<std::uint64_t>(raster_.polygon));
+    add(raster_.scissor_test);
+
+    add(depth_.test);
+    add(depth_.write);
+    add(static_cast<std::uint64_t>(depth_.function));
+
+    add(stencil_.enable_stencil);
+    add(static_cast<std::uint64_t>(stencil_.test));
+    add(static_cast<std::uint64_t>(stencil_.success_depth_success));
+    add(static_cast<std::uint64_t>(stencil_.success_depth_fail));
+    add(static_cast<std::uint64_t>(stencil_.fail));
+    add(static_cast<std::uint32_t>(stencil_.stencil_value));
+    add(static_cast<std::uint32_t>(stencil_.stencil_mask_));
+
+    add(blend_.enabled);
+    add(static_cast<std::uint64_t>(blend_.src_color));
+    add(static_cast<std::uint64_t>(blend_.dst_color));
+    add(static_cast<std::uint64_t>(blend_.src_alpha));
+    add(static_cast<std::uint64_t>(blend_.dst_alpha));
+    add(static_cast<std::uint64_t>(blend_.color_equation));
+    add(static_cast<std::uint64_t>(blend_.alpha_equation));
+
+    add(color_mask_);
+
+    return static_cast<std::size_t>(h);
+}
+
+std::uint32_t
+pipeline_state::difference(const pipeline_state& other) const noexcept
+{
+    std::uint32_t groups = 0;
+
+    auto mark = [&groups](bool differs, state_group group)
+    {
+        if(differs)
+            groups |= bit(group);
+    };
+
+    mark(raster_.cull != other.raster_.cull, state_group::cull);
+    mark(raster_.front != other.raster_.front, state_group::front_face);
+    mark(raster_.polygon != other.raster_.polygon, state_group::polygon);
+    mark(raster_.scissor_test != other.raster_.scissor_test,
+         state_group::scissor);
+
+    mark(depth_.test != other.depth_.test, state_group::depth_test);
+    mark(depth_.write != other.depth_.write, state_group::depth_write);
+    mark(depth_.function != other.depth_.function,
+         state_group::depth_function);
+
+    mark(!(stencil_ == other.stencil_), state_group::stencil);
+
+    mark(blend_.enabled != other.blend_.enabled, state_group::blend_enable);
+    mark(blend_.src_color != other.blend_.src_color ||
+             blend_.dst_color != other.blend_.dst_color ||
+             blend_.src_alpha != other.blend_.src_alpha ||
+             blend_.dst_alpha != other.blend_.dst_alpha,
+         state_group::blend_function);
+    mark(blend_.color_equation != other.blend_.color_equation ||
+             blend_.alpha_equation != other.blend_.alpha_equation,
+         state_group::blend_equation);
+
+    mark(color_mask_ != other.color_mask_, state_group::color_mask);
+
+    return groups;
+}
+
+bool pipeline_state::operator==(const pipeline_state& other) const noexcept
+{
+    return hash_ == other.hash_ && difference(other) == 0;
+}
+
+// pipeline_state_registry
+
+pipeline_state_registry& pipeline_state_registry::instance()
+{
+    static pipeline_state_registry registry;
+    return registry;
+}
+
+pipeline_state_registry::pipeline_state_registry()
+{
+    states_.emplace_back();
+    ids_.emplace(states_.front(), 0);
+}
+
+pipeline_state_id pipeline_state_registry::intern(const pipeline_state& state)
+{
+    std::lock_guard lock(mutex_);
+
+    if(auto it = ids_.find(state); it != ids_.end())
+        return it->second;
+
+    if(states_.size() > 0xFFFF)
+        throw std::length_error(
+            "pipeline_state_registry::intern : Too many pipeline states");
+
+    const auto id = static_cast<pipeline_state_id>(states_.size());
+    states_.push_back(state);
+    ids_.emplace(state, id);
+    return id;
+}
+
+const pipeline_state& pipeline_state_registry::get(pipeline_state_id id) const
+{
+    std::lock_guard lock(mutex_);
+
+    if(id >= states_.size())
+        throw std::out_of_range(
+            "pipeline_state_registry::get : Unknown pipeline state id");
+
+    return states_[id];
+}
+
+std::uint32_t pipeline_state_registry::delta(pipeline_state_id from,
+                                             pipeline_state_id to)
+{
+    if(from == to)
+        return 0;
+
+    const std::uint32_t key = (std::uint32_t(from) << 16) | to;
+
+    std::lock_guard lock(mutex_);
+
+    if(auto it = deltas_.find(key); it != deltas_.end())
+        return it->second;
+
+    if(from >= states_.size() || to >= states_.size())
+        throw std::out_of_range(
+            "pipeline_state_registry::delta : Unknown pipeline state id");
+
+    const auto groups = states_[from].difference(states_[to]);
+    deltas_.emplace(key, groups);
+    return groups;
+}
+
+void pipeline_state_registry::apply(pipeline_state_id from,
+                                    pipeline_state_id to)
+{
+    const auto groups = delta(from, to);
+
+    if(groups == 0)
+        return;
+
+    apply(get(from), get(to), groups);
+}
+
+void pipeline_state_registry::apply_defaults()
+{
+    const auto& defaults = get(0);
+
+    // Comparing against a stencil that differs in every field forces
+    // stencil::apply to set everything
+    corgi::stencil forced;
+    forced.enable_stencil = !defaults.stencil().enable_stencil;
+    forced.test           = stencil_test::equal;
+    forced.stencil_value  = defaults.stencil().stencil_value + 1;
+    forced.stencil_mask_  = ~defaults.stencil().stencil_mask_;
+    forced.fail           = stencil_operation::replace;
+
+    apply(defaults.with_stencil(forced), defaults, state_group_all);
+}
+
+std::size_t pipeline_state_registry::size() const
+{
+    std::lock_guard lock(mutex_);
+    return states_.size();
+}
+
+void pipeline_state_registry::apply(const pipeline_state& from,
+                                    const pipeline_state& to,
+                                    std::uint32_t         groups) const
+{
+    const auto& raster = to.raster();
+    const auto& depth  = to.depth();
+    const auto& blend  = to.blend();
+
+    if(groups & bit(state_group::cull))
+    {
+        enable(GL_CULL_FACE, raster.cull != cull_mode::none);
+
+        if(raster.cull != cull_mode::none)
+            glCullFace(raster.cull == cull_mode::front ? GL_FRONT : GL_BACK);
+    }
+
+    if(groups & bit(state_group::front_face))
+        glFrontFace(raster.front == front_face::clockwise ? GL_CW : GL_CCW);
+
+    if(groups & bit(state_group::polygon))
+        glPolygonMode(GL_FRONT_AND_BACK, to_gl(raster.polygon));
+
+    if(groups & bit(state_group::scissor))
+        enable(GL_SCISSOR_TEST, raster.scissor_test);
+
+    if(groups & bit(state_group::depth_test))
+        enable(GL_DEPTH_TEST, depth.test);
+
+    if(groups & bit(state_group::depth_write))
+        glDepthMask(depth.write ? GL_TRUE : GL_FALSE);
+
+    if(groups & bit(state_group::depth_function))
+        glDepthFunc(to_gl(depth.function));
+
+    if(groups & bit(state_group::stencil))
+        to.stencil().apply(from.stencil());
+
+    if(groups & bit(state_group::blend_enable))
+        enable(GL_BLEND, blend.enabled);
+
+    if(groups & bit(state_group::blend_function))
+        glBlendFuncSeparate(to_gl(blend.src_color), to_gl(blend.dst_color),
+                            to_gl(blend.src_alpha), to_gl(blend.dst_alpha));
+
+    if(groups & bit(state_group::blend_equation))
+        glBlendEquationSeparate(to_gl(blend.color_equation),
+                                to_gl(blend.alpha_equation));
+
+    if(groups & bit(state_group::color_mask))
+    {
+        const auto mask = to.color_mask();
+        glColorMask((mask & color_mask_red) != 0, (mask & color_mask_green) != 0,
+                    (mask & color_mask_blue) != 0,
+                    (mask & color_mask_alpha) != 0);
+    }
+}
+
+}    // namespace corgi
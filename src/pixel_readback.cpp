@@ -0,0 +1,327 @@
+#include <corgi/opengl/memory_tracker.h>
+#include <corgi/opengl/pixel_readback.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace corgi
+{
+
+static int channel_count(format format)
+{
+    switch(format)
+    {
+        case format::red:
+            return 1;
+        case format::rg:
+            return 2;
+        case format::rgb:
+        case format::bgr:
+            return 3;
+        case format::rgba:
+        case format::bgra:
+            return 4;
+        default:
+            throw std::invalid_argument(
+                "pixel_readback::request : Format isn't supported");
+    }
+}
+
+static GLenum to_gl(format format)
+{
+    switch(format)
+    {
+        case format::red:
+            return GL_RED;
+        case format::rg:
+            return GL_RG;
+        case format::rgb:
+            return GL_RGB;
+        case format::bgr:
+            return GL_BGR;
+        case format::bgra:
+            return GL_BGRA;
+        default:
+            return GL_RGBA;
+    }
+}
+
+// readback_ticket
+
+readback_ticket::readback_ticket(pixel_readback* owner, std::uint64_t id)
+    : owner_(owner)
+    , id_(id)
+{
+}
+
+readback_ticket::readback_ticket(readback_ticket&& other) noexcept
+    : owner_(std::exchange(other.owner_, nullptr))
+    , id_(std::exchange(other.id_, 0))
+{
+}
+
+readback_ticket& readback_ticket::operator=(readback_ticket&& other) noexcept
+{
+    if(this != &other)
+    {
+        discard();
+        owner_ = std::exchange(other.owner_, nullptr);
+        id_    = std::exchange(other.id_, 0);
+    }
+    return *this;
+}
+
+readback_ticket::~readback_ticket()
+{
+    discard();
+}
+
+bool readback_ticket::ready() const
+{
+    return owner_ != nullptr && owner_->ready(id_);
+}
+
+image readback_ticket::take()
+{
+    if(owner_ == nullptr)
+        throw std::logic_error(
+            "readback_ticket::take : Ticket is empty or was already taken");
+
+    auto* owner = owner_;
+    owner_      = nullptr;
+    return owner->take(id_);
+}
+
+void readback_ticket::discard() noexcept
+{
+    if(owner_ == nullptr)
+        return;
+
+    owner_->discard(id_);
+    owner_ = nullptr;
+}
+
+bool readback_ticket::valid() const noexcept
+{
+    return owner_ != nullptr;
+}
+
+// pixel_readback
+
+pixel_readback::pixel_readback(std::size_t slots)
+{
+    if(slots == 0)
+        throw std::invalid_argument(
+            "pixel_readback::pixel_readback : Ring must have at least one "
+            "slot");
+
+    slots_.resize(slots);
+}
+
+pixel_readback::~pixel_readback()
+{
+    for(auto& s : slots_)
+    {
+        if(s.fence != nullptr)
+            glDeleteSync(static_cast<GLsync>(s.fence));
+
+        if(s.id != 0)
+        {
+            memory_tracker::instance().untrack(resource_type::pixel_buffer,
+                                               s.id);
+            glDeleteBuffers(1, &s.id);
+        }
+    }
+}
+
+readback_ticket pixel_readback::request(pixel_rect rect, format pixel_format)
+{
+    if(rect.width == 0 || rect.height == 0)
+        throw std::invalid_argument(
+            "pixel_readback::request : Area to read must not be empty");
+
+    const int         channels = channel_count(pixel_format);
+    const std::size_t bytes    = std::size_t(rect.width) * rect.height *
+                              static_cast<std::size_t>(channels);
+
+    auto& s = free_slot();
+
+    if(s.id == 0)
+        glGenBuffers(1, &s.id);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.id);
+
+    // Buffers only grow, so a ring used for a fixed size never reallocates
+    if(s.capacity < bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes),
+                     nullptr, GL_STREAM_READ);
+        s.capacity = bytes;
+        memory_tracker::instance().track(resource_type::pixel_buffer, s.id,
+                                         bytes);
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(rect.x, rect.y, static_cast<GLsizei>(rect.width),
+                 static_cast<GLsizei>(rect.height), to_gl(pixel_format),
+                 GL_UNSIGNED_BYTE, nullptr);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    s.fence    = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.ticket   = next_ticket_++;
+    s.width    = static_cast<int>(rect.width);
+    s.height   = static_cast<int>(rect.height);
+    s.channels = channels;
+
+    // Makes sure the fence reaches the GPU, otherwise polling it could
+    // never succeed
+    glFlush();
+
+    return readback_ticket(this, s.ticket);
+}
+
+std::size_t pixel_readback::pending() const noexcept
+{
+    return completed_.size() +
+           static_cast<std::size_t>(
+               std::count_if(slots_.begin(), slots_.end(),
+                             [](const slot& s) { return s.ticket != 0; }));
+}
+
+std::size_t pixel_readback::slot_count() const noexcept
+{
+    return slots_.size();
+}
+
+pixel_readback::slot* pixel_readback::find(std::uint64_t ticket)
+{
+    for(auto& s : slots_)
+        if(s.ticket == ticket)
+            return &s;
+    return nullptr;
+}
+
+pixel_readback::slot& pixel_readback::free_slot()
+{
+    for(auto& s : slots_)
+        if(s.ticket == 0)
+            return s;
+
+    // Every buffer is in use, the oldest one is copied out so the ring can
+    // move on. Its ticket is still valid
+    auto& oldest = *std::min_element(slots_.begin(), slots_.end(),
+                                     [](const slot& a, const slot& b)
+                                     { return a.ticket < b.ticket; });
+
+    const auto ticket  = oldest.ticket;
+    completed_[ticket] = copy_out(oldest);
+    return oldest;
+}
+
+bool pixel_readback::ready(std::uint64_t ticket) const
+{
+    if(completed_.contains(ticket))
+        return true;
+
+    for(const auto& s : slots_)
+    {
+        if(s.ticket != ticket)
+            continue;
+
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(static_cast<GLsync>(s.fence), GL_SYNC_STATUS,
+                    sizeof(status), nullptr, &status);
+        return status == GL_SIGNALED;
+    }
+    return false;
+}
+
+image pixel_readback::take(std::uint64_t ticket)
+{
+    if(auto it = completed_.find(ticket); it != completed_.end())
+    {
+        image img = std::move(it->second);
+        completed_.erase(it);
+        return img;
+    }
+
+    if(auto* s = find(ticket))
+        return copy_out(*s);
+
+    throw std::logic_error(
+        "pixel_readback::take : Ticket is unknown or was already taken");
+}
+
+void pixel_readback::discard(std::uint64_t ticket) noexcept
+{
+    if(completed_.erase(ticket) != 0)
+        return;
+
+    // The copy may still be running, deleting the fence doesn't wait for it
+    if(auto* s = find(ticket))
+    {
+        glDeleteSync(static_cast<GLsync>(s->fence));
+        s->fence  = nullptr;
+        s->ticket = 0;
+    }
+}
+
+image pixel_readback::copy_out(slot& s)
+{
+    auto fence = static_cast<GLsync>(s.fence);
+
+    // Waits by steps of 1ms, the first wait flushes the commands
+    GLenum result =
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+    while(result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(fence, 0, 1000000);
+
+    glDeleteSync(fence);
+    s.fence = nullptr;
+
+    if(result == GL_WAIT_FAILED)
+    {
+        s.ticket = 0;
+        throw std::runtime_error(
+            "pixel_readback::take : Waiting for the copy to finish failed");
+    }
+
+    image img;
+    img.width    = s.width;
+    img.height   = s.height;
+    img.channels = s.channels;
+    img.data.resize(std::size_t(s.width) * s.height * s.channels);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.id);
+
+    const void* pixels =
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                         static_cast<GLsizeiptr>(img.data.size()),
+                         GL_MAP_READ_BIT);
+
+    // The buffer's content is undefined if unmapping fails
+    bool copied = false;
+
+    if(pixels != nullptr)
+    {
+        std::memcpy(img.data.data(), pixels, img.data.size());
+        copied = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    s.ticket = 0;
+
+    if(!copied)
+        throw std::runtime_error(
+            "pixel_readback::take : Could not map the pixel pack buffer");
+
+    return img;
+}
+
+}    // namespace corgi
@@ -0,0 +1,88 @@
+#include <corgi/opengl/png_sink.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+png_sink::png_sink(std::size_t max_queued)
+    : max_queued_(max_queued)
+{
+    if(max_queued_ == 0)
+        throw std::invalid_argument(
+            "png_sink::png_sink : max_queued must be greater than 0");
+
+    worker_ = std::thread(&png_sink::run, this);
+}
+
+png_sink::~png_sink()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_one();
+    worker_.join();
+}
+
+void png_sink::push(image img, std::string path)
+{
+    {
+        std::unique_lock lock(mutex_);
+        work_done_.wait(lock, [this] { return queue_.size() < max_queued_; });
+        queue_.push_back({std::move(img), std::move(path)});
+    }
+    work_available_.notify_one();
+}
+
+void png_sink::flush()
+{
+    std::unique_lock lock(mutex_);
+    work_done_.wait(lock, [this] { return queue_.empty() && encoding_ == 0; });
+}
+
+std::size_t png_sink::written() const
+{
+    std::lock_guard lock(mutex_);
+    return written_;
+}
+
+std::size_t png_sink::failed() const
+{
+    std::lock_guard lock(mutex_);
+    return failed_;
+}
+
+void png_sink::run()
+{
+    std::unique_lock lock(mutex_);
+
+    while(true)
+    {
+        work_available_.wait(lock,
+                             [this] { return stopping_ || !queue_.empty(); });
+
+        if(queue_.empty())
+            return;
+
+        job current = std::move(queue_.front());
+        queue_.pop_front();
+        encoding_++;
+
+        // Room was made in the queue
+        work_done_.notify_all();
+
+        lock.unlock();
+        const bool success = current.img.save_png(current.path);
+        lock.lock();
+
+        encoding_--;
+        if(success)
+            written_++;
+        else
+            failed_++;
+        work_done_.notify_all();
+    }
+}
+
+}    // namespace corgi
@@ -1,3 +1,4 @@
+#include <corgi/opengl/deletion_queue.h>
 #include <corgi/opengl/program.h>
 #include <glad/glad.h>
 
@@ -9,7 +10,8 @@ namespace corgi
 
 program::program(shader& vertex_shader, shader& fragment_shader)
 {
-    // Shaders must share the same vertex attributes
+    // Shaders must share the same vertex attributes. Common shaders are also
+    // checked at compile time, this covers the ones built at runtime
     assert(vertex_shader.vertex_attributes() ==
            fragment_shader.vertex_attributes());
 
@@ -64,7 +66,7 @@ program::program(program&& other) noexcept
 
 program& program::operator=(program&& other) noexcept
 {
-    glDeleteProgram(id_);
+    deletion_queue::instance().retire(gl_object::program, id_);
 
     id_              = other.id_;
     vertex_shader_   = other.vertex_shader_;
@@ -79,7 +81,7 @@ program& program::operator=(program&& other) noexcept
 
 program::~program()
 {
-    glDeleteProgram(id_);
+    deletion_queue::instance().retire(gl_object::program, id_);
 }
 
 void program::use()
@@ -0,0 +1,637 @@
+#include <corgi/opengl/render_graph.h>
+#include <corgi/opengl/renderer.h>
+
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <stdexcept>
+
+namespace corgi
+{
+
+static bool is_depth(internal_format format)
+{
+    return format == internal_format::depth_component ||
+           format == internal_format::depth_component24 ||
+           format == internal_format::depth_stencil ||
+           format == internal_format::depth24_stencil8;
+}
+
+static bool has_stencil(internal_format format)
+{
+    return format == internal_format::depth_stencil ||
+           format == internal_format::depth24_stencil8;
+}
+
+static std::unique_ptr<texture> make_target(const render_target_desc& desc)
+{
+    create_info info;
+    info.min_filter      = min_filter::linear;
+    info.mag_filter      = mag_filter::linear;
+    info.wrap_s          = wrap::clamp_to_edge;
+    info.wrap_t          = wrap::clamp_to_edge;
+    info.internal_format = desc.format;
+    info.width           = static_cast<int>(desc.width);
+    info.height          = static_cast<int>(desc.height);
+    info.data            = nullptr;
+
+    if(has_stencil(desc.format))
+    {
+        info.format    = format::depth_stencil;
+        info.data_type = data_type::unsigned_int24_8;
+    }
+    else if(is_depth(desc.format))
+    {
+        info.format    = format::depth_component;
+        info.data_type = data_type::float_;
+    }
+    else if(desc.format == internal_format::rgba16_f)
+    {
+        info.data_type = data_type::half_float;
+    }
+
+    return std::make_unique<texture>(info);
+}
+
+// pass_builder
+
+render_graph::pass_builder::pass_builder(render_graph& graph, std::size_t pass)
+    : graph_(graph)
+    , pass_(pass)
+{
+}
+
+void render_graph::pass_builder::read(resource r)
+{
+    graph_.check(r);
+
+    if(graph_.resources_[r].default_target)
+        throw std::logic_error(
+            "render_graph::pass_builder::read : The default target can't be "
+            "read by a pass");
+
+    graph_.passes_[pass_].reads.push_back(r);
+}
+
+void render_graph::pass_builder::write(resource r)
+{
+    graph_.check(r);
+
+    // The default target can't share a framebuffer with other targets
+    auto& writes = graph_.passes_[pass_].writes;
+
+    auto is_default = [&](resource w)
+    { return graph_.resources_[w].default_target; };
+
+    if(!writes.empty() &&
+       (is_default(r) || std::any_of(writes.begin(), writes.end(), is_default)))
+        throw std::logic_error(
+            "render_graph::pass_builder::write : The default target can't be "
+            "written with other resources");
+
+    writes.push_back(r);
+}
+
+// pass_context
+
+render_graph::pass_context::pass_context(const render_graph& graph,
+                                         corgi::renderer&    renderer)
+    : graph_(graph)
+    , renderer_(renderer)
+{
+}
+
+const texture& render_graph::pass_context::texture(resource r) const
+{
+    return graph_.texture(r);
+}
+
+renderer& render_graph::pass_context::renderer() const
+{
+    return renderer_;
+}
+
+// render_graph
+
+render_graph::render_graph()
+{
+    reset();
+}
+
+render_graph::~render_graph() = default;
+
+void render_graph::reset()
+{
+    resources_.clear();
+    passes_.clear();
+    order_.clear();
+    compiled_ = false;
+
+    resource_node node;
+    node.name           = "default_target";
+    node.default_target = true;
+    node.output         = true;
+    resources_.push_back(std::move(node));
+
+    default_target_ = 0;
+}
+
+void render_graph::check(resource r) const
+{
+    if(r >= resources_.size())
+        throw std::out_of_range("render_graph : Unknown resource");
+}
+
+bool render_graph::is_transient(const resource_node& node) const noexcept
+{
+    return node.imported == nullptr && !node.default_target;
+}
+
+render_graph::resource render_graph::create(std::string        name,
+                                            render_target_desc desc)
+{
+    if(desc.width == 0 || desc.height == 0)
+        throw std::invalid_argument(
+            "render_graph::create : Render target size must be greater than "
+            "0");
+
+    resource_node node;
+    node.name = std::move(name);
+    node.desc = desc;
+    resources_.push_back(std::move(node));
+
+    compiled_ = false;
+    return static_cast<resource>(resources_.size() - 1);
+}
+
+render_graph::resource render_graph::import(std::string     name,
+                                            corgi::texture& texture)
+{
+    resource_node node;
+    node.name     = std::move(name);
+    node.imported = &texture;
+    node.output   = true;
+    node.desc     = {texture.width(), texture.height(),
+                     texture.internal_format()};
+    resources_.push_back(std::move(node));
+
+    compiled_ = false;
+    return static_cast<resource>(resources_.size() - 1);
+}
+
+render_graph::resource render_graph::default_target() const noexcept
+{
+    return default_target_;
+}
+
+void render_graph::mark_output(resource r)
+{
+    check(r);
+    resources_[r].output = true;
+    compiled_            = false;
+}
+
+void render_graph::add_pass(std::string      name,
+                            setup_function   setup,
+                            execute_function execute)
+{
+    pass_node node;
+    node.name    = std::move(name);
+    node.execute = std::move(execute);
+    passes_.push_back(std::move(node));
+
+    pass_builder builder(*this, passes_.size() - 1);
+
+    // A setup that throws doesn't leave a half declared pass behind
+    try
+    {
+        setup(builder);
+    }
+    catch(...)
+    {
+        passes_.pop_back();
+        throw;
+    }
+
+    compiled_ = false;
+}
+
+void render_graph::cull()
+{
+    for(auto& pass : passes_)
+        pass.culled = true;
+
+    // Walking backward from the outputs, a pass is needed if it writes
+    // a resource that is an output or that is read by a needed pass
+    std::vector<bool> needed(resources_.size(), false);
+
+    for(std::size_t i = 0; i < resources_.size(); i++)
+        needed[i] = resources_[i].output;
+
+    bool changed = true;
+
+    while(changed)
+    {
+        changed = false;
+
+        for(auto& pass : passes_)
+        {
+            if(!pass.culled)
+                continue;
+
+            const bool contributes =
+                std::any_of(pass.writes.begin(), pass.writes.end(),
+                            [&](resource r) { return needed[r]; });
+
+            if(!contributes)
+                continue;
+
+            pass.culled = false;
+            changed     = true;
+
+            for(auto r : pass.reads)
+                needed[r] = true;
+        }
+    }
+}
+
+void render_graph::sort()
+{
+    // A pass reads the content left by the last pass declared before it that
+    // writes the resource, and must run before the passes declared after it
+    // that overwrite it. When no earlier pass writes the resource, the pass
+    // depends on every pass writing it. Passes writing the same resource keep
+    // their declaration order
+    const auto count = passes_.size();
+
+    std::vector<std::vector<std::size_t>> successors(count);
+    std::vector<std::size_t>              dependencies(count, 0);
+
+    auto add_edge = [&](std::size_t from, std::size_t to)
+    {
+        auto& s = successors[from];
+        if(std::find(s.begin(), s.end(), to) != s.end())
+            return;
+        s.push_back(to);
+        dependencies[to]++;
+    };
+
+    auto touches = [](const std::vector<resource>& list, resource r)
+    { return std::find(list.begin(), list.end(), r) != list.end(); };
+
+    auto writes = [&](std::size_t pass, resource r)
+    {
+        return !passes_[pass].culled && touches(passes_[pass].writes, r);
+    };
+
+    for(std::size_t pass = 0; pass < count; pass++)
+    {
+        if(passes_[pass].culled)
+            continue;
+
+        for(auto r : passes_[pass].reads)
+        {
+            std::size_t last_writer = count;
+
+            for(std::size_t writer = 0; writer < pass; writer++)
+                if(writes(writer, r))
+                    last_writer = writer;
+
+            for(std::size_t other = 0; other < count; other++)
+            {
+                if(other == pass || !writes(other, r))
+                    continue;
+
+                if(last_writer == count || other == last_writer)
+                    add_edge(other, pass);
+                else if(other > pass)
+                    add_edge(pass, other);
+            }
+        }
+
+        for(std::size_t writer = 0; writer < pass; writer++)
+            for(auto r : passes_[pass].writes)
+                if(writes(writer, r))
+                    add_edge(writer, pass);
+    }
+
+    // Kahn's algorithm, picking the first declared pass when several are
+    // ready
+    std::priority_queue<std::size_t, std::vector<std::size_t>,
+                        std::greater<std::size_t>>
+        ready;
+
+    std::size_t active = 0;
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        if(passes_[i].culled)
+            continue;
+
+        active++;
+
+        if(dependencies[i] == 0)
+            ready.push(i);
+    }
+
+    order_.clear();
+
+    while(!ready.empty())
+    {
+        const auto pass = ready.top();
+        ready.pop();
+        order_.push_back(pass);
+
+        for(auto next : successors[pass])
+            if(--dependencies[next] == 0)
+                ready.push(next);
+    }
+
+    if(order_.size() != active)
+        throw std::logic_error(
+            "render_graph::compile : Passes have cyclic dependencies");
+}
+
+void render_graph::assign_slots()
+{
+    for(auto& node : resources_)
+    {
+        node.used = false;
+        node.slot = -1;
+    }
+
+    for(std::size_t position = 0; position < order_.size(); position++)
+    {
+        const auto& pass = passes_[order_[position]];
+
+        auto use = [&](resource r)
+        {
+            auto& node = resources_[r];
+
+            if(!node.used)
+                node.first_use = position;
+
+            node.used     = true;
+            node.last_use = position;
+        };
+
+        std::for_each(pass.reads.begin(), pass.reads.end(), use);
+        std::for_each(pass.writes.begin(), pass.writes.end(), use);
+    }
+
+    for(auto& target : pool_)
+        target.used = false;
+
+    // Resources are given a slot in the order they start living. A slot can
+    // be reused once the last resource using it is dead
+    std::vector<resource> transients;
+
+    for(resource r = 0; r < resources_.size(); r++)
+        if(resources_[r].used && is_transient(resources_[r]))
+            transients.push_back(r);
+
+    std::stable_sort(transients.begin(), transients.end(),
+                     [&](resource a, resource b)
+                     { return resources_[a].first_use < resources_[b].first_use; });
+
+    for(auto r : transients)
+    {
+        auto& node = resources_[r];
+
+        for(std::size_t slot = 0; slot < pool_.size(); slot++)
+        {
+            auto& target = pool_[slot];
+
+            if(target.desc != node.desc)
+                continue;
+
+            if(target.used && target.busy_until >= node.first_use)
+                continue;
+
+            node.slot = static_cast<int>(slot);
+            break;
+        }
+
+        if(node.slot == -1)
+        {
+            pool_.push_back({node.desc, nullptr, false, 0});
+            node.slot = static_cast<int>(pool_.size() - 1);
+        }
+
+        // Outputs are read after the graph runs, they are never aliased
+        auto& target      = pool_[node.slot];
+        target.used       = true;
+        target.busy_until = node.output ? order_.size() : node.last_use;
+    }
+}
+
+void render_graph::compile()
+{
+    cull();
+    sort();
+    assign_slots();
+
+    // Attachments may have changed, framebuffers are found again in the
+    // cache when executing
+    for(auto& pass : passes_)
+        pass.framebuffer = nullptr;
+
+    for(auto& cached : framebuffers_)
+        cached.used = false;
+
+    compiled_ = true;
+}
+
+const texture& render_graph::texture(resource r) const
+{
+    check(r);
+
+    const auto& node = resources_[r];
+
+    if(node.default_target)
+        throw std::logic_error(
+            "render_graph::texture : The default target isn't a texture");
+
+    if(node.imported != nullptr)
+        return *node.imported;
+
+    if(node.slot == -1 || pool_[node.slot].texture == nullptr)
+        throw std::logic_error(
+            "render_graph::texture : Resource isn't used by the compiled "
+            "graph");
+
+    return *pool_[node.slot].texture;
+}
+
+void render_graph::prepare_pass(pass_node& pass)
+{
+    for(auto r : pass.reads)
+    {
+        auto& node = resources_[r];
+        if(is_transient(node) && pool_[node.slot].texture == nullptr)
+            pool_[node.slot].texture = make_target(node.desc);
+    }
+
+    for(auto r : pass.writes)
+    {
+        auto& node = resources_[r];
+        if(is_transient(node) && pool_[node.slot].texture == nullptr)
+            pool_[node.slot].texture = make_target(node.desc);
+    }
+
+    const bool to_default_target =
+        std::any_of(pass.writes.begin(), pass.writes.end(),
+                    [&](resource r) { return resources_[r].default_target; });
+
+    if(to_default_target || pass.framebuffer != nullptr || pass.writes.empty())
+        return;
+
+    pass.attachments.clear();
+
+    std::vector<std::pair<attachment, unsigned>> attached;
+
+    int color_count = 0;
+
+    for(auto r : pass.writes)
+    {
+        const auto& desc = resources_[r].desc;
+
+        attachment point;
+
+        if(has_stencil(desc.format))
+            point = attachment::depth_stencil;
+        else if(is_depth(desc.format))
+            point = attachment::depth;
+        else if(color_count < max_color_attachments)
+            point = static_cast<attachment>(color_count++);
+        else
+            throw std::logic_error(
+                "render_graph::execute : Too many color targets written by a "
+                "pass");
+
+        pass.attachments.push_back(point);
+        attached.emplace_back(point, texture(r).id());
+    }
+
+    auto cached = std::find_if(framebuffers_.begin(), framebuffers_.end(),
+                               [&](const cached_framebuffer& c)
+                               { return c.attachments == attached; });
+
+    if(cached == framebuffers_.end())
+    {
+        cached_framebuffer entry;
+        entry.framebuffer = std::make_unique<corgi::framebuffer>();
+
+        for(std::size_t i = 0; i < pass.writes.size(); i++)
+            entry.framebuffer->attach(pass.attachments[i],
+                                      texture(pass.writes[i]));
+
+        entry.attachments = std::move(attached);
+        framebuffers_.push_back(std::move(entry));
+        cached = std::prev(framebuffers_.end());
+    }
+
+    cached->used     = true;
+    pass.framebuffer = cached->framebuffer.get();
+}
+
+void render_graph::execute(corgi::renderer& renderer)
+{
+    if(!compiled_)
+        compile();
+
+    pass_context context(*this, renderer);
+
+    for(std::size_t position = 0; position < order_.size(); position++)
+    {
+        auto& pass = passes_[order_[position]];
+
+        prepare_pass(pass);
+
+        if(pass.framebuffer != nullptr)
+            pass.framebuffer->bind();
+        else
+            framebuffer::unbind();
+
+        if(pass.execute)
+            pass.execute(context);
+
+        // Transient targets that die with this pass don't need to be stored
+        if(pass.framebuffer != nullptr)
+        {
+            std::vector<attachment> dead;
+
+            for(std::size_t i = 0; i < pass.writes.size(); i++)
+            {
+                const auto& node = resources_[pass.writes[i]];
+
+                if(is_transient(node) && !node.output &&
+                   node.last_use == position)
+                    dead.push_back(pass.attachments[i]);
+            }
+
+            if(!dead.empty())
+                pass.framebuffer->invalidate(dead);
+        }
+    }
+
+    framebuffer::unbind();
+}
+
+void render_graph::trim()
+{
+    // Framebuffers go first, they may attach the textures released below
+    std::erase_if(framebuffers_,
+                  [](const cached_framebuffer& c) { return !c.used; });
+
+    for(auto& target : pool_)
+        if(!target.used)
+            target.texture.reset();
+}
+
+std::vector<std::string> render_graph::execution_order() const
+{
+    std::vector<std::string> names;
+    for(auto pass : order_)
+        names.push_back(passes_[pass].name);
+    return names;
+}
+
+std::vector<std::string> render_graph::culled_passes() const
+{
+    std::vector<std::string> names;
+    for(const auto& pass : passes_)
+        if(pass.culled)
+            names.push_back(pass.name);
+    return names;
+}
+
+std::size_t render_graph::transient_bytes() const
+{
+    std::size_t total = 0;
+    for(const auto& target : pool_)
+        if(target.used)
+            total += texture_size_in_bytes(target.desc.format,
+                                           target.desc.width,
+                                           target.desc.height);
+    return total;
+}
+
+std::size_t render_graph::transient_bytes_without_aliasing() const
+{
+    std::size_t total = 0;
+    for(const auto& node : resources_)
+        if(node.used && is_transient(node))
+            total += texture_size_in_bytes(node.desc.format, node.desc.width,
+                                           node.desc.height);
+    return total;
+}
+
+std::size_t render_graph::physical_target_count() const
+{
+    return static_cast<std::size_t>(
+        std::count_if(pool_.begin(), pool_.end(),
+                      [](const pooled_target& t) { return t.used; }));
+}
+
+}    // namespace corgi
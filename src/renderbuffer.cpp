@@ -0,0 +1,135 @@
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/memory_tracker.h>
+#include <corgi/opengl/renderbuffer.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace corgi
+{
+
+renderbuffer::renderbuffer(internal_format format,
+                           unsigned        width,
+                           unsigned        height,
+                           int             samples)
+    : format_(format)
+    , width_(width)
+    , height_(height)
+    , samples_(samples)
+{
+    if(width_ == 0 || height_ == 0)
+        throw std::invalid_argument(
+            "renderbuffer::renderbuffer : width and height must be greater "
+            "than 0");
+
+    glGenRenderbuffers(1, &id_);
+
+    if(id_ == 0)
+        throw std::logic_error(
+            "renderbuffer::renderbuffer : id is equals to 0 after "
+            "glGenRenderbuffers");
+
+    bind();
+
+    if(samples_ > 0)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples_,
+                                         to_gl(format_), width_, height_);
+    else
+        glRenderbufferStorage(GL_RENDERBUFFER, to_gl(format_), width_,
+                              height_);
+
+    unbind();
+
+    memory_tracker::instance().track(resource_type::renderbuffer, id_,
+                                     size_in_bytes());
+}
+
+renderbuffer::renderbuffer(renderbuffer&& other) noexcept
+    : id_(other.id_)
+    , format_(other.format_)
+    , width_(other.width_)
+    , height_(other.height_)
+    , samples_(other.samples_)
+{
+    other.id_ = 0;
+}
+
+renderbuffer& renderbuffer::operator=(renderbuffer&& other) noexcept
+{
+    clear();
+
+    id_      = other.id_;
+    format_  = other.format_;
+    width_   = other.width_;
+    height_  = other.height_;
+    samples_ = other.samples_;
+
+    other.id_ = 0;
+    return *this;
+}
+
+renderbuffer::~renderbuffer()
+{
+    clear();
+}
+
+void renderbuffer::clear()
+{
+    deletion_queue::instance().retire(gl_object::renderbuffer, id_,
+                                      resource_type::renderbuffer);
+    id_ = 0;
+}
+
+unsigned renderbuffer::id() const noexcept
+{
+    return id_;
+}
+
+internal_format renderbuffer::format() const noexcept
+{
+    return format_;
+}
+
+unsigned renderbuffer::width() const noexcept
+{
+    return width_;
+}
+
+unsigned renderbuffer::height() const noexcept
+{
+    return height_;
+}
+
+int renderbuffer::samples() const noexcept
+{
+    return samples_;
+}
+
+std::size_t renderbuffer::size_in_bytes() const noexcept
+{
+    return texture_size_in_bytes(format_, width_, height_) *
+           static_cast<std::size_t>(std::max(samples_, 1));
+}
+
+void renderbuffer::set_tag(std::string tag) const
+{
+    memory_tracker::instance().set_tag(resource_type::renderbuffer, id_,
+                                       std::move(tag));
+}
+
+void renderbuffer::bind() const
+{
+    if(id_ == 0)
+        throw std::logic_error(
+            "renderbuffer::bind : Can't bind an empty renderbuffer");
+
+    glBindRenderbuffer(GL_RENDERBUFFER, id_);
+}
+
+void renderbuffer::unbind() const
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+}    // namespace corgi
@@ -1,3 +1,4 @@
+#include <corgi/opengl/deletion_queue.h>
 #include <corgi/opengl/renderer.h>
 #include <glad/glad.h>
 #include <corgi/opengl/uniform_buffers.h>
@@ -29,6 +30,11 @@ renderer::renderer(unsigned short screen_width, unsigned short screen_height)
                                         *default_fragment_shader_));
 
     default_pipeline_.program_ = default_program_.get();
+
+    pipeline_state_registry::instance().apply_defaults();
+
+    default_shape_ = dynamic_mesh(
+        layout_registry::instance().intern(common_attributes::pos2_uv));
 }
 
 void renderer::set_default_color(float r, float g, float b, float a)
@@ -47,7 +53,10 @@ void renderer::set_default_color(float r, float g, float b, float a)
 
 void renderer::draw_default_circle_on_screen(float x, float y, float radius)
 {
-    mesh m = corgi::primitive::build_circle_pos2_uv(radius, 100);
+    corgi::primitive::circle_pos2_uv(
+        radius, corgi::primitive::circle_discretisation(radius),
+        default_shape_vertices_, default_shape_indexes_);
+    default_shape_.update(default_shape_vertices_, default_shape_indexes_);
 
     auto value = default_pipeline_.get_ubo<default_ubo>(1).data().front();
    
@@ -63,7 +72,49 @@ void renderer::draw_default_circle_on_screen(float x, float y, float radius)
     
         
     apply_pipeline(default_pipeline_);
-    draw(m);
+    draw(default_shape_);
+}
+
+void renderer::end_frame()
+{
+    deletion_queue::instance().end_frame();
+}
+
+frustum renderer::screen_frustum() const
+{
+    return frustum::orthographic(-screen_width_ / 2.0F, screen_width_ / 2.0F,
+                                 -screen_height_ / 2.0F, screen_height_ / 2.0F,
+                                 -100.0F, 100.0F);
+}
+
+view_rect renderer::screen_rect() const noexcept
+{
+    return {-screen_width_ / 2.0F, -screen_height_ / 2.0F, screen_width_ / 2.0F,
+            screen_height_ / 2.0F};
+}
+
+vertex_array_cache& renderer::vertex_arrays() noexcept
+{
+    return vertex_arrays_;
+}
+
+pipeline_state_id renderer::current_state() const noexcept
+{
+    return state_;
+}
+
+program* renderer::current_program() const noexcept
+{
+    return pipeline_ != nullptr ? pipeline_->program_ : nullptr;
+}
+
+readback_ticket renderer::read_pixels_async(pixel_rect rect,
+                                            format     pixel_format)
+{
+    if(readback_ == nullptr)
+        readback_ = std::make_unique<pixel_readback>();
+
+    return readback_->request(rect, pixel_format);
 }
 
 void renderer::clear()
@@ -73,7 +124,10 @@ void renderer::clear()
 
 void renderer::draw_default_rect_on_screen(float x, float y, float width, float height)
 {
-    mesh m = corgi::primitive::build_rect_pos2_uv(width/2.0F, height/2.0F);
+    corgi::primitive::rect_pos2_uv(width / 2.0F, height / 2.0F,
+                                   default_shape_vertices_,
+                                   default_shape_indexes_);
+    default_shape_.update(default_shape_vertices_, default_shape_indexes_);
 
     auto value = default_pipeline_.get_ubo<default_ubo>(1).data().front();
 
@@ -87,7 +141,7 @@ void renderer::draw_default_rect_on_screen(float x, float y, float width, float
     default_pipeline_.get_ubo<default_ubo>(1).set_value(value);
 
     apply_pipeline(default_pipeline_);
-    draw(m);
+    draw(default_shape_);
 }
 
 void renderer::set_clear_color(color clear_color)
@@ -98,45 +152,151 @@ void renderer::set_clear_color(color clear_color)
     clear_color_ = clear_color;
 }
 
+static GLenum to_gl(primitive_type primitive)
+{
+    switch(primitive)
+    {
+        case primitive_type::lines:
+            return GL_LINES;
+        case primitive_type::quads:
+            return GL_QUADS;
+        case primitive_type::triangles:
+            return GL_TRIANGLES;
+    }
+    return GL_TRIANGLES;
+}
+
+static GLenum to_gl(index_type type)
+{
+    switch(type)
+    {
+        case index_type::uint8:
+            return GL_UNSIGNED_BYTE;
+        case index_type::uint16:
+            return GL_UNSIGNED_SHORT;
+        case index_type::uint32:
+            return GL_UNSIGNED_INT;
+    }
+    return GL_UNSIGNED_INT;
+}
+
 void renderer::draw(const mesh& m)
 {
-    m.vertex_array()->bind();
+    draw(m, 0, m.index_count());
+}
+
+void renderer::draw(const mesh&   m,
+                    std::uint32_t first_index,
+                    std::uint32_t index_count)
+{
+    if(m.empty())
+        return;
 
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m.indexes().size()),
-                   GL_UNSIGNED_INT, (void*)0);
+    // Meshes of the same layout share the vertex array, only the buffers
+    // change
+    vertex_arrays_.bind(m.layout(), m.vertex_buffer()->id(),
+                        m.index_buffer()->id());
 
-    m.vertex_array()->end();
+    const auto offset = static_cast<std::uintptr_t>(first_index) *
+                        index_type_size(m.index_type());
 
-   // pipeline_->program_->end();
+    glDrawElements(to_gl(m.primitive()), static_cast<GLsizei>(index_count),
+                   to_gl(m.index_type()),
+                   reinterpret_cast<const void*>(offset));
 }
 
-void renderer::apply_pipeline(corgi::pipeline& new_pipeline)
+void renderer::draw(const lod_mesh& m, float screen_size)
 {
-    if (pipeline_->write_color != new_pipeline.write_color)
-    {
-        if(new_pipeline.write_color)
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-        else
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    }
+    if(m.levels().empty())
+        return;
+
+    const auto& level = m.levels()[m.select(screen_size)];
+    draw(m.mesh(), level.first_index, level.index_count);
+}
+
+void renderer::draw(const compact_mesh& m)
+{
+    m.bind(vertex_arrays_);
+
+    glDrawElements(to_gl(m.primitive()), static_cast<GLsizei>(m.index_count()),
+                   to_gl(m.index_type()), (void*)0);
+}
+
+void renderer::draw(const dynamic_mesh& m)
+{
+    if(m.draw_count() == 0)
+        return;
+
+    m.bind(vertex_arrays_);
+
+    const auto offset = static_cast<std::uintptr_t>(m.first_index()) *
+                        index_type_size(m.index_type());
+
+    glDrawElements(to_gl(m.primitive()), static_cast<GLsizei>(m.draw_count()),
+                   to_gl(m.index_type()),
+                   reinterpret_cast<const void*>(offset));
+}
+
+void renderer::draw(const static_batch& batch)
+{
+    draw(batch.mesh());
+}
+
+void renderer::draw(const static_batch&            batch,
+                    std::span<const std::uint32_t> ranges)
+{
+    const auto& m = batch.mesh();
+
+    if(m.empty() || ranges.empty())
+        return;
+
+    multi_draw_counts_.clear();
+    multi_draw_offsets_.clear();
+
+    const auto index_size = index_type_size(m.index_type());
 
-    if (pipeline_->enable_depth_test != new_pipeline.enable_depth_test)
+    std::uint32_t first = 0;
+    std::uint32_t end   = 0;
+
+    for(auto r : ranges)
     {
-        if(new_pipeline.enable_depth_test)
-            glEnable(GL_DEPTH_TEST);
-        else
-            glDisable(GL_DEPTH_TEST);
+        const auto& range = batch.ranges().at(r);
+
+        // Meshes next to each other in the index buffer are drawn together
+        if(!multi_draw_counts_.empty() && range.first_index == end)
+        {
+            end += range.index_count;
+            multi_draw_counts_.back() = static_cast<int>(end - first);
+            continue;
+        }
+
+        first = range.first_index;
+        end   = range.first_index + range.index_count;
+
+        multi_draw_counts_.push_back(static_cast<int>(range.index_count));
+        multi_draw_offsets_.push_back(reinterpret_cast<const void*>(
+            static_cast<std::uintptr_t>(first) * index_size));
     }
 
-    if(pipeline_->depth_mask != new_pipeline.depth_mask)
+    m.bind(vertex_arrays_);
+
+    glMultiDrawElements(to_gl(m.primitive()), multi_draw_counts_.data(),
+                        to_gl(m.index_type()), multi_draw_offsets_.data(),
+                        static_cast<GLsizei>(multi_draw_counts_.size()));
+}
+
+void renderer::apply_pipeline(corgi::pipeline& new_pipeline)
+{
+    // Nothing has been applied yet, so we can't skip any state change
+    const bool first = pipeline_ == nullptr;
+
+    if(state_ != new_pipeline.state())
     {
-        if(new_pipeline.depth_mask)
-            glDepthMask(GL_TRUE);
-        else
-            glDepthMask(GL_FALSE);
+        pipeline_state_registry::instance().apply(state_, new_pipeline.state());
+        state_ = new_pipeline.state();
     }
 
-    if (pipeline_->program_->id() != new_pipeline.program_->id())
+    if (first || pipeline_->program_->id() != new_pipeline.program_->id())
     {
         new_pipeline.program_->use();
     }
@@ -149,12 +309,13 @@ void renderer::apply_pipeline(corgi::pipeline& new_pipeline)
         glActiveTexture(GL_TEXTURE0 + sampler.binding);    // Texture unit 0
         sampler.texture->bind();
     }
+
+    pipeline_ = &new_pipeline;
 }
 
 void renderer::set_pipeline(corgi::pipeline& pipeline)
 {
-    apply_pipeline(*pipeline_);
-    pipeline_ = &pipeline;
+    apply_pipeline(pipeline);
 }
 
 }    // namespace corgi
\ No newline at end of file
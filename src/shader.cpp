@@ -1,3 +1,4 @@
+#include <corgi/opengl/deletion_queue.h>
 #include <corgi/opengl/shader.h>
 #include <glad/glad.h>
 
@@ -25,7 +26,7 @@ shader::shader(std::string                   source,
 shader::shader(const shader_content& s)
     : source_(s.content)
     , shader_type_(s.shader_type)
-    , vertex_attributes_(s.attributes)
+    , vertex_attributes_(s.attributes.begin(), s.attributes.end())
 {
     assert(
         !vertex_attributes_.empty());    // Vertex attributes must not be empty
@@ -90,6 +91,6 @@ void shader::check_compile_status()
 
 shader::~shader()
 {
-    glDeleteShader(id_);
+    deletion_queue::instance().retire(gl_object::shader, id_);
 }
 }    // namespace corgi
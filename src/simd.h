@@ -0,0 +1,9 @@
+#pragma once
+
+// Private to the library sources. CORGI_OPENGL_SSE is defined when SSE
+// intrinsics can be used, every SSE path keeps a scalar fallback
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define CORGI_OPENGL_SSE 1
+#    include <xmmintrin.h>
+#endif
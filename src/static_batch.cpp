@@ -0,0 +1,236 @@
+#include <corgi/opengl/static_batch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "simd.h"
+
+namespace corgi
+{
+
+static const vertex_attribute* find_normal(const mesh_data& data,
+                                           int              location)
+{
+    for(const auto& attribute : data.attributes)
+        if(attribute.location == location &&
+           attribute.type == attribute_type::float32 &&
+           attribute.mode == attribute_mode::floating)
+            return &attribute;
+    return nullptr;
+}
+
+/**
+ * @brief Transforms the float attribute of every vertex, in place, and
+ * returns the bounds of the results
+ *
+ * @param w 1 for points, 0 for directions
+ */
+static aabb transform_attribute(std::span<std::byte> vertices,
+                                std::size_t          stride,
+                                std::size_t          offset,
+                                int                  components,
+                                const matrix4&       m,
+                                float                w)
+{
+    const auto count = vertices.size() / stride;
+    const auto bytes = static_cast<std::size_t>(components) * sizeof(float);
+
+    aabb bounds;
+
+#ifdef CORGI_OPENGL_SSE
+    const __m128 c0 = _mm_loadu_ps(&m[0]);
+    const __m128 c1 = _mm_loadu_ps(&m[4]);
+    const __m128 c2 = _mm_loadu_ps(&m[8]);
+    const __m128 c3 = _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(w));
+
+    __m128 min = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 max = _mm_set1_ps(std::numeric_limits<float>::lowest());
+
+    for(std::size_t v = 0; v < count; v++)
+    {
+        std::byte* attribute = vertices.data() + v * stride + offset;
+
+        float p[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+        std::memcpy(p, attribute, bytes);
+
+        // One column per component, the 4 rows at once
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), c3);
+        r        = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        r        = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+
+        min = _mm_min_ps(min, r);
+        max = _mm_max_ps(max, r);
+
+        _mm_storeu_ps(p, r);
+        std::memcpy(attribute, p, bytes);
+    }
+
+    float lowest[4];
+    float highest[4];
+    _mm_storeu_ps(lowest, min);
+    _mm_storeu_ps(highest, max);
+
+    if(count != 0)
+        for(int i = 0; i < 3; i++)
+        {
+            bounds.min[i] = lowest[i];
+            bounds.max[i] = highest[i];
+        }
+#else
+    for(std::size_t v = 0; v < count; v++)
+    {
+        std::byte* attribute = vertices.data() + v * stride + offset;
+
+        std::array<float, 3> p {0.0F, 0.0F, 0.0F};
+        std::memcpy(p.data(), attribute, bytes);
+
+        const std::array<float, 3> r {
+            m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12] * w,
+            m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13] * w,
+            m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14] * w};
+
+        bounds.expand(r);
+        std::memcpy(attribute, r.data(), bytes);
+    }
+#endif
+
+    return bounds;
+}
+
+static void normalize_attribute(std::span<std::byte> vertices,
+                                std::size_t          stride,
+                                std::size_t          offset)
+{
+    for(std::size_t v = 0; v < vertices.size() / stride; v++)
+    {
+        std::byte* attribute = vertices.data() + v * stride + offset;
+
+        float n[3];
+        std::memcpy(n, attribute, sizeof(n));
+
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+        if(length > 0.0F)
+            for(auto& c : n)
+                c /= length;
+
+        std::memcpy(attribute, n, sizeof(n));
+    }
+}
+
+batch_data build_static_batch(std::span<const batch_item> items,
+                              int                         normal_location)
+{
+    if(items.empty())
+        throw std::invalid_argument("build_static_batch : No mesh to batch");
+
+    for(const auto& item : items)
+        if(item.mesh == nullptr || item.mesh->empty())
+            throw std::invalid_argument(
+                "build_static_batch : Can't batch a null or empty mesh");
+
+    const auto layout    = items.front().mesh->layout();
+    const auto primitive = items.front().mesh->primitive();
+
+    batch_data batch;
+    batch.data.attributes = items.front().mesh->attributes();
+    batch.data.primitive  = primitive;
+
+    const auto* position = find_position_attribute(batch.data.attributes);
+    const auto* normal   = normal_location >= 0
+                               ? find_normal(batch.data, normal_location)
+                               : nullptr;
+
+    if(position == nullptr)
+        throw std::invalid_argument(
+            "build_static_batch : Meshes have no float position at location "
+            "0");
+
+    if(normal_location >= 0 && (normal == nullptr || normal->size != 3))
+        throw std::invalid_argument(
+            "build_static_batch : Normal isn't made of 3 floats");
+
+    const auto stride = static_cast<std::size_t>(
+        attributes_stride(batch.data.attributes));
+
+    std::size_t vertex_bytes = 0;
+    std::size_t index_count  = 0;
+
+    for(const auto& item : items)
+    {
+        if(item.mesh->layout() != layout || item.mesh->primitive() != primitive)
+            throw std::invalid_argument(
+                "build_static_batch : Meshes don't share their layout and "
+                "primitive");
+
+        vertex_bytes += item.mesh->vertices().size();
+        index_count += item.mesh->index_count();
+    }
+
+    if(vertex_bytes / stride > 0xFFFFFFFFull)
+        throw std::invalid_argument(
+            "build_static_batch : Too many vertices for 32 bits indexes");
+
+    batch.data.vertices.resize(vertex_bytes);
+    batch.data.indexes.reserve(index_count);
+    batch.ranges.reserve(items.size());
+
+    std::size_t vertex_offset = 0;
+
+    for(const auto& item : items)
+    {
+        const auto& source = item.mesh->vertices();
+
+        std::span<std::byte> vertices(batch.data.vertices.data() + vertex_offset,
+                                      source.size());
+        std::memcpy(vertices.data(), source.data(), source.size());
+
+        batch_range range;
+        range.first_index = static_cast<std::uint32_t>(batch.data.indexes.size());
+        range.index_count = item.mesh->index_count();
+        range.bounds =
+            transform_attribute(vertices, stride, position->offset,
+                                std::min(position->size, 3), item.transform,
+                                1.0F);
+
+        if(normal != nullptr)
+        {
+            transform_attribute(vertices, stride, normal->offset, 3,
+                                item.transform, 0.0F);
+            normalize_attribute(vertices, stride, normal->offset);
+        }
+
+        const auto base = static_cast<unsigned>(vertex_offset / stride);
+
+        for(auto index : item.mesh->indexes())
+            batch.data.indexes.push_back(index + base);
+
+        batch.bounds.merge(range.bounds);
+        batch.ranges.push_back(range);
+
+        vertex_offset += source.size();
+    }
+
+    return batch;
+}
+
+static_batch::static_batch(const batch_data& data)
+    : mesh_(std::span<const std::byte>(data.data.vertices),
+            data.data.indexes,
+            layout_registry::instance().intern(data.data.attributes),
+            data.data.primitive)
+    , ranges_(data.ranges)
+    , bounds_(data.bounds)
+{
+}
+
+static_batch::static_batch(std::span<const batch_item> items,
+                           int                         normal_location)
+    : static_batch(build_static_batch(items, normal_location))
+{
+}
+
+}    // namespace corgi
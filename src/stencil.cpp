@@ -12,9 +12,10 @@ namespace corgi
             case stencil_operation::replace:
                 return  GL_REPLACE;
         }
+        return GL_KEEP;
     }
 
-	void stencil::apply(stencil previous)
+	void stencil::apply(stencil previous) const
 	{
         if (enable_stencil != previous.enable_stencil)
             enable_stencil? glEnable(GL_STENCIL_TEST) : glDisable(GL_STENCIL_TEST);
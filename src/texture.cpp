@@ -1,11 +1,33 @@
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/memory_tracker.h>
 #include <corgi/opengl/texture.h>
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <bit>
 #include <filesystem>
 #include <iostream>
 
 using namespace corgi;
 
+// A recycled texture already has storage of the right format and size, only
+// its pixels are updated
+static void specify_storage(bool        has_storage,
+                            GLint       internal_format,
+                            GLsizei     width,
+                            GLsizei     height,
+                            GLenum      format,
+                            GLenum      type,
+                            const void* data)
+{
+    if(!has_storage)
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+                     format, type, data);
+    else if(data != nullptr)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type,
+                        data);
+}
+
 #define check_gl_error()                                                       \
     {                                                                          \
         GLenum result;                                                         \
@@ -51,9 +73,11 @@ texture::texture(create_info info)
     , height_(info.height)
     , data_(info.data)
 {
-    // Generate the new texture
+    // Get a texture name, recycled ones already have the right storage
     glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &id_);
+    const auto name = gl_name_pool::instance().acquire_texture(
+        internal_format_, width_, height_, level_count());
+    id_ = name.id;
     // We bind the texture
     glBindTexture(GL_TEXTURE_2D, id_);
     // check_gl_error();
@@ -201,53 +225,7 @@ texture::texture(create_info info)
             break;
     }
     // check_gl_error();
-    switch(internal_format_)
-    {
-        case corgi::internal_format::depth_component:
-            internal_format = GL_DEPTH_COMPONENT;
-            break;
-        case corgi::internal_format::depth_stencil:
-            internal_format = GL_DEPTH_STENCIL;
-            break;
-        case corgi::internal_format::red:
-            internal_format = GL_RED;
-            break;
-        case corgi::internal_format::rg:
-            internal_format = GL_RG;
-            break;
-        case corgi::internal_format::rgb:
-            internal_format = GL_RGB;
-            break;
-        case corgi::internal_format::rgba:
-            internal_format = GL_RGBA;
-            break;
-        case corgi::internal_format::r8:
-            internal_format = GL_R8;
-            break;
-        case corgi::internal_format::r16:
-            internal_format = GL_R16;
-            break;
-        case corgi::internal_format::rg8:
-            internal_format = GL_RG8;
-            break;
-        case corgi::internal_format::rg16:
-            internal_format = GL_RG16;
-            break;
-        case corgi::internal_format::rg32_f:
-            internal_format = GL_RG32F;
-            break;
-        case corgi::internal_format::rg32_i:
-            internal_format = GL_RG32I;
-            break;
-        case corgi::internal_format::rg32_ui:
-            internal_format = GL_RG32UI;
-            break;
-        case corgi::internal_format::depth24_stencil8:
-            internal_format = GL_DEPTH24_STENCIL8;
-            break;
-        default:
-            break;
-    }
+    internal_format = static_cast<GLint>(to_gl(internal_format_));
     // check_gl_error();
     switch(data_type_)
     {
@@ -282,24 +260,14 @@ texture::texture(create_info info)
     }
     // check_gl_error();
 
-    int max_size;
-
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
-    std::cout << (max_size) << std::endl;
-
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,                  // Level
-                 internal_format,    // Internal format
-                 width_, height_,
-                 0,         // Border
-                 format,    // format
-                 t,         // type
-                 data_      // data
-    );
+    specify_storage(name.has_storage, internal_format, width_, height_, format,
+                    t, data_);
 
     // check_gl_error();
     glBindTexture(GL_TEXTURE_2D, 0);
     glDisable(GL_TEXTURE_2D);
+
+    track_memory();
 }
 
 texture::texture()
@@ -389,6 +357,10 @@ texture::texture(texture&& texture) noexcept
     , wrap_t_(texture.wrap_t_)
     , width_(texture.width_)
     , height_(texture.height_)
+    , format_(texture.format_)
+    , internal_format_(texture.internal_format_)
+    , data_type_(texture.data_type_)
+    , data_(texture.data_)
 {
     // log_info("texture Move Constructor for "+ name_);
 
@@ -406,7 +378,11 @@ texture& texture::operator=(texture&& texture) noexcept
     // log_info("Move Affectation texture for "+ name_);
 
     if(id_ != 0)
-        glDeleteTextures(1, &id_);
+    {
+        memory_tracker::instance().untrack(resource_type::texture, id_);
+        gl_name_pool::instance().release_texture(
+            id_, internal_format_, width_, height_, level_count());
+    }
 
     name_       = std::move(texture.name_);
     id_         = texture.id_;
@@ -417,6 +393,11 @@ texture& texture::operator=(texture&& texture) noexcept
     width_      = texture.width_;
     height_     = texture.height_;
 
+    format_          = texture.format_;
+    internal_format_ = texture.internal_format_;
+    data_type_       = texture.data_type_;
+    data_            = texture.data_;
+
     texture.id_         = 0u;
     texture.width_      = static_cast<unsigned short>(0);
     texture.height_     = static_cast<unsigned short>(0);
@@ -428,17 +409,17 @@ texture& texture::operator=(texture&& texture) noexcept
     return *this;
 }
 
-texture::texture(const std::string& name,
-                 unsigned           width,
-                 unsigned           height,
-                 corgi::min_filter  min_f,
-                 corgi::mag_filter  mag_f,
-                 wrap               wrap_s,
-                 wrap               wrap_t,
-                 format             format,
-                 internal_format    internal_format,
-                 data_type          dt,
-                 unsigned char*     data)
+texture::texture(const std::string&     name,
+                 unsigned               width,
+                 unsigned               height,
+                 corgi::min_filter      min_f,
+                 corgi::mag_filter      mag_f,
+                 wrap                   wrap_s,
+                 wrap                   wrap_t,
+                 format                 format,
+                 corgi::internal_format internal_format,
+                 data_type              dt,
+                 unsigned char*         data)
     : name_(name)
     , min_filter_(min_f)
     , mag_filter_(mag_f)
@@ -452,11 +433,13 @@ texture::texture(const std::string& name,
     , data_(data)
 {
 
-    glGenTextures(1, &id_);
+    const auto pooled = gl_name_pool::instance().acquire_texture(
+        internal_format_, width_, height_, level_count());
+    id_ = pooled.id;
 
     bind();
 
-    generate_opengl_texture();
+    generate_opengl_texture(pooled.has_storage);
 
     update_gl_mag_filter();
     update_gl_min_filter();
@@ -464,6 +447,8 @@ texture::texture(const std::string& name,
     update_gl_wrap_t();
 
     unbind();
+
+    track_memory();
 }
 
 void texture::unbind() const
@@ -483,7 +468,7 @@ void texture::bind() const
     glBindTexture(GL_TEXTURE_2D, id_);
 }
 
-void texture::generate_opengl_texture()
+void texture::generate_opengl_texture(bool has_storage)
 {
     GLenum format {GL_RGBA};
     GLint  internal_format {GL_RGBA};
@@ -541,53 +526,7 @@ void texture::generate_opengl_texture()
             break;
     }
 
-    switch(internal_format_)
-    {
-        case corgi::internal_format::depth_component:
-            internal_format = GL_DEPTH_COMPONENT;
-            break;
-        case corgi::internal_format::depth_stencil:
-            internal_format = GL_DEPTH_STENCIL;
-            break;
-        case corgi::internal_format::red:
-            internal_format = GL_RED;
-            break;
-        case corgi::internal_format::rg:
-            internal_format = GL_RG;
-            break;
-        case corgi::internal_format::rgb:
-            internal_format = GL_RGB;
-            break;
-        case corgi::internal_format::rgba:
-            internal_format = GL_RGBA;
-            break;
-        case corgi::internal_format::r8:
-            internal_format = GL_R8;
-            break;
-        case corgi::internal_format::r16:
-            internal_format = GL_R16;
-            break;
-        case corgi::internal_format::rg8:
-            internal_format = GL_RG8;
-            break;
-        case corgi::internal_format::rg16:
-            internal_format = GL_RG16;
-            break;
-        case corgi::internal_format::rg32_f:
-            internal_format = GL_RG32F;
-            break;
-        case corgi::internal_format::rg32_i:
-            internal_format = GL_RG32I;
-            break;
-        case corgi::internal_format::rg32_ui:
-            internal_format = GL_RG32UI;
-            break;
-        case corgi::internal_format::depth24_stencil8:
-            internal_format = GL_DEPTH24_STENCIL8;
-            break;
-        default:
-            break;
-    }
+    internal_format = static_cast<GLint>(to_gl(internal_format_));
 
     switch(data_type_)
     {
@@ -620,17 +559,16 @@ void texture::generate_opengl_texture()
         default:
             break;
     }
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,    // Level
-                 internal_format, width_, height_,
-                 0,    // Border
-                 format, data_type_gl, data_);
+    specify_storage(has_storage, internal_format, width_, height_, format,
+                    data_type_gl, data_);
 }
 
 texture::~texture()
 {
     // log_info("texture Destructor for "+name_);
-    glDeleteTextures(1, &id_);
+    memory_tracker::instance().untrack(resource_type::texture, id_);
+    gl_name_pool::instance().release_texture(id_, internal_format_, width_,
+                                             height_, level_count());
 }
 
 bool texture::operator==(const texture& other) const noexcept
@@ -840,6 +778,132 @@ unsigned texture::height() const noexcept
     return height_;
 }
 
+corgi::internal_format texture::internal_format() const noexcept
+{
+    return internal_format_;
+}
+
+unsigned texture::level_count() const noexcept
+{
+    switch(min_filter_)
+    {
+        case corgi::min_filter::nearest_mipmap_nearest:
+        case corgi::min_filter::nearest_mipmap_linear:
+        case corgi::min_filter::linear_mipmap_linear:
+        case corgi::min_filter::linear_mipmap_nearest:
+            return mipmap_level_count(width_, height_);
+        default:
+            return 1;
+    }
+}
+
+std::size_t texture::size_in_bytes() const noexcept
+{
+    return texture_size_in_bytes(internal_format_, width_, height_,
+                                 level_count());
+}
+
+void texture::track_memory() const
+{
+    auto& tracker = memory_tracker::instance();
+    tracker.track(resource_type::texture, id_, size_in_bytes());
+
+    if(!name_.empty())
+        tracker.set_tag(resource_type::texture, id_, name_);
+}
+
+unsigned corgi::to_gl(internal_format format) noexcept
+{
+    switch(format)
+    {
+        case internal_format::depth_component:
+            return GL_DEPTH_COMPONENT;
+        case internal_format::depth_stencil:
+            return GL_DEPTH_STENCIL;
+        case internal_format::red:
+            return GL_RED;
+        case internal_format::rg:
+            return GL_RG;
+        case internal_format::rgb:
+            return GL_RGB;
+        case internal_format::rgba:
+            return GL_RGBA;
+        case internal_format::r8:
+            return GL_R8;
+        case internal_format::r16:
+            return GL_R16;
+        case internal_format::rg8:
+            return GL_RG8;
+        case internal_format::rg16:
+            return GL_RG16;
+        case internal_format::rg32_f:
+            return GL_RG32F;
+        case internal_format::rg32_i:
+            return GL_RG32I;
+        case internal_format::rg32_ui:
+            return GL_RG32UI;
+        case internal_format::depth24_stencil8:
+            return GL_DEPTH24_STENCIL8;
+        case internal_format::rgba8:
+            return GL_RGBA8;
+        case internal_format::rgba16_f:
+            return GL_RGBA16F;
+        case internal_format::depth_component24:
+            return GL_DEPTH_COMPONENT24;
+    }
+    return GL_RGBA;
+}
+
+std::size_t corgi::bytes_per_texel(internal_format format) noexcept
+{
+    switch(format)
+    {
+        case internal_format::red:
+        case internal_format::r8:
+            return 1;
+        case internal_format::rg:
+        case internal_format::rg8:
+        case internal_format::r16:
+            return 2;
+        case internal_format::rgb:
+        case internal_format::rgba:
+        case internal_format::rg16:
+        case internal_format::depth_component:
+        case internal_format::depth_stencil:
+        case internal_format::depth24_stencil8:
+        case internal_format::rgba8:
+        case internal_format::depth_component24:
+            return 4;
+        case internal_format::rg32_f:
+        case internal_format::rg32_i:
+        case internal_format::rg32_ui:
+        case internal_format::rgba16_f:
+            return 8;
+    }
+    return 4;
+}
+
+unsigned corgi::mipmap_level_count(unsigned width, unsigned height) noexcept
+{
+    return static_cast<unsigned>(std::bit_width(std::max({width, height, 1u})));
+}
+
+std::size_t corgi::texture_size_in_bytes(internal_format format,
+                                         unsigned        width,
+                                         unsigned        height,
+                                         unsigned        levels) noexcept
+{
+    std::size_t texels = 0;
+
+    for(unsigned level = 0; level < levels; level++)
+    {
+        texels += static_cast<std::size_t>(width) * height;
+        width  = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return texels * bytes_per_texel(format);
+}
+
 void texture::width(unsigned width) noexcept
 {
     width_ = width;
@@ -0,0 +1,407 @@
+#include <corgi/opengl/memory_tracker.h>
+#include <corgi/opengl/texture_streamer.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace corgi
+{
+
+static bool uses_mipmaps(min_filter filter)
+{
+    return filter != min_filter::nearest && filter != min_filter::linear;
+}
+
+texture_streamer::texture_streamer(thread_pool& pool,
+                                   std::size_t  ring_size,
+                                   std::size_t  frame_budget)
+    : pool_(pool)
+    , decoded_(std::make_shared<decoded_queue>())
+    , ring_size_(ring_size)
+    , frame_budget_(frame_budget)
+{
+    if(ring_size == 0)
+        throw std::invalid_argument(
+            "texture_streamer::texture_streamer : Ring can't be empty");
+
+    if(frame_budget == 0)
+        throw std::invalid_argument(
+            "texture_streamer::texture_streamer : Frame budget can't be 0");
+
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &ring_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER,
+                    static_cast<GLsizeiptr>(ring_size), nullptr, flags);
+
+    // Stays mapped while the GPU reads from it, writes only have to stay
+    // away from the parts still in flight
+    mapped_ = static_cast<unsigned char*>(glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(ring_size), flags));
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(mapped_ == nullptr)
+    {
+        glDeleteBuffers(1, &ring_);
+        throw std::runtime_error(
+            "texture_streamer::texture_streamer : Could not map the pixel "
+            "unpack buffer");
+    }
+
+    memory_tracker::instance().track(resource_type::pixel_buffer, ring_,
+                                     ring_size);
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    max_texture_size_ = max_size;
+}
+
+texture_streamer::~texture_streamer()
+{
+    for(auto& f : in_flight_)
+        glDeleteSync(static_cast<GLsync>(f.fence));
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    memory_tracker::instance().untrack(resource_type::pixel_buffer, ring_);
+    glDeleteBuffers(1, &ring_);
+}
+
+texture_streamer::handle texture_streamer::load(const std::string& path,
+                                                stream_settings    settings)
+{
+    const auto h = next_handle_++;
+
+    entry e;
+    e.settings = settings;
+    entries_.emplace(h, std::move(e));
+
+    // The job only holds the queue, the streamer may be gone when it ends
+    pool_.submit(
+        [queue = decoded_, path, h]()
+        {
+            try
+            {
+                auto pixels = image::load(path);
+
+                std::scoped_lock lock(queue->mutex);
+                queue->images.emplace_back(h, std::move(pixels));
+            }
+            catch(const std::exception&)
+            {
+                std::scoped_lock lock(queue->mutex);
+                queue->failures.push_back(h);
+            }
+        });
+
+    return h;
+}
+
+texture_streamer::handle texture_streamer::load(image           pixels,
+                                                stream_settings settings)
+{
+    if(pixels.width <= 0 || pixels.height <= 0 || pixels.data.empty())
+        throw std::invalid_argument(
+            "texture_streamer::load : Image can't be empty");
+
+    if(pixels.channels != 4)
+        throw std::invalid_argument(
+            "texture_streamer::load : Image must have 4 channels");
+
+    const auto h = next_handle_++;
+
+    entry e;
+    e.state    = stream_state::uploading;
+    e.settings = settings;
+    e.pixels   = std::move(pixels);
+    entries_.emplace(h, std::move(e));
+    uploads_.push_back(h);
+
+    return h;
+}
+
+void texture_streamer::retire()
+{
+    while(!in_flight_.empty())
+    {
+        auto fence = static_cast<GLsync>(in_flight_.front().fence);
+
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(fence, GL_SYNC_STATUS, sizeof(status), nullptr, &status);
+
+        if(status != GL_SIGNALED)
+            break;
+
+        glDeleteSync(fence);
+        in_flight_.pop_front();
+    }
+
+    // Nothing left in flight, the next upload starts at the beginning
+    if(in_flight_.empty())
+        head_ = 0;
+}
+
+void texture_streamer::collect()
+{
+    std::vector<std::pair<handle, image>> images;
+    std::vector<handle>                   failures;
+
+    {
+        std::scoped_lock lock(decoded_->mutex);
+        images.swap(decoded_->images);
+        failures.swap(decoded_->failures);
+    }
+
+    for(auto& [h, pixels] : images)
+    {
+        auto it = entries_.find(h);
+
+        // Released while it was decoding
+        if(it == entries_.end())
+            continue;
+
+        it->second.state  = stream_state::uploading;
+        it->second.pixels = std::move(pixels);
+        uploads_.push_back(h);
+    }
+
+    for(auto h : failures)
+        if(auto it = entries_.find(h); it != entries_.end())
+            it->second.state = stream_state::failed;
+}
+
+std::size_t texture_streamer::free_block(std::size_t& offset) const
+{
+    if(in_flight_.empty() && !batch_used_)
+    {
+        offset = 0;
+        return ring_size_;
+    }
+
+    const auto tail =
+        in_flight_.empty() ? batch_begin_ : in_flight_.front().begin;
+
+    // Free space is split between the end and the start of the ring, the
+    // larger part is used
+    if(head_ > tail)
+    {
+        if(ring_size_ - head_ >= tail)
+        {
+            offset = head_;
+            return ring_size_ - head_;
+        }
+
+        offset = 0;
+        return tail;
+    }
+
+    offset = head_;
+    return head_ < tail ? tail - head_ : 0;
+}
+
+bool texture_streamer::upload(entry& e, std::size_t& budget)
+{
+    const auto row_bytes = static_cast<std::size_t>(e.pixels.width) * 4;
+    const int  rows_left = e.pixels.height - e.next_row;
+
+    std::size_t offset = 0;
+    const auto  block  = free_block(offset);
+
+    // At least one row is sent each frame, even with a budget too small for
+    // it, so large images still get through
+    auto rows = std::min<std::size_t>(
+        {static_cast<std::size_t>(rows_left), block / row_bytes,
+         std::max<std::size_t>(budget / row_bytes,
+                               uploaded_bytes_ == 0 ? 1 : 0)});
+
+    if(rows == 0)
+        return false;
+
+    const auto bytes = rows * row_bytes;
+
+    std::memcpy(mapped_ + offset,
+                e.pixels.data.data() +
+                    static_cast<std::size_t>(e.next_row) * row_bytes,
+                bytes);
+
+    head_       = offset + bytes;
+    batch_used_ = true;
+
+    glBindTexture(GL_TEXTURE_2D, e.gpu->id());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, e.next_row, e.pixels.width,
+                    static_cast<GLsizei>(rows), GL_RGBA, GL_UNSIGNED_BYTE,
+                    reinterpret_cast<const void*>(offset));
+
+    e.next_row += static_cast<int>(rows);
+    budget -= std::min(budget, bytes);
+    uploaded_bytes_ += bytes;
+
+    return true;
+}
+
+void texture_streamer::update()
+{
+    retire();
+    collect();
+
+    uploaded_bytes_ = 0;
+    batch_begin_    = head_;
+    batch_used_     = false;
+
+    std::size_t budget = frame_budget_;
+    bool        bound  = false;
+
+    while(!uploads_.empty() && (budget > 0 || uploaded_bytes_ == 0))
+    {
+        auto it = entries_.find(uploads_.front());
+
+        if(it == entries_.end())
+        {
+            uploads_.pop_front();
+            continue;
+        }
+
+        auto& e = it->second;
+
+        if(!e.gpu)
+        {
+            if(static_cast<std::size_t>(e.pixels.width) * 4 > ring_size_ ||
+               e.pixels.width > max_texture_size_ ||
+               e.pixels.height > max_texture_size_)
+            {
+                e.state  = stream_state::failed;
+                e.pixels = {};
+                uploads_.pop_front();
+                continue;
+            }
+
+            // Created before binding the ring, otherwise the texture would
+            // take its first pixels from it
+            if(bound)
+            {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                bound = false;
+            }
+
+            create_info info;
+            info.min_filter      = e.settings.min;
+            info.mag_filter      = e.settings.mag;
+            info.wrap_s          = e.settings.wrap_s;
+            info.wrap_t          = e.settings.wrap_t;
+            info.internal_format = internal_format::rgba8;
+            info.format          = format::rgba;
+            info.width           = e.pixels.width;
+            info.height          = e.pixels.height;
+            info.data            = nullptr;
+
+            e.gpu = std::make_unique<texture>(info);
+        }
+
+        if(!bound)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            bound = true;
+        }
+
+        // The ring is full until the GPU is done with older uploads
+        if(!upload(e, budget))
+            break;
+
+        if(e.next_row < e.pixels.height)
+            continue;
+
+        if(uses_mipmaps(e.settings.min))
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+        e.state  = stream_state::resident;
+        e.pixels = {};
+        uploads_.pop_front();
+    }
+
+    if(bound)
+    {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    if(batch_used_)
+    {
+        in_flight_.push_back(
+            {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), batch_begin_});
+        batch_used_ = false;
+
+        // Makes sure the fence reaches the GPU, otherwise polling it could
+        // never succeed
+        glFlush();
+    }
+}
+
+const texture_streamer::entry&
+texture_streamer::find(handle texture, const char* function) const
+{
+    auto it = entries_.find(texture);
+
+    if(it == entries_.end())
+        throw std::out_of_range(std::string("texture_streamer::") + function +
+                                " : Unknown texture");
+
+    return it->second;
+}
+
+stream_state texture_streamer::state(handle texture) const
+{
+    return find(texture, "state").state;
+}
+
+bool texture_streamer::resident(handle texture) const
+{
+    return state(texture) == stream_state::resident;
+}
+
+const texture& texture_streamer::get(handle texture) const
+{
+    const auto& e = find(texture, "get");
+
+    if(e.state != stream_state::resident)
+        throw std::logic_error(
+            "texture_streamer::get : Texture isn't resident yet");
+
+    return *e.gpu;
+}
+
+void texture_streamer::release(handle texture)
+{
+    find(texture, "release");
+    entries_.erase(texture);
+}
+
+std::size_t texture_streamer::pending() const noexcept
+{
+    return static_cast<std::size_t>(std::count_if(
+        entries_.begin(), entries_.end(),
+        [](const auto& pair)
+        {
+            return pair.second.state == stream_state::decoding ||
+                   pair.second.state == stream_state::uploading;
+        }));
+}
+
+void texture_streamer::frame_budget(std::size_t budget)
+{
+    if(budget == 0)
+        throw std::invalid_argument(
+            "texture_streamer::frame_budget : Budget can't be 0");
+
+    frame_budget_ = budget;
+}
+
+}    // namespace corgi
@@ -0,0 +1,123 @@
+#include <corgi/opengl/thread_pool.h>
+
+#include <algorithm>
+
+namespace corgi
+{
+
+std::size_t thread_pool::default_thread_count()
+{
+    const auto hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+thread_pool::thread_pool(std::size_t threads)
+{
+    workers_.reserve(threads);
+    for(std::size_t i = 0; i < threads; i++)
+        workers_.emplace_back(&thread_pool::run, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for(auto& worker : workers_)
+        worker.join();
+}
+
+void thread_pool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(std::move(job));
+    }
+    work_available_.notify_one();
+}
+
+void thread_pool::wait()
+{
+    std::unique_lock lock(mutex_);
+    work_done_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+}
+
+void thread_pool::parallel_for(std::size_t           count,
+                               std::size_t           min_chunk,
+                               const chunk_function& body)
+{
+    if(count == 0)
+        return;
+
+    min_chunk = std::max<std::size_t>(min_chunk, 1);
+
+    const auto chunks =
+        std::min(max_chunks(), (count + min_chunk - 1) / min_chunk);
+
+    if(chunks == 1)
+    {
+        body(0, count, 0);
+        return;
+    }
+
+    const auto chunk_size = (count + chunks - 1) / chunks;
+
+    // Counts the chunks still running on the workers. Waiting on it rather
+    // than on wait() lets other jobs run in the pool meanwhile
+    std::mutex              mutex;
+    std::condition_variable done;
+    std::size_t             remaining = chunks - 1;
+
+    for(std::size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        const auto begin = std::min(count, chunk * chunk_size);
+        const auto end   = std::min(count, begin + chunk_size);
+
+        submit(
+            [&, begin, end, chunk]()
+            {
+                body(begin, end, chunk);
+
+                std::lock_guard lock(mutex);
+                if(--remaining == 0)
+                    done.notify_one();
+            });
+    }
+
+    // The calling thread takes the first chunk instead of idling
+    body(0, std::min(count, chunk_size), 0);
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return remaining == 0; });
+}
+
+void thread_pool::run()
+{
+    std::unique_lock lock(mutex_);
+
+    while(true)
+    {
+        work_available_.wait(lock,
+                             [this] { return stopping_ || !queue_.empty(); });
+
+        if(queue_.empty())
+            return;
+
+        auto job = std::move(queue_.front());
+        queue_.pop_front();
+        running_++;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        running_--;
+        if(queue_.empty() && running_ == 0)
+            work_done_.notify_all();
+    }
+}
+
+}    // namespace corgi
@@ -1,18 +1,98 @@
+#include <corgi/opengl/gl_name_pool.h>
 #include <corgi/opengl/vertex_array.h>
 #include <glad/glad.h>
 
 namespace corgi
 {
 
-vertex_array::vertex_array(
-    std::vector<vertex_attribute>                        vertex_attributes,
-    buffer<float, buffer_type::array_buffer>&            vertex_buffer,
-    buffer<unsigned, buffer_type::element_array_buffer>& index_buffer)
-    : vertex_buffer_(&vertex_buffer)
-    , index_buffer_(&index_buffer)
-    , vertex_attributes_(std::move(vertex_attributes))
+static GLenum to_gl(attribute_type type)
 {
-    push_data();
+    switch(type)
+    {
+        case attribute_type::float32:
+            return GL_FLOAT;
+        case attribute_type::float16:
+            return GL_HALF_FLOAT;
+        case attribute_type::int8:
+            return GL_BYTE;
+        case attribute_type::uint8:
+            return GL_UNSIGNED_BYTE;
+        case attribute_type::int16:
+            return GL_SHORT;
+        case attribute_type::uint16:
+            return GL_UNSIGNED_SHORT;
+        case attribute_type::int32:
+            return GL_INT;
+        case attribute_type::uint32:
+            return GL_UNSIGNED_INT;
+        case attribute_type::int_2_10_10_10_rev:
+            return GL_INT_2_10_10_10_REV;
+        case attribute_type::uint_2_10_10_10_rev:
+            return GL_UNSIGNED_INT_2_10_10_10_REV;
+    }
+    return GL_FLOAT;
+}
+
+static void disable_unused(const std::vector<vertex_attribute>& attributes,
+                           std::uint32_t enabled_attributes)
+{
+    const auto unused = enabled_attributes & ~attributes_locations(attributes);
+
+    for(unsigned location = 0; location < 32; location++)
+        if(unused & (1u << location))
+            glDisableVertexAttribArray(location);
+}
+
+void set_vertex_formats(const std::vector<vertex_attribute>& attributes,
+                        unsigned                             binding,
+                        std::uint32_t                        enabled_attributes)
+{
+    disable_unused(attributes, enabled_attributes);
+
+    for(const auto& attribute : attributes)
+    {
+        glEnableVertexAttribArray(attribute.location);
+
+        if(attribute.mode == attribute_mode::integer)
+            glVertexAttribIFormat(attribute.location, attribute.size,
+                                  to_gl(attribute.type), attribute.offset);
+        else
+            glVertexAttribFormat(
+                attribute.location, attribute.size, to_gl(attribute.type),
+                attribute.mode == attribute_mode::normalized ? GL_TRUE
+                                                             : GL_FALSE,
+                attribute.offset);
+
+        glVertexAttribBinding(attribute.location, binding);
+    }
+}
+
+void set_vertex_attributes(const std::vector<vertex_attribute>& attributes,
+                           std::uint32_t enabled_attributes)
+{
+    disable_unused(attributes, enabled_attributes);
+
+    const auto stride = static_cast<GLsizei>(attributes_stride(attributes));
+
+    for(const auto& attribute : attributes)
+    {
+        glEnableVertexAttribArray(attribute.location);
+
+        const auto offset = reinterpret_cast<const void*>(
+            static_cast<std::uintptr_t>(attribute.offset));
+
+        // Integer attributes would be converted to float by
+        // glVertexAttribPointer
+        if(attribute.mode == attribute_mode::integer)
+            glVertexAttribIPointer(attribute.location, attribute.size,
+                                   to_gl(attribute.type), stride, offset);
+        else
+            glVertexAttribPointer(
+                attribute.location, attribute.size, to_gl(attribute.type),
+                attribute.mode == attribute_mode::normalized ? GL_TRUE
+                                                             : GL_FALSE,
+                stride, offset);
+    }
 }
 
 vertex_array::vertex_array(const vertex_array& other)
@@ -20,7 +100,8 @@ vertex_array::vertex_array(const vertex_array& other)
     , index_buffer_(other.index_buffer_)
     , vertex_attributes_(other.vertex_attributes_)
 {
-    push_data();
+    if(other.id_ != 0)
+        push_data();
 }
 
 vertex_array& vertex_array::operator=(vertex_array&& other) noexcept
@@ -32,6 +113,8 @@ vertex_array& vertex_array::operator=(vertex_array&& other) noexcept
     index_buffer_      = other.index_buffer_;
     vertex_attributes_ = other.vertex_attributes_;
 
+    // The name now belongs to this vertex array
+    other.id_ = 0;
     other.clear();
     return *this;
 }
@@ -44,22 +127,22 @@ vertex_array& vertex_array::operator=(const vertex_array& other)
     index_buffer_      = other.index_buffer_;
     vertex_attributes_ = other.vertex_attributes_;
 
-    push_data();
+    if(other.id_ != 0)
+        push_data();
     return *this;
 }
 
-void vertex_array::set(
-    buffer<float, buffer_type::array_buffer>&           vertex_buffer,
-    buffer<unsigned, buffer_type::element_array_buffer> index_buffer,
-    std::vector<vertex_attribute>                       attributes)
+void vertex_array::set(unsigned                      vertex_buffer,
+                       unsigned                      index_buffer,
+                       std::vector<vertex_attribute> attributes)
 {
     // I'm not sure how glBindVertexArray works so for now
     // I'll go with "delete and recreate another id" if needed
 
     clear();
 
-    vertex_buffer_     = &vertex_buffer;
-    index_buffer_      = &index_buffer;
+    vertex_buffer_     = vertex_buffer;
+    index_buffer_      = index_buffer;
     vertex_attributes_ = std::move(attributes);
 
     push_data();
@@ -71,6 +154,7 @@ vertex_array::vertex_array(vertex_array&& other) noexcept
     , index_buffer_(other.index_buffer_)
     , vertex_attributes_(std::move(other.vertex_attributes_))
 {
+    other.id_ = 0;
     other.clear();
 }
 
@@ -94,9 +178,10 @@ void vertex_array::bind() const
 
 void vertex_array::clear()
 {
-    glDeleteVertexArrays(1, &id_);
-    vertex_buffer_ = nullptr;
-    index_buffer_  = nullptr;
+    gl_name_pool::instance().release_vertex_array(
+        id_, attributes_locations(vertex_attributes_));
+    vertex_buffer_ = 0;
+    index_buffer_  = 0;
     vertex_attributes_.clear();
     id_ = 0;
 }
@@ -113,11 +198,11 @@ unsigned corgi::vertex_array::id() const
 
 void vertex_array::push_data()
 {
-    if(vertex_buffer_->empty())
+    if(vertex_buffer_ == 0)
         throw std::invalid_argument(
             "vertex_array::set : vertex_buffer in empty state");
 
-    if(index_buffer_->empty())
+    if(index_buffer_ == 0)
         throw std::invalid_argument(
             "vertex_array::set : index_buffer in empty state");
 
@@ -125,24 +210,18 @@ void vertex_array::push_data()
         throw std::invalid_argument(
             "vertex_array::set : attributes vector is empty");
 
-    glGenVertexArrays(1, &id_);
+    const auto name = gl_name_pool::instance().acquire_vertex_array();
+    id_             = name.id;
 
     if(id_ == 0)
         throw std::logic_error(
             "vertex_array::set : generated vertex_array id equals 0");
     bind();
-    vertex_buffer_->bind();
-    index_buffer_->bind();
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
 
-    for(const auto& attribute : vertex_attributes_)
-    {
-        glEnableVertexAttribArray(attribute.location);
-
-        glVertexAttribPointer(
-            attribute.location, attribute.size, GL_FLOAT, GL_FALSE,
-            attributes_total_size(vertex_attributes_) * sizeof(float),
-            (void*)(attribute.offset * sizeof(GL_FLOAT)));
-    }
+    // A recycled vertex array may have attributes we don't use enabled
+    set_vertex_attributes(vertex_attributes_, name.enabled_attributes);
 
     glBindVertexArray(0);
 
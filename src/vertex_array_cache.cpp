@@ -0,0 +1,88 @@
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/vertex_array.h>
+#include <corgi/opengl/vertex_array_cache.h>
+#include <glad/glad.h>
+
+#include <stdexcept>
+
+namespace corgi
+{
+
+vertex_array_cache::~vertex_array_cache()
+{
+    clear();
+}
+
+const vertex_array_cache::entry& vertex_array_cache::get(layout_id layout)
+{
+    if(layout < vertex_arrays_.size() && vertex_arrays_[layout].id != 0)
+        return vertex_arrays_[layout];
+
+    const auto& attributes = layout_registry::instance().attributes(layout);
+
+    const auto name = gl_name_pool::instance().acquire_vertex_array();
+
+    if(name.id == 0)
+        throw std::logic_error(
+            "vertex_array_cache::vertex_array : Couldn't generate a vertex "
+            "array");
+
+    glBindVertexArray(name.id);
+
+    // A recycled vertex array may have attributes we don't use enabled
+    set_vertex_formats(attributes, 0, name.enabled_attributes);
+
+    if(layout >= vertex_arrays_.size())
+        vertex_arrays_.resize(layout + 1);
+
+    vertex_arrays_[layout] = {name.id, attributes_stride(attributes)};
+    size_++;
+
+    return vertex_arrays_[layout];
+}
+
+unsigned vertex_array_cache::vertex_array(layout_id layout)
+{
+    return get(layout).id;
+}
+
+void vertex_array_cache::bind(layout_id layout,
+                              unsigned  vertex_buffer,
+                              unsigned  index_buffer)
+{
+    const auto& e = get(layout);
+
+    glBindVertexArray(e.id);
+
+    // Buffer names may have been deleted and generated again since the last
+    // time, so they are always attached again. It's 2 calls, the attributes'
+    // format doesn't change
+    glBindVertexBuffer(0, vertex_buffer, 0, e.stride);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+}
+
+std::size_t vertex_array_cache::size() const noexcept
+{
+    return size_;
+}
+
+void vertex_array_cache::clear()
+{
+    auto& pool     = gl_name_pool::instance();
+    auto& registry = layout_registry::instance();
+
+    for(std::size_t layout = 0; layout < vertex_arrays_.size(); layout++)
+    {
+        const auto id = vertex_arrays_[layout].id;
+
+        if(id != 0)
+            pool.release_vertex_array(
+                id, attributes_locations(registry.attributes(
+                        static_cast<layout_id>(layout))));
+    }
+
+    vertex_arrays_.clear();
+    size_ = 0;
+}
+
+}    // namespace corgi
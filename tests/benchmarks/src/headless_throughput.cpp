@@ -0,0 +1,108 @@
+#include <corgi/opengl/headless_context.h>
+#include <corgi/opengl/renderer.h>
+#include <glad/glad.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace corgi;
+
+// Measures how many images per second can be rendered and read back without
+// any display, the way a thumbnail or chart server would do it
+
+struct resolution
+{
+    unsigned short width;
+    unsigned short height;
+};
+
+constexpr int warmup_images    = 5;
+constexpr int benchmark_images = 100;
+
+static void render_image(renderer& r, const resolution& res)
+{
+    r.clear();
+
+    // A few shapes so the rasterizer has something to do
+    for(int i = 0; i < 20; i++)
+    {
+        const float x = (i % 5 - 2) * res.width / 5.0F;
+        const float y = (i / 5 - 2) * res.height / 5.0F;
+
+        r.set_default_color(i / 20.0F, 0.5F, 1.0F - i / 20.0F);
+        r.draw_default_circle_on_screen(x, y, res.height / 12.0F);
+        r.draw_default_rect_on_screen(x, y, res.width / 20.0F,
+                                      res.height / 20.0F);
+    }
+}
+
+// Renders the images and returns the number of images per second
+template<class Read>
+static double measure(renderer& r, const resolution& res, Read read)
+{
+    for(int i = 0; i < warmup_images; i++)
+    {
+        render_image(r, res);
+        read();
+        r.end_frame();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < benchmark_images; i++)
+    {
+        render_image(r, res);
+        read();
+        r.end_frame();
+    }
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return benchmark_images / elapsed.count();
+}
+
+int main()
+{
+    const std::vector<resolution> resolutions {
+        {256, 256}, {512, 512}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+
+    std::cout << std::left << std::setw(14) << "resolution" << std::setw(16)
+              << "sync images/s" << "async images/s" << std::endl;
+
+    for(const auto& res : resolutions)
+    {
+        headless_context context(res.width, res.height);
+        renderer         r(res.width, res.height);
+
+        r.set_clear_color({0.2F, 0.2F, 0.2F, 1.0F});
+
+        // Reading the pixels back waits for the image to be done
+        const double sync = measure(r, res, [&] { context.read_pixels(); });
+
+        // The pixels of an image are taken while the next one renders
+        readback_ticket previous;
+
+        const double async = measure(r, res,
+                                     [&]
+                                     {
+                                         auto ticket = r.read_pixels_async(
+                                             {0, 0, res.width, res.height});
+                                         if(previous.valid())
+                                             previous.take();
+                                         previous = std::move(ticket);
+                                     });
+        previous.take();
+
+        std::cout << std::left << std::setw(14)
+                  << (std::to_string(res.width) + "x" +
+                      std::to_string(res.height))
+                  << std::setw(16) << std::fixed << std::setprecision(1)
+                  << sync << async << std::endl;
+    }
+
+    return 0;
+}
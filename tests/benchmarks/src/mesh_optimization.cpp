@@ -0,0 +1,97 @@
+#include <corgi/opengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <random>
+
+using namespace corgi;
+
+// Measures the vertex cache efficiency of meshes whose triangles arrive in a
+// random order, after each optimization pass. Doesn't need an OpenGL context
+
+static mesh_data build_sphere(unsigned rings, unsigned segments)
+{
+    mesh_data data;
+    data.attributes = {{0, 0, 3}};
+
+    std::vector<float> positions;
+
+    for(unsigned r = 0; r <= rings; r++)
+    {
+        const float phi = std::numbers::pi_v<float> * float(r) / float(rings);
+
+        for(unsigned s = 0; s <= segments; s++)
+        {
+            const float theta =
+                2.0F * std::numbers::pi_v<float> * float(s) / float(segments);
+
+            positions.insert(positions.end(),
+                             {std::sin(phi) * std::cos(theta), std::cos(phi),
+                              std::sin(phi) * std::sin(theta)});
+        }
+    }
+
+    data.vertices.resize(positions.size() * sizeof(float));
+    std::memcpy(data.vertices.data(), positions.data(), data.vertices.size());
+
+    std::vector<std::array<unsigned, 3>> triangles;
+
+    for(unsigned r = 0; r < rings; r++)
+        for(unsigned s = 0; s < segments; s++)
+        {
+            const unsigned v = r * (segments + 1) + s;
+            triangles.push_back({v, v + segments + 1, v + 1});
+            triangles.push_back({v + 1, v + segments + 1, v + segments + 2});
+        }
+
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+
+    for(const auto& t : triangles)
+        data.indexes.insert(data.indexes.end(), t.begin(), t.end());
+
+    return data;
+}
+
+static void print(const char* step, const mesh_data& data)
+{
+    const auto statistics =
+        mesh_optimizer::analyze_vertex_cache(data.indexes, data.vertex_count());
+
+    std::cout << "  " << std::left << std::setw(14) << step << " ACMR "
+              << statistics.acmr << "  ATVR " << statistics.atvr << std::endl;
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(3);
+
+    auto data = build_sphere(200, 400);
+
+    std::cout << "Sphere, " << data.indexes.size() / 3
+              << " triangles in random order, 16 entries FIFO cache"
+              << std::endl;
+
+    print("unoptimized", data);
+
+    const auto start = std::chrono::steady_clock::now();
+    mesh_optimizer::optimize_vertex_cache(data.indexes, data.vertex_count());
+    const std::chrono::duration<double, std::milli> cache_time =
+        std::chrono::steady_clock::now() - start;
+    print("vertex cache", data);
+
+    mesh_optimizer::optimize_overdraw(data.indexes,
+                                      mesh_optimizer::vertex_positions(data));
+    print("overdraw", data);
+
+    mesh_optimizer::optimize_vertex_fetch(data.vertices, data.indexes,
+                                          3 * sizeof(float));
+    print("vertex fetch", data);
+
+    std::cout << std::setprecision(1) << "  vertex cache pass : "
+              << cache_time.count() << " ms" << std::endl;
+}
@@ -0,0 +1,149 @@
+#include <corgi/opengl/culling.h>
+#include <corgi/opengl/occlusion_buffer.h>
+#include <corgi/opengl/primitives.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace corgi;
+
+// Measures the software occlusion pass on a dense scene : rows of buildings
+// hiding a hundred thousand small objects. Doesn't need an OpenGL context
+
+constexpr int repetitions = 20;
+
+// Perspective looking down -z, 90 degrees, near 1 and far 200
+static matrix4 projection()
+{
+    matrix4 m {};
+    m[0]  = 1.0F;
+    m[5]  = 1.0F;
+    m[10] = -201.0F / 199.0F;
+    m[11] = -1.0F;
+    m[14] = -400.0F / 199.0F;
+    return m;
+}
+
+struct scene
+{
+    std::vector<std::vector<float>>    positions;
+    std::vector<std::vector<unsigned>> indexes;
+    std::vector<occluder>              occluders;
+    cull_set                           objects;
+};
+
+static void build_scene(scene& s, const matrix4& view_projection)
+{
+    // Buildings in 3 rows, with gaps between them
+    for(int row = 0; row < 3; row++)
+        for(int column = -6; column < 6; column++)
+        {
+            const float z = -20.0F - 25.0F * row;
+            const float x = column * 12.0F + row * 4.0F;
+
+            s.positions.emplace_back();
+            s.indexes.emplace_back();
+            primitive::box_pos3({{x, -40.0F, z - 8.0F}, {x + 10.0F, 15.0F, z}},
+                                s.positions.back(), s.indexes.back());
+        }
+
+    for(std::size_t i = 0; i < s.positions.size(); i++)
+        s.occluders.push_back({s.positions[i], s.indexes[i], view_projection});
+
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> depth(-190.0F, -5.0F);
+    std::uniform_real_distribution<float> side(-1.0F, 1.0F);
+
+    for(int i = 0; i < 100000; i++)
+    {
+        const float z = depth(random);
+        const float x = side(random) * -z;
+        const float y = side(random) * -z * 0.5F;
+
+        s.objects.add(
+            {{x - 0.5F, y - 0.5F, z - 0.5F}, {x + 0.5F, y + 0.5F, z + 0.5F}});
+    }
+}
+
+template<class Function>
+static double milliseconds(Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < repetitions; i++)
+        function();
+
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / repetitions;
+}
+
+int main()
+{
+    const auto view_projection = projection();
+    const auto view            = frustum::from_matrix(view_projection);
+
+    scene s;
+    build_scene(s, view_projection);
+
+    thread_pool pool;
+
+    std::cout << s.occluders.size() << " occluders, " << s.objects.size()
+              << " objects, " << pool.max_chunks() << " threads" << std::endl;
+
+    std::cout << std::left << std::setw(12) << "buffer" << std::setw(12)
+              << "triangles" << std::setw(14) << "render ms" << std::setw(14)
+              << "render ms mt" << std::setw(12) << "test ms" << std::setw(14)
+              << "test ms mt" << "hidden" << std::endl;
+
+    for(const auto& [width, height] : {std::pair {128, 64}, std::pair {256, 128},
+                                       std::pair {512, 256}})
+    {
+        occlusion_buffer buffer(width, height);
+
+        auto render = [&](thread_pool* threads)
+        {
+            buffer.clear();
+            buffer.render(s.occluders, threads);
+        };
+
+        const double render_single   = milliseconds([&] { render(nullptr); });
+        const double render_parallel = milliseconds([&] { render(&pool); });
+
+        culling_stage single;
+        culling_stage parallel(&pool);
+
+        const auto in_frustum = single.cull(s.objects, view).size();
+
+        const double test_single = milliseconds(
+            [&]
+            {
+                single.cull(s.objects, view);
+                single.remove_occluded(s.objects, buffer, view_projection);
+            });
+
+        const double test_parallel = milliseconds(
+            [&]
+            {
+                parallel.cull(s.objects, view);
+                parallel.remove_occluded(s.objects, buffer, view_projection);
+            });
+
+        const double hidden =
+            100.0 * double(in_frustum - single.visible().size()) / in_frustum;
+
+        std::cout << std::left << std::setw(12)
+                  << (std::to_string(width) + "x" + std::to_string(height))
+                  << std::setw(12) << buffer.rendered_triangles() << std::fixed
+                  << std::setprecision(3) << std::setw(14) << render_single
+                  << std::setw(14) << render_parallel << std::setw(12)
+                  << test_single << std::setw(14) << test_parallel
+                  << std::setprecision(1) << hidden << "%" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <corgi/opengl/render_graph.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace corgi;
+
+// Compares the memory used by the transient render targets of a typical
+// post processing chain with and without aliasing, and measures how long it
+// takes to compile the graph. Compiling doesn't need an OpenGL context
+
+constexpr int benchmark_compilations = 10000;
+
+static void build_graph(render_graph& graph, unsigned width, unsigned height)
+{
+    const render_target_desc hdr {width, height, internal_format::rgba16_f};
+    const render_target_desc depth {width, height,
+                                    internal_format::depth24_stencil8};
+    const render_target_desc ldr {width, height, internal_format::rgba8};
+    const render_target_desc half {width / 2, height / 2,
+                                   internal_format::rgba16_f};
+
+    auto scene_color = graph.create("scene_color", hdr);
+    auto scene_depth = graph.create("scene_depth", depth);
+    auto bright      = graph.create("bright", half);
+    auto blur_h      = graph.create("blur_h", half);
+    auto blur_v      = graph.create("blur_v", half);
+    auto composite   = graph.create("composite", hdr);
+    auto tonemapped  = graph.create("tonemapped", ldr);
+    auto debug       = graph.create("debug", ldr);
+
+    auto nothing = [](render_graph::pass_context&) {};
+
+    auto pass = [&](const char* name, std::vector<render_graph::resource> in,
+                    std::vector<render_graph::resource> out)
+    {
+        graph.add_pass(
+            name,
+            [in, out](render_graph::pass_builder& b)
+            {
+                for(auto r : in)
+                    b.read(r);
+                for(auto r : out)
+                    b.write(r);
+            },
+            nothing);
+    };
+
+    pass("scene", {}, {scene_color, scene_depth});
+    pass("bright", {scene_color}, {bright});
+    pass("blur_h", {bright}, {blur_h});
+    pass("blur_v", {blur_h}, {blur_v});
+    pass("composite", {scene_color, blur_v}, {composite});
+    pass("tonemap", {composite}, {tonemapped});
+    pass("fxaa", {tonemapped}, {graph.default_target()});
+    pass("debug", {scene_depth}, {debug});
+}
+
+int main()
+{
+    render_graph graph;
+    build_graph(graph, 1920, 1080);
+    graph.compile();
+
+    const auto mib = [](std::size_t bytes)
+    { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "1920x1080 post processing chain" << std::endl;
+
+    std::cout << "  passes   :";
+    for(const auto& name : graph.execution_order())
+        std::cout << " " << name;
+    std::cout << std::endl;
+
+    std::cout << "  culled   :";
+    for(const auto& name : graph.culled_passes())
+        std::cout << " " << name;
+    std::cout << std::endl;
+
+    std::cout << "  without aliasing : "
+              << mib(graph.transient_bytes_without_aliasing()) << " MiB"
+              << std::endl;
+    std::cout << "  with aliasing    : " << mib(graph.transient_bytes())
+              << " MiB in " << graph.physical_target_count() << " textures"
+              << std::endl;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < benchmark_compilations; i++)
+    {
+        graph.reset();
+        build_graph(graph, 1920, 1080);
+        graph.compile();
+    }
+
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << std::setprecision(2) << "  build + compile  : "
+              << elapsed.count() / benchmark_compilations << " us per frame"
+              << std::endl;
+}
@@ -0,0 +1,159 @@
+#include <corgi/opengl/aabb_tree.h>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace corgi;
+
+// Measures the 2D spatial index against a linear scan, on maps of small
+// objects with the same density at every size. Doesn't need an OpenGL
+// context
+
+constexpr int   queries       = 1000;
+constexpr float screen_width  = 64.0F;
+constexpr float screen_height = 36.0F;
+
+template<class Function>
+static double milliseconds(Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+int main()
+{
+    std::cout << std::left << std::setw(10) << "objects" << std::setw(11)
+              << "build ms" << std::setw(12) << "insert ms" << std::setw(12)
+              << "update ms" << std::setw(10) << "height" << std::setw(14)
+              << "view us" << std::setw(14) << "scan us" << std::setw(12)
+              << "pick us" << "nearest us" << std::endl;
+
+    for(const std::size_t count : {10000, 100000, 1000000})
+    {
+        // Four objects per square of 10 units
+        const float world = 5.0F * std::sqrt(static_cast<float>(count));
+
+        std::mt19937                          random(5);
+        std::uniform_real_distribution<float> position(0.0F, world);
+        std::uniform_real_distribution<float> size(0.5F, 3.0F);
+        std::uniform_real_distribution<float> step(-0.2F, 0.2F);
+
+        std::vector<aabb> boxes(count);
+        for(auto& box : boxes)
+        {
+            const float x = position(random);
+            const float y = position(random);
+            box = {{x, y, 0.0F}, {x + size(random), y + size(random), 0.0F}};
+        }
+
+        aabb_tree tree(0.5F);
+
+        const double build = milliseconds([&] { tree.build(boxes); });
+
+        aabb_tree  inserted(0.5F);
+        const auto insert = milliseconds(
+            [&]
+            {
+                for(std::uint32_t i = 0; i < count; i++)
+                    inserted.insert(boxes[i], i);
+            });
+
+        // A tenth of the objects move a little each frame, for 10 frames
+        const double update = milliseconds(
+            [&]
+            {
+                for(int frame = 0; frame < 10; frame++)
+                    for(std::uint32_t i = frame; i < count; i += 10)
+                    {
+                        const float dx = step(random);
+                        const float dy = step(random);
+
+                        auto& box = boxes[i];
+                        box.min   = {box.min[0] + dx, box.min[1] + dy, 0.0F};
+                        box.max   = {box.max[0] + dx, box.max[1] + dy, 0.0F};
+                        tree.move(i, box);
+                    }
+            });
+
+        std::vector<std::uint32_t> found;
+        std::size_t                seen = 0;
+
+        std::uniform_real_distribution<float> corner(
+            0.0F, world - screen_width);
+
+        const double view = milliseconds(
+            [&]
+            {
+                for(int i = 0; i < queries; i++)
+                {
+                    const float x = corner(random);
+                    const float y = corner(random);
+
+                    found.clear();
+                    tree.query({x, y, x + screen_width, y + screen_height},
+                               found);
+                    seen += found.size();
+                }
+            });
+
+        const double scan = milliseconds(
+            [&]
+            {
+                for(int i = 0; i < queries / 10; i++)
+                {
+                    const float     x = corner(random);
+                    const float     y = corner(random);
+                    const view_rect rect {x, y, x + screen_width,
+                                          y + screen_height};
+
+                    found.clear();
+                    for(std::uint32_t j = 0; j < count; j++)
+                        if(rect.intersects(boxes[j]))
+                            found.push_back(j);
+                    seen += found.size();
+                }
+            });
+
+        const double pick = milliseconds(
+            [&]
+            {
+                for(int i = 0; i < queries; i++)
+                {
+                    found.clear();
+                    tree.query(position(random), position(random), found);
+                    seen += found.size();
+                }
+            });
+
+        const double nearest = milliseconds(
+            [&]
+            {
+                for(int i = 0; i < queries; i++)
+                    seen += tree.nearest(position(random), position(random));
+            });
+
+        std::cout << std::left << std::setw(10) << count << std::fixed
+                  << std::setprecision(2) << std::setw(11) << build
+                  << std::setw(12) << insert << std::setw(12) << update / 10.0
+                  << std::setw(10) << tree.height() << std::setw(14)
+                  << view * 1000.0 / queries << std::setw(14)
+                  << scan * 1000.0 / (queries / 10) << std::setw(12)
+                  << pick * 1000.0 / queries << nearest * 1000.0 / queries
+                  << std::endl;
+
+        // Keeps the queries from being optimized away
+        if(seen == 0)
+            std::cout << "nothing found" << std::endl;
+    }
+
+    return 0;
+}
@@ -172,6 +172,7 @@ int main(int argc, char* argv[])
         renderer.set_default_color(1.0F, 0.0F, 1.0F);
         renderer.draw_default_rect_on_screen(-150.0F, 0.0F, 10, 10);
         SDL_GL_SwapWindow(window);
+        renderer.end_frame();
 
         angle += 0.001f;
     }
@@ -1,12 +1,80 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_main.h>
+#include <corgi/opengl/aabb_tree.h>
 #include <corgi/opengl/buffer.h>
+#include <corgi/opengl/compact_mesh.h>
+#include <corgi/opengl/culling.h>
+#include <corgi/opengl/deletion_queue.h>
+#include <corgi/opengl/dynamic_mesh.h>
+#include <corgi/opengl/framebuffer.h>
+#include <corgi/opengl/gl_name_pool.h>
+#include <corgi/opengl/lod_mesh.h>
+#include <corgi/opengl/memory_tracker.h>
+#include <corgi/opengl/mesh_file.h>
+#include <corgi/opengl/mesh_optimizer.h>
+#include <corgi/opengl/occlusion_buffer.h>
+#include <corgi/opengl/occlusion_queries.h>
+#include <corgi/opengl/pipeline.h>
+#include <corgi/opengl/pipeline_state.h>
+#include <corgi/opengl/pixel_readback.h>
+#include <corgi/opengl/png_sink.h>
+#include <corgi/opengl/primitives.h>
+#include <corgi/opengl/render_graph.h>
+#include <corgi/opengl/renderer.h>
+#include <corgi/opengl/static_batch.h>
+#include <corgi/opengl/texture.h>
+#include <corgi/opengl/texture_streamer.h>
+#include <corgi/opengl/thread_pool.h>
+#include <corgi/opengl/vertex_array_cache.h>
+#include <corgi/opengl/vertex_layout.h>
+#include <corgi/opengl/vertex_packing.h>
 #include <corgi/test/test.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace corgi;
 
+struct lit_vertex
+{
+    std::array<float, 3>     position;
+    corgi::packed_2_10_10_10 normal;
+    corgi::unorm8x4          color;
+    corgi::half2             uv;
+};
+
+template<>
+struct corgi::vertex_layout<lit_vertex>
+{
+    static constexpr std::array attributes {
+        CORGI_VERTEX_ATTRIBUTE(lit_vertex, position, 0),
+        CORGI_VERTEX_ATTRIBUTE(lit_vertex, normal, 1),
+        CORGI_VERTEX_ATTRIBUTE(lit_vertex, color, 2),
+        CORGI_VERTEX_ATTRIBUTE(lit_vertex, uv, 3)};
+};
+
+// Everything is checked at compile time
+static_assert(corgi::vertex_stride_v<lit_vertex> == sizeof(lit_vertex));
+static_assert(corgi::vertex_layout<lit_vertex>::attributes[2].offset == 16);
+static_assert(corgi::vertex_layout<lit_vertex>::attributes[2].mode ==
+              corgi::attribute_mode::normalized);
+static_assert(corgi::layout_is_valid(corgi::vertex_layout<lit_vertex>::attributes));
+static_assert(!corgi::layout_matches<lit_vertex>(corgi::common_layouts::pos2_uv));
+static_assert(corgi::layout_matches<corgi::common_vertices::pos2_uv>(
+    corgi::common_layouts::pos2_uv));
+
 int main(int argc, char** argv)
 {
     SDL_Init(SDL_INIT_VIDEO);
@@ -158,5 +226,2032 @@ int main(int argc, char** argv)
                        check_any_throw(b.bind());
                    });
 
+    test::add_test(
+        "memory_tracker", "buffer_allocations",
+        []()
+        {
+            auto&      tracker = memory_tracker::instance();
+            const auto before  = tracker.current(resource_type::vertex_buffer);
+
+            {
+                buffer<float, buffer_type::array_buffer> b(
+                    {1.0F, 2.0F, 3.0F, 4.0F});
+                b.set_tag("test_buffer");
+
+                assert_that(tracker.current(resource_type::vertex_buffer),
+                            test::equals(before + 4 * sizeof(float)));
+                assert_that(tracker.tag_total("test_buffer"),
+                            test::equals(4 * sizeof(float)));
+
+                b.set_data({1.0F, 2.0F});
+
+                // Tag is kept when the buffer is resized
+                assert_that(tracker.tag_total("test_buffer"),
+                            test::equals(2 * sizeof(float)));
+            }
+
+            assert_that(tracker.current(resource_type::vertex_buffer),
+                        test::equals(before));
+            check_true(tracker.peak(resource_type::vertex_buffer) >=
+                       before + 4 * sizeof(float));
+        });
+
+    test::add_test("memory_tracker", "texture_size_in_bytes",
+                   []()
+                   {
+                       assert_that(texture_size_in_bytes(
+                                       internal_format::rgba, 256, 128),
+                                   test::equals(std::size_t(256 * 128 * 4)));
+
+                       assert_that(mipmap_level_count(256, 128),
+                                   test::equals(9u));
+
+                       // 4x4 + 2x2 + 1x1 texels
+                       assert_that(
+                           texture_size_in_bytes(internal_format::r8, 4, 4, 3),
+                           test::equals(std::size_t(21)));
+                   });
+
+    test::add_test(
+        "framebuffer", "render_to_texture",
+        []()
+        {
+            create_info info;
+            info.internal_format = internal_format::rgba8;
+            info.width           = 64;
+            info.height          = 64;
+            info.data            = nullptr;
+
+            texture      color(info);
+            renderbuffer depth(internal_format::depth24_stencil8, 64, 64);
+
+            framebuffer fb;
+            fb.attach(attachment::color0, color);
+            fb.attach(attachment::depth_stencil, depth);
+
+            check_true(fb.complete());
+            check_true(fb.width() == 64);
+
+            fb.bind();
+            glClearColor(0.0F, 1.0F, 0.0F, 1.0F);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            fb.invalidate({attachment::depth_stencil});
+            framebuffer::unbind();
+
+            std::vector<unsigned char> pixels(64 * 64 * 4);
+            color.bind();
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                          pixels.data());
+            color.unbind();
+
+            check_true(pixels[0] == 0 && pixels[1] == 255 && pixels[2] == 0);
+        });
+
+    test::add_test(
+        "framebuffer", "multisample_resolve",
+        []()
+        {
+            renderbuffer msaa_color(internal_format::rgba8, 32, 32, 4);
+            renderbuffer resolved_color(internal_format::rgba8, 32, 32);
+
+            framebuffer msaa;
+            msaa.attach(attachment::color0, msaa_color);
+
+            framebuffer resolved;
+            resolved.attach(attachment::color0, resolved_color);
+
+            check_true(msaa.complete());
+            check_true(resolved.complete());
+
+            // Attachments must share the same sample count
+            renderbuffer depth(internal_format::depth24_stencil8, 32, 32);
+            check_any_throw(msaa.attach(attachment::depth_stencil, depth));
+
+            msaa.bind();
+            glClearColor(1.0F, 0.0F, 0.0F, 1.0F);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            msaa.resolve(resolved);
+            msaa.invalidate();
+
+            unsigned char pixel[4];
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, resolved.id());
+            glReadPixels(16, 16, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+            framebuffer::unbind();
+
+            check_true(pixel[0] == 255 && pixel[1] == 0);
+
+            // Multisampled blits can't scale, on either side
+            renderbuffer small_color(internal_format::rgba8, 16, 16);
+            renderbuffer small_msaa_color(internal_format::rgba8, 16, 16, 4);
+            framebuffer  small;
+            framebuffer  small_msaa;
+            small.attach(attachment::color0, small_color);
+            small_msaa.attach(attachment::color0, small_msaa_color);
+            check_any_throw(msaa.resolve(small));
+            check_any_throw(msaa.blit_to(small_msaa));
+            check_any_throw(msaa.blit_to(0, 16, 16));
+            check_true(glGetError() == GL_NO_ERROR);
+        });
+
+    test::add_test(
+        "render_graph", "culling_and_aliasing",
+        []()
+        {
+            render_graph graph;
+
+            const render_target_desc full {256, 256, internal_format::rgba8};
+            const render_target_desc half {128, 128, internal_format::rgba8};
+
+            auto scene = graph.create("scene", full);
+            auto blur  = graph.create("blur", half);
+            auto blur2 = graph.create("blur2", half);
+            auto debug = graph.create("debug", full);
+
+            auto nothing = [](render_graph::pass_context&) {};
+
+            // Declared out of order on purpose
+            graph.add_pass(
+                "composite",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(scene);
+                    b.read(blur2);
+                    b.write(graph.default_target());
+                },
+                nothing);
+
+            graph.add_pass("scene", [&](render_graph::pass_builder& b)
+                           { b.write(scene); }, nothing);
+
+            graph.add_pass(
+                "blur_h",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(scene);
+                    b.write(blur);
+                },
+                nothing);
+
+            graph.add_pass(
+                "blur_v",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(blur);
+                    b.write(blur2);
+                },
+                nothing);
+
+            graph.add_pass("debug", [&](render_graph::pass_builder& b)
+                           { b.write(debug); }, nothing);
+
+            graph.compile();
+
+            const std::vector<std::string> order {"scene", "blur_h", "blur_v",
+                                                  "composite"};
+            check_true(graph.execution_order() == order);
+            check_true(graph.culled_passes() ==
+                       std::vector<std::string> {"debug"});
+
+            // blur and blur2 overlap, nothing can be aliased yet
+            assert_that(graph.physical_target_count(), test::equals(std::size_t(3)));
+
+            // A second half resolution pass after the composite can reuse
+            // the blur texture
+            auto overlay = graph.create("overlay", half);
+            graph.add_pass("overlay", [&](render_graph::pass_builder& b)
+                           { b.write(overlay); }, nothing);
+            graph.add_pass(
+                "present",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(overlay);
+                    b.write(graph.default_target());
+                },
+                nothing);
+
+            graph.compile();
+
+            assert_that(graph.physical_target_count(), test::equals(std::size_t(3)));
+            check_true(graph.transient_bytes() <
+                       graph.transient_bytes_without_aliasing());
+
+            // Cycles can't be ordered
+            render_graph cyclic;
+            auto         a = cyclic.create("a", half);
+            auto         c = cyclic.create("c", half);
+            cyclic.mark_output(a);
+            cyclic.add_pass(
+                "first",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(c);
+                    b.write(a);
+                },
+                nothing);
+            cyclic.add_pass(
+                "second",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(a);
+                    b.write(c);
+                },
+                nothing);
+            check_any_throw(cyclic.compile());
+        });
+
+    test::add_test(
+        "render_graph", "versions_and_framebuffers",
+        []()
+        {
+            const render_target_desc color {64, 64, internal_format::rgba8};
+            auto nothing = [](render_graph::pass_context&) {};
+
+            // "reader" reads what "first" wrote, so it runs before "second"
+            // overwrites it
+            render_graph versions;
+            auto         x = versions.create("x", color);
+            versions.mark_output(x);
+            versions.add_pass("first", [&](render_graph::pass_builder& b)
+                              { b.write(x); }, nothing);
+            versions.add_pass(
+                "reader",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(x);
+                    b.write(versions.default_target());
+                },
+                nothing);
+            versions.add_pass("second", [&](render_graph::pass_builder& b)
+                              { b.write(x); }, nothing);
+            versions.compile();
+
+            const std::vector<std::string> order {"first", "reader", "second"};
+            check_true(versions.execution_order() == order);
+
+            // Imported depth textures go to the depth attachment
+            create_info info;
+            info.internal_format = internal_format::depth_component24;
+            info.format          = format::depth_component;
+            info.data_type       = data_type::float_;
+            info.width           = 64;
+            info.height          = 64;
+            info.data            = nullptr;
+            texture depth(info);
+
+            renderer     r(64, 64);
+            render_graph graph;
+            GLint        bound[2] {0, 0};
+
+            for(int frame = 0; frame < 2; frame++)
+            {
+                graph.reset();
+                auto scene = graph.create("scene", color);
+                auto z     = graph.import("depth", depth);
+
+                graph.add_pass(
+                    "scene",
+                    [&](render_graph::pass_builder& b)
+                    {
+                        b.write(scene);
+                        b.write(z);
+                    },
+                    [&](render_graph::pass_context&)
+                    {
+                        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,
+                                      &bound[frame]);
+
+                        GLint name = 0;
+                        glGetFramebufferAttachmentParameteriv(
+                            GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &name);
+                        assert_that(name, test::equals(GLint(depth.id())));
+                        check_true(glCheckFramebufferStatus(
+                                       GL_DRAW_FRAMEBUFFER) ==
+                                   GL_FRAMEBUFFER_COMPLETE);
+                    });
+
+                graph.add_pass(
+                    "present",
+                    [&](render_graph::pass_builder& b)
+                    {
+                        b.read(scene);
+                        b.write(graph.default_target());
+                    },
+                    nothing);
+
+                graph.execute(r);
+            }
+
+            // The framebuffer survived the reset
+            check_true(bound[0] != 0);
+            assert_that(bound[1], test::equals(bound[0]));
+
+            // Outputs keep their texture, "later" would have reused it
+            // otherwise
+            render_graph outputs;
+            auto         result = outputs.create("result", color);
+            auto         later  = outputs.create("later", color);
+            outputs.mark_output(result);
+
+            outputs.add_pass(
+                "result", [&](render_graph::pass_builder& b)
+                { b.write(result); },
+                [](render_graph::pass_context&)
+                {
+                    glClearColor(0.0F, 1.0F, 0.0F, 1.0F);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                });
+            outputs.add_pass(
+                "later", [&](render_graph::pass_builder& b)
+                { b.write(later); },
+                [](render_graph::pass_context&)
+                {
+                    glClearColor(1.0F, 0.0F, 0.0F, 1.0F);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                });
+            outputs.add_pass(
+                "present",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.read(later);
+                    b.write(outputs.default_target());
+                },
+                nothing);
+
+            outputs.execute(r);
+            glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
+
+            assert_that(outputs.physical_target_count(),
+                        test::equals(std::size_t(2)));
+            check_true(outputs.texture(result).id() !=
+                       outputs.texture(later).id());
+            check_any_throw(outputs.texture(outputs.default_target()));
+
+            framebuffer read_back;
+            read_back.attach(attachment::color0, outputs.texture(result));
+            read_back.bind();
+            unsigned char pixel[4] {0, 0, 0, 0};
+            glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+            framebuffer::unbind();
+            assert_that(int(pixel[1]), test::equals(255));
+            assert_that(int(pixel[0]), test::equals(0));
+
+            // The default target can't be written with other targets
+            check_any_throw(outputs.add_pass(
+                "mixed",
+                [&](render_graph::pass_builder& b)
+                {
+                    b.write(result);
+                    b.write(outputs.default_target());
+                },
+                nothing));
+            assert_that(outputs.execution_order().size(),
+                        test::equals(std::size_t(3)));
+
+            graph.reset();
+            graph.compile();
+            graph.trim();
+            check_true(glGetError() == GL_NO_ERROR);
+        });
+
+    test::add_test(
+        "pixel_readback", "ring_overflow",
+        []()
+        {
+            renderbuffer color(internal_format::rgba8, 16, 16);
+            framebuffer  fb;
+            fb.attach(attachment::color0, color);
+            fb.bind();
+
+            pixel_readback readback(2);
+
+            std::vector<readback_ticket> tickets;
+
+            // One more request than slots, the oldest one is copied out
+            for(int i = 0; i < 3; i++)
+            {
+                glClearColor(i / 2.0F, 0.0F, 1.0F, 1.0F);
+                glClear(GL_COLOR_BUFFER_BIT);
+                tickets.push_back(readback.request({0, 0, 16, 16}));
+            }
+
+            assert_that(readback.pending(), test::equals(std::size_t(3)));
+            check_true(tickets[0].ready());
+
+            for(int i = 0; i < 3; i++)
+            {
+                image img = tickets[i].take();
+                check_true(img.width == 16 && img.channels == 4);
+                check_true(std::abs(img.data[0] - i * 255 / 2) <= 1);
+                check_true(img.data[2] == 255);
+            }
+
+            check_true(!tickets[0].valid());
+            check_any_throw(tickets[0].take());
+            assert_that(readback.pending(), test::equals(std::size_t(0)));
+
+            // Dropped tickets give back their pixels, copied out or not
+            tickets.clear();
+            for(int i = 0; i < 3; i++)
+                tickets.push_back(readback.request({0, 0, 16, 16}));
+
+            auto moved = std::move(tickets[2]);
+            check_true(!tickets[2].valid() && moved.valid());
+
+            tickets.clear();
+            assert_that(readback.pending(), test::equals(std::size_t(1)));
+
+            moved.discard();
+            check_true(!moved.valid());
+            assert_that(readback.pending(), test::equals(std::size_t(0)));
+
+            framebuffer::unbind();
+        });
+
+    test::add_test(
+        "png_sink", "write_files",
+        []()
+        {
+            const auto folder =
+                std::filesystem::temp_directory_path() / "corgi_png_sink";
+            std::filesystem::create_directories(folder);
+
+            {
+                png_sink sink(1);
+
+                for(int i = 0; i < 3; i++)
+                {
+                    image img {std::vector<unsigned char>(8 * 4 * 3, 128), 8,
+                               4, 3};
+                    sink.push(std::move(img),
+                              (folder / (std::to_string(i) + ".png")).string());
+                }
+
+                sink.flush();
+                assert_that(sink.written(), test::equals(std::size_t(3)));
+            }
+
+            check_true(std::filesystem::exists(folder / "2.png"));
+            std::filesystem::remove_all(folder);
+        });
+
+    test::add_test(
+        "pipeline_state", "interning",
+        []()
+        {
+            auto& registry = pipeline_state_registry::instance();
+
+            // Id 0 is OpenGL's default state
+            assert_that(registry.intern(pipeline_state()),
+                        test::equals(pipeline_state_id(0)));
+
+            const auto blended =
+                pipeline_state().with_blend(blend_state::alpha_blending());
+            const auto same =
+                pipeline_state().with_blend(blend_state::alpha_blending());
+
+            check_true(blended.hash() == same.hash());
+            check_true(registry.intern(blended) == registry.intern(same));
+
+            const auto culled = blended.with_raster({cull_mode::back});
+            check_true(registry.intern(culled) != registry.intern(blended));
+
+            assert_that(
+                registry.delta(registry.intern(blended),
+                               registry.intern(culled)),
+                test::equals(static_cast<std::uint32_t>(state_group::cull)));
+
+            const auto blend_bits =
+                static_cast<std::uint32_t>(state_group::blend_enable) |
+                static_cast<std::uint32_t>(state_group::blend_function);
+            assert_that(registry.delta(0, registry.intern(blended)),
+                        test::equals(blend_bits));
+
+            // Pipelines keep the depth test on and depth writes off by
+            // default
+            pipeline p;
+            check_true(p.state_description().depth().test);
+            check_true(!p.state_description().depth().write);
+
+            corgi::stencil s = pipeline_state::default_stencil();
+            s.enable_stencil = true;
+            p.set_state(p.state_description().with_stencil(s));
+            check_true(p.state() != pipeline::default_state());
+            check_true(p.state_description().stencil().enable_stencil);
+        });
+
+    test::add_test(
+        "pipeline_state", "apply",
+        []()
+        {
+            auto& registry = pipeline_state_registry::instance();
+            registry.apply_defaults();
+
+            const auto state = registry.intern(
+                pipeline_state()
+                    .with_depth({true, false, compare_function::less_equal})
+                    .with_color_mask(color_mask_red));
+
+            registry.apply(0, state);
+
+            GLboolean mask[4];
+            glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+            GLint depth_function = 0;
+            glGetIntegerv(GL_DEPTH_FUNC, &depth_function);
+
+            check_true(glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+            check_true(mask[0] == GL_TRUE && mask[1] == GL_FALSE);
+            check_true(depth_function == GL_LEQUAL);
+
+            registry.apply(state, 0);
+            check_true(glIsEnabled(GL_DEPTH_TEST) == GL_FALSE);
+        });
+
+    test::add_test(
+        "deletion_queue", "deferred_deletion",
+        []()
+        {
+            auto& queue = deletion_queue::instance();
+            queue.flush();
+
+            // Names that don't fit in the pool go to the deletion queue
+            auto& pool = gl_name_pool::instance();
+            pool.clear();
+            queue.flush();
+            const auto max_per_bucket = pool.max_per_bucket();
+            pool.set_max_per_bucket(0);
+
+            unsigned id = 0;
+
+            {
+                buffer<float, buffer_type::array_buffer> b({1.0F, 2.0F, 3.0F});
+                id = b.id();
+            }
+
+            // Destroying the buffer only retires it
+            check_true(glIsBuffer(id) == GL_TRUE);
+            assert_that(queue.pending(), test::equals(std::size_t(1)));
+
+            // The batch is kept until it's old enough
+            queue.set_frames_in_flight(2);
+            queue.end_frame();
+            check_true(glIsBuffer(id) == GL_TRUE);
+
+            // Objects can be retired from any thread
+            auto other = std::make_unique<buffer<float, buffer_type::array_buffer>>(
+                std::vector<float> {4.0F});
+            std::thread([&other] { other.reset(); }).join();
+            assert_that(queue.pending(), test::equals(std::size_t(2)));
+
+            queue.flush();
+            check_true(glIsBuffer(id) == GL_FALSE);
+            assert_that(queue.pending(), test::equals(std::size_t(0)));
+
+            // Retired storage is counted until it's deleted
+            auto&      tracker = memory_tracker::instance();
+            const auto before  = tracker.current(resource_type::renderbuffer);
+
+            auto rb = std::make_unique<renderbuffer>(internal_format::rgba8,
+                                                     16, 16);
+            rb.reset();
+            check_true(tracker.current(resource_type::renderbuffer) > before);
+
+            queue.flush();
+            assert_that(tracker.current(resource_type::renderbuffer),
+                        test::equals(before));
+
+            pool.set_max_per_bucket(max_per_bucket);
+        });
+
+    test::add_test(
+        "gl_name_pool", "recycling",
+        []()
+        {
+            auto& pool = gl_name_pool::instance();
+            pool.clear();
+            pool.reset_statistics();
+
+            unsigned id = 0;
+
+            {
+                buffer<float, buffer_type::array_buffer> b(
+                    std::vector<float>(10, 1.0F));
+                id = b.id();
+            }
+
+            // 10 and 12 floats both go to the 64 bytes bucket
+            buffer<float, buffer_type::array_buffer> b(
+                std::vector<float>(12, 2.0F));
+            check_true(b.id() == id);
+
+            const auto stats = pool.statistics(gl_object::buffer);
+            assert_that(stats.acquired, test::equals(std::size_t(2)));
+            assert_that(stats.recycled, test::equals(std::size_t(1)));
+            check_true(stats.hit_rate() == 0.5);
+
+            // Textures only come back once their frames are over
+            create_info info;
+            info.internal_format = internal_format::rgba8;
+            info.width           = 8;
+            info.height          = 8;
+            info.data            = nullptr;
+
+            unsigned texture_id = 0;
+            {
+                texture t(info);
+                texture_id = t.id();
+            }
+
+            {
+                texture t(info);
+                check_true(t.id() != texture_id);
+            }
+
+            auto& queue = deletion_queue::instance();
+            for(unsigned i = 0; i < queue.frames_in_flight(); i++)
+                queue.end_frame();
+
+            texture t(info);
+            check_true(t.id() == texture_id);
+
+            std::ostringstream report;
+            pool.dump(report);
+            check_true(report.str().find("textures") != std::string::npos);
+
+            // Pooled storage is tracked, and trimmed oldest first
+            auto& tracker = memory_tracker::instance();
+            queue.flush();
+
+            {
+                buffer<float, buffer_type::array_buffer> released(
+                    std::vector<float>(10, 1.0F));
+            }
+
+            {
+                texture first(info);
+                texture second(info);
+            }
+
+            const auto texture_bytes =
+                texture_size_in_bytes(internal_format::rgba8, 8, 8);
+
+            assert_that(pool.pooled_bytes(),
+                        test::equals(texture_bytes * 2 + 40));
+            assert_that(tracker.current(resource_type::pooled_texture),
+                        test::equals(texture_bytes * 2));
+            assert_that(tracker.current(resource_type::pooled_buffer),
+                        test::equals(std::size_t(40)));
+
+            // The buffer's 40 bytes were released first
+            pool.trim(texture_bytes * 2);
+            assert_that(pool.pooled_bytes(),
+                        test::equals(texture_bytes * 2));
+            assert_that(pool.statistics(gl_object::buffer).pooled,
+                        test::equals(std::size_t(0)));
+
+            pool.set_max_pooled_bytes(texture_bytes);
+            assert_that(pool.pooled_bytes(), test::equals(texture_bytes));
+
+            // Trimmed textures are counted until they're deleted
+            assert_that(tracker.current(resource_type::pooled_texture),
+                        test::equals(texture_bytes * 2));
+            queue.flush();
+            assert_that(tracker.current(resource_type::pooled_texture),
+                        test::equals(texture_bytes));
+
+            // Mipmapped textures count and match their whole chain
+            pool.set_max_pooled_bytes(gl_name_pool::default_max_pooled_bytes);
+            pool.clear();
+            queue.flush();
+
+            unsigned mipmapped_id = 0;
+            {
+                auto mipmapped       = info;
+                mipmapped.min_filter = min_filter::linear_mipmap_linear;
+                texture m(mipmapped);
+                mipmapped_id = m.id();
+            }
+
+            assert_that(pool.pooled_bytes(),
+                        test::equals(texture_size_in_bytes(
+                            internal_format::rgba8, 8, 8,
+                            mipmap_level_count(8, 8))));
+
+            for(unsigned i = 0; i < queue.frames_in_flight(); i++)
+                queue.end_frame();
+
+            {
+                texture single(info);
+                check_true(single.id() != mipmapped_id);
+            }
+
+            pool.clear();
+            queue.flush();
+            assert_that(tracker.current(resource_type::pooled_texture),
+                        test::equals(std::size_t(0)));
+        });
+
+    test::add_test(
+        "compact_mesh", "upload",
+        []()
+        {
+            auto& layouts = layout_registry::instance();
+
+            const auto layout = layouts.intern(common_attributes::pos2_uv);
+            assert_that(layouts.intern({{0, 0, 2}, {1, 2, 2}}),
+                        test::equals(layout));
+            assert_that(layouts.stride(layout),
+                        test::equals(4 * sizeof(float)));
+            check_any_throw(layouts.stride(0xFFFF));
+
+            const auto rect = primitive::build_rect_pos2_uv(1.0F, 1.0F);
+
+            compact_mesh m(rect.vertices(), rect.indexes(), layout);
+            assert_that(m.vertex_count(), test::equals(std::uint32_t(4)));
+            assert_that(m.index_count(), test::equals(std::uint32_t(6)));
+            assert_that(m.size_in_bytes(),
+                        test::equals(4 * 4 * sizeof(float) +
+                                     6 * sizeof(std::uint16_t)));
+            check_true(m.index_type() == index_type::uint16);
+
+            GLint size = 0;
+            glBindBuffer(GL_ARRAY_BUFFER, m.vertex_buffer());
+            glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+            assert_that(size, test::equals(GLint(4 * 4 * sizeof(float))));
+
+            compact_mesh moved(std::move(m));
+            check_true(m.empty());
+            check_true(!moved.empty());
+
+            std::vector<compact_mesh> meshes;
+            meshes.push_back(std::move(moved));
+            meshes.clear();
+
+            // 5 floats can't be split in vertices of 4 floats
+            const std::vector<float> broken(5, 0.0F);
+            check_any_throw(compact_mesh(broken, rect.indexes(), layout));
+        });
+
+    test::add_test(
+        "vertex_attribute", "packed_formats",
+        []()
+        {
+            assert_that(pack_half(1.0F), test::equals(std::uint16_t(0x3C00)));
+            assert_that(pack_half(-2.0F), test::equals(std::uint16_t(0xC000)));
+            assert_that(pack_half(0.5F), test::equals(std::uint16_t(0x3800)));
+            assert_that(pack_half(1e6F), test::equals(std::uint16_t(0x7C00)));
+            assert_that(pack_snorm_2_10_10_10(1.0F, -1.0F, 0.0F),
+                        test::equals(std::uint32_t(0x1FF | (0x201 << 10))));
+
+            // position : 2 floats, color : 4 normalized bytes, uv : 2 halfs,
+            // normal : packed, id : 1 integer byte
+            const std::vector<vertex_attribute> attributes {
+                {0, 0, 2, attribute_type::float32, attribute_mode::floating},
+                {1, 8, 4, attribute_type::uint8, attribute_mode::normalized},
+                {2, 12, 2, attribute_type::float16, attribute_mode::floating},
+                {3, 16, 4, attribute_type::int_2_10_10_10_rev,
+                 attribute_mode::normalized},
+                {4, 20, 1, attribute_type::uint8, attribute_mode::integer}};
+
+            // 21 bytes, rounded up to 24
+            assert_that(attributes_stride(attributes), test::equals(24));
+            assert_that(attributes_stride(common_attributes::pos2_uv),
+                        test::equals(int(4 * sizeof(float))));
+
+            mesh m(std::vector<std::byte>(3 * 24), {0, 1, 2}, attributes);
+            check_true(!m.empty());
+
+            vertex_array_cache vertex_arrays;
+            vertex_arrays.bind(m.layout(), m.vertex_buffer()->id(),
+                               m.index_buffer()->id());
+
+            auto get = [](unsigned location, GLenum name)
+            {
+                GLint value = 0;
+                glGetVertexAttribiv(location, name, &value);
+                return value;
+            };
+
+            assert_that(get(1, GL_VERTEX_ATTRIB_ARRAY_TYPE),
+                        test::equals(GLint(GL_UNSIGNED_BYTE)));
+            assert_that(get(1, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED),
+                        test::equals(GLint(GL_TRUE)));
+            assert_that(get(2, GL_VERTEX_ATTRIB_ARRAY_TYPE),
+                        test::equals(GLint(GL_HALF_FLOAT)));
+            assert_that(get(3, GL_VERTEX_ATTRIB_ARRAY_TYPE),
+                        test::equals(GLint(GL_INT_2_10_10_10_REV)));
+            assert_that(get(4, GL_VERTEX_ATTRIB_ARRAY_INTEGER),
+                        test::equals(GLint(GL_TRUE)));
+            assert_that(get(0, GL_VERTEX_ATTRIB_ARRAY_INTEGER),
+                        test::equals(GLint(GL_FALSE)));
+            assert_that(get(3, GL_VERTEX_ATTRIB_RELATIVE_OFFSET),
+                        test::equals(GLint(16)));
+            assert_that(get(4, GL_VERTEX_ATTRIB_BINDING),
+                        test::equals(GLint(0)));
+
+            GLint stride = 0;
+            glGetIntegeri_v(GL_VERTEX_BINDING_STRIDE, 0, &stride);
+            assert_that(stride, test::equals(GLint(24)));
+
+            glBindVertexArray(0);
+        });
+
+    test::add_test(
+        "mesh", "index_type",
+        []()
+        {
+            check_true(select_index_type(200u) == index_type::uint16);
+            check_true(select_index_type(200u, true) == index_type::uint8);
+            check_true(select_index_type(70000u) == index_type::uint32);
+
+            const auto rect = primitive::build_rect_pos2(1.0F, 1.0F);
+            check_true(rect.index_type() == index_type::uint16);
+            assert_that(rect.index_count(), test::equals(std::uint32_t(6)));
+            assert_that(rect.index_buffer()->size_in_bytes(),
+                        test::equals(std::size_t(12)));
+            check_true(rect.indexes() ==
+                       std::vector<unsigned>({0, 1, 2, 2, 3, 0}));
+
+            // The last index needs 32 bits
+            std::vector<float> vertices(2 * 70001, 0.0F);
+            mesh big(vertices, {0, 1, 70000}, common_attributes::pos2);
+            check_true(big.index_type() == index_type::uint32);
+            check_true(big.indexes() == std::vector<unsigned>({0, 1, 70000}));
+
+            mesh copy(rect);
+            check_true(copy.index_type() == index_type::uint16);
+            assert_that(copy.index_count(), test::equals(std::uint32_t(6)));
+        });
+
+    test::add_test(
+        "mesh_optimizer", "reorder_grid",
+        []()
+        {
+            // Grid of 32x32 quads, with triangles in a random order
+            constexpr unsigned side = 33;
+
+            mesh_data data;
+            data.attributes = {{0, 0, 3}};
+
+            std::vector<float> positions;
+            for(unsigned y = 0; y < side; y++)
+                for(unsigned x = 0; x < side; x++)
+                    positions.insert(positions.end(), {float(x), float(y), 0.0F});
+
+            data.vertices.resize(positions.size() * sizeof(float));
+            std::memcpy(data.vertices.data(), positions.data(),
+                        data.vertices.size());
+
+            std::vector<std::array<unsigned, 3>> triangles;
+            for(unsigned y = 0; y + 1 < side; y++)
+                for(unsigned x = 0; x + 1 < side; x++)
+                {
+                    const unsigned v = y * side + x;
+                    triangles.push_back({v, v + 1, v + side + 1});
+                    triangles.push_back({v, v + side + 1, v + side});
+                }
+
+            std::shuffle(triangles.begin(), triangles.end(),
+                         std::mt19937(42));
+            for(const auto& t : triangles)
+                data.indexes.insert(data.indexes.end(), t.begin(), t.end());
+
+            const auto before = mesh_optimizer::analyze_vertex_cache(
+                data.indexes, data.vertex_count());
+
+            // Triangles as sets of positions, to check none got lost
+            auto triangle_set = [](const mesh_data& d)
+            {
+                const auto p = mesh_optimizer::vertex_positions(d);
+                std::vector<std::array<float, 6>> result;
+                for(std::size_t i = 0; i < d.indexes.size(); i += 3)
+                {
+                    std::array<std::pair<float, float>, 3> corners;
+                    for(unsigned k = 0; k < 3; k++)
+                        corners[k] = {p[d.indexes[i + k] * 3],
+                                      p[d.indexes[i + k] * 3 + 1]};
+                    std::sort(corners.begin(), corners.end());
+                    result.push_back({corners[0].first, corners[0].second,
+                                      corners[1].first, corners[1].second,
+                                      corners[2].first, corners[2].second});
+                }
+                std::sort(result.begin(), result.end());
+                return result;
+            };
+
+            const auto original = triangle_set(data);
+
+            mesh_optimizer::optimize(data);
+
+            const auto after = mesh_optimizer::analyze_vertex_cache(
+                data.indexes, data.vertex_count());
+
+            check_true(before.acmr > 2.0F);
+            check_true(after.acmr < 1.0F);
+            check_true(after.atvr < before.atvr);
+            assert_that(after.triangles, test::equals(before.triangles));
+            check_true(triangle_set(data) == original);
+
+            // Vertices are in the order of their first use
+            unsigned next = 0;
+            for(auto index : data.indexes)
+            {
+                check_true(index <= next);
+                if(index == next)
+                    next++;
+            }
+            assert_that(std::size_t(next), test::equals(data.vertex_count()));
+
+            // The optimized data can be uploaded as is
+            mesh m(std::move(data));
+            check_true(!m.empty());
+        });
+
+    test::add_test(
+        "mesh_optimizer", "weld_vertices",
+        []()
+        {
+            // Triangle soup of a 100 segments circle : 3 vertices per
+            // triangle, like the primitives used to build it
+            mesh_data data;
+            data.attributes = common_attributes::pos2_uv;
+
+            std::vector<float> soup;
+            const float delta = 2.0F * std::numbers::pi_v<float> / 100.0F;
+
+            for(int i = 0; i < 100; i++)
+            {
+                const float a = delta * float(i);
+                const float b = delta * float(i + 1);
+                soup.insert(soup.end(), {0.0F, 0.0F, 0.0F, 0.0F});
+                soup.insert(soup.end(),
+                            {std::cos(a), std::sin(a), std::cos(a), std::sin(a)});
+                soup.insert(soup.end(),
+                            {std::cos(b), std::sin(b), std::cos(b), std::sin(b)});
+                for(unsigned k = 0; k < 3; k++)
+                    data.indexes.push_back(unsigned(i) * 3 + k);
+            }
+
+            data.vertices.resize(soup.size() * sizeof(float));
+            std::memcpy(data.vertices.data(), soup.data(), data.vertices.size());
+
+            // The last rim vertex lands a few ulps away from the first one
+            assert_that(mesh_optimizer::weld_vertices(data, 1e-4F),
+                        test::equals(std::size_t(101)));
+            assert_that(data.vertex_count(), test::equals(std::size_t(101)));
+            assert_that(data.indexes.size(), test::equals(std::size_t(300)));
+
+            // Vertices further apart than epsilon stay apart
+            mesh_data pair;
+            pair.attributes = common_attributes::pos2;
+            const std::array<float, 6> points {0.0F, 0.0F, 0.1F, 0.0F,
+                                               0.0F, 0.0F};
+            pair.vertices.resize(sizeof(points));
+            std::memcpy(pair.vertices.data(), points.data(), sizeof(points));
+            pair.indexes = {0, 1, 2};
+
+            // The first and last vertices are merged, so the only triangle
+            // becomes degenerate
+            assert_that(mesh_optimizer::weld_vertices(pair, 1e-3F),
+                        test::equals(std::size_t(2)));
+            check_true(pair.indexes.empty());
+
+            const auto circle = primitive::build_circle_pos2_uv(1.0F, 100);
+            assert_that(circle.data().vertex_count(),
+                        test::equals(std::size_t(101)));
+            assert_that(circle.index_count(), test::equals(std::uint32_t(300)));
+        });
+
+    test::add_test(
+        "mesh_optimizer", "simplify",
+        []()
+        {
+            // Flat 16x16 grid : interior vertices can go, the border stays
+            constexpr unsigned side = 17;
+
+            std::vector<float>    positions;
+            std::vector<unsigned> indexes;
+
+            for(unsigned y = 0; y < side; y++)
+                for(unsigned x = 0; x < side; x++)
+                    positions.insert(positions.end(),
+                                     {float(x), float(y), 0.0F});
+
+            for(unsigned y = 0; y + 1 < side; y++)
+                for(unsigned x = 0; x + 1 < side; x++)
+                {
+                    const unsigned v = y * side + x;
+                    indexes.insert(indexes.end(), {v, v + 1, v + side + 1, v,
+                                                   v + side + 1, v + side});
+                }
+
+            float error  = 1.0F;
+            auto  result = mesh_optimizer::simplify(indexes, positions, 0,
+                                                    1e-3F, &error);
+
+            check_true(result.size() < indexes.size() / 4);
+            check_true(error < 1e-3F);
+
+            // Same area and orientation as the original square
+            double area = 0.0;
+            for(std::size_t i = 0; i < result.size(); i += 3)
+            {
+                const float* a = &positions[result[i] * 3];
+                const float* b = &positions[result[i + 1] * 3];
+                const float* c = &positions[result[i + 2] * 3];
+                area += 0.5 * ((b[0] - a[0]) * (c[1] - a[1]) -
+                               (b[1] - a[1]) * (c[0] - a[0]));
+            }
+            check_true(std::abs(area - 256.0) < 1e-3);
+
+            // Levels of detail of a sphere share its vertices
+            mesh_data sphere;
+            sphere.attributes = {{0, 0, 3}};
+            std::vector<float> points;
+            for(unsigned r = 0; r <= 32; r++)
+                for(unsigned s = 0; s <= 64; s++)
+                {
+                    const float phi   = std::numbers::pi_v<float> * r / 32.0F;
+                    const float theta =
+                        2.0F * std::numbers::pi_v<float> * s / 64.0F;
+                    points.insert(points.end(),
+                                  {std::sin(phi) * std::cos(theta),
+                                   std::cos(phi),
+                                   std::sin(phi) * std::sin(theta)});
+                }
+            for(unsigned r = 0; r < 32; r++)
+                for(unsigned s = 0; s < 64; s++)
+                {
+                    const unsigned v = r * 65 + s;
+                    sphere.indexes.insert(sphere.indexes.end(),
+                                          {v, v + 65, v + 1, v + 1, v + 65,
+                                           v + 66});
+                }
+            sphere.vertices.resize(points.size() * sizeof(float));
+            std::memcpy(sphere.vertices.data(), points.data(),
+                        sphere.vertices.size());
+
+            const auto original_indexes = sphere.indexes.size();
+
+            lod_mesh lods(std::move(sphere));
+            const auto& levels = lods.levels();
+
+            check_true(levels.size() >= 3);
+            assert_that(std::size_t(levels[0].index_count),
+                        test::equals(original_indexes));
+
+            for(std::size_t i = 1; i < levels.size(); i++)
+            {
+                check_true(levels[i].index_count < levels[i - 1].index_count);
+                assert_that(levels[i].first_index,
+                            test::equals(levels[i - 1].first_index +
+                                         levels[i - 1].index_count));
+                check_true(levels[i].error <= 0.05F);
+            }
+
+            // Close objects use the original mesh, tiny ones the coarsest
+            // level
+            assert_that(lods.select(1e6F), test::equals(std::size_t(0)));
+            assert_that(lods.select(4.0F),
+                        test::equals(levels.size() - 1));
+
+            // Nothing to draw for an empty lod_mesh
+            renderer r(64, 64);
+            r.draw(lod_mesh(), 100.0F);
+            check_true(glGetError() == GL_NO_ERROR);
+
+            check_true(projected_size(2.0F, 10.0F, 1.0F, 1080.0F) >
+                       projected_size(2.0F, 20.0F, 1.0F, 1080.0F));
+
+            check_true(primitive::circle_discretisation(2.0F) <
+                       primitive::circle_discretisation(200.0F));
+            assert_that(primitive::circle_discretisation(0.1F),
+                        test::equals(8));
+        });
+
+    test::add_test(
+        "mesh_file", "round_trip",
+        []()
+        {
+            const auto path =
+                std::filesystem::temp_directory_path() / "corgi_mesh_file.cmsh";
+
+            const auto rect = primitive::build_rect_pos2_uv(2.0F, 1.0F);
+            const auto data = rect.data();
+
+            write_mesh_file(path, data);
+
+            {
+                const mesh_file file(path);
+                const auto&     header = file.header();
+
+                assert_that(header.vertex_count, test::equals(4u));
+                assert_that(header.index_count, test::equals(6u));
+                check_true(file.attributes() == data.attributes);
+                check_true(file.index_type() == index_type::uint16);
+                check_true(header.bounds_max[0] - header.bounds_min[0] == 4.0F);
+                check_true(header.bounds_max[1] - header.bounds_min[1] == 2.0F);
+
+                // Blobs are aligned and hold the data as is
+                assert_that(header.vertices_offset % mesh_file_alignment,
+                            test::equals(std::uint64_t(0)));
+                assert_that(header.indexes_offset % mesh_file_alignment,
+                            test::equals(std::uint64_t(0)));
+                check_true(std::ranges::equal(file.vertices(), data.vertices));
+                check_true(unpack_indexes(file.indexes(), file.index_type()) ==
+                           data.indexes);
+
+                const auto m = file.upload();
+                assert_that(m.vertex_count(), test::equals(std::uint32_t(4)));
+                assert_that(m.index_count(), test::equals(std::uint32_t(6)));
+                check_true(m.layout() ==
+                           layout_registry::instance().intern(data.attributes));
+            }
+
+            // Indexes past the last vertex are refused
+            {
+                auto corrupted = data;
+                corrupted.indexes.back() = 4;
+                write_mesh_file(path, corrupted);
+                check_any_throw(load_mesh_file(path));
+                write_mesh_file(path, data);
+            }
+
+            // Attributes are checked against the stride and their type
+            {
+                auto patch_attribute = [&](std::size_t field, auto value)
+                {
+                    write_mesh_file(path, data);
+                    std::fstream file(path, std::ios::binary | std::ios::in |
+                                                std::ios::out);
+                    file.seekp(static_cast<std::streamoff>(
+                        sizeof(mesh_file_header) + field));
+                    file.write(reinterpret_cast<const char*>(&value),
+                               sizeof(value));
+                };
+
+                patch_attribute(offsetof(mesh_file_attribute, offset),
+                                std::int32_t(0x7FFFFFFC));
+                check_any_throw(load_mesh_file(path));
+
+                patch_attribute(offsetof(mesh_file_attribute, type),
+                                static_cast<std::uint8_t>(
+                                    attribute_type::int_2_10_10_10_rev));
+                check_any_throw(load_mesh_file(path));
+
+                write_mesh_file(path, data);
+                check_true(mesh_file(path).attributes() == data.attributes);
+            }
+
+            // Truncated files are refused instead of being read past the end
+            std::filesystem::resize_file(
+                path, std::filesystem::file_size(path) - 4);
+            check_any_throw(load_mesh_file(path));
+
+            std::filesystem::remove(path);
+            check_any_throw(load_mesh_file(path));
+        });
+
+    test::add_test(
+        "vertex_array_cache", "shared_by_layout",
+        []()
+        {
+            vertex_array_cache vertex_arrays;
+
+            const auto a = primitive::build_rect_pos2_uv(1.0F, 1.0F);
+            const auto b = primitive::build_rect_pos2_uv(2.0F, 1.0F);
+            const auto c = primitive::build_rect_pos2(1.0F, 1.0F);
+
+            // Meshes with the same attributes share their vertex array
+            check_true(a.layout() == b.layout());
+            check_true(a.layout() != c.layout());
+
+            const auto id = vertex_arrays.vertex_array(a.layout());
+            assert_that(vertex_arrays.vertex_array(b.layout()),
+                        test::equals(id));
+            check_true(vertex_arrays.vertex_array(c.layout()) != id);
+            assert_that(vertex_arrays.size(), test::equals(std::size_t(2)));
+
+            // Binding a mesh only swaps the buffers
+            vertex_arrays.bind(b.layout(), b.vertex_buffer()->id(),
+                               b.index_buffer()->id());
+
+            GLint value = 0;
+            glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+            assert_that(value, test::equals(GLint(id)));
+            glGetIntegeri_v(GL_VERTEX_BINDING_BUFFER, 0, &value);
+            assert_that(value, test::equals(GLint(b.vertex_buffer()->id())));
+            glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &value);
+            assert_that(value, test::equals(GLint(b.index_buffer()->id())));
+
+            // Creating a mesh doesn't attach its indexes to the shared
+            // vertex array bound at the time
+            const auto d = primitive::build_rect_pos2_uv(3.0F, 1.0F);
+            glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &value);
+            assert_that(value, test::equals(GLint(b.index_buffer()->id())));
+
+            glBindVertexArray(0);
+
+            check_any_throw(vertex_arrays.vertex_array(0xFFFF));
+
+            // Locations past 31 don't fit in the location masks
+            check_any_throw(layout_registry::instance().intern(
+                {vertex_attribute(32, 0, 2)}));
+
+            vertex_arrays.clear();
+            assert_that(vertex_arrays.size(), test::equals(std::size_t(0)));
+        });
+
+    test::add_test(
+        "vertex_layout", "from_struct",
+        []()
+        {
+            // Same attributes as lit_vertex, described by hand
+            const std::vector<vertex_attribute> attributes {
+                {0, 0, 3, attribute_type::float32, attribute_mode::floating},
+                {1, 12, 4, attribute_type::int_2_10_10_10_rev,
+                 attribute_mode::normalized},
+                {2, 16, 4, attribute_type::uint8, attribute_mode::normalized},
+                {3, 20, 2, attribute_type::float16, attribute_mode::floating}};
+
+            check_true(attributes_of<lit_vertex>() == attributes);
+            assert_that(layout_of<lit_vertex>(),
+                        test::equals(
+                            layout_registry::instance().intern(attributes)));
+            assert_that(layout_of<common_vertices::pos2_uv>(),
+                        test::equals(layout_registry::instance().intern(
+                            common_attributes::pos2_uv)));
+
+            std::vector<lit_vertex> vertices(3);
+            for(auto& v : vertices)
+            {
+                v.normal.value = pack_snorm_2_10_10_10(0.0F, 0.0F, 1.0F);
+                v.color.value  = {255, 0, 0, 255};
+                v.uv.value     = {pack_half(0.5F), pack_half(1.0F)};
+            }
+            vertices[1].position = {1.0F, 0.0F, 0.0F};
+            vertices[2].position = {0.0F, 1.0F, 0.0F};
+
+            mesh m(vertices, {0, 1, 2});
+            assert_that(m.layout(), test::equals(layout_of<lit_vertex>()));
+            assert_that(m.vertices().size(),
+                        test::equals(3 * sizeof(lit_vertex)));
+
+            const std::vector<unsigned> indexes {0, 1, 2};
+            compact_mesh c(std::span<const lit_vertex>(vertices), indexes);
+            assert_that(c.vertex_count(), test::equals(std::uint32_t(3)));
+            assert_that(c.layout(), test::equals(layout_of<lit_vertex>()));
+        });
+
+    test::add_test(
+        "dynamic_mesh", "update",
+        []()
+        {
+            const auto layout =
+                layout_registry::instance().intern(common_attributes::pos2_uv);
+
+            for(auto mode : {update_mode::orphan, update_mode::map_range})
+            {
+                dynamic_mesh m(layout, primitive_type::triangles, mode);
+                check_true(m.empty());
+                check_any_throw(m.set_draw_range(0, 3));
+
+                std::vector<float>    vertices;
+                std::vector<unsigned> indexes;
+
+                primitive::rect_pos2_uv(1.0F, 1.0F, vertices, indexes);
+                m.update(vertices, indexes);
+
+                const auto vertex_buffer = m.vertex_buffer();
+                const auto index_buffer  = m.index_buffer();
+
+                assert_that(m.vertex_count(), test::equals(std::uint32_t(4)));
+                assert_that(m.draw_count(), test::equals(std::uint32_t(6)));
+                check_true(m.vertex_capacity() >= 4 * 4 * sizeof(float));
+
+                // Indexes are packed as uint16, straight from the mapping
+                // in map_range mode
+                std::array<std::uint16_t, 6> stored {};
+                glBindBuffer(GL_ARRAY_BUFFER, index_buffer);
+                glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(stored),
+                                   stored.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                check_true(std::ranges::equal(stored, indexes));
+
+                // Growing keeps the buffers' names
+                primitive::circle_pos2_uv(10.0F, 256, vertices, indexes);
+                m.update(vertices, indexes);
+
+                assert_that(m.vertex_count(), test::equals(std::uint32_t(257)));
+                assert_that(m.vertex_buffer(), test::equals(vertex_buffer));
+                assert_that(m.index_buffer(), test::equals(index_buffer));
+                check_true(m.reallocations() > 0);
+
+                // Smaller geometry fits in the current storage
+                const auto reallocations = m.reallocations();
+                primitive::circle_pos2_uv(10.0F, 16, vertices, indexes);
+                m.update(vertices, indexes);
+                assert_that(m.reallocations(), test::equals(reallocations));
+
+                m.set_draw_range(3, 6);
+                assert_that(m.first_index(), test::equals(std::uint32_t(3)));
+                assert_that(m.draw_count(), test::equals(std::uint32_t(6)));
+                check_any_throw(m.set_draw_range(40, 9));
+
+                // The center vertex moves, the rest stays
+                const std::array<float, 4> center {1.0F, 2.0F, 0.5F, 0.5F};
+                m.update_vertices(0, std::as_bytes(std::span(center)));
+
+                std::array<float, 8> read {};
+                glBindBuffer(GL_ARRAY_BUFFER, m.vertex_buffer());
+                glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(read),
+                                   read.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                check_true(read[1] == 2.0F);
+                check_true(read[4] == vertices[4]);
+
+                check_any_throw(
+                    m.update_vertices(17, std::as_bytes(std::span(center))));
+            }
+
+            // Typed meshes take their layout from the vertex struct, other
+            // layouts don't compile
+            dynamic_mesh_of<common_vertices::pos2_uv> typed;
+            assert_that(typed.layout(), test::equals(layout));
+
+            const std::array<common_vertices::pos2_uv, 3> corners {
+                {{{0.0F, 0.0F}, {0.0F, 0.0F}},
+                 {{1.0F, 0.0F}, {1.0F, 0.0F}},
+                 {{0.0F, 1.0F}, {0.0F, 1.0F}}}};
+            const std::array<unsigned, 3> triangle {0, 1, 2};
+
+            typed.update(std::span<const common_vertices::pos2_uv>(corners),
+                         triangle);
+            assert_that(typed.vertex_count(), test::equals(std::uint32_t(3)));
+            static_assert(!layout_matches<common_vertices::pos2>(
+                common_layouts::pos2_uv));
+        });
+
+    test::add_test(
+        "static_batch", "merge",
+        []()
+        {
+            const auto rect   = primitive::build_rect_pos2_uv(1.0F, 1.0F);
+            const auto plain  = primitive::build_rect_pos2(1.0F, 1.0F);
+
+            auto moved = identity_matrix4;
+            moved[12]  = 10.0F;
+            moved[13]  = -4.0F;
+
+            const std::array<batch_item, 2> items {
+                batch_item {&rect, identity_matrix4}, batch_item {&rect, moved}};
+
+            const auto batch = build_static_batch(items);
+
+            assert_that(batch.ranges.size(), test::equals(std::size_t(2)));
+            assert_that(batch.data.vertices.size(),
+                        test::equals(2 * rect.vertices().size()));
+            assert_that(batch.ranges[1].first_index,
+                        test::equals(rect.index_count()));
+            assert_that(batch.ranges[1].index_count,
+                        test::equals(rect.index_count()));
+
+            // Second copy's vertices are moved, and its indexes rebased
+            const auto vertex_count =
+                static_cast<unsigned>(rect.vertices().size() / (4 * sizeof(float)));
+            float first[4];
+            float copied[4];
+            std::memcpy(first, batch.data.vertices.data(), sizeof(first));
+            std::memcpy(copied,
+                        batch.data.vertices.data() + rect.vertices().size(),
+                        sizeof(copied));
+            check_true(copied[0] == first[0] + 10.0F);
+            check_true(copied[1] == first[1] - 4.0F);
+            check_true(copied[2] == first[2] && copied[3] == first[3]);
+            assert_that(batch.data.indexes[batch.ranges[1].first_index],
+                        test::equals(rect.indexes()[0] + vertex_count));
+
+            check_true(batch.ranges[0].bounds.min[0] == -1.0F);
+            check_true(batch.ranges[1].bounds.max[0] == 11.0F);
+            check_true(batch.ranges[1].bounds.min[1] == -5.0F);
+            check_true(batch.bounds.min[0] == -1.0F);
+            check_true(batch.bounds.max[0] == 11.0F);
+
+            // Boxes follow the transform
+            check_true(transform(batch.ranges[0].bounds, moved) ==
+                       batch.ranges[1].bounds);
+            check_true(aabb().empty());
+            check_true(transform(aabb(), moved).empty());
+
+            // Meshes must share their layout
+            const std::array<batch_item, 2> mixed {batch_item {&rect},
+                                                   batch_item {&plain}};
+            check_any_throw(build_static_batch(mixed));
+            check_any_throw(build_static_batch({}));
+
+            const static_batch uploaded(items);
+            assert_that(uploaded.size(), test::equals(std::size_t(2)));
+            assert_that(uploaded.mesh().index_count(),
+                        test::equals(2 * rect.index_count()));
+            check_true(uploaded.bounds() == batch.bounds);
+        });
+
+    test::add_test(
+        "mesh", "bounds",
+        []()
+        {
+            std::mt19937                          random(7);
+            std::uniform_real_distribution<float> coordinate(-50.0F, 50.0F);
+
+            std::vector<lit_vertex> vertices(1001);
+            std::vector<unsigned>   indexes;
+
+            aabb expected;
+            for(unsigned i = 0; i < vertices.size(); i++)
+            {
+                vertices[i].position = {coordinate(random), coordinate(random),
+                                        coordinate(random)};
+                expected.expand(vertices[i].position);
+            }
+            for(unsigned i = 0; i + 2 < vertices.size(); i += 3)
+                indexes.insert(indexes.end(), {i, i + 1, i + 2});
+
+            const mesh m(vertices, indexes);
+
+            check_true(m.bounds() == expected);
+
+            // Every point is inside the sphere, and one is on it
+            const auto& sphere = m.bounding_sphere();
+            check_true(sphere.center == expected.center());
+
+            float farthest = 0.0F;
+            for(const auto& v : vertices)
+            {
+                float d2 = 0.0F;
+                for(int i = 0; i < 3; i++)
+                    d2 += (v.position[i] - sphere.center[i]) *
+                          (v.position[i] - sphere.center[i]);
+                farthest = std::max(farthest, std::sqrt(d2));
+            }
+            check_true(std::abs(sphere.radius - farthest) < 1e-4F);
+
+            // 2D positions give a flat box. The last vertex of the stream is
+            // too short to be read as 4 floats
+            const auto rect = primitive::build_rect_pos2(3.0F, 2.0F);
+            check_true(rect.bounds().min == (std::array {-3.0F, -2.0F, 0.0F}));
+            check_true(rect.bounds().max == (std::array {3.0F, 2.0F, 0.0F}));
+            check_true(std::abs(rect.bounding_sphere().radius -
+                                std::sqrt(13.0F)) < 1e-5F);
+
+            // Copies keep the bounds, empty meshes have none
+            const mesh copy(m);
+            check_true(copy.bounds() == m.bounds());
+            check_true(mesh().bounds().empty());
+            check_true(mesh().bounding_sphere().empty());
+        });
+
+    test::add_test(
+        "thread_pool", "parallel_for",
+        []()
+        {
+            thread_pool pool(3);
+            assert_that(pool.max_chunks(), test::equals(std::size_t(4)));
+
+            // Every element is visited once, chunks are in order
+            std::vector<int>         visits(10000, 0);
+            std::vector<std::size_t> firsts(pool.max_chunks(), 0);
+
+            pool.parallel_for(visits.size(), 100,
+                              [&](std::size_t begin, std::size_t end,
+                                  std::size_t chunk)
+                              {
+                                  firsts[chunk] = begin;
+                                  for(auto i = begin; i < end; i++)
+                                      visits[i]++;
+                              });
+
+            check_true(std::ranges::all_of(visits, [](int v) { return v == 1; }));
+            check_true(std::ranges::is_sorted(firsts));
+
+            // Small loops stay on the calling thread
+            std::size_t chunks = 0;
+            pool.parallel_for(50, 100,
+                              [&](std::size_t, std::size_t, std::size_t)
+                              { chunks++; });
+            assert_that(chunks, test::equals(std::size_t(1)));
+
+            std::atomic<int> done {0};
+            for(int i = 0; i < 20; i++)
+                pool.submit([&] { done++; });
+            pool.wait();
+            assert_that(done.load(), test::equals(20));
+        });
+
+    test::add_test(
+        "culling", "frustum_and_rect",
+        []()
+        {
+            std::mt19937                          random(11);
+            std::uniform_real_distribution<float> position(-1000.0F, 1000.0F);
+            std::uniform_real_distribution<float> size(0.5F, 20.0F);
+
+            std::vector<aabb> boxes(50001);
+            cull_set          set;
+            set.reserve(boxes.size());
+
+            for(auto& box : boxes)
+            {
+                const std::array<float, 3> center {position(random),
+                                                   position(random),
+                                                   position(random) * 0.1F};
+                const float half = size(random);
+                box.expand({center[0] - half, center[1] - half, center[2] - half});
+                box.expand({center[0] + half, center[1] + half, center[2] + half});
+                set.add(box);
+            }
+
+            // Never visible
+            set.add(aabb());
+            assert_that(set.size(), test::equals(boxes.size() + 1));
+
+            const auto view = frustum::orthographic(-400.0F, 400.0F, -300.0F,
+                                                    300.0F, -100.0F, 100.0F);
+            const view_rect rect {-400.0F, -300.0F, 400.0F, 300.0F};
+
+            std::vector<std::uint32_t> expected_3d;
+            std::vector<std::uint32_t> expected_2d;
+            for(std::uint32_t i = 0; i < boxes.size(); i++)
+            {
+                if(view.intersects(boxes[i]))
+                    expected_3d.push_back(i);
+                if(rect.intersects(boxes[i]))
+                    expected_2d.push_back(i);
+            }
+            check_true(!expected_3d.empty() && expected_3d.size() < boxes.size());
+
+            // Same lists on one thread and split across the pool
+            thread_pool   pool(3);
+            culling_stage single;
+            culling_stage parallel(&pool, 1024);
+
+            check_true(std::ranges::equal(single.cull(set, view), expected_3d));
+            check_true(std::ranges::equal(parallel.cull(set, view), expected_3d));
+            check_true(std::ranges::equal(single.cull(set, rect), expected_2d));
+            check_true(std::ranges::equal(parallel.cull(set, rect), expected_2d));
+            check_true(std::ranges::equal(parallel.visible(), expected_2d));
+
+            // Moved out of sight
+            set.set(expected_2d.front(), aabb {{5000.0F, 5000.0F, 0.0F},
+                                               {5001.0F, 5001.0F, 0.0F}});
+            assert_that(single.cull(set, rect).size(),
+                        test::equals(expected_2d.size() - 1));
+            check_any_throw(set.set(std::uint32_t(set.size()), aabb()));
+
+            // Perspective looking down -z, 90 degrees, near 1 and far 100
+            matrix4 projection {};
+            projection[0]  = 1.0F;
+            projection[5]  = 1.0F;
+            projection[10] = -101.0F / 99.0F;
+            projection[11] = -1.0F;
+            projection[14] = -200.0F / 99.0F;
+
+            const auto camera = frustum::from_matrix(projection);
+            auto cube = [](float x, float z) {
+                return aabb {{x - 1.0F, -1.0F, z - 1.0F}, {x + 1.0F, 1.0F, z + 1.0F}};
+            };
+
+            check_true(camera.intersects(cube(0.0F, -10.0F)));
+            check_true(!camera.intersects(cube(0.0F, 10.0F)));
+            check_true(!camera.intersects(cube(50.0F, -10.0F)));
+            check_true(!camera.intersects(cube(0.0F, -250.0F)));
+        });
+
+    test::add_test(
+        "occlusion_buffer", "hides_boxes_behind_occluders",
+        []()
+        {
+            // Perspective looking down -z, 90 degrees, near 1 and far 100
+            matrix4 projection {};
+            projection[0]  = 1.0F;
+            projection[5]  = 1.0F;
+            projection[10] = -101.0F / 99.0F;
+            projection[11] = -1.0F;
+            projection[14] = -200.0F / 99.0F;
+
+            // A wall covering the left half of the view
+            std::vector<float>    positions;
+            std::vector<unsigned> indexes;
+            primitive::box_pos3({{-30.0F, -30.0F, -11.0F}, {0.0F, 30.0F, -10.0F}},
+                                positions, indexes);
+
+            const std::array<occluder, 1> occluders {
+                occluder {positions, indexes, projection}};
+
+            occlusion_buffer single(64, 48);
+            single.render(occluders);
+
+            assert_that(single.rendered_triangles(), test::equals(std::size_t(2)));
+            check_true(single.depth().front() < 1.0F);
+            check_true(single.depth().back() == 1.0F);
+
+            // Same pixels when rendered in bands by several threads
+            thread_pool      pool(3);
+            occlusion_buffer parallel(64, 48);
+            parallel.render(occluders, &pool);
+            check_true(std::ranges::equal(single.depth(), parallel.depth()));
+            check_true(std::ranges::equal(single.tile_depth(),
+                                          parallel.tile_depth()));
+
+            auto cube = [](float x, float z) {
+                return aabb {{x - 1.0F, -1.0F, z - 1.0F}, {x + 1.0F, 1.0F, z + 1.0F}};
+            };
+
+            check_true(!single.visible(cube(-20.0F, -50.0F), projection));
+            check_true(single.visible(cube(20.0F, -50.0F), projection));
+            check_true(single.visible(cube(-3.0F, -5.0F), projection));
+            // Partly behind the wall's edge
+            check_true(single.visible(cube(0.0F, -50.0F), projection));
+            // Crossing the near plane, or off screen
+            check_true(single.visible(cube(0.0F, 0.0F), projection));
+            check_true(!single.visible(cube(-200.0F, -50.0F), projection));
+
+            // As a pass of the culling stage
+            cull_set set;
+            set.add(cube(-20.0F, -50.0F));
+            set.add(cube(20.0F, -50.0F));
+            set.add(cube(-3.0F, -5.0F));
+
+            culling_stage stage;
+            stage.cull(set, frustum::from_matrix(projection));
+            assert_that(stage.visible().size(), test::equals(std::size_t(3)));
+
+            const auto visible = stage.remove_occluded(set, single, projection);
+            check_true(std::ranges::equal(visible, std::array {1u, 2u}));
+
+            single.clear();
+            check_true(single.visible(cube(-20.0F, -50.0F), projection));
+
+            check_any_throw(occlusion_buffer(60, 48));
+        });
+
+    test::add_test(
+        "occlusion_queries", "one_frame_delay",
+        []()
+        {
+            create_info info;
+            info.internal_format = internal_format::rgba8;
+            info.width           = 64;
+            info.height          = 64;
+            info.data            = nullptr;
+
+            texture      color(info);
+            renderbuffer depth(internal_format::depth24_stencil8, 64, 64);
+
+            framebuffer fb;
+            fb.attach(attachment::color0, color);
+            fb.attach(attachment::depth_stencil, depth);
+            fb.bind();
+            glViewport(0, 0, 64, 64);
+
+            // The depth buffer hides everything farther than 0.6, like a
+            // wall would
+            glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
+            glClearDepth(0.6);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glClearDepth(1.0);
+
+            // Perspective looking down -z, 90 degrees, near 1 and far 100
+            matrix4 projection {};
+            projection[0]  = 1.0F;
+            projection[5]  = 1.0F;
+            projection[10] = -101.0F / 99.0F;
+            projection[11] = -1.0F;
+            projection[14] = -200.0F / 99.0F;
+
+            auto cube = [](float x, float z, float half) {
+                return aabb {{x - half, -half, z - half}, {x + half, half, z + half}};
+            };
+
+            const std::array<aabb, 4> boxes {
+                cube(0.0F, -1.5F, 0.2F),     // In front of the wall
+                cube(0.0F, -10.0F, 1.0F),    // Behind it
+                cube(50.0F, -10.0F, 1.0F),   // Off screen
+                cube(0.0F, 0.0F, 1.0F)};     // Around the camera
+
+            occlusion_queries  queries(1);
+            vertex_array_cache vertex_arrays;
+
+            for(std::size_t i = 0; i < boxes.size(); i++)
+                queries.add();
+
+            check_any_throw(
+                queries.begin_proxies(vertex_arrays, projection, 0, nullptr));
+
+            // State the scene is drawn with, restored after the proxies
+            auto&      registry = pipeline_state_registry::instance();
+            const auto scene    = registry.intern(
+                pipeline_state().with_raster({cull_mode::back}));
+            registry.apply_defaults();
+            registry.apply(0, scene);
+
+            auto frame = [&]()
+            {
+                queries.begin_frame();
+                queries.begin_proxies(vertex_arrays, projection, scene,
+                                      nullptr);
+                for(std::uint32_t i = 0; i < boxes.size(); i++)
+                    queries.test(i, boxes[i]);
+                queries.end_proxies();
+            };
+
+            frame();
+
+            // No result yet, everything is visible
+            for(std::uint32_t i = 0; i < boxes.size(); i++)
+                check_true(queries.visible(i));
+
+            glFinish();
+            frame();
+
+            check_true(queries.visible(0));
+            check_true(!queries.visible(1));
+            check_true(!queries.visible(2));
+            check_true(queries.visible(3));
+            assert_that(queries.history(1) & 1u, test::equals(0u));
+            assert_that(queries.stalls(), test::equals(std::size_t(0)));
+
+            // The state is restored
+            GLboolean mask[4];
+            glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+            check_true(mask[0] == GL_TRUE);
+            check_true(glIsEnabled(GL_CULL_FACE) == GL_TRUE);
+            check_true(glIsEnabled(GL_DEPTH_TEST) == GL_FALSE);
+
+            GLint program_id = -1;
+            glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+            assert_that(program_id, test::equals(0));
+            registry.apply(scene, 0);
+
+            // The GPU skips the draws of the hidden box. Results must be
+            // there for the GPU not to draw anyway
+            glFinish();
+            renderer r(64, 64);
+            r.set_default_color(1.0F, 0.0F, 0.0F);
+
+            queries.begin_conditional_render(1);
+            r.draw_default_rect_on_screen(0.0F, 0.0F, 64.0F, 64.0F);
+            queries.end_conditional_render();
+
+            std::array<unsigned char, 4> pixel {};
+            glReadPixels(32, 32, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel.data());
+            check_true(pixel[0] == 0);
+
+            queries.begin_conditional_render(0);
+            r.draw_default_rect_on_screen(0.0F, 0.0F, 64.0F, 64.0F);
+            queries.end_conditional_render();
+
+            glReadPixels(32, 32, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel.data());
+            check_true(pixel[0] == 255);
+
+            // Proxies between renderer draws give the renderer its state and
+            // program back, the next draw can skip setting them again
+            queries.begin_frame();
+            queries.begin_proxies(r.vertex_arrays(), projection,
+                                  r.current_state(), r.current_program());
+            queries.test(0, boxes[0]);
+            queries.end_proxies();
+
+            glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+            assert_that(program_id,
+                        test::equals(GLint(r.current_program()->id())));
+
+            r.set_default_color(0.0F, 1.0F, 0.0F);
+            r.draw_default_rect_on_screen(0.0F, 0.0F, 64.0F, 64.0F);
+
+            glReadPixels(32, 32, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel.data());
+            check_true(pixel[0] == 0 && pixel[1] == 255);
+
+            framebuffer::unbind();
+            check_true(glGetError() == GL_NO_ERROR);
+        });
+
+    test::add_test(
+        "aabb_tree", "matches_linear_scan",
+        []()
+        {
+            std::mt19937                          random(11);
+            std::uniform_real_distribution<float> position(-100.0F, 100.0F);
+            std::uniform_real_distribution<float> size(0.1F, 4.0F);
+
+            auto random_box = [&]()
+            {
+                const float x = position(random);
+                const float y = position(random);
+                return aabb {{x, y, 0.0F},
+                             {x + size(random), y + size(random), 0.0F}};
+            };
+
+            std::vector<aabb> boxes(2000);
+            for(auto& box : boxes)
+                box = random_box();
+
+            // Half built at once, half inserted one by one
+            aabb_tree tree(0.5F);
+            tree.build(std::span(boxes).first(1000));
+
+            std::vector<std::uint32_t> proxies(boxes.size());
+            for(std::uint32_t i = 0; i < boxes.size(); i++)
+                proxies[i] = i < 1000 ? i : tree.insert(boxes[i], i);
+
+            // Some objects move, some leave
+            std::vector<bool> alive(boxes.size(), true);
+            std::size_t       moved = 0;
+
+            for(std::uint32_t i = 0; i < boxes.size(); i += 3)
+            {
+                boxes[i] = random_box();
+                if(tree.move(proxies[i], boxes[i]))
+                    moved++;
+            }
+
+            for(std::uint32_t i = 1; i < boxes.size(); i += 7)
+            {
+                tree.remove(proxies[i]);
+                alive[i] = false;
+            }
+
+            check_true(moved > 0);
+            assert_that(tree.size(),
+                        test::equals(std::size_t(
+                            std::count(alive.begin(), alive.end(), true))));
+
+            // A balanced tree of 1700 leaves
+            check_true(tree.height() < 24);
+
+            check_true(tree.bounds(proxies[3]).min[0] == boxes[3].min[0]);
+            assert_that(tree.object(proxies[1500]), test::equals(1500u));
+            check_any_throw(tree.move(proxies[1], boxes[1]));
+            check_any_throw(tree.insert(aabb {}, 0));
+
+            std::vector<std::uint32_t> found;
+
+            for(int i = 0; i < 50; i++)
+            {
+                const float x = position(random);
+                const float y = position(random);
+
+                const view_rect rect {x, y, x + 20.0F, y + 10.0F};
+
+                std::vector<std::uint32_t> expected;
+                for(std::uint32_t j = 0; j < boxes.size(); j++)
+                    if(alive[j] && rect.intersects(boxes[j]))
+                        expected.push_back(j);
+
+                found.clear();
+                tree.query(rect, found);
+                std::sort(found.begin(), found.end());
+                check_true(found == expected);
+
+                // Picking
+                expected.clear();
+                for(std::uint32_t j = 0; j < boxes.size(); j++)
+                    if(alive[j] && boxes[j].min[0] <= x && boxes[j].max[0] >= x &&
+                       boxes[j].min[1] <= y && boxes[j].max[1] >= y)
+                        expected.push_back(j);
+
+                found.clear();
+                tree.query(x, y, found);
+                std::sort(found.begin(), found.end());
+                check_true(found == expected);
+
+                // The nearest object is as close as the closest of the scan
+                auto distance = [&](const aabb& box)
+                {
+                    const float dx =
+                        std::max({box.min[0] - x, 0.0F, x - box.max[0]});
+                    const float dy =
+                        std::max({box.min[1] - y, 0.0F, y - box.max[1]});
+                    return std::sqrt(dx * dx + dy * dy);
+                };
+
+                float closest = std::numeric_limits<float>::max();
+                for(std::uint32_t j = 0; j < boxes.size(); j++)
+                    if(alive[j])
+                        closest = std::min(closest, distance(boxes[j]));
+
+                const auto nearest = tree.nearest(x, y);
+                check_true(nearest != aabb_tree::null);
+                check_true(distance(boxes[nearest]) == closest);
+
+                assert_that(tree.nearest(x + 1000.0F, y, 10.0F),
+                            test::equals(aabb_tree::null));
+            }
+
+            // The culling stage sorts what the tree finds
+            culling_stage   stage;
+            const view_rect screen {-50.0F, -50.0F, 50.0F, 50.0F};
+            const auto      visible = stage.cull(tree, screen);
+
+            check_true(std::is_sorted(visible.begin(), visible.end()));
+            for(auto index : visible)
+                check_true(alive[index] && screen.intersects(boxes[index]));
+
+            tree.clear();
+            check_true(tree.empty());
+            assert_that(tree.nearest(0.0F, 0.0F), test::equals(aabb_tree::null));
+        });
+
+    test::add_test(
+        "texture_streamer", "uploads_within_budget",
+        []()
+        {
+            // 64x32 pixels of 256 bytes per row, in a ring of 16 rows
+            image pixels;
+            pixels.width  = 64;
+            pixels.height = 32;
+            pixels.data.resize(64 * 32 * 4);
+
+            for(int y = 0; y < 32; y++)
+                for(int x = 0; x < 64; x++)
+                {
+                    auto* texel = &pixels.data[(y * 64 + x) * 4];
+                    texel[0]    = static_cast<unsigned char>(x * 4);
+                    texel[1]    = static_cast<unsigned char>(y * 8);
+                    texel[2]    = 7;
+                    texel[3]    = 255;
+                }
+
+            const auto file =
+                (std::filesystem::temp_directory_path() / "corgi_stream.png")
+                    .string();
+            check_true(pixels.save_png(file));
+
+            thread_pool      pool(2);
+            texture_streamer streamer(pool, 16 * 256, 4 * 256);
+
+            const auto from_memory = streamer.load(pixels);
+            const auto from_file   = streamer.load(file);
+            const auto missing     = streamer.load(file + ".missing");
+
+            check_any_throw(streamer.load(image {}));
+            check_any_throw(streamer.get(from_memory));
+
+            pool.wait();
+            assert_that(streamer.pending(), test::equals(std::size_t(3)));
+
+            int frames = 0;
+            while(streamer.pending() > 0 && frames < 100)
+            {
+                streamer.update();
+                check_true(streamer.uploaded_bytes() <= 4 * 256);
+
+                // Lets the GPU free the ring
+                glFinish();
+                frames++;
+            }
+
+            // 64 rows of 256 bytes, 4 rows per frame
+            assert_that(frames, test::equals(16));
+            check_true(streamer.resident(from_memory));
+            check_true(streamer.resident(from_file));
+            check_true(streamer.state(missing) == stream_state::failed);
+
+            // Both textures hold the pixels, rows in the same order
+            for(auto h : {from_memory, from_file})
+            {
+                const auto& t = streamer.get(h);
+                assert_that(t.width(), test::equals(64u));
+                assert_that(t.height(), test::equals(32u));
+
+                std::vector<unsigned char> read(64 * 32 * 4);
+                glBindTexture(GL_TEXTURE_2D, t.id());
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                              read.data());
+                glBindTexture(GL_TEXTURE_2D, 0);
+
+                check_true(read == pixels.data);
+            }
+
+            streamer.release(from_file);
+            check_any_throw(streamer.state(from_file));
+
+            // Taller than any texture can be, fails before being created
+            GLint max_size = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+            image tall;
+            tall.width  = 1;
+            tall.height = max_size + 1;
+            tall.data.resize(static_cast<std::size_t>(max_size + 1) * 4);
+
+            const auto too_tall = streamer.load(std::move(tall));
+            streamer.update();
+            check_true(streamer.state(too_tall) == stream_state::failed);
+
+            std::filesystem::remove(file);
+            check_true(glGetError() == GL_NO_ERROR);
+        });
+
     return test::run_all();
 }